@@ -1,6 +1,7 @@
 #pragma once
 #include "common_def.h"
 #include "shim.h"
+#include <vector>
 #define EMPTY 0
 #define ISSUANCE 1
 #define OWNERSHIP 2
@@ -60,6 +61,44 @@ static constexpr char CONTRACT_ASSET_UNIT_OF_MEASUREMENT[7] = { 0, 0, 0, 0, 0, 0
 
 static constexpr unsigned int NO_ASSET_INDEX = 0xffffffff;
 
+// Registers a record that was just written into an empty slot in the holder index.
+static void indexAssetRecord(int index)
+{
+    assetHolderIndex.add(assets[index].varStruct.issuance.publicKey, static_cast<uint32_t>(index));
+}
+
+/**
+ * @brief Rebuilds the holder index from the whole universe. Call after loading or reorganizing it.
+ * The new index is built off-line, readers keep using the previous one until it is swapped in.
+ */
+static void rebuildAssetHolderIndex()
+{
+    AssetHolderIndex::Map map;
+    for (unsigned int i = 0; i < ASSETS_CAPACITY; i++)
+    {
+        if (assets[i].varStruct.issuance.type != EMPTY)
+        {
+            map[assets[i].varStruct.issuance.publicKey].push_back(i);
+        }
+    }
+    assetHolderIndex.reset(std::move(map));
+}
+
+// Reports a change of the shares held by an ownership record to the rich list.
+static void rankOwnershipChange(int ownershipIndex, long long delta)
+{
+    const auto& ownership = assets[ownershipIndex].varStruct.ownership;
+    const auto& issuance = assets[ownership.issuanceIndex & (ASSETS_CAPACITY - 1)].varStruct.issuance;
+    richList.addShares(issuance.publicKey, (*((unsigned long long*)issuance.name)) & 0xFFFFFFFFFFFFFF, ownership.publicKey, delta);
+}
+
+// Journals a change of the shares of an ownership or possession record; call right after the change.
+static void journalShares(int index, long long delta)
+{
+    const long long shares = assets[index].varStruct.ownership.numberOfShares;
+    stateJournal.record(StateJournal::SHARES, static_cast<uint32_t>(index), shares - delta, shares);
+}
+
 static long long issueAsset(const m256i& issuerPublicKey, const char name[7], char numberOfDecimalPlaces, const char unitOfMeasurement[7], long long numberOfShares, unsigned short managingContractIndex,
                             int* issuanceIndex, int* ownershipIndex, int* possessionIndex)
 {
@@ -70,8 +109,10 @@ static long long issueAsset(const m256i& issuerPublicKey, const char name[7], ch
     iteration:
     if (assets[*issuanceIndex].varStruct.issuance.type == EMPTY)
     {
+        undoJournal.saveAsset(*issuanceIndex, &assets[*issuanceIndex]);
         assets[*issuanceIndex].varStruct.issuance.publicKey = issuerPublicKey;
         assets[*issuanceIndex].varStruct.issuance.type = ISSUANCE;
+        indexAssetRecord(*issuanceIndex);
         copyMem(assets[*issuanceIndex].varStruct.issuance.name, name, sizeof(assets[*issuanceIndex].varStruct.issuance.name));
         assets[*issuanceIndex].varStruct.issuance.numberOfDecimalPlaces = numberOfDecimalPlaces;
         copyMem(assets[*issuanceIndex].varStruct.issuance.unitOfMeasurement, unitOfMeasurement, sizeof(assets[*issuanceIndex].varStruct.issuance.unitOfMeasurement));
@@ -80,21 +121,28 @@ static long long issueAsset(const m256i& issuerPublicKey, const char name[7], ch
         iteration2:
         if (assets[*ownershipIndex].varStruct.ownership.type == EMPTY)
         {
+            undoJournal.saveAsset(*ownershipIndex, &assets[*ownershipIndex]);
             assets[*ownershipIndex].varStruct.ownership.publicKey = issuerPublicKey;
             assets[*ownershipIndex].varStruct.ownership.type = OWNERSHIP;
+            indexAssetRecord(*ownershipIndex);
             assets[*ownershipIndex].varStruct.ownership.managingContractIndex = managingContractIndex;
             assets[*ownershipIndex].varStruct.ownership.issuanceIndex = *issuanceIndex;
             assets[*ownershipIndex].varStruct.ownership.numberOfShares = numberOfShares;
+            journalShares(*ownershipIndex, numberOfShares);
+            rankOwnershipChange(*ownershipIndex, numberOfShares);
 
             *possessionIndex = (*ownershipIndex + 1) & (ASSETS_CAPACITY - 1);
             iteration3:
             if (assets[*possessionIndex].varStruct.possession.type == EMPTY)
             {
+                undoJournal.saveAsset(*possessionIndex, &assets[*possessionIndex]);
                 assets[*possessionIndex].varStruct.possession.publicKey = issuerPublicKey;
                 assets[*possessionIndex].varStruct.possession.type = POSSESSION;
+                indexAssetRecord(*possessionIndex);
                 assets[*possessionIndex].varStruct.possession.managingContractIndex = managingContractIndex;
                 assets[*possessionIndex].varStruct.possession.ownershipIndex = *ownershipIndex;
                 assets[*possessionIndex].varStruct.possession.numberOfShares = numberOfShares;
+                journalShares(*possessionIndex, numberOfShares);
 
                 assetChangeFlags[*issuanceIndex >> 6] |= (1ULL << (*issuanceIndex & 63));
                 assetChangeFlags[*ownershipIndex >> 6] |= (1ULL << (*ownershipIndex & 63));
@@ -181,8 +229,13 @@ static bool transferShareOwnershipAndPossession(int sourceOwnershipIndex, int so
         }
 
         // Burn by subtracting shares from source records
+        undoJournal.saveAsset(sourceOwnershipIndex, &assets[sourceOwnershipIndex]);
+        undoJournal.saveAsset(sourcePossessionIndex, &assets[sourcePossessionIndex]);
         assets[sourceOwnershipIndex].varStruct.ownership.numberOfShares -= numberOfShares;
+        journalShares(sourceOwnershipIndex, -numberOfShares);
         assets[sourcePossessionIndex].varStruct.possession.numberOfShares -= numberOfShares;
+        journalShares(sourcePossessionIndex, -numberOfShares);
+        rankOwnershipChange(sourceOwnershipIndex, -numberOfShares);
         assetChangeFlags[sourceOwnershipIndex >> 6] |= (1ULL << (sourceOwnershipIndex & 63));
         assetChangeFlags[sourcePossessionIndex >> 6] |= (1ULL << (sourcePossessionIndex & 63));
 
@@ -205,16 +258,23 @@ static bool transferShareOwnershipAndPossession(int sourceOwnershipIndex, int so
             && assets[*destinationOwnershipIndex].varStruct.ownership.issuanceIndex == assets[sourceOwnershipIndex].varStruct.ownership.issuanceIndex
             && assets[*destinationOwnershipIndex].varStruct.ownership.publicKey == destinationPublicKey))
     {
+        undoJournal.saveAsset(sourceOwnershipIndex, &assets[sourceOwnershipIndex]);
+        undoJournal.saveAsset(*destinationOwnershipIndex, &assets[*destinationOwnershipIndex]);
         assets[sourceOwnershipIndex].varStruct.ownership.numberOfShares -= numberOfShares;
+        journalShares(sourceOwnershipIndex, -numberOfShares);
 
         if (assets[*destinationOwnershipIndex].varStruct.ownership.type == EMPTY)
         {
             assets[*destinationOwnershipIndex].varStruct.ownership.publicKey = destinationPublicKey;
             assets[*destinationOwnershipIndex].varStruct.ownership.type = OWNERSHIP;
+            indexAssetRecord(*destinationOwnershipIndex);
             assets[*destinationOwnershipIndex].varStruct.ownership.managingContractIndex = assets[sourceOwnershipIndex].varStruct.ownership.managingContractIndex;
             assets[*destinationOwnershipIndex].varStruct.ownership.issuanceIndex = assets[sourceOwnershipIndex].varStruct.ownership.issuanceIndex;
         }
         assets[*destinationOwnershipIndex].varStruct.ownership.numberOfShares += numberOfShares;
+        journalShares(*destinationOwnershipIndex, numberOfShares);
+        rankOwnershipChange(sourceOwnershipIndex, -numberOfShares);
+        rankOwnershipChange(*destinationOwnershipIndex, numberOfShares);
 
         *destinationPossessionIndex = destinationPublicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1);
         iteration2:
@@ -224,16 +284,21 @@ static bool transferShareOwnershipAndPossession(int sourceOwnershipIndex, int so
                 && assets[*destinationPossessionIndex].varStruct.possession.ownershipIndex == *destinationOwnershipIndex
                 && assets[*destinationPossessionIndex].varStruct.possession.publicKey == destinationPublicKey))
         {
+            undoJournal.saveAsset(sourcePossessionIndex, &assets[sourcePossessionIndex]);
+            undoJournal.saveAsset(*destinationPossessionIndex, &assets[*destinationPossessionIndex]);
             assets[sourcePossessionIndex].varStruct.possession.numberOfShares -= numberOfShares;
+            journalShares(sourcePossessionIndex, -numberOfShares);
 
             if (assets[*destinationPossessionIndex].varStruct.possession.type == EMPTY)
             {
                 assets[*destinationPossessionIndex].varStruct.possession.publicKey = destinationPublicKey;
                 assets[*destinationPossessionIndex].varStruct.possession.type = POSSESSION;
+                indexAssetRecord(*destinationPossessionIndex);
                 assets[*destinationPossessionIndex].varStruct.possession.managingContractIndex = assets[sourcePossessionIndex].varStruct.possession.managingContractIndex;
                 assets[*destinationPossessionIndex].varStruct.possession.ownershipIndex = *destinationOwnershipIndex;
             }
             assets[*destinationPossessionIndex].varStruct.possession.numberOfShares += numberOfShares;
+            journalShares(*destinationPossessionIndex, numberOfShares);
 
             assetChangeFlags[sourceOwnershipIndex >> 6] |= (1ULL << (sourceOwnershipIndex & 63));
             assetChangeFlags[sourcePossessionIndex >> 6] |= (1ULL << (sourcePossessionIndex & 63));
@@ -483,16 +548,22 @@ static bool transferShareManagementRights(int sourceOwnershipIndex, int sourcePo
             && assets[destinationOwnershipIndex].varStruct.ownership.publicKey == ownershipPublicKey))
     {
         // found empty slot for ownership record or existing record to update
+        undoJournal.saveAsset(sourceOwnershipIndex, &assets[sourceOwnershipIndex]);
+        undoJournal.saveAsset(destinationOwnershipIndex, &assets[destinationOwnershipIndex]);
         assets[sourceOwnershipIndex].varStruct.ownership.numberOfShares -= numberOfShares;
+        journalShares(sourceOwnershipIndex, -numberOfShares);
 
         if (assets[destinationOwnershipIndex].varStruct.ownership.type == EMPTY)
         {
             assets[destinationOwnershipIndex].varStruct.ownership.publicKey = ownershipPublicKey;
             assets[destinationOwnershipIndex].varStruct.ownership.type = OWNERSHIP;
+            indexAssetRecord(destinationOwnershipIndex);
             assets[destinationOwnershipIndex].varStruct.ownership.managingContractIndex = destinationOwnershipManagingContractIndex;
             assets[destinationOwnershipIndex].varStruct.ownership.issuanceIndex = issuanceIndex;
         }
+        // same owner under another managing contract, so the owned total in the rich list doesn't change
         assets[destinationOwnershipIndex].varStruct.ownership.numberOfShares += numberOfShares;
+        journalShares(destinationOwnershipIndex, numberOfShares);
 
         int destinationPossessionIndex = possessionPublicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1);
         iteration2:
@@ -503,16 +574,21 @@ static bool transferShareManagementRights(int sourceOwnershipIndex, int sourcePo
                 && assets[destinationPossessionIndex].varStruct.possession.publicKey == possessionPublicKey))
         {
             // found empty slot for poss possession or existing record to update
+            undoJournal.saveAsset(sourcePossessionIndex, &assets[sourcePossessionIndex]);
+            undoJournal.saveAsset(destinationPossessionIndex, &assets[destinationPossessionIndex]);
             assets[sourcePossessionIndex].varStruct.possession.numberOfShares -= numberOfShares;
+            journalShares(sourcePossessionIndex, -numberOfShares);
 
             if (assets[destinationPossessionIndex].varStruct.possession.type == EMPTY)
             {
                 assets[destinationPossessionIndex].varStruct.possession.publicKey = possessionPublicKey;
                 assets[destinationPossessionIndex].varStruct.possession.type = POSSESSION;
+                indexAssetRecord(destinationPossessionIndex);
                 assets[destinationPossessionIndex].varStruct.possession.managingContractIndex = destinationPossessionManagingContractIndex;
                 assets[destinationPossessionIndex].varStruct.possession.ownershipIndex = destinationOwnershipIndex;
             }
             assets[destinationPossessionIndex].varStruct.possession.numberOfShares += numberOfShares;
+            journalShares(destinationPossessionIndex, numberOfShares);
 
             assetChangeFlags[sourceOwnershipIndex >> 6] |= (1ULL << (sourceOwnershipIndex & 63));
             assetChangeFlags[sourcePossessionIndex >> 6] |= (1ULL << (sourcePossessionIndex & 63));
@@ -645,22 +721,69 @@ static void assetsEndEpoch()
     RELEASE(universeLock);
 }
 
+// Looks the records up through the holder index, so only the records carrying pk/issuer are
+// checked. Falls back to probing the universe while the index is not built yet.
 static void getAssetBalances(const m256i pk, const m256i issuer, const uint64_t assetName, const uint32_t manageSCIndex,
                       long long& ownershipBalance, long long& possessionBalance)
 {
     ownershipBalance = -1;
     possessionBalance = -1;
+    std::vector<uint32_t> records;
     int issuanceIndex = -1;
-    findIssuerIndex(issuer, assetName, &issuanceIndex);
+    if (assetHolderIndex.get(issuer, records))
+    {
+        for (uint32_t i : records)
+        {
+            if (assets[i].varStruct.issuance.type == ISSUANCE
+                && (((*((unsigned long long*)assets[i].varStruct.issuance.name)) & 0xFFFFFFFFFFFFFF) == assetName)
+                && assets[i].varStruct.issuance.publicKey == issuer)
+            {
+                issuanceIndex = i;
+                break;
+            }
+        }
+    }
+    else
+    {
+        findIssuerIndex(issuer, assetName, &issuanceIndex);
+    }
     if (issuanceIndex == -1) return;
 
     int ownershipIndex = -1;
-    findOwnershipIndex(issuanceIndex, pk, manageSCIndex, &ownershipIndex);
-    if (ownershipIndex == -1) return;
-    ownershipBalance = assets[ownershipIndex].varStruct.ownership.numberOfShares;
-
     int possIndex = -1;
-    findPossessionIndex(ownershipIndex, pk, manageSCIndex, &possIndex);
+    if (assetHolderIndex.get(pk, records))
+    {
+        for (uint32_t i : records)
+        {
+            if (assets[i].varStruct.ownership.type == OWNERSHIP
+                && assets[i].varStruct.ownership.issuanceIndex == issuanceIndex
+                && assets[i].varStruct.ownership.publicKey == pk
+                && assets[i].varStruct.ownership.managingContractIndex == manageSCIndex)
+            {
+                ownershipIndex = i;
+                break;
+            }
+        }
+        if (ownershipIndex == -1) return;
+        for (uint32_t i : records)
+        {
+            if (assets[i].varStruct.possession.type == POSSESSION
+                && assets[i].varStruct.possession.ownershipIndex == ownershipIndex
+                && assets[i].varStruct.possession.publicKey == pk
+                && assets[i].varStruct.possession.managingContractIndex == manageSCIndex)
+            {
+                possIndex = i;
+                break;
+            }
+        }
+    }
+    else
+    {
+        findOwnershipIndex(issuanceIndex, pk, manageSCIndex, &ownershipIndex);
+        if (ownershipIndex == -1) return;
+        findPossessionIndex(ownershipIndex, pk, manageSCIndex, &possIndex);
+    }
+    ownershipBalance = assets[ownershipIndex].varStruct.ownership.numberOfShares;
     if (possIndex == -1) return;
     possessionBalance = assets[possIndex].varStruct.possession.numberOfShares;
     return;
@@ -0,0 +1,74 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "m256i.h"
+
+// Secondary index of the universe: public key -> indices of the issuance, ownership and
+// possession records that carry that key.
+// usage: the asset mutation helpers in Asset.h call add() whenever they fill an empty slot;
+// the whole index is rebuilt after the universe is loaded or reorganized. Records only disappear
+// between rebuilds when a batch is rolled back, readers still re-check the record type and key.
+class AssetHolderIndex
+{
+public:
+    struct KeyHash
+    {
+        size_t operator()(const m256i& k) const { return static_cast<size_t>(k.m256i_u64[0]); }
+    };
+    using Map = std::unordered_map<m256i, std::vector<uint32_t>, KeyHash>;
+
+    void add(const m256i& publicKey, uint32_t recordIndex)
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        map_[publicKey].push_back(recordIndex);
+    }
+
+    // Forget a record whose slot became empty again, e.g. when a batch is rolled back.
+    void remove(const m256i& publicKey, uint32_t recordIndex)
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        auto it = map_.find(publicKey);
+        if (it == map_.end()) return;
+        auto& v = it->second;
+        v.erase(std::remove(v.begin(), v.end(), recordIndex), v.end());
+        if (v.empty()) map_.erase(it);
+    }
+
+    // Replace the whole index, e.g. after a rebuild built off-line.
+    void reset(Map&& map)
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        map_.swap(map);
+        ready_ = true;
+    }
+
+    /**
+     * @brief Copies the record indices of a public key.
+     * @return False if the index has not been built yet; out is then empty and callers must probe the universe.
+     */
+    bool get(const m256i& publicKey, std::vector<uint32_t>& out)
+    {
+        out.clear();
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        if (!ready_) return false;
+        auto it = map_.find(publicKey);
+        if (it != map_.end()) out = it->second;
+        return true;
+    }
+
+    size_t size()
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        return map_.size();
+    }
+
+private:
+    Map map_;
+    bool ready_ = false;
+    std::shared_mutex mtx_;
+};
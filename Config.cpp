@@ -49,6 +49,20 @@ bool LoadConfig(const std::string& path, AppConfig& out, std::string& error) {
         }
     }
 
+    if (root.isMember("bundle-peers")) {
+        if (!root["bundle-peers"].isArray()) {
+            error = "Invalid type: array required for key 'bundle-peers'";
+            return false;
+        }
+        for (const auto& v : root["bundle-peers"]) {
+            if (!v.isString()) {
+                error = "Invalid type: elements of 'bundle-peers' must be strings";
+                return false;
+            }
+            out.bundle_peers.emplace_back(v.asString());
+        }
+    }
+
     // Optional fields (use defaults from AppConfig if absent)
     if (root.isMember("log-level")) {
         if (!root["log-level"].isString()) {
@@ -66,6 +80,44 @@ bool LoadConfig(const std::string& path, AppConfig& out, std::string& error) {
         out.keydb_url = root["keydb-url"].asString();
     }
 
+    if (root.isMember("storage-backend")) {
+        if (!root["storage-backend"].isString()) {
+            error = "Invalid type: string required for key 'storage-backend'";
+            return false;
+        }
+        const std::string mode = root["storage-backend"].asString();
+        if (mode == "keydb") out.storage_backend = StorageBackendMode::KeyDB;
+        else if (mode == "embedded") out.storage_backend = StorageBackendMode::Embedded;
+        else {
+            error = "Invalid value for 'storage-backend': must be one of 'keydb' or 'embedded'";
+            return false;
+        }
+    }
+
+    if (root.isMember("keydb-replica-url")) {
+        if (!root["keydb-replica-url"].isString()) {
+            error = "Invalid type: string required for key 'keydb-replica-url'";
+            return false;
+        }
+        out.keydb_replica_url = root["keydb-replica-url"].asString();
+    }
+
+    if (root.isMember("embedded-storage-path")) {
+        if (!root["embedded-storage-path"].isString() || root["embedded-storage-path"].asString().empty()) {
+            error = "Invalid type: non-empty string required for key 'embedded-storage-path'";
+            return false;
+        }
+        out.embedded_storage_path = root["embedded-storage-path"].asString();
+    }
+
+    if (root.isMember("log-segment-path")) {
+        if (!root["log-segment-path"].isString()) {
+            error = "Invalid type: string required for key 'log-segment-path'";
+            return false;
+        }
+        out.log_segment_path = root["log-segment-path"].asString();
+    }
+
     if (root.isMember("arbitrator-identity")) {
         if (!root["arbitrator-identity"].isString()) {
             error = "Invalid type: string required for key 'arbitrator-identity'";
@@ -95,6 +147,22 @@ bool LoadConfig(const std::string& path, AppConfig& out, std::string& error) {
         out.is_testnet = root["is-testnet"].asBool();
     }
 
+    if (root.isMember("fast-sync")) {
+        if (!root["fast-sync"].isBool()) {
+            error = "Invalid type: boolean required for key 'fast-sync'";
+            return false;
+        }
+        out.fast_sync = root["fast-sync"].asBool();
+    }
+
+    if (root.isMember("state-journal")) {
+        if (!root["state-journal"].isBool()) {
+            error = "Invalid type: boolean required for key 'state-journal'";
+            return false;
+        }
+        out.state_journal = root["state-journal"].asBool();
+    }
+
     auto validate_uint = [&](const char* key, unsigned& target) -> bool {
         if (!root.isMember(key)) return true;
         const auto& v = root[key];
@@ -118,7 +186,17 @@ bool LoadConfig(const std::string& path, AppConfig& out, std::string& error) {
     if (!validate_uint("request-cycle-ms", out.request_cycle_ms)) return false;
     if (!validate_uint("request-logging-cycle-ms", out.request_logging_cycle_ms)) return false;
     if (!validate_uint("future-offset", out.future_offset)) return false;
+    if (!validate_uint("log-fetch-window", out.log_fetch_window)) return false;
+    if (out.log_fetch_window == 0) out.log_fetch_window = 1;
+    if (!validate_uint("speculative-ticks", out.speculative_ticks)) return false;
     if (!validate_uint("server-port", out.server_port)) return false;
+    if (!validate_uint("keydb-ingest-pool-size", out.keydb_ingest_pool_size)) return false;
+    if (!validate_uint("keydb-background-pool-size", out.keydb_background_pool_size)) return false;
+    if (!validate_uint("keydb-api-pool-size", out.keydb_api_pool_size)) return false;
+    if (out.keydb_ingest_pool_size == 0) out.keydb_ingest_pool_size = 1;
+    if (out.keydb_background_pool_size == 0) out.keydb_background_pool_size = 1;
+    if (out.keydb_api_pool_size == 0) out.keydb_api_pool_size = 1;
+    if (!validate_uint("keydb-replica-max-lag", out.keydb_replica_max_lag)) return false;
 
     // Maximum threads the system can use (0 means auto/unlimited)
     if (!validate_uint("max-thread", out.max_thread)) return false;
@@ -127,6 +205,29 @@ bool LoadConfig(const std::string& path, AppConfig& out, std::string& error) {
         out.max_thread = std::thread::hardware_concurrency();
     }
 
+    if (root.isMember("huge-pages")) {
+        if (!root["huge-pages"].isString()) {
+            error = "Invalid type: string required for key 'huge-pages'";
+            return false;
+        }
+        const std::string mode = root["huge-pages"].asString();
+        if (mode == "auto") out.huge_pages = HugePageMode::Auto;
+        else if (mode == "thp") out.huge_pages = HugePageMode::Thp;
+        else if (mode == "off") out.huge_pages = HugePageMode::Off;
+        else {
+            error = "Invalid value for 'huge-pages': must be one of 'auto', 'thp', or 'off'";
+            return false;
+        }
+    }
+
+    if (root.isMember("numa-node")) {
+        if (!root["numa-node"].isInt()) {
+            error = "Invalid type: integer required for key 'numa-node'";
+            return false;
+        }
+        out.numa_node = root["numa-node"].asInt();
+    }
+
     // Spam/Junk QU transfer detection threshold (default 0)
     if (!validate_uint("spam-qu-threshold", out.spam_qu_threshold)) return false;
 
@@ -295,6 +396,23 @@ bool LoadConfig(const std::string& path, AppConfig& out, std::string& error) {
         }
     }
 
+    if (root.isMember("vtick-compression-level")) {
+        const auto& v = root["vtick-compression-level"];
+        if (!v.isInt() || v.asInt() < 1 || v.asInt() > 19) {
+            error = "Invalid value for 'vtick-compression-level': must be an integer from 1 to 19";
+            return false;
+        }
+        out.vtick_compression_level = v.asInt();
+    }
+
+    if (root.isMember("vtick-dictionary")) {
+        if (!root["vtick-dictionary"].isBool()) {
+            error = "Invalid type: boolean required for key 'vtick-dictionary'";
+            return false;
+        }
+        out.vtick_dictionary = root["vtick-dictionary"].asBool();
+    }
+
     if (out.tick_storage_mode == TickStorageMode::LastNTick)
     {
         if (out.tx_storage_mode != TxStorageMode::LastNTick && out.tx_storage_mode != TxStorageMode::Free)
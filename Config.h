@@ -16,18 +16,42 @@ enum class TxStorageMode {
     Kvrocks,
     Free
 };
+// Backing pages of the GlobalState tables (spectrum, universe, digest trees)
+enum class HugePageMode {
+    Auto, // hugetlb pages if reserved, else transparent huge pages
+    Thp,  // transparent huge pages only
+    Off
+};
+
+enum class StorageBackendMode {
+    KeyDB,   // keydb-url, plus kvrocks-url for the kvrocks storage modes
+    Embedded // in-process engine under embedded-storage-path
+};
 
 struct AppConfig {
     std::vector<std::string> p2p_nodes;
+    std::vector<std::string> bundle_peers; // inbound addresses allowed to request tick bundles
 
     std::string log_level;
     std::string keydb_url;
+    // connections of each KeyDB workload class: ingestion, verify/index/cleanup, API reads
+    unsigned keydb_ingest_pool_size = 32;
+    unsigned keydb_background_pool_size = 16;
+    unsigned keydb_api_pool_size = 16;
+    std::string keydb_replica_url; // replica for API reads; empty reads from the primary
+    unsigned keydb_replica_max_lag = 5; // verified ticks the replica may trail before reads go to the primary
+    StorageBackendMode storage_backend = StorageBackendMode::KeyDB;
+    std::string embedded_storage_path = "bobdb"; // directory of the embedded engine's log files
     std::string arbitrator_identity;
     bool run_server = false;
     bool is_testnet = false;
+    bool fast_sync = false; // start a fresh node from a bob peer's verified checkpoint
+    bool state_journal = true; // persist per-tick balance changes for historical queries
     unsigned request_cycle_ms = 0;
     unsigned request_logging_cycle_ms = 0;
     unsigned future_offset = 0;
+    unsigned log_fetch_window = 16; // ticks whose logs are fetched concurrently
+    unsigned speculative_ticks = 2; // ticks whose logs are fetched and simulated before their votes are verified
     unsigned server_port = 0;
     std::string node_seed;
 
@@ -35,8 +59,11 @@ struct AppConfig {
     TickStorageMode tick_storage_mode = TickStorageMode::LastNTick;
     unsigned last_n_tick_storage = 1000;              // used when mode is LastNTick
     std::string kvrocks_url = "tcp://127.0.0.1:6666"; // used when mode is Kvrocks
+    std::string log_segment_path; // directory of per-epoch log segments; empty keeps moved logs in kvrocks
 
     unsigned max_thread = 0;
+    HugePageMode huge_pages = HugePageMode::Auto;
+    int numa_node = -1; // bind GlobalState to this NUMA node, -1 = no binding
     // Spam/Junk detection threshold for QU transfers (amount <= threshold and no input)
     unsigned spam_qu_threshold = 100;
     // transaction storage mode configuration
@@ -46,6 +73,9 @@ struct AppConfig {
 
     // time to live (data expiration) for records in kvrocks engine (default 3 weeks - 1814400 seconds) (0 => no expiration)
     long long kvrocks_ttl = 1814400;
+    // zstd level of the vticks compressed into kvrocks, and whether a dictionary is trained for them
+    int vtick_compression_level = 3;
+    bool vtick_dictionary = true;
 };
 
 // Returns true on success; on failure returns false and fills error with a human-readable message.
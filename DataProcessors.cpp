@@ -1,11 +1,18 @@
 #include <sstream>
 #include <iomanip>
 #include <cassert>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
 #include "database/db.h"
 #include "GlobalVar.h"
 #include "Logger.h"
 #include "K12AndKeyUtil.h"
 #include "shim.h"
+#include "zstd.h"
+#include "RESTAPI/LogSubscriptionManager.h"
 
 bool verifySignature(void* ptr, uint8_t* pubkey, int structSize) // structSize include sig 64 bytes
 {
@@ -18,6 +25,13 @@ bool verifySignature(void* ptr, uint8_t* pubkey, int structSize) // structSize i
     }
     return false;
 }
+// Ticks below the verified head are normally dropped, except those being backfilled after a fast sync.
+static bool isStaleTick(uint32_t tick)
+{
+    if (tick >= gCurrentVerifyLoggingTick - 1) return false;
+    return !(tick >= gBackfillFromTick && tick < gBackfillToTick);
+}
+
 void processTickVote(uint8_t* ptr)
 {
     TickVote _vote;
@@ -28,7 +42,7 @@ void processTickVote(uint8_t* ptr)
     {
         return;
     }
-    if (vote->tick < gCurrentVerifyLoggingTick - 1)
+    if (isStaleTick(vote->tick))
     {
         return; // already verified
     }
@@ -39,6 +53,7 @@ void processTickVote(uint8_t* ptr)
     if (ok)
     {
         db_insert_tick_vote(*vote);
+        inflightRequests.touch(RequestedQuorumTick::type, vote->tick);
     }
     else
     {
@@ -55,7 +70,7 @@ void processTickData(uint8_t* ptr)
     {
         return;
     }
-    if (data->tick < gCurrentVerifyLoggingTick - 1)
+    if (isStaleTick(data->tick))
     {
         return; // already verified
     }
@@ -66,6 +81,7 @@ void processTickData(uint8_t* ptr)
     if (ok)
     {
         db_insert_tick_data(*data);
+        inflightRequests.complete({RequestTickData::type, data->tick, 0});
     }
     else
     {
@@ -84,7 +100,7 @@ void processTransaction(const uint8_t* ptr)
         Logger::get()->warn("Malformed transaction data");
         return;
     }
-    if (tx->tick < gCurrentVerifyLoggingTick - 1)
+    if (isStaleTick(tx->tick))
     {
         return; // already verified
     }
@@ -114,6 +130,7 @@ void processTransaction(const uint8_t* ptr)
     if (verifySignature((void *) buffer, pubkey, sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE))
     {
         db_insert_transaction(tx);
+        inflightRequests.touch(RequestedTickTransactions::type, tx->tick);
     }
     else
     {
@@ -128,6 +145,9 @@ void processLogEvent(const uint8_t* _ptr, uint32_t chunkSize)
 {
     uint32_t offset = 0;
     uint64_t maxLogId = 0;
+    uint32_t lastTouchedTick = 0;
+    auto& subscriptions = LogSubscriptionManager::instance();
+    std::vector<LogEvent> preliminary;
     while (offset < chunkSize)
     {
         auto ptr = _ptr + offset;
@@ -148,6 +168,16 @@ void processLogEvent(const uint8_t* _ptr, uint32_t chunkSize)
             {
                 Logger::get()->warn("Failed to add log {}", logId);
             }
+            else
+            {
+                logFetchWindow.markReceived(tick, logId);
+                if (subscriptions.notePreliminaryLog(tick)) preliminary.push_back(std::move(le));
+                if (tick != lastTouchedTick)
+                {
+                    inflightRequests.touch(RequestLog::type(), tick);
+                    lastTouchedTick = tick;
+                }
+            }
         }
         else
         {
@@ -158,7 +188,11 @@ void processLogEvent(const uint8_t* _ptr, uint32_t chunkSize)
         offset += messageSize + LogEvent::PackedHeaderSize;
         maxLogId = std::max(maxLogId, logId);
     }
-    db_update_latest_log_id(gCurrentProcessingEpoch, maxLogId);
+    StatusCommit commit;
+    commit.epoch = gCurrentProcessingEpoch;
+    commit.latestLogId = maxLogId;
+    db_commit_status(commit);
+    if (!preliminary.empty()) subscriptions.pushPreliminaryLogs(std::move(preliminary));
 }
 
 void processLogRanges(RequestResponseHeader& header, const uint8_t* ptr)
@@ -169,17 +203,15 @@ void processLogRanges(RequestResponseHeader& header, const uint8_t* ptr)
         uint32_t tick;
     } packet;
 
-    std::vector<uint8_t> request;
-    requestMapperFrom.get(header.getDejavu(), request);
-    if (request.size() == sizeof(packet))
+    if (requestMapperFrom.peek(header.getDejavu(), &packet, sizeof(packet)) == static_cast<int>(sizeof(packet)))
     {
-        memcpy((void*)&packet, request.data(), sizeof(packet));
         int header_sz = header.size();
         int needed_sz = sizeof(RequestResponseHeader) + sizeof(LogRangesPerTxInTick);
         if (header_sz == needed_sz)
         {
             const auto* logRange = reinterpret_cast<const LogRangesPerTxInTick*>(ptr);
             db_insert_log_range(packet.tick, *logRange);
+            inflightRequests.complete({RequestAllLogIdRangesFromTick::type(), packet.tick, 0});
         }
     }
     else
@@ -188,6 +220,155 @@ void processLogRanges(RequestResponseHeader& header, const uint8_t* ptr)
     }
 }
 
+// Walks the records of a decompressed bundle frame. With ingest false it only checks that the whole
+// frame parses, so a malformed frame is dropped before any of its items is stored.
+static bool walkTickBundle(const RespondVerifiedTickBundle& frame, std::vector<uint8_t>& raw, bool ingest)
+{
+    const bool withLogs = (frame.flags & RespondVerifiedTickBundle::WITH_LOGS) != 0;
+    size_t offset = 0;
+    while (offset < raw.size())
+    {
+        TickBundleRecord rec;
+        if (offset + sizeof(rec) > raw.size()) return false;
+        memcpy((void*)&rec, raw.data() + offset, sizeof(rec));
+        offset += sizeof(rec);
+        size_t fixedSize = (rec.hasTickData ? sizeof(TickData) : 0) +
+                           size_t(rec.voteCount) * sizeof(TickVote) +
+                           (rec.hasLogRange ? sizeof(LogRangesPerTxInTick) : 0);
+        if (rec.tick < frame.fromTick || rec.tick > frame.toTick ||
+            rec.voteCount > NUMBER_OF_COMPUTORS || rec.txCount > NUMBER_OF_TRANSACTIONS_PER_TICK ||
+            offset + fixedSize > raw.size())
+        {
+            return false;
+        }
+        if (rec.hasTickData)
+        {
+            if (ingest) processTickData(raw.data() + offset);
+            offset += sizeof(TickData);
+        }
+        for (int i = 0; i < rec.voteCount; i++)
+        {
+            if (ingest) processTickVote(raw.data() + offset);
+            offset += sizeof(TickVote);
+        }
+        if (rec.hasLogRange)
+        {
+            if (ingest && withLogs)
+            {
+                LogRangesPerTxInTick logRange;
+                memcpy((void*)&logRange, raw.data() + offset, sizeof(logRange));
+                db_insert_log_range(rec.tick, logRange);
+                inflightRequests.complete({RequestAllLogIdRangesFromTick::type(), rec.tick, 0});
+            }
+            offset += sizeof(LogRangesPerTxInTick);
+        }
+        for (int i = 0; i < rec.txCount; i++)
+        {
+            uint32_t txSize = 0;
+            if (offset + 4 > raw.size()) return false;
+            memcpy(&txSize, raw.data() + offset, 4);
+            offset += 4;
+            if (txSize < sizeof(Transaction) || offset + txSize > raw.size()) return false;
+            const auto* tx = reinterpret_cast<const Transaction*>(raw.data() + offset);
+            if (sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE != txSize) return false;
+            if (ingest) processTransaction(raw.data() + offset);
+            offset += txSize;
+        }
+        if (offset + rec.logSize > raw.size()) return false;
+        if (ingest && withLogs && rec.logSize) processLogEvent(raw.data() + offset, rec.logSize);
+        offset += rec.logSize;
+    }
+    return true;
+}
+
+// The frames that arrived intact for each backfill request, by first tick. Frames can be handled by
+// different data threads in any order, and a dropped one leaves a hole until the request is retried.
+struct BackfillProgress
+{
+    uint32_t lastTick = 0; // toTick of the last frame, 0 until it arrived
+    std::map<uint32_t, uint32_t> frames; // fromTick -> toTick
+};
+static std::mutex backfillProgressMtx;
+static std::map<uint32_t, BackfillProgress> backfillProgress; // by requestFromTick
+
+// Moves gBackfillFromTick past a request only once its frames cover every tick up to the last one.
+static void recordBackfillFrame(const RespondVerifiedTickBundle& frame)
+{
+    std::lock_guard<std::mutex> lock(backfillProgressMtx);
+    // requests behind the backfill head are done
+    backfillProgress.erase(backfillProgress.begin(), backfillProgress.lower_bound(gBackfillFromTick));
+    auto& progress = backfillProgress[frame.requestFromTick];
+    if (frame.rawSize && frame.fromTick >= frame.requestFromTick && frame.toTick >= frame.fromTick)
+    {
+        auto& to = progress.frames[frame.fromTick];
+        to = std::max(to, frame.toTick);
+    }
+    if ((frame.flags & RespondVerifiedTickBundle::LAST_FRAME) && frame.toTick >= frame.requestFromTick)
+    {
+        progress.lastTick = frame.toTick;
+    }
+    if (progress.lastTick == 0) return;
+    uint32_t next = frame.requestFromTick;
+    for (const auto& [from, to] : progress.frames)
+    {
+        if (from > next) break;
+        next = std::max(next, to + 1);
+    }
+    if (next <= progress.lastTick) return;
+    uint32_t backfillFrom = frame.requestFromTick;
+    gBackfillFromTick.compare_exchange_strong(backfillFrom, progress.lastTick + 1);
+    backfillProgress.erase(frame.requestFromTick);
+}
+
+// Ingest one frame of a bulk sync bundle. Every item goes through the same checks as if it had been
+// fetched on its own, so a bundle can't inject anything the per-item path would reject.
+void processVerifiedTickBundle(const uint8_t* ptr, uint32_t size)
+{
+    RespondVerifiedTickBundle frame{};
+    if (size < sizeof(frame)) return;
+    memcpy((void*)&frame, ptr, sizeof(frame));
+    if (frame.epoch != gCurrentProcessingEpoch) return;
+
+    // only a claim, checked against signed votes by IORequestThread. The latest one is kept rather than
+    // the highest, so a peer announcing a tick far ahead cannot hide the claims of the others.
+    if (frame.latestVerifiedTick) gBundlePeerClaimedTick = frame.latestVerifiedTick;
+
+    if (frame.rawSize)
+    {
+        if (frame.rawSize > RespondVerifiedTickBundle::MAX_RAW_SIZE + 2 * RespondVerifiedTickBundle::MAX_TICK_LOG_SIZE)
+        {
+            Logger::get()->warn("Tick bundle {}-{} is too large ({} bytes)", frame.fromTick, frame.toTick, frame.rawSize);
+            return;
+        }
+        thread_local std::vector<uint8_t> raw;
+        raw.resize(frame.rawSize);
+        const size_t dSize = ZSTD_decompress(raw.data(), raw.size(), ptr + sizeof(frame), size - sizeof(frame));
+        if (ZSTD_isError(dSize) || dSize != frame.rawSize)
+        {
+            Logger::get()->warn("Failed to decompress tick bundle {}-{}", frame.fromTick, frame.toTick);
+            return;
+        }
+        if (!walkTickBundle(frame, raw, false))
+        {
+            Logger::get()->warn("Malformed tick bundle {}-{}, dropping the frame", frame.fromTick, frame.toTick);
+            return;
+        }
+        walkTickBundle(frame, raw, true);
+    }
+    if (frame.requestFromTick >= gBackfillFromTick && frame.requestFromTick < gBackfillToTick)
+    {
+        recordBackfillFrame(frame);
+    }
+    if (frame.flags & RespondVerifiedTickBundle::LAST_FRAME)
+    {
+        inflightRequests.complete({RequestVerifiedTickBundle::type(), frame.requestFromTick, 0});
+    }
+    else
+    {
+        inflightRequests.touch(RequestVerifiedTickBundle::type(), frame.requestFromTick);
+    }
+}
+
 void recordSmartContractResponse(uint32_t size, uint32_t dejavu, const uint8_t* ptr)
 {
     responseSCData.add(dejavu, ptr, size, nullptr);
@@ -231,6 +412,9 @@ void DataProcessorThread(std::atomic_bool& exitFlag)
             case RespondContractFunction::type:
                 recordSmartContractResponse(header.size() - sizeof(RequestResponseHeader), header.getDejavu(), payload);
                 break;
+            case RespondVerifiedTickBundle::type(): // bulk sync frame
+                processVerifiedTickBundle(payload, packet_size - 8);
+                break;
             default:
                 break;
         }
@@ -460,6 +644,267 @@ void replyCurrentTickInfo(QCPtr& conn, uint32_t dejavu, uint8_t* ptr)
 }
 
 
+// Append the record of one verified tick to a bundle frame.
+static void appendTickBundleRecord(uint32_t tick, std::vector<uint8_t>& raw)
+{
+    TickBundleRecord rec{};
+    rec.tick = tick;
+    const size_t recOffset = raw.size();
+    raw.resize(recOffset + sizeof(rec));
+
+    TickData td{};
+    if (db_try_get_tick_data(tick, td) && td.tick == tick)
+    {
+        rec.hasTickData = 1;
+        const size_t o = raw.size();
+        raw.resize(o + sizeof(TickData));
+        memcpy(raw.data() + o, &td, sizeof(TickData));
+    }
+    for (auto& tv : db_try_get_tick_vote(tick))
+    {
+        if (tv.tick != tick || tv.epoch == 0) continue;
+        const size_t o = raw.size();
+        raw.resize(o + sizeof(TickVote));
+        memcpy(raw.data() + o, &tv, sizeof(TickVote));
+        rec.voteCount++;
+    }
+    LogRangesPerTxInTick logRange{};
+    if (db_try_get_log_ranges(tick, logRange))
+    {
+        rec.hasLogRange = 1;
+        const size_t o = raw.size();
+        raw.resize(o + sizeof(LogRangesPerTxInTick));
+        memcpy(raw.data() + o, &logRange, sizeof(LogRangesPerTxInTick));
+    }
+    if (rec.hasTickData)
+    {
+        std::vector<uint8_t> txData;
+        for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+        {
+            if (td.transactionDigests[i] == m256i::zero()) continue;
+            char hash[64] = {0};
+            getIdentityFromPublicKey(td.transactionDigests[i].m256i_u8, hash, true);
+            if (!db_try_get_transaction(std::string(hash), txData)) continue;
+            const uint32_t txSize = txData.size();
+            const size_t o = raw.size();
+            raw.resize(o + 4 + txSize);
+            memcpy(raw.data() + o, &txSize, 4);
+            memcpy(raw.data() + o + 4, txData.data(), txSize);
+            rec.txCount++;
+        }
+    }
+    long long fromLogId = -1, length = 0;
+    if (rec.hasLogRange && db_try_get_log_range_for_tick(tick, fromLogId, length) && fromLogId >= 0 && length > 0)
+    {
+        // logs are all or nothing per tick; an incomplete or huge set is left to the log fetcher
+        const size_t logOffset = raw.size();
+        long long count = 0;
+        for (long long id = fromLogId; id < fromLogId + length; id++)
+        {
+            LogEvent le;
+            if (!db_try_get_log(gCurrentProcessingEpoch, id, le)) break;
+            const size_t sz = le.getLogSize() + LogEvent::PackedHeaderSize;
+            if (raw.size() + sz - logOffset > RespondVerifiedTickBundle::MAX_TICK_LOG_SIZE) break;
+            const size_t o = raw.size();
+            raw.resize(o + sz);
+            memcpy(raw.data() + o, le.getRawPtr(), sz);
+            count++;
+        }
+        if (count == length) rec.logSize = raw.size() - logOffset;
+        else raw.resize(logOffset);
+    }
+    memcpy(raw.data() + recOffset, &rec, sizeof(rec));
+}
+
+// Frames go out with dejavu 0: a dejavu would make enqueueSend keep a copy of every multi-MB frame in
+// requestMapperFrom. The peer matches them by requestFromTick.
+static void sendTickBundleFrame(QCPtr& conn, RespondVerifiedTickBundle& frame,
+                                const std::vector<uint8_t>& raw, std::vector<uint8_t>& out)
+{
+    frame.rawSize = raw.size();
+    const size_t headerSize = sizeof(RequestResponseHeader) + sizeof(RespondVerifiedTickBundle);
+    out.resize(headerSize + (raw.empty() ? 0 : ZSTD_compressBound(raw.size())));
+    size_t cSize = 0;
+    if (!raw.empty())
+    {
+        cSize = ZSTD_compress(out.data() + headerSize, out.size() - headerSize, raw.data(), raw.size(), ZSTD_defaultCLevel());
+        if (ZSTD_isError(cSize) || headerSize + cSize > RequestResponseHeader::max_size)
+        {
+            Logger::get()->warn("Cannot pack tick bundle {}-{}", frame.fromTick, frame.toTick);
+            return;
+        }
+    }
+    RequestResponseHeader hdr{};
+    hdr.setType(RespondVerifiedTickBundle::type());
+    hdr.setDejavu(0);
+    hdr.setSize(headerSize + cSize);
+    memcpy(out.data(), &hdr, sizeof(hdr));
+    memcpy(out.data() + sizeof(hdr), &frame, sizeof(frame));
+    conn->enqueueSend(out.data(), headerSize + cSize);
+}
+
+// Bulk sync for bobs that join mid-epoch: every verified tick of the requested range with its
+// votes, transactions, log ranges and logs, packed into zstd frames of about MAX_RAW_SIZE bytes.
+static void replyVerifiedTickBundle(QCPtr& conn, uint32_t dejavu, const RequestVerifiedTickBundle& request)
+{
+    const uint32_t verifiedTick = gCurrentVerifyLoggingTick.load();
+    if (computorsList.epoch == 0 || verifiedTick == 0 || request.fromTick < gInitialTick || request.fromTick > request.toTick)
+    {
+        conn->sendEndPacket(dejavu);
+        return;
+    }
+    const uint32_t lastTick = std::min({request.toTick,
+                                        verifiedTick - 1,
+                                        request.fromTick + RequestVerifiedTickBundle::MAX_TICKS - 1});
+
+    RespondVerifiedTickBundle frame{};
+    frame.requestFromTick = request.fromTick;
+    frame.fromTick = request.fromTick;
+    frame.latestVerifiedTick = verifiedTick - 1;
+    frame.epoch = gCurrentProcessingEpoch;
+    frame.flags = RespondVerifiedTickBundle::WITH_LOGS;
+
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> out;
+    raw.reserve(RespondVerifiedTickBundle::MAX_RAW_SIZE + RespondVerifiedTickBundle::MAX_TICK_LOG_SIZE);
+    for (uint32_t tick = request.fromTick; tick <= lastTick; tick++)
+    {
+        appendTickBundleRecord(tick, raw);
+        if (raw.size() >= RespondVerifiedTickBundle::MAX_RAW_SIZE && tick != lastTick)
+        {
+            frame.toTick = tick;
+            sendTickBundleFrame(conn, frame, raw, out);
+            raw.clear();
+            frame.fromTick = tick + 1;
+        }
+    }
+    // the last frame tells the peer how far we are, even when it carries no tick
+    frame.toTick = lastTick;
+    frame.flags |= RespondVerifiedTickBundle::LAST_FRAME;
+    if (raw.empty()) frame.fromTick = frame.toTick = 0;
+    sendTickBundleFrame(conn, frame, raw, out);
+}
+
+struct TickBundleJob
+{
+    QCPtr conn;
+    uint32_t dejavu;
+    RequestVerifiedTickBundle request;
+};
+// Bundles are built by TickBundleServerThread, one at a time, so bundle requests cannot tie up the
+// request processors with MBs of DB reads. At most this many requests wait, one per connection.
+static constexpr size_t MAX_QUEUED_TICK_BUNDLES = 4;
+static std::mutex tickBundleJobsMtx;
+static std::condition_variable tickBundleJobsCv;
+static std::deque<TickBundleJob> tickBundleJobs;
+
+static void queueTickBundle(QCPtr& conn, uint32_t dejavu, uint8_t* ptr)
+{
+    TickBundleJob job{conn, dejavu, {}};
+    memcpy((void*)&job.request, ptr, sizeof(job.request));
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(tickBundleJobsMtx);
+        const bool pending = std::any_of(tickBundleJobs.begin(), tickBundleJobs.end(),
+                                         [&](const TickBundleJob& j) { return j.conn == conn; });
+        if (!pending && tickBundleJobs.size() < MAX_QUEUED_TICK_BUNDLES)
+        {
+            tickBundleJobs.push_back(std::move(job));
+            queued = true;
+        }
+    }
+    if (!queued)
+    {
+        // busy: the peer's request times out into a retry, most likely on another bob
+        conn->sendEndPacket(dejavu);
+        return;
+    }
+    tickBundleJobsCv.notify_one();
+}
+
+void TickBundleServerThread(std::atomic_bool& exitFlag)
+{
+    while (!exitFlag.load())
+    {
+        TickBundleJob job;
+        {
+            std::unique_lock<std::mutex> lock(tickBundleJobsMtx);
+            if (!tickBundleJobsCv.wait_for(lock, std::chrono::milliseconds(100), [] { return !tickBundleJobs.empty(); }))
+            {
+                continue;
+            }
+            job = std::move(tickBundleJobs.front());
+            tickBundleJobs.pop_front();
+        }
+        replyVerifiedTickBundle(job.conn, job.dejavu, job.request);
+    }
+    std::lock_guard<std::mutex> lock(tickBundleJobsMtx);
+    tickBundleJobs.clear();
+}
+
+// Fast sync for new bobs: one chunk of a saved verified spectrum/universe checkpoint.
+void replyStateCheckpoint(QCPtr& conn, uint32_t dejavu, uint8_t* ptr)
+{
+    RequestStateCheckpoint request;
+    memcpy((void*)&request, ptr, sizeof(request));
+    const long long latestVerified = db_get_latest_verified_tick();
+    if (computorsList.epoch == 0 || latestVerified < (long long)gInitialTick || request.part > RequestStateCheckpoint::UNIVERSE)
+    {
+        conn->sendEndPacket(dejavu);
+        return;
+    }
+    const uint32_t tick = request.tick ? request.tick : (uint32_t)latestVerified;
+    const bool isSpectrum = request.part == RequestStateCheckpoint::SPECTRUM;
+    const uint64_t fileSize = isSpectrum ? SPECTRUM_CAPACITY * 64 : ASSETS_CAPACITY * 48; // same layout as GlobalState
+    const uint32_t chunkCount = (fileSize + RequestStateCheckpoint::CHUNK_SIZE - 1) / RequestStateCheckpoint::CHUNK_SIZE;
+    if (tick < gInitialTick || request.chunk >= chunkCount)
+    {
+        conn->sendEndPacket(dejavu);
+        return;
+    }
+    // checkpoints are rotated by saveState; a vanished one makes the peer start over with the latest
+    const std::string path = (isSpectrum ? "spectrum." : "universe.") + std::to_string(tick);
+    const uint64_t offset = uint64_t(request.chunk) * RequestStateCheckpoint::CHUNK_SIZE;
+    std::vector<uint8_t> raw(std::min<uint64_t>(RequestStateCheckpoint::CHUNK_SIZE, fileSize - offset));
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f)
+    {
+        conn->sendEndPacket(dejavu);
+        return;
+    }
+    const bool ok = fseeko(f, (off_t)offset, SEEK_SET) == 0 && fread(raw.data(), 1, raw.size(), f) == raw.size();
+    fclose(f);
+    if (!ok)
+    {
+        conn->sendEndPacket(dejavu);
+        return;
+    }
+
+    RespondStateCheckpoint resp{};
+    resp.tick = tick;
+    resp.chunk = request.chunk;
+    resp.chunkCount = chunkCount;
+    resp.rawSize = raw.size();
+    resp.epoch = gCurrentProcessingEpoch;
+    resp.part = request.part;
+    const size_t headerSize = sizeof(RequestResponseHeader) + sizeof(RespondStateCheckpoint);
+    std::vector<uint8_t> out(headerSize + ZSTD_compressBound(raw.size()));
+    // level 1: the state is mostly empty slots, higher levels only cost server time
+    const size_t cSize = ZSTD_compress(out.data() + headerSize, out.size() - headerSize, raw.data(), raw.size(), 1);
+    if (ZSTD_isError(cSize) || headerSize + cSize > RequestResponseHeader::max_size)
+    {
+        conn->sendEndPacket(dejavu);
+        return;
+    }
+    RequestResponseHeader hdr{};
+    hdr.setType(RespondStateCheckpoint::type());
+    hdr.setDejavu(dejavu);
+    hdr.setSize(headerSize + cSize);
+    memcpy(out.data(), &hdr, sizeof(hdr));
+    memcpy(out.data() + sizeof(hdr), &resp, sizeof(resp));
+    conn->enqueueSend(out.data(), headerSize + cSize);
+}
+
 void RequestProcessorThread(std::atomic_bool& exitFlag)
 {
     std::vector<uint8_t> buf;
@@ -479,9 +924,8 @@ void RequestProcessorThread(std::atomic_bool& exitFlag)
         auto type = header.type();
         ptr += 8;
 
-        std::vector<uint8_t> ignore;
         QCPtr conn;
-        requestMapperTo.get(header.getDejavu(), ignore, conn);
+        requestMapperTo.getConn(header.getDejavu(), conn);
         if (conn == nullptr) continue;
         switch (type)
         {
@@ -506,6 +950,12 @@ void RequestProcessorThread(std::atomic_bool& exitFlag)
             case RequestAllLogIdRangesFromTick::type(): // logID ranges
                 replyLogRange(conn, header.getDejavu(), ptr);
                 break;
+            case RequestVerifiedTickBundle::type(): // bulk sync
+                queueTickBundle(conn, header.getDejavu(), ptr);
+                break;
+            case RequestStateCheckpoint::type(): // fast sync
+                replyStateCheckpoint(conn, header.getDejavu(), ptr);
+                break;
             default:
                 break;
         }
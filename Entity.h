@@ -42,18 +42,24 @@ static void increaseEnergy(const m256i& publicKey, long long amount, uint32_t ti
         iteration:
         if (spectrum[index].publicKey == publicKey)
         {
+            undoJournal.saveSpectrum(index, &spectrum[index]);
             spectrum[index].incomingAmount += amount;
             spectrum[index].numberOfIncomingTransfers++;
             spectrum[index].latestIncomingTransferTick = tick;
+            richList.setQu(publicKey, energy(index));
+            stateJournal.record(StateJournal::QU, index, energy(index) - amount, energy(index));
         }
         else
         {
             if (isZero(spectrum[index].publicKey))
             {
+                undoJournal.saveSpectrum(index, &spectrum[index]);
                 spectrum[index].publicKey = publicKey;
                 spectrum[index].incomingAmount = amount;
                 spectrum[index].numberOfIncomingTransfers = 1;
                 spectrum[index].latestIncomingTransferTick = tick;
+                richList.setQu(publicKey, amount);
+                stateJournal.record(StateJournal::QU, index, 0, amount);
             }
             else
             {
@@ -71,9 +77,12 @@ static bool decreaseEnergy(const int index, long long amount, uint32_t tick)
     {
         if (energy(index) >= amount)
         {
+            undoJournal.saveSpectrum(index, &spectrum[index]);
             spectrum[index].outgoingAmount += amount;
             spectrum[index].numberOfOutgoingTransfers++;
             spectrum[index].latestOutgoingTransferTick = tick;
+            richList.setQu(spectrum[index].publicKey, energy(index));
+            stateJournal.record(StateJournal::QU, index, energy(index) + amount, energy(index));
             return true;
         }
     }
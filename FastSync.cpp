@@ -0,0 +1,267 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "connection/connection.h"
+#include "structs.h"
+#include "GlobalVar.h"
+#include "Logger.h"
+#include "database/db.h"
+#include "K12AndKeyUtil.h"
+#include "Entity.h"
+#include "Asset.h"
+#include "shim.h"
+#include "zstd.h"
+
+using namespace std::chrono_literals;
+
+// Fast sync: a fresh bob starts from the latest verified spectrum/universe checkpoint of a bob peer
+// instead of replaying every log of the epoch. The checkpoint is only accepted if its recomputed
+// digests match the salted digests of a vote quorum for the checkpoint tick. The ticks before the
+// checkpoint are backfilled afterwards from bob peers with tick bundles.
+
+bool verifySignature(void* ptr, uint8_t* pubkey, int structSize);
+void computeSpectrumDigest(const uint32_t tickStart, const uint32_t tickEnd);
+m256i getUniverseDigest(const uint32_t tickStart, const uint32_t tickEnd);
+void saveFiles(const std::string tickSpectrum, const std::string tickUniverse);
+uint32_t indexTickRange(uint32_t fromTick, uint32_t toTick, const std::atomic_bool& stopFlag);
+
+// A checkpoint this close to the initial tick is cheaper to replay
+static constexpr uint32_t kMinTicksToSkip = 1000;
+// Chunk requests kept in flight while downloading a checkpoint
+static constexpr uint32_t kCheckpointWindow = 4;
+static constexpr int kMaxIdlePackets = 200;
+
+static std::string backfillFromKey() { return "backfill_from:" + std::to_string(gCurrentProcessingEpoch); }
+static std::string backfillToKey() { return "backfill_to:" + std::to_string(gCurrentProcessingEpoch); }
+
+/**
+ * @brief Downloads one checkpoint file into dst. Bootstrap only: reads the connection directly.
+ * @param tick Checkpoint tick to download; 0 asks for the latest one and receives its tick.
+ * @return False if the peer can't serve the whole file.
+ */
+static bool downloadCheckpointPart(QubicConnection& conn, uint32_t& tick, uint8_t part, uint8_t* dst, uint64_t size)
+{
+    const uint32_t chunkCount = (size + RequestStateCheckpoint::CHUNK_SIZE - 1) / RequestStateCheckpoint::CHUNK_SIZE;
+    std::vector<uint8_t> done(chunkCount, 0);
+    uint32_t nextChunk = 0;
+    uint32_t received = 0;
+    int idle = 0;
+    auto requestChunk = [&](uint32_t chunk) {
+        RequestStateCheckpoint req{};
+        req.tick = tick;
+        req.chunk = chunk;
+        req.part = part;
+        conn.enqueueWithHeader((uint8_t*)&req, sizeof(req), RequestStateCheckpoint::type(), true);
+    };
+
+    std::vector<uint8_t> packet;
+    while (received < chunkCount)
+    {
+        // the first answer tells which tick "latest" is, only then the window opens
+        const uint32_t window = tick ? kCheckpointWindow : 1;
+        while (nextChunk < chunkCount && nextChunk - received < window) requestChunk(nextChunk++);
+
+        RequestResponseHeader header{};
+        conn.receiveAFullPacket(header, packet);
+        if (packet.empty()) return false;
+        if (header.type() == 35) return false; // end packet: the peer can't serve this chunk
+        if (header.type() != RespondStateCheckpoint::type() ||
+            packet.size() < sizeof(RequestResponseHeader) + sizeof(RespondStateCheckpoint))
+        {
+            if (++idle > kMaxIdlePackets) return false;
+            continue;
+        }
+        RespondStateCheckpoint resp{};
+        memcpy((void*)&resp, packet.data() + sizeof(RequestResponseHeader), sizeof(resp));
+        if (resp.epoch != gCurrentProcessingEpoch || resp.part != part || resp.chunkCount != chunkCount ||
+            resp.chunk >= chunkCount || (tick && resp.tick != tick))
+        {
+            return false;
+        }
+        tick = resp.tick;
+        const uint64_t offset = uint64_t(resp.chunk) * RequestStateCheckpoint::CHUNK_SIZE;
+        const uint64_t expected = std::min<uint64_t>(RequestStateCheckpoint::CHUNK_SIZE, size - offset);
+        const size_t headerSize = sizeof(RequestResponseHeader) + sizeof(RespondStateCheckpoint);
+        const size_t dSize = ZSTD_decompress(dst + offset, expected, packet.data() + headerSize, packet.size() - headerSize);
+        if (ZSTD_isError(dSize) || dSize != expected || resp.rawSize != expected) return false;
+        if (!done[resp.chunk])
+        {
+            done[resp.chunk] = 1;
+            received++;
+        }
+        idle = 0;
+    }
+    return true;
+}
+
+// Votes of one tick with a valid computor signature, at most one per computor.
+static std::vector<TickVote> downloadVotes(QubicConnection& conn, uint32_t tick)
+{
+    std::vector<TickVote> votes;
+    std::vector<uint8_t> seen(NUMBER_OF_COMPUTORS, 0);
+    RequestedQuorumTick rqt{};
+    rqt.tick = tick;
+    conn.enqueueWithHeader((uint8_t*)&rqt, sizeof(rqt), RequestedQuorumTick::type, true);
+
+    std::vector<uint8_t> packet;
+    for (int i = 0; i < NUMBER_OF_COMPUTORS + kMaxIdlePackets; i++)
+    {
+        RequestResponseHeader header{};
+        conn.receiveAFullPacket(header, packet);
+        if (packet.empty() || header.type() == 35) break;
+        if (header.type() != BROADCAST_TICK_VOTE || packet.size() != sizeof(RequestResponseHeader) + sizeof(TickVote)) continue;
+        TickVote vote;
+        memcpy((void*)&vote, packet.data() + sizeof(RequestResponseHeader), sizeof(TickVote));
+        if (vote.tick != tick || vote.epoch != gCurrentProcessingEpoch || vote.computorIndex >= NUMBER_OF_COMPUTORS) continue;
+        if (seen[vote.computorIndex]) continue;
+        uint8_t* compPubkey = computorsList.publicKeys[vote.computorIndex].m256i_u8;
+        vote.computorIndex ^= 3;
+        const bool ok = verifySignature((void*)&vote, compPubkey, sizeof(TickVote));
+        vote.computorIndex ^= 3;
+        if (!ok) continue;
+        seen[vote.computorIndex] = 1;
+        votes.push_back(vote);
+    }
+    return votes;
+}
+
+// Same quorum rule as the log verifier: 451 matching votes for a non-empty tick, 226 for an empty one.
+static bool stateMatchesQuorum(const std::vector<TickVote>& votes, const m256i& spectrumDigest, const m256i& universeDigest)
+{
+    int emptyTick = 0, nonEmptyTick = 0, matched = 0;
+    m256i saltedDataSpectrum[2];
+    m256i saltedDataUniverse[2];
+    saltedDataSpectrum[1] = spectrumDigest;
+    saltedDataUniverse[1] = universeDigest;
+    for (const auto& vote : votes)
+    {
+        if (vote.transactionDigest == m256i::zero()) emptyTick++;
+        else nonEmptyTick++;
+        saltedDataSpectrum[0] = computorsList.publicKeys[vote.computorIndex];
+        saltedDataUniverse[0] = computorsList.publicKeys[vote.computorIndex];
+        m256i salted;
+        KangarooTwelve((uint8_t*)saltedDataSpectrum, 64, salted.m256i_u8, 32);
+        if (salted != vote.saltedSpectrumDigest) continue;
+        KangarooTwelve((uint8_t*)saltedDataUniverse, 64, salted.m256i_u8, 32);
+        if (salted != vote.saltedUniverseDigest) continue;
+        matched++;
+    }
+    if (nonEmptyTick >= 451) return matched >= 451;
+    if (emptyTick >= 226) return matched >= 226;
+    return false;
+}
+
+bool fastSyncFromBobPeer(ConnectionPool& cp)
+{
+    for (int i = 0; i < (int)cp.size(); i++)
+    {
+        auto& conn = cp.get(i);
+        if (!conn->isBob() || !conn->isSocketValid()) continue;
+        try {
+            uint32_t tick = 0;
+            Logger::get()->info("Fast sync: downloading spectrum checkpoint from {}", conn->getNodeIp());
+            if (!downloadCheckpointPart(*conn, tick, RequestStateCheckpoint::SPECTRUM, (uint8_t*)spectrum, SPECTRUM_CAPACITY * sizeof(EntityRecord)))
+            {
+                Logger::get()->warn("Fast sync: {} has no usable spectrum checkpoint", conn->getNodeIp());
+                continue;
+            }
+            if (tick < gInitialTick + kMinTicksToSkip)
+            {
+                Logger::get()->info("Fast sync: checkpoint {} of {} is too close to the initial tick", tick, conn->getNodeIp());
+                continue;
+            }
+            Logger::get()->info("Fast sync: downloading universe checkpoint {}", tick);
+            if (!downloadCheckpointPart(*conn, tick, RequestStateCheckpoint::UNIVERSE, (uint8_t*)assets, ASSETS_CAPACITY * sizeof(AssetRecord)))
+            {
+                Logger::get()->warn("Fast sync: {} has no usable universe checkpoint {}", conn->getNodeIp(), tick);
+                continue;
+            }
+            auto votes = downloadVotes(*conn, tick);
+            computeSpectrumDigest(UINT32_MAX, UINT32_MAX);
+            const m256i spectrumDigest = spectrumDigests[(SPECTRUM_CAPACITY * 2 - 1) - 1];
+            const m256i universeDigest = getUniverseDigest(UINT32_MAX, UINT32_MAX);
+            if (!stateMatchesQuorum(votes, spectrumDigest, universeDigest))
+            {
+                Logger::get()->warn("Fast sync: checkpoint {} from {} doesn't match the quorum ({} votes)", tick, conn->getNodeIp(), votes.size());
+                continue;
+            }
+
+            // from here the node looks as if it had verified everything up to the checkpoint
+            saveFiles("spectrum." + std::to_string(tick), "universe." + std::to_string(tick));
+            for (const auto& vote : votes) db_insert_tick_vote(vote);
+            db_insert_u32("verified_history:" + std::to_string(gCurrentProcessingEpoch), tick);
+            StatusCommit commit;
+            commit.epoch = gCurrentProcessingEpoch;
+            commit.latestTick = tick;
+            commit.latestVerifiedTick = tick;
+            commit.lastIndexedTick = tick;
+            db_commit_status(commit);
+            db_update_latest_event_tick_and_epoch(tick, gCurrentProcessingEpoch);
+            gCurrentFetchingTick = tick + 1;
+            gCurrentFetchingLogTick = tick + 1;
+
+            // older ticks would be cleaned right away in lastNTick mode, skip them
+            uint32_t backfillFrom = gInitialTick;
+            if (gTickStorageMode == TickStorageMode::LastNTick && tick > gLastNTickStorage)
+            {
+                backfillFrom = std::max<uint32_t>(backfillFrom, tick - gLastNTickStorage);
+            }
+            db_insert_u32(backfillFromKey(), backfillFrom);
+            db_insert_u32(backfillToKey(), tick + 1);
+            Logger::get()->info("Fast sync: starting from verified checkpoint {}, backfilling ticks {}->{}", tick, backfillFrom, tick);
+            return true;
+        } catch (...) {
+            Logger::get()->warn("Fast sync: connection error with {}", conn->getNodeIp());
+            SLEEP(1000);
+            conn->reconnect();
+        }
+    }
+    return false;
+}
+
+// Lazily fetch the ticks skipped by fast sync from bob peers, one bundle at a time.
+// processVerifiedTickBundle moves gBackfillFromTick past a bundle once all of its frames arrived intact.
+// The indexer started at the checkpoint, so every completed range is indexed here; the saved backfill
+// head only moves past indexed ticks, a restart re-indexes the rest.
+void backfillThread(ConnectionPool& cp, std::atomic_bool& stopFlag)
+{
+    uint32_t from = 0, to = 0;
+    if (!db_get_u32(backfillFromKey(), from) || !db_get_u32(backfillToKey(), to) || from >= to) return;
+    gBackfillToTick = to;
+    gBackfillFromTick = from;
+    Logger::get()->info("Backfilling ticks {}->{}", from, to - 1);
+
+    const uint32_t bundleTicks = 32;
+    const auto bundleTimeout = 5000ms;
+    uint32_t indexed = from;
+    while (!stopFlag.load(std::memory_order_relaxed) && !gIsEndEpoch)
+    {
+        from = gBackfillFromTick;
+        if (from > indexed)
+        {
+            const uint32_t reached = indexTickRange(indexed, from, stopFlag);
+            db_insert_u32(backfillFromKey(), reached);
+            Logger::get()->debug("Backfill: indexed ticks {}->{}", indexed, reached - 1);
+            indexed = reached;
+            continue;
+        }
+        if (from >= to) break;
+        InflightRegistry::Key key{RequestVerifiedTickBundle::type(), from, 0};
+        const QubicConnection* avoid = nullptr;
+        if (inflightRequests.shouldSend(key, bundleTimeout, avoid))
+        {
+            RequestVerifiedTickBundle rvb{from, std::min(from + bundleTicks, to) - 1};
+            const QubicConnection* chosen = nullptr;
+            cp.sendToRandomBob((uint8_t*)&rvb, sizeof(rvb), RequestVerifiedTickBundle::type(), true, avoid, &chosen);
+            inflightRequests.markSent(key, chosen);
+        }
+        SLEEP(200);
+    }
+    if (indexed >= to)
+    {
+        gBackfillToTick = 0;
+        Logger::get()->info("Backfill finished up to tick {}", to - 1);
+    }
+}
@@ -1,18 +1,133 @@
 #include "GlobalVar.h"
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
-GlobalState& GS() {
-    // Allocate once on the heap to avoid gigantic .bss/.data sections.
-    static GlobalState* inst = []() -> GlobalState* {
-        // Use malloc to avoid throwing in low-memory situations; then zero memory.
-        void* mem = std::malloc(sizeof(GlobalState));
+namespace {
+    HugePageMode gStateHugePageMode = HugePageMode::Auto;
+    int gStateNumaNode = -1;
+    std::string gStateMemoryInfo = "not allocated";
+
+    constexpr size_t kHugePage2M = 2ull << 20;
+    constexpr size_t kHugePage1G = 1ull << 30;
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+
+    size_t roundUp(size_t size, size_t align) { return (size + align - 1) / align * align; }
+
+    // Explicit hugetlb pages; only succeeds if the pool (vm.nr_hugepages or the 1G pool) is large enough.
+    // No MAP_NORESERVE here: without a reservation a fault on an exhausted pool is a SIGBUS.
+    void* mapHugetlb(size_t size, size_t pageSize, int pageShift)
+    {
+#ifdef MAP_HUGETLB
+        void* p = mmap(nullptr, roundUp(size, pageSize), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (pageShift << MAP_HUGE_SHIFT), -1, 0);
+        return p == MAP_FAILED ? nullptr : p;
+#else
+        (void)size; (void)pageSize; (void)pageShift;
+        return nullptr;
+#endif
+    }
+
+    // Regular anonymous mapping aligned to 2 MiB so transparent huge pages can back all of it.
+    void* mapAligned(size_t size, bool adviseHuge, bool& advised)
+    {
+        const size_t mapped = roundUp(size, kHugePage2M) + kHugePage2M;
+        void* raw = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (raw == MAP_FAILED) return nullptr;
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+        const uintptr_t aligned = roundUp(begin, kHugePage2M);
+        const size_t used = roundUp(size, kHugePage2M);
+        if (aligned > begin) munmap(raw, aligned - begin);
+        const uintptr_t end = begin + mapped;
+        if (end > aligned + used) munmap(reinterpret_cast<void*>(aligned + used), end - (aligned + used));
+        advised = false;
+#ifdef MADV_HUGEPAGE
+        if (adviseHuge) advised = madvise(reinterpret_cast<void*>(aligned), used, MADV_HUGEPAGE) == 0;
+#endif
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Pages are placed on first touch, so binding before the constructor runs covers the whole state.
+    bool bindToNode(void* p, size_t size, int node)
+    {
+#ifdef SYS_mbind
+        if (node < 0 || node >= 64) return false;
+        unsigned long mask = 1UL << node;
+        return syscall(SYS_mbind, p, size, MPOL_BIND, &mask, sizeof(mask) * 8, 0) == 0;
+#else
+        (void)p; (void)size; (void)node;
+        return false;
+#endif
+    }
+
+    GlobalState* allocateGlobalState()
+    {
+        const size_t size = sizeof(GlobalState);
+        void* mem = nullptr;
+        size_t length = size;
+        std::string backing;
+        if (gStateHugePageMode == HugePageMode::Auto) {
+            if ((mem = mapHugetlb(size, kHugePage1G, 30))) {
+                backing = "hugetlb 1GiB pages";
+                length = roundUp(size, kHugePage1G);
+            } else if ((mem = mapHugetlb(size, kHugePage2M, 21))) {
+                backing = "hugetlb 2MiB pages";
+                length = roundUp(size, kHugePage2M);
+            }
+        }
         if (!mem) {
-            // If you have a logger available here, you could log and abort.
-            std::abort();
+            bool advised = false;
+            mem = mapAligned(size, gStateHugePageMode != HugePageMode::Off, advised);
+            length = roundUp(size, kHugePage2M);
+            if (gStateHugePageMode == HugePageMode::Off) backing = "regular pages (huge pages disabled)";
+            else if (advised) backing = "transparent huge pages (madvise)";
+            else backing = "regular pages (huge pages unavailable)";
         }
-        std::memset(mem, 0, sizeof(GlobalState));
-        // Placement-new is optional since GlobalState is trivially constructible.
-        return new (mem) GlobalState();
-    }();
-    return *inst;
+        if (!mem) {
+            const int mmapError = errno;
+            // Use malloc to avoid throwing in low-memory situations; then zero memory.
+            mem = std::malloc(size);
+            if (!mem) {
+                std::abort();
+            }
+            std::memset(mem, 0, size);
+            backing = "heap (mmap failed: " + std::string(strerror(mmapError)) + ")";
+            length = size;
+        }
+        if (gStateNumaNode >= 0) {
+            backing += bindToNode(mem, length, gStateNumaNode)
+                       ? ", bound to NUMA node " + std::to_string(gStateNumaNode)
+                       : ", NUMA binding to node " + std::to_string(gStateNumaNode) + " failed";
+        }
+        gStateMemoryInfo = std::to_string(size >> 20) + " MiB on " + backing;
+        // Anonymous mappings are zero-filled: default-initialize so untouched pages stay unmapped until used.
+        return new (mem) GlobalState;
+    }
 }
 
+void configureGlobalStateMemory(HugePageMode mode, int numaNode)
+{
+    gStateHugePageMode = mode;
+    gStateNumaNode = numaNode;
+}
+
+std::string globalStateMemoryInfo()
+{
+    GS();
+    return gStateMemoryInfo;
+}
+
+GlobalState& GS() {
+    // Allocate once, outside of .bss/.data, with huge pages where possible.
+    static GlobalState* inst = allocateGlobalState();
+    return *inst;
+}
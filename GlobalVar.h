@@ -5,6 +5,12 @@
 #include "structs.h"
 #include "SpecialBufferStructs.h"
 #include "RequestMap.h"
+#include "InflightRegistry.h"
+#include "LogFetchWindow.h"
+#include "AssetIndex.h"
+#include "RichList.h"
+#include "StateJournal.h"
+#include "UndoJournal.h"
 #include "common_def.h"
 #include <atomic>
 #include <chrono>
@@ -17,6 +23,12 @@ struct GlobalState {
     RequestMap requestMapperFrom;
     RequestMap requestMapperTo;
     RequestMap responseSCData;
+    InflightRegistry inflightRequests;
+    LogFetchWindow logFetchWindow;
+    AssetHolderIndex assetHolderIndex;
+    RichList richList;
+    StateJournal stateJournal;
+    UndoJournal undoJournal;
 
     std::atomic<uint32_t> gCurrentProcessingTick{0};
     std::atomic<uint16_t> gCurrentProcessingEpoch{0};
@@ -24,6 +36,13 @@ struct GlobalState {
     std::atomic<uint32_t> gCurrentLoggingEventTick{0};
     std::atomic<uint32_t> gCurrentVerifyLoggingTick{0};
     std::atomic<uint32_t> gCurrentIndexingTick{0};
+    std::atomic<uint32_t> gBundlePeerClaimedTick{0};  // highest verified tick announced by a bob peer in a bundle frame
+    std::atomic<uint32_t> gBundlePeerVerifiedTick{0}; // the latest of those claims backed by signed computor votes
+    // ticks [from, to) skipped by fast sync, accepted by the data processors while they are backfilled
+    std::atomic<uint32_t> gBackfillFromTick{0};
+    std::atomic<uint32_t> gBackfillToTick{0};
+    // epoch whose initial spectrum/universe (and digest trees) are already in memory after an in-process epoch transition
+    std::atomic<uint16_t> gInMemoryStateEpoch{0};
     Computors computorsList{0};
     // Fixed-size global state buffers (no heap allocations)
     uint8_t spectrum[SPECTRUM_CAPACITY * 64]; // 64 is sizeof entity
@@ -57,6 +76,8 @@ struct GlobalState {
     bool gNotSaveTickVote = false;
 
     std::map<m256i, bool> gTrustedEntities;
+    // addresses of inbound peers that may request tick bundles (bundle-peers)
+    std::vector<std::string> gBundlePeers;
 
     TickStorageMode gTickStorageMode = TickStorageMode::LastNTick;
     unsigned gLastNTickStorage = 1000;              // used when mode is LastNTick
@@ -71,11 +92,23 @@ struct GlobalState {
     int gNumBMConnection = 0;
 
     long long gKvrocksTTL = 1814400;
+    int gVtickCompressionLevel = 3;
+    bool gVtickDictionary = true;
 };
 
 // Safe, lazy singleton accessor avoids static init order issues.
 GlobalState& GS();
 
+/**
+ * @brief Chooses the page backing of GlobalState. Only effective before the first GS() call.
+ * @param mode Huge page policy.
+ * @param numaNode NUMA node to bind the state to, or -1 for no binding.
+ */
+void configureGlobalStateMemory(HugePageMode mode, int numaNode);
+
+// Size and page backing of GlobalState, for the startup log. Allocates it if needed.
+std::string globalStateMemoryInfo();
+
 #define SLEEP(x) std::this_thread::sleep_for(std::chrono::milliseconds(x))
 #define BATCH_VERIFICATION 64
 #define QU_TRANSFER 0
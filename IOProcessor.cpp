@@ -132,6 +132,21 @@ void IORequestThread(ConnectionPool& conn_pool, std::atomic_bool& stopFlag, std:
     auto idleBackoff = 10ms;   // Backoff when there's nothing immediate to request
     const auto errorBackoff = 2000ms; // Backoff after an exception
     auto requestClock = std::chrono::high_resolution_clock::now() - requestCycle;
+    const auto inflightTimeout = std::max<std::chrono::milliseconds>(requestCycle * 3, 300ms);
+    // bulk sync from bob peers
+    const uint32_t bundleTicks = 32;
+    const uint32_t bundlesInFlight = 2;
+    const auto bundleTimeout = 3000ms;
+    uint32_t lastPeerTick = 0;
+    auto lastPeerTickChange = std::chrono::steady_clock::now();
+    // a peer's claim under check; bundle frames are not signed, so a claim counts once enough computors
+    // signed votes for that tick to prove the network reached it
+    const long long claimVotes = 226;
+    uint32_t checkedClaim = 0;
+    auto checkedClaimSince = std::chrono::steady_clock::now();
+    auto nextClaimCheck = checkedClaimSince;
+    uint32_t lastFetchingTick = 0;
+    auto lastFetchingTickChange = std::chrono::steady_clock::now();
     while (!stopFlag.load(std::memory_order_relaxed)) {
         if (gIsEndEpoch) break;
 
@@ -164,14 +179,90 @@ void IORequestThread(ConnectionPool& conn_pool, std::atomic_bool& stopFlag, std:
             if (now - requestClock >= requestCycle)
             {
                 requestClock = now;
-                for (uint32_t offset = 0; offset < futureOffset; offset++) {
+                // While a bob peer is well ahead of us, verified ticks come in compressed bundles from
+                // bob peers and the per-item requests are skipped. A peer tick that stops moving means
+                // bundles stopped arriving: fall back to per-item requests.
+                uint32_t peerTick = gBundlePeerVerifiedTick.load();
+                const auto steadyNow = std::chrono::steady_clock::now();
+                const uint32_t claim = gBundlePeerClaimedTick.load();
+                if (claim > peerTick && (checkedClaim <= peerTick || steadyNow - checkedClaimSince > 5s))
+                {
+                    checkedClaim = claim;
+                    checkedClaimSince = steadyNow;
+                }
+                if (checkedClaim > peerTick && checkedClaim > gCurrentFetchingTick + futureOffset &&
+                    steadyNow >= nextClaimCheck)
+                {
+                    nextClaimCheck = steadyNow + 500ms;
+                    if (db_get_tick_vote_count(checkedClaim) >= claimVotes)
+                    {
+                        gBundlePeerVerifiedTick.compare_exchange_strong(peerTick, checkedClaim);
+                        peerTick = gBundlePeerVerifiedTick.load();
+                    }
+                    else
+                    {
+                        InflightRegistry::Key key{RequestedQuorumTick::type, checkedClaim, 0};
+                        const QubicConnection* avoid = nullptr;
+                        if (inflightRequests.shouldSend(key, inflightTimeout, avoid))
+                        {
+                            RequestedQuorumTick rqt{};
+                            rqt.tick = checkedClaim;
+                            memset(rqt.voteFlags, 0, sizeof(rqt.voteFlags));
+                            const QubicConnection* chosen = nullptr;
+                            conn_pool.sendToRandom((uint8_t *) &rqt, sizeof(rqt), RequestedQuorumTick::type, true, avoid, &chosen);
+                            inflightRequests.markSent(key, chosen);
+                        }
+                    }
+                }
+                if (peerTick != lastPeerTick)
+                {
+                    lastPeerTick = peerTick;
+                    lastPeerTickChange = steadyNow;
+                }
+                else if (peerTick != 0 && steadyNow - lastPeerTickChange > 10s)
+                {
+                    gBundlePeerVerifiedTick.compare_exchange_strong(peerTick, 0);
+                    lastPeerTick = peerTick = 0;
+                }
+                if (gCurrentFetchingTick != lastFetchingTick)
+                {
+                    lastFetchingTick = gCurrentFetchingTick;
+                    lastFetchingTickChange = steadyNow;
+                }
+                // a tick the bundles could not complete is filled in by the per-item requests
+                const bool bulkSync = peerTick > gCurrentFetchingTick + futureOffset &&
+                                      steadyNow - lastFetchingTickChange < 5s;
+                // outside bulk sync a single bundle request per tick acts as a probe of the bob peers
+                for (uint32_t i = 0; i < (bulkSync ? bundlesInFlight : 1); i++) {
+                    const uint32_t fromTick = gCurrentFetchingTick + i * bundleTicks;
+                    InflightRegistry::Key key{RequestVerifiedTickBundle::type(), fromTick, 0};
+                    const QubicConnection* avoid = nullptr;
+                    if (inflightRequests.shouldSend(key, bundleTimeout, avoid))
+                    {
+                        RequestVerifiedTickBundle rvb{fromTick, fromTick + bundleTicks - 1};
+                        const QubicConnection* chosen = nullptr;
+                        conn_pool.sendToRandomBob((uint8_t *) &rvb, sizeof(rvb), RequestVerifiedTickBundle::type(), true, avoid, &chosen);
+                        inflightRequests.markSent(key, chosen);
+                    }
+                }
+                // Requests still waiting for an answer are skipped; a request whose peer stayed silent
+                // past its timeout is retried on a different peer.
+                for (uint32_t offset = 0; offset < (bulkSync ? 0 : futureOffset); offset++) {
+                    const uint32_t tick = gCurrentFetchingTick + offset;
                     bool have_next_td = false;
                     {
-                        if (!db_has_tick_data(gCurrentFetchingTick + offset))
+                        if (!db_has_tick_data(tick))
                         {
-                            RequestTickData rtd;
-                            rtd.tick = gCurrentFetchingTick + offset;
-                            conn_pool.sendToMany((uint8_t *) &rtd, sizeof(rtd), 1, RequestTickData::type, true);
+                            InflightRegistry::Key key{RequestTickData::type, tick, 0};
+                            const QubicConnection* avoid = nullptr;
+                            if (inflightRequests.shouldSend(key, inflightTimeout, avoid))
+                            {
+                                RequestTickData rtd;
+                                rtd.tick = tick;
+                                const QubicConnection* chosen = nullptr;
+                                conn_pool.sendToRandom((uint8_t *) &rtd, sizeof(rtd), RequestTickData::type, true, avoid, &chosen);
+                                inflightRequests.markSent(key, chosen);
+                            }
                         } else {
                             have_next_td = true;
                         }
@@ -179,29 +270,38 @@ void IORequestThread(ConnectionPool& conn_pool, std::atomic_bool& stopFlag, std:
 
                     {
                         // tick votes
-                        RequestedQuorumTick rqt{};
-                        rqt.tick = gCurrentFetchingTick + offset;
-                        memset(rqt.voteFlags, 0, sizeof(rqt.voteFlags));
-                        int count = 0;
-                        auto tvs = db_get_tick_votes(gCurrentFetchingTick + offset);
-                        for (auto& tv: tvs) {
-                            int i = tv.computorIndex;
-                            rqt.voteFlags[i >> 3] |= (1 << (i & 7)); // turn on the flag if the vote exists
-                            count++;
-                        }
-                        if (count < 676)
+                        InflightRegistry::Key key{RequestedQuorumTick::type, tick, 0};
+                        const QubicConnection* avoid = nullptr;
+                        if (inflightRequests.shouldSend(key, inflightTimeout, avoid))
                         {
-                            conn_pool.sendToMany((uint8_t *) &rqt, sizeof(rqt), 1, RequestedQuorumTick::type, true);
+                            RequestedQuorumTick rqt{};
+                            rqt.tick = tick;
+                            memset(rqt.voteFlags, 0, sizeof(rqt.voteFlags));
+                            int count = 0;
+                            auto tvs = db_get_tick_votes(tick);
+                            for (auto& tv: tvs) {
+                                int i = tv.computorIndex;
+                                rqt.voteFlags[i >> 3] |= (1 << (i & 7)); // turn on the flag if the vote exists
+                                count++;
+                            }
+                            const QubicConnection* chosen = nullptr;
+                            if (count < 676)
+                            {
+                                conn_pool.sendToRandom((uint8_t *) &rqt, sizeof(rqt), RequestedQuorumTick::type, true, avoid, &chosen);
+                            }
+                            inflightRequests.markSent(key, chosen);
                         }
                     }
 
                     {
                         // transactions: requires to have tickdata
-                        if (have_next_td) {
+                        InflightRegistry::Key key{RequestedTickTransactions::type, tick, 0};
+                        const QubicConnection* avoid = nullptr;
+                        if (have_next_td && inflightRequests.shouldSend(key, inflightTimeout, avoid)) {
                             TickData td{};
-                            db_get_tick_data(gCurrentFetchingTick + offset, td);
+                            db_get_tick_data(tick, td);
                             RequestedTickTransactions rtt;
-                            rtt.tick = gCurrentFetchingTick + offset;
+                            rtt.tick = tick;
                             memset(rtt.flag, 0, sizeof(rtt.flag));
                             int count = 0;
                             for (unsigned int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++) {
@@ -216,10 +316,13 @@ void IORequestThread(ConnectionPool& conn_pool, std::atomic_bool& stopFlag, std:
                                     count++;
                                 }
                             }
-                            if (count) conn_pool.sendToMany((uint8_t *) &rtt, sizeof(rtt), 1, RequestedTickTransactions::type, true);
+                            const QubicConnection* chosen = nullptr;
+                            if (count) conn_pool.sendToRandom((uint8_t *) &rtt, sizeof(rtt), RequestedTickTransactions::type, true, avoid, &chosen);
+                            inflightRequests.markSent(key, chosen);
                         }
                     }
                 }
+                inflightRequests.expire(30s);
             }
             SLEEP(idleBackoff);
         } catch (const std::exception& ex) {
@@ -250,7 +353,10 @@ void IOVerifyThread(std::atomic_bool& stopFlag)
         else
         {
             auto current_tick = gCurrentFetchingTick.load();
-            db_update_latest_tick_and_epoch(gCurrentFetchingTick, gCurrentProcessingEpoch);
+            StatusCommit commit;
+            commit.epoch = gCurrentProcessingEpoch;
+            commit.latestTick = current_tick;
+            db_commit_status(commit);
             Logger::get()->trace("Progress ticking from {} to {}", gCurrentFetchingTick.load(), gCurrentFetchingTick.load() + 1);
             uint32_t tmp_tick;
             uint16_t tmp_epoch;
@@ -276,6 +382,8 @@ static bool isRequestType(int type)
     if (type == RequestedTickTransactions::type) return true;         // request tx
     if (type == RequestLog::type()) return true;                      // request log
     if (type == RequestAllLogIdRangesFromTick::type()) return true;   // request log range
+    if (type == RequestVerifiedTickBundle::type()) return true;       // request tick bundle
+    if (type == RequestStateCheckpoint::type()) return true;          // request state checkpoint
     return false;
 }
 static bool isDataType(int type)
@@ -286,12 +394,13 @@ static bool isDataType(int type)
     if (type == RespondLog::type()) return true;                      // log
     if (type == LogRangesPerTxInTick::type()) return true;  // logrange
     if (type == RespondContractFunction::type) return true;
+    if (type == RespondVerifiedTickBundle::type()) return true;       // tick bundle
     return false;
 }
 
 
 // Receiver thread: continuously receives full packets and enqueues them into the global round buffer (MRB).
-void connReceiver(QCPtr& conn, const bool isTrustedNode, std::atomic_bool& stopFlag)
+void connReceiver(QCPtr& conn, const bool isTrustedNode, const bool isBundlePeer, std::atomic_bool& stopFlag)
 {
     using namespace std::chrono_literals;
 
@@ -307,18 +416,31 @@ void connReceiver(QCPtr& conn, const bool isTrustedNode, std::atomic_bool& stopF
             if (packet.empty()) {
                 // Defensive check; shouldn't happen if receiveAFullPacket succeeds.
                 if (!conn->isReconnectable()) return;
+                conn->recordError();
                 Logger::get()->trace("connReceiver error on : {}. Disconnecting", conn->getNodeIp());
                 conn->disconnect();
                 SLEEP(errorBackoff);
                 conn->reconnect();
                 continue;
             }
+            conn->recordReceived(hdr.getDejavu(), static_cast<uint32_t>(packet.size()));
+            if (!isBundlePeer && hdr.type() == RequestVerifiedTickBundle::type())
+            {
+                continue; // bundles are built only for known peers
+            }
             if (!isTrustedNode)
             {
                 if (!checkAllowedTypeForNonTrusted(hdr.type()))
                 {
                     continue; //drop
                 }
+                if (hdr.type() == RespondVerifiedTickBundle::type() &&
+                    packet.size() >= sizeof(RequestResponseHeader) + sizeof(RespondVerifiedTickBundle))
+                {
+                    // logs are only taken from trusted nodes
+                    auto* frame = reinterpret_cast<RespondVerifiedTickBundle*>(packet.data() + sizeof(RequestResponseHeader));
+                    frame->flags &= ~RespondVerifiedTickBundle::WITH_LOGS;
+                }
             }
             // trusted conn allowed all packets
             if (isDataType(hdr.type()))
@@ -348,12 +470,14 @@ void connReceiver(QCPtr& conn, const bool isTrustedNode, std::atomic_bool& stopF
 
         } catch (const std::logic_error& ex) {
             if (!conn->isReconnectable()) return;
+            conn->recordError();
             Logger::get()->trace("connReceiver error on : {}. Disconnecting", conn->getNodeIp());
             conn->disconnect();
             SLEEP(errorBackoff);
             conn->reconnect();
         } catch (...) {
             if (!conn->isReconnectable()) return;
+            conn->recordError();
             Logger::get()->trace("connReceiver unknown exception from ip {}", conn->getNodeIp());
             conn->disconnect();
             SLEEP(errorBackoff);
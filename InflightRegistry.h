@@ -0,0 +1,212 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class QubicConnection;
+
+// Registry of outstanding requests to peers.
+// usage: the periodic request loops ask shouldSend() before re-sending a request, so an
+// identical request that is still in flight is not sent again every cycle. Data processors
+// call touch()/complete() when a matching response arrives. A request that sees no response
+// within its timeout is released again with an exponential backoff and the caller is told
+// which peer to avoid on the retry.
+// Timeouts are per peer: every response updates a smoothed round-trip estimate for the peer
+// the request went to.
+class InflightRegistry
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Key
+    {
+        uint32_t type;  // request packet type
+        uint64_t a;     // tick, or first id of a range
+        uint64_t b;     // sub-key: chunk start, last id of a range, or 0
+
+        bool operator<(const Key& other) const
+        {
+            if (type != other.type) return type < other.type;
+            if (a != other.a) return a < other.a;
+            return b < other.b;
+        }
+    };
+
+    static constexpr int kMaxBackoffShift = 2;
+    static constexpr std::chrono::milliseconds kMaxTimeout{10000};
+
+    /**
+     * @brief Decides whether a request must be (re)sent now and, if so, records the attempt.
+     * @param key Request identity.
+     * @param baseTimeout Minimum time to wait for a response before retrying.
+     * @param avoidPeer Receives the peer used by the previous attempt (nullptr for a first attempt).
+     * @return True if the caller should send the request and then call markSent().
+     */
+    bool shouldSend(const Key& key, std::chrono::milliseconds baseTimeout, const QubicConnection*& avoidPeer)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        const auto now = Clock::now();
+        avoidPeer = nullptr;
+
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            Entry& e = it->second;
+            if (now < e.deadline) {
+                suppressed_++;
+                return false;
+            }
+            avoidPeer = e.peer;
+            e.attempts++;
+            retried_++;
+        } else {
+            it = entries_.emplace(key, Entry{}).first;
+        }
+        Entry& e = it->second;
+        e.sentAt = now;
+        e.lastProgress = now;
+        e.responded = false;
+        e.peer = nullptr;
+        e.deadline = now + timeoutFor(nullptr, baseTimeout, e.attempts);
+        e.baseTimeout = baseTimeout;
+        sent_++;
+        return true;
+    }
+
+    // Records which peer the attempt went to; a null peer (nothing could be sent) releases the key.
+    void markSent(const Key& key, const QubicConnection* peer)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) return;
+        if (peer == nullptr) {
+            entries_.erase(it);
+            return;
+        }
+        Entry& e = it->second;
+        e.peer = peer;
+        e.deadline = e.sentAt + timeoutFor(peer, e.baseTimeout, e.attempts);
+    }
+
+    // A partial response for every request (type, a, *) arrived: extend their deadlines.
+    void touch(uint32_t type, uint64_t a)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        const auto now = Clock::now();
+        for (auto it = entries_.lower_bound(Key{type, a, 0});
+             it != entries_.end() && it->first.type == type && it->first.a == a; ++it) {
+            Entry& e = it->second;
+            sampleRtt(e, now);
+            e.attempts = 0;
+            e.lastProgress = now;
+            e.deadline = now + timeoutFor(e.peer, e.baseTimeout, 0);
+        }
+    }
+
+    // The request is fully answered.
+    void complete(const Key& key)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) return;
+        sampleRtt(it->second, Clock::now());
+        entries_.erase(it);
+    }
+
+    // Every request (type, a, *) is fully answered.
+    void completeAll(uint32_t type, uint64_t a)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        const auto now = Clock::now();
+        auto it = entries_.lower_bound(Key{type, a, 0});
+        while (it != entries_.end() && it->first.type == type && it->first.a == a) {
+            sampleRtt(it->second, now);
+            it = entries_.erase(it);
+        }
+    }
+
+    // The peer disconnected or was replaced: drop its round-trip estimate and release the requests waiting
+    // on it, so they are retried on the next cycle.
+    void forgetPeer(const QubicConnection* peer)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        peerRttMs_.erase(peer);
+        const auto now = Clock::now();
+        for (auto& kv : entries_) {
+            Entry& e = kv.second;
+            if (e.peer != peer) continue;
+            e.peer = nullptr;
+            e.deadline = now;
+        }
+    }
+
+    // Forget requests that made no progress for longer than idle (e.g. ticks we moved past).
+    void expire(std::chrono::milliseconds idle)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        const auto now = Clock::now();
+        for (auto it = entries_.begin(); it != entries_.end(); ) {
+            if (now - it->second.lastProgress > idle) it = entries_.erase(it);
+            else ++it;
+        }
+    }
+
+    /**
+     * @brief Returns a string with in-flight count and send/retry/suppress counters since the last call.
+     */
+    std::string GetUsageString()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        std::string s = "Inflight: " + std::to_string(entries_.size()) +
+                        " | sent " + std::to_string(sent_) +
+                        " | retried " + std::to_string(retried_) +
+                        " | suppressed " + std::to_string(suppressed_);
+        sent_ = retried_ = suppressed_ = 0;
+        return s;
+    }
+
+private:
+    struct Entry
+    {
+        Clock::time_point sentAt{};
+        Clock::time_point lastProgress{};
+        Clock::time_point deadline{};
+        std::chrono::milliseconds baseTimeout{0};
+        const QubicConnection* peer = nullptr;
+        int attempts = 0;
+        bool responded = false;
+    };
+
+    // Caller holds mtx_.
+    std::chrono::milliseconds timeoutFor(const QubicConnection* peer, std::chrono::milliseconds base, int attempts) const
+    {
+        auto t = base;
+        if (peer != nullptr) {
+            auto it = peerRttMs_.find(peer);
+            if (it != peerRttMs_.end()) t = std::max(t, std::chrono::milliseconds((long long)(it->second * 4)));
+        }
+        t *= (1 << std::min(attempts, kMaxBackoffShift));
+        return std::min(t, kMaxTimeout);
+    }
+
+    // Caller holds mtx_. Only the first response of an attempt is a round-trip sample.
+    void sampleRtt(Entry& e, Clock::time_point now)
+    {
+        if (e.responded || e.peer == nullptr) return;
+        e.responded = true;
+        const double ms = std::chrono::duration<double, std::milli>(now - e.sentAt).count();
+        auto it = peerRttMs_.find(e.peer);
+        if (it == peerRttMs_.end()) peerRttMs_.emplace(e.peer, ms);
+        else it->second += (ms - it->second) / 8.0;
+    }
+
+    std::map<Key, Entry> entries_;
+    std::unordered_map<const QubicConnection*, double> peerRttMs_;
+    uint64_t sent_ = 0;
+    uint64_t retried_ = 0;
+    uint64_t suppressed_ = 0;
+    std::mutex mtx_;
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Bookkeeping for the windowed log fetcher (EventRequestFromTrustedNode).
+// For every tick in the fetch window whose log range is known, a bitmap records which
+// log ids have been stored. processLogEvent marks ids as they are inserted, so the fetcher
+// can compute the missing chunks of many ticks without probing the database id by id.
+class LogFetchWindow
+{
+public:
+    /**
+     * @brief Registers a tick with its log id range. Ticks without logs (length <= 0) are complete at once.
+     * @return False if the tick is already registered.
+     */
+    bool addTick(uint32_t tick, long long fromId, long long length)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (ticks_.count(tick)) return false;
+        Slot& s = ticks_[tick];
+        s.fromId = fromId;
+        s.length = length > 0 ? length : 0;
+        s.bits.assign((s.length + 63) / 64, 0);
+        return true;
+    }
+
+    // OR in ids already present in storage; exists[i] refers to fromId + i.
+    void seed(uint32_t tick, const std::vector<uint8_t>& exists)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = ticks_.find(tick);
+        if (it == ticks_.end()) return;
+        Slot& s = it->second;
+        const long long n = std::min<long long>(s.length, (long long)exists.size());
+        for (long long i = 0; i < n; i++) {
+            if (exists[i]) s.set(i);
+        }
+    }
+
+    // Called for every stored log; ids outside the registered range of the tick are ignored.
+    void markReceived(uint32_t tick, uint64_t logId)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = ticks_.find(tick);
+        if (it == ticks_.end()) return;
+        Slot& s = it->second;
+        const long long i = (long long)logId - s.fromId;
+        if (i < 0 || i >= s.length) return;
+        s.set(i);
+    }
+
+    bool contains(uint32_t tick)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return ticks_.count(tick) != 0;
+    }
+
+    bool isComplete(uint32_t tick)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = ticks_.find(tick);
+        return it != ticks_.end() && it->second.received == it->second.length;
+    }
+
+    /**
+     * @brief Lists the missing ids of a tick, grouped by chunkSize-aligned chunks of its range.
+     * @param out Receives (chunkStart, firstMissing, lastMissing) per chunk with at least one missing id.
+     */
+    void missingChunks(uint32_t tick, long long chunkSize, std::vector<std::pair<long long, std::pair<long long, long long>>>& out)
+    {
+        out.clear();
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = ticks_.find(tick);
+        if (it == ticks_.end()) return;
+        const Slot& s = it->second;
+        for (long long c = 0; c < s.length; c += chunkSize) {
+            const long long end = std::min(s.length, c + chunkSize);
+            long long first = -1, last = -1;
+            for (long long i = c; i < end; i++) {
+                // skip whole words that are fully present
+                if ((i & 63) == 0 && i + 64 <= end && s.bits[i >> 6] == ~0ULL) { i += 63; continue; }
+                if (!s.test(i)) {
+                    if (first < 0) first = i;
+                    last = i;
+                }
+            }
+            if (first >= 0) out.push_back({s.fromId + c, {s.fromId + first, s.fromId + last}});
+        }
+    }
+
+    void erase(uint32_t tick)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        ticks_.erase(tick);
+    }
+
+    // Drop every tick below 'tick' (e.g. after the fetch head jumped on rescue or epoch change).
+    void eraseBelow(uint32_t tick)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        ticks_.erase(ticks_.begin(), ticks_.lower_bound(tick));
+    }
+
+private:
+    struct Slot
+    {
+        long long fromId = -1;
+        long long length = 0;
+        long long received = 0;
+        std::vector<uint64_t> bits;
+
+        bool test(long long i) const { return (bits[i >> 6] >> (i & 63)) & 1ULL; }
+        void set(long long i)
+        {
+            uint64_t& w = bits[i >> 6];
+            const uint64_t m = 1ULL << (i & 63);
+            if (!(w & m)) {
+                w |= m;
+                received++;
+            }
+        }
+    };
+
+    std::map<uint32_t, Slot> ticks_;
+    std::mutex mtx_;
+};
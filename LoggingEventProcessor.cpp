@@ -14,6 +14,8 @@
 #include "commonFunctions.h"
 #include "Entity.h"
 #include "Asset.h"
+#include "StateReorg.h"
+#include "StateRollback.h"
 #include <string>
 #include <filesystem>
 #include "Profiler.h"
@@ -35,6 +37,30 @@ static void KangarooTwelve64To32(void* input, void* output)
     KangarooTwelve((uint8_t*)input, 64, (uint8_t*)output, 32);
 }
 
+// Rehashes the inner nodes above every flagged spectrum leaf, up to the root.
+static void propagateSpectrumDigests()
+{
+    unsigned int digestIndex = SPECTRUM_CAPACITY;
+    unsigned int previousLevelBeginning = 0;
+    unsigned int numberOfLeafs = SPECTRUM_CAPACITY;
+    while (numberOfLeafs > 1)
+    {
+        for (unsigned int i = 0; i < numberOfLeafs; i += 2)
+        {
+            if (spectrumChangeFlags[i >> 6] & (3ULL << (i & 63)))
+            {
+                KangarooTwelve64To32(&spectrumDigests[previousLevelBeginning + i], &spectrumDigests[digestIndex]);
+                spectrumChangeFlags[i >> 6] &= ~(3ULL << (i & 63));
+                spectrumChangeFlags[i >> 7] |= (1ULL << ((i >> 1) & 63));
+            }
+            digestIndex++;
+        }
+        previousLevelBeginning += numberOfLeafs;
+        numberOfLeafs >>= 1;
+    }
+    spectrumChangeFlags[0] = 0;
+}
+
 void computeSpectrumDigest(const uint32_t tickStart, const uint32_t tickEnd)
 {
     unsigned int digestIndex;
@@ -59,24 +85,7 @@ void computeSpectrumDigest(const uint32_t tickStart, const uint32_t tickEnd)
         }
     }
 
-    unsigned int previousLevelBeginning = 0;
-    unsigned int numberOfLeafs = SPECTRUM_CAPACITY;
-    while (numberOfLeafs > 1)
-    {
-        for (unsigned int i = 0; i < numberOfLeafs; i += 2)
-        {
-            if (spectrumChangeFlags[i >> 6] & (3ULL << (i & 63)))
-            {
-                KangarooTwelve64To32(&spectrumDigests[previousLevelBeginning + i], &spectrumDigests[digestIndex]);
-                spectrumChangeFlags[i >> 6] &= ~(3ULL << (i & 63));
-                spectrumChangeFlags[i >> 7] |= (1ULL << ((i >> 1) & 63));
-            }
-            digestIndex++;
-        }
-        previousLevelBeginning += numberOfLeafs;
-        numberOfLeafs >>= 1;
-    }
-    spectrumChangeFlags[0] = 0;
+    propagateSpectrumDigests();
 }
 
 m256i getUniverseDigest(const uint32_t tickStart, const uint32_t tickEnd)
@@ -122,6 +131,104 @@ m256i getUniverseDigest(const uint32_t tickStart, const uint32_t tickEnd)
     return assetDigests[(ASSETS_CAPACITY * 2 - 1) - 1];
 }
 
+static bool isEmptySlot(const void* record, size_t size)
+{
+    const uint64_t* w = (const uint64_t*)record;
+    for (size_t i = 0; i < size / 8; i++)
+    {
+        if (w[i]) return false;
+    }
+    return true;
+}
+
+// Flags every spectrum and universe slot that holds a record. The end-epoch reorganization only
+// moves records between slots, so flagging before and after it covers every leaf that can change.
+static void flagOccupiedStateSlots()
+{
+    for (unsigned int i = 0; i < SPECTRUM_CAPACITY; i++)
+    {
+        if (!isEmptySlot(&spectrum[i], sizeof(EntityRecord))) spectrumChangeFlags[i >> 6] |= (1ULL << (i & 63));
+    }
+    for (unsigned int i = 0; i < ASSETS_CAPACITY; i++)
+    {
+        if (!isEmptySlot(&assets[i], sizeof(AssetRecord))) assetChangeFlags[i >> 6] |= (1ULL << (i & 63));
+    }
+}
+
+// Rehashes the flagged spectrum leaves and everything above them.
+static void rehashFlaggedSpectrum()
+{
+    for (unsigned int i = 0; i < SPECTRUM_CAPACITY; i++)
+    {
+        if (spectrumChangeFlags[i >> 6] & (1ULL << (i & 63)))
+        {
+            KangarooTwelve64To32(&spectrum[i], &spectrumDigests[i]);
+        }
+    }
+    propagateSpectrumDigests();
+}
+
+/**
+ * @brief Reorganizes spectrum and universe for the next epoch and refreshes both digest trees in place.
+ * Only the slots occupied before or after the reorganization are rehashed, so the next epoch can start
+ * verifying without reloading the state files or recomputing the full trees.
+ */
+static void reorganizeStateForNextEpoch()
+{
+    flagOccupiedStateSlots();
+    // assetsEndEpoch marks the whole universe as changed; keep the occupied-slot flags instead
+    std::vector<unsigned long long> assetFlags(assetChangeFlags, assetChangeFlags + ASSETS_CAPACITY / 64);
+    reorganizeSpectrumParallel(gMaxThreads);
+    assetsEndEpochParallel(gMaxThreads);
+    memcpy(assetChangeFlags, assetFlags.data(), assetFlags.size() * sizeof(unsigned long long));
+    flagOccupiedStateSlots();
+    rebuildAssetHolderIndex();
+    rebuildRichList();
+
+    auto futSpectrum = std::async(std::launch::async, rehashFlaggedSpectrum);
+    getUniverseDigest(0, 0);
+    futSpectrum.get();
+}
+
+/**
+ * @brief Puts back the records changed by the batch being verified, from the undo journal.
+ * Everything derived from them follows: rich list, holder index, digest trees, and the state
+ * journal entries that were not persisted yet. Afterwards the state is exactly the verified state
+ * before the batch, so the batch can be refetched and simulated again without a restart.
+ */
+static void rollbackBatch()
+{
+    const size_t entities = undoJournal.spectrumImages().size();
+    const size_t records = undoJournal.assetImages().size();
+    restoreUndoJournal();
+    Logger::get()->info("Rolled back {} entities and {} asset records", entities, records);
+    stateJournal.discardPending();
+
+    auto futSpectrum = std::async(std::launch::async, rehashFlaggedSpectrum);
+    getUniverseDigest(0, 0);
+    futSpectrum.get();
+}
+
+// Persists the journaled balance changes of the simulated ticks. On failure they are kept and
+// written with the next batch.
+static void flushStateJournal()
+{
+    if (!stateJournal.enabled()) return;
+    size_t dropped = 0;
+    auto deltas = stateJournal.take(dropped);
+    if (dropped)
+    {
+        Logger::get()->error("State journal: dropped {} unpersisted balance changes, historical balances before tick {} are incomplete",
+                             dropped, deltas.front().tick);
+    }
+    if (!deltas.empty() && !db_insert_state_deltas(gCurrentProcessingEpoch, deltas))
+    {
+        Logger::get()->warn("Failed to persist {} journaled balance changes, retrying with the next batch", deltas.size());
+        return;
+    }
+    stateJournal.commit();
+}
+
 void processQuTransfer(LogEvent& le)
 {
     QuTransfer qt;
@@ -311,6 +418,8 @@ static bool loadFile(const std::string& path,
 }
 
 #define SAVE_PERIOD 1000
+// Misaligned batches rolled back and refetched in place before falling back to a restart
+#define MAX_ROLLBACK_ATTEMPTS 3
 
 void saveFiles(const std::string tickSpectrum, const std::string tickUniverse)
 {
@@ -341,7 +450,9 @@ void saveState(uint32_t& tracker, uint32_t lastVerified)
     std::string tickSpectrum = "spectrum." + std::to_string(lastVerified);
     std::string tickUniverse = "universe." + std::to_string(lastVerified);
     saveFiles(tickSpectrum, tickUniverse);
-    db_update_latest_verified_tick(lastVerified);
+    StatusCommit commit;
+    commit.latestVerifiedTick = lastVerified;
+    db_commit_status(commit);
     tickSpectrum = "spectrum." + std::to_string(tracker);
     tickUniverse = "universe." + std::to_string(tracker);
     if (std::filesystem::exists(tickSpectrum) && std::filesystem::exists(tickUniverse)) {
@@ -380,9 +491,12 @@ static bool checkLogExistAndVerify(uint16_t epoch, long long logId)
 void verifyLoggingEvent(std::atomic_bool& stopFlag)
 {
     gIsEndEpoch = false;
+    stateJournal.clear(); // changes of ticks that were never verified
     bool saveLastTick = false;
     bool needBootstrapFiles = false;
     uint32_t lastQuorumTick = 0;
+    int rollbackAttempts = 0;
+    bool refetchBatch = false;
     uint32_t lastVerifiedTick = db_get_latest_verified_tick();
     std::string spectrumFilePath;
     std::string assetFilePath;
@@ -405,35 +519,48 @@ void verifyLoggingEvent(std::atomic_bool& stopFlag)
         lastVerifiedTick =  gInitialTick - 1;
     }
 
-    if (!loadFile(spectrumFilePath, spectrum, sizeof(EntityRecord), SPECTRUM_CAPACITY, "spectrum")) {
-        if (needBootstrapFiles)
-        {
-            Logger::get()->info("Cannot find bootstrap files, trying to download from qubic.global");
-            DownloadStateFiles(gCurrentProcessingEpoch);
-            if (!loadFile(spectrumFilePath, spectrum, sizeof(EntityRecord), SPECTRUM_CAPACITY, "spectrum"))
+    // After an in-process epoch transition the reorganized state and its digests are still in memory
+    const bool stateInMemory = needBootstrapFiles && gInMemoryStateEpoch == gCurrentProcessingEpoch;
+    gInMemoryStateEpoch = 0;
+    if (stateInMemory)
+    {
+        Logger::get()->info("Using spectrum/universe of epoch {} carried over in memory", gCurrentProcessingEpoch.load());
+        gCurrentVerifyLoggingTick = lastVerifiedTick+1;
+    }
+    else
+    {
+        if (!loadFile(spectrumFilePath, spectrum, sizeof(EntityRecord), SPECTRUM_CAPACITY, "spectrum")) {
+            if (needBootstrapFiles)
             {
+                Logger::get()->info("Cannot find bootstrap files, trying to download from qubic.global");
+                DownloadStateFiles(gCurrentProcessingEpoch);
+                if (!loadFile(spectrumFilePath, spectrum, sizeof(EntityRecord), SPECTRUM_CAPACITY, "spectrum"))
+                {
+                    return;
+                }
+            } else {
                 return;
             }
-        } else {
-            return;
         }
-    }
 
-    if (!loadFile(assetFilePath, assets, sizeof(AssetRecord), ASSETS_CAPACITY, "universe")) {
-        return;
-    }
-    gCurrentVerifyLoggingTick = lastVerifiedTick+1;
+        if (!loadFile(assetFilePath, assets, sizeof(AssetRecord), ASSETS_CAPACITY, "universe")) {
+            return;
+        }
+        gCurrentVerifyLoggingTick = lastVerifiedTick+1;
 
-    auto futSpectrum = std::async(std::launch::async, []() {
-        computeSpectrumDigest(UINT32_MAX, UINT32_MAX);
-    });
-    auto futUniverse = std::async(std::launch::async, []() {
-        return getUniverseDigest(UINT32_MAX, UINT32_MAX);
-    });
+        auto futSpectrum = std::async(std::launch::async, []() {
+            computeSpectrumDigest(UINT32_MAX, UINT32_MAX);
+        });
+        auto futUniverse = std::async(std::launch::async, []() {
+            return getUniverseDigest(UINT32_MAX, UINT32_MAX);
+        });
+        rebuildAssetHolderIndex();
+        rebuildRichList();
 
-    // Synchronize both
-    futSpectrum.get();
-    futUniverse.get();
+        // Synchronize both
+        futSpectrum.get();
+        futUniverse.get();
+    }
 
     while (gCurrentFetchingLogTick == gInitialTick) {
         if (stopFlag.load()) return;
@@ -465,6 +592,7 @@ void verifyLoggingEvent(std::atomic_bool& stopFlag)
                 }
             }
         }
+retryBatch:
         std::vector<LogEvent> vle;
         {
             PROFILE_SCOPE("db_get_logs_by_tick_range");
@@ -479,8 +607,10 @@ gatherAllLoggingEvents:
                 Logger::get()->critical("Bob has more log than needed for tick {}->{} "
                                         "unexpected behavior {} but get {}", processFromTick, processToTick, vle.size(), length);
             }
-            if (fromId != -1 && length != -1 && vle.size() != length)
+            if (fromId != -1 && length != -1 && (vle.size() != length || refetchBatch))
             {
+                refetchBatch = false;
+                LogSubscriptionManager::instance().pushTickStatus(processFromTick, processToTick, false);
                 Logger::get()->info("Entering rescue mode to refetch malformed data");
                 Logger::get()->info("tick {}->{} unexpected behavior expected {} but get {}", processFromTick, processToTick, length, vle.size());
                 Logger::get()->info("Trying to refetch log ranges");
@@ -547,6 +677,7 @@ gatherAllLoggingEvents:
             }
         }
 
+        undoJournal.clear();
         LogEvent* ple = nullptr; // to solve the case of transferring ownership & possession, they go with pair
         LogEvent* ple1 = nullptr; // to solve the case of transferring management rights, they go with pair
         {
@@ -565,6 +696,7 @@ gatherAllLoggingEvents:
                     exit(2);
                 }
 
+                stateJournal.setTick(le.getTick());
                 auto type = le.getType();
                 switch(type)
                 {
@@ -668,15 +800,30 @@ gatherAllLoggingEvents:
             }
         }
 
+        if (gIsEndEpoch)
+        {
+            // the end-epoch batch has no votes to verify against but is final
+            LogSubscriptionManager::instance().pushTickStatus(processFromTick, processToTick, true);
+            break;
+        }
+        // The digests are computed right after simulating, while the votes of the batch may still be
+        // on their way (see speculative-ticks). Waiting and vote refetches below reuse them.
+        m256i spectrumDigest, universeDigest;
+        {
+            PROFILE_SCOPE("computeDigests");
+            computeSpectrumDigest(processFromTick, processToTick);
+            spectrumDigest = spectrumDigests[(SPECTRUM_CAPACITY * 2 - 1) - 1];
+            universeDigest = getUniverseDigest(processFromTick, processToTick);
+        }
 verifyNodeStateDigest:
-        if (gIsEndEpoch) break;
-        while (gCurrentVerifyLoggingTick == gCurrentFetchingTick)
+        while (gCurrentFetchingTick <= processToTick)
         {
-            SLEEP(100); // need to wait until tick data and votes arrive
+            // logs may run ahead, wait until tick data and votes catch up with the batch: gCurrentFetchingTick
+            // is the tick still being fetched, so the votes of processToTick are complete once it has moved past
+            SLEEP(10);
             if (stopFlag.load(std::memory_order_relaxed)) return;
         }
         if (stopFlag.load()) break;
-        m256i spectrumDigest, universeDigest;
         std::vector<TickVote> votes;
         int voteCount = 0;
         bool hasTickData = false;
@@ -684,11 +831,7 @@ verifyNodeStateDigest:
         int nonEmptyTick = 0;
         int emptyTick = 0;
         {
-            PROFILE_SCOPE("computeDigests");
-            computeSpectrumDigest(processFromTick, processToTick);
-            spectrumDigest = spectrumDigests[(SPECTRUM_CAPACITY * 2 - 1) - 1];
-            universeDigest = getUniverseDigest(processFromTick, processToTick);
-
+            PROFILE_SCOPE("checkVotes");
             votes = db_try_to_get_votes(processToTick);
             //verifying spectrum and universe state
             voteCount = 0;
@@ -742,10 +885,21 @@ verifyNodeStateDigest:
                )
             {
                 // quorum already reach but not matched
+                if (rollbackAttempts < MAX_ROLLBACK_ATTEMPTS)
+                {
+                    rollbackAttempts++;
+                    Logger::get()->critical("Misalignment states!!! Rolling back tick {}->{} and refetching its logs (attempt {}/{})",
+                                            processFromTick, processToTick, rollbackAttempts, MAX_ROLLBACK_ATTEMPTS);
+                    rollbackBatch();
+                    LogSubscriptionManager::instance().pushTickStatus(processFromTick, processToTick, false);
+                    refetchBatch = true;
+                    goto retryBatch;
+                }
                 Logger::get()->critical("Misalignment states!!! Cleaning all potential malformed data and restarting bob");
                 stopFlag.store(true);
                 SLEEP(1000);
                 processToTick = gCurrentFetchingLogTick - 1;
+                LogSubscriptionManager::instance().pushTickStatus(processFromTick, processToTick, false);
                 long long fromId, length;
                 db_get_combined_log_range_for_ticks(processFromTick, processToTick, fromId, length);
                 auto endId = fromId + length - 1;
@@ -766,6 +920,10 @@ verifyNodeStateDigest:
         else
         {
             Logger::get()->trace("Verified logging event tick {}->{}", processFromTick, processToTick);
+            rollbackAttempts = 0;
+            flushStateJournal();
+            // the votes of verified ticks are only read from now on: one key per tick instead of 676
+            db_pack_tick_votes(processFromTick, processToTick);
             if (processToTick - lastVerifiedTick >= SAVE_PERIOD)
             {
                 saveState(lastVerifiedTick, processToTick);
@@ -779,25 +937,27 @@ verifyNodeStateDigest:
                 for (const auto& log : vle) {
                     uint32_t logTick = log.getTick();
                     if (logTick != currentTick && !tickLogs.empty()) {
-                        LogSubscriptionManager::instance().pushVerifiedLogs(currentTick, gCurrentProcessingEpoch, tickLogs);
+                        LogSubscriptionManager::instance().pushVerifiedLogs(currentTick, gCurrentProcessingEpoch, std::move(tickLogs));
                         tickLogs.clear();
                     }
                     currentTick = logTick;
                     tickLogs.push_back(log);
                 }
                 if (!tickLogs.empty()) {
-                    LogSubscriptionManager::instance().pushVerifiedLogs(currentTick, gCurrentProcessingEpoch, tickLogs);
+                    LogSubscriptionManager::instance().pushVerifiedLogs(currentTick, gCurrentProcessingEpoch, std::move(tickLogs));
                 }
             }
+            LogSubscriptionManager::instance().pushTickStatus(processFromTick, processToTick, true);
 
             gCurrentVerifyLoggingTick = processToTick + 1;
         }
     }
     if (gIsEndEpoch)
     {
+        // the end-epoch batch has no votes to verify against but is final
+        flushStateJournal();
         Logger::get()->info("Reorg spectrum and universe...");
-        reorganizeSpectrum();
-        assetsEndEpoch();
+        reorganizeStateForNextEpoch();
         gCurrentVerifyLoggingTick = lastQuorumTick + 1;
         // begin epoch transition procedure
         uint16_t nextEpoch = gCurrentProcessingEpoch + 1;
@@ -841,15 +1001,13 @@ verifyNodeStateDigest:
             oldKey = "log_sig:" + std::to_string(endTick) + ":" + std::to_string(chunkId);
         }
 
-        db_rename("tick_log_range:" + std::to_string(endTick),
-                      "end_epoch:tick_log_range:"+std::to_string(gCurrentProcessingEpoch));
-        db_rename("log_ranges:" + std::to_string(endTick),
-                      "end_epoch:log_ranges:"+std::to_string(gCurrentProcessingEpoch));
+        db_rename_end_epoch_log_ranges(endTick, gCurrentProcessingEpoch);
         std::string key = "end_epoch_tick:" + std::to_string(gCurrentProcessingEpoch);
         db_insert_u32(key, endTick);
         // end epoch tick is a virtual tick for logging, we set it back to lastQuorumTick
         db_update_field("db_status", "latest_event_tick", std::to_string(lastQuorumTick));
         db_insert_u32("verified_history:" + std::to_string(gCurrentProcessingEpoch), lastQuorumTick); // update historical tracker
+        gInMemoryStateEpoch = nextEpoch;
     }
     Logger::get()->info("verifyLoggingEvent stopping gracefully.");
 }
@@ -857,9 +1015,26 @@ verifyNodeStateDigest:
 // The logging fetcher thread from trusted nodes only (no signature require)
 void EventRequestFromTrustedNode(ConnectionPool& connPoolWithPwd,
                                  std::atomic_bool& stopFlag,
-                                 std::chrono::milliseconds request_logging_cycle_ms)
+                                 std::chrono::milliseconds request_logging_cycle_ms,
+                                 uint32_t fetchWindow,
+                                 uint32_t speculativeTicks)
 {
     auto idleBackoff = request_logging_cycle_ms;
+    if (fetchWindow == 0) fetchWindow = 1;
+    std::vector<std::pair<long long, std::pair<long long, long long>>> missingChunks;
+    const auto inflightTimeout = std::max<std::chrono::milliseconds>(request_logging_cycle_ms * 10, std::chrono::milliseconds(500));
+
+    // Ask a random trusted peer for the log ranges of a tick, unless the same request is still outstanding.
+    auto requestLogRange = [&](uint32_t tick)
+    {
+        InflightRegistry::Key key{RequestAllLogIdRangesFromTick::type(), tick, 0};
+        const QubicConnection* avoid = nullptr;
+        if (!inflightRequests.shouldSend(key, inflightTimeout, avoid)) return;
+        RequestAllLogIdRangesFromTick ralr{{0,0,0,0},tick};
+        const QubicConnection* chosen = nullptr;
+        connPoolWithPwd.sendWithPasscodeToRandom((uint8_t*)&ralr, 0, sizeof(RequestAllLogIdRangesFromTick), RequestAllLogIdRangesFromTick::type(), true, avoid, &chosen);
+        inflightRequests.markSent(key, chosen);
+    };
 
     while (!stopFlag.load(std::memory_order_relaxed)) {
         try {
@@ -884,49 +1059,73 @@ void EventRequestFromTrustedNode(ConnectionPool& connPoolWithPwd,
                 }
                 SLEEP(1000);
             }
-            if (gCurrentFetchingLogTick >= (gCurrentFetchingTick+1))
+            const uint32_t headTick = gCurrentFetchingLogTick;
+            // logs may run speculativeTicks ahead of the tick data verified by quorum
+            const uint32_t fetchLimit = gCurrentFetchingTick + 1 + speculativeTicks;
+            if (headTick >= fetchLimit)
             {
                 SLEEP(100);
                 continue;
             }
             if (stopFlag.load(std::memory_order_relaxed)) break;
-            if (!db_check_log_range(gCurrentFetchingLogTick))
+            logFetchWindow.eraseBelow(headTick);
+            // keep up to fetchWindow ticks in flight, never past the speculation limit
+            const uint32_t windowEnd = std::min<uint32_t>(headTick + fetchWindow, fetchLimit);
+            for (uint32_t tick = headTick; tick < windowEnd; tick++)
             {
-                RequestAllLogIdRangesFromTick ralr{{0,0,0,0},gCurrentFetchingLogTick};
-                connPoolWithPwd.sendWithPasscodeToRandom((uint8_t*)&ralr, 0, sizeof(RequestAllLogIdRangesFromTick), RequestAllLogIdRangesFromTick::type(), true);
-            } else {
-                long long fromId, length;
-                if (!db_try_get_log_range_for_tick(gCurrentFetchingLogTick, fromId, length)) continue;
-                if (fromId == -1 || length == -1)
+                if (!logFetchWindow.contains(tick))
                 {
-                    Logger::get()->trace("Tick {} doesn't generate any log. Advancing logEvent tick", gCurrentFetchingLogTick);
-                    gCurrentFetchingLogTick++;
-                    continue;
-                }
-                long long endId = fromId + length - 1; // inclusive
-                while (db_log_exists(gCurrentProcessingEpoch, fromId) && fromId <= endId)
-                {
-                    fromId++;
-                }
-                for (long long s = fromId; s <= endId; s += BOB_LOG_EVENT_CHUNK_SIZE) {
-                    long long e = std::min(endId, s + BOB_LOG_EVENT_CHUNK_SIZE - 1);
-                    RequestLog rl{{0,0,0,0},(unsigned long long)(s),(unsigned long long)(e)};
-                    connPoolWithPwd.sendWithPasscodeToRandom((uint8_t *) &rl, 0, sizeof(RequestLog), RequestLog::type(), true);
+                    if (!db_check_log_range(tick))
+                    {
+                        requestLogRange(tick);
+                        continue;
+                    }
+                    long long fromId, length;
+                    if (!db_try_get_log_range_for_tick(tick, fromId, length)) continue;
+                    if (fromId == -1 || length == -1)
+                    {
+                        Logger::get()->trace("Tick {} doesn't generate any log", tick);
+                        logFetchWindow.addTick(tick, -1, 0);
+                        continue;
+                    }
+                    if (logFetchWindow.addTick(tick, fromId, length))
+                    {
+                        // one pipelined round trip picks up logs stored before the tick entered the window
+                        std::vector<uint8_t> exists;
+                        if (db_check_logs_exist(gCurrentProcessingEpoch, fromId, length, exists))
+                        {
+                            logFetchWindow.seed(tick, exists);
+                        }
+                    }
                 }
-                if (fromId > endId)
+                // chunks stay aligned to the start of the tick's range so each one keeps a stable in-flight key;
+                // every chunk is an independent peer pick, so one tick's chunks spread over the pool
+                logFetchWindow.missingChunks(tick, BOB_LOG_EVENT_CHUNK_SIZE, missingChunks);
+                for (const auto& [chunkStart, ids] : missingChunks)
                 {
-                    Logger::get()->trace("Advancing logEvent tick {}", gCurrentFetchingLogTick);
-                    gCurrentFetchingLogTick++;
-                    db_update_latest_event_tick_and_epoch(gCurrentFetchingLogTick, gCurrentProcessingEpoch);
+                    InflightRegistry::Key key{RequestLog::type(), tick, (uint64_t)chunkStart};
+                    const QubicConnection* avoid = nullptr;
+                    if (!inflightRequests.shouldSend(key, inflightTimeout, avoid)) continue;
+                    RequestLog rl{{0,0,0,0},(unsigned long long)(ids.first),(unsigned long long)(ids.second)};
+                    const QubicConnection* chosen = nullptr;
+                    connPoolWithPwd.sendWithPasscodeToRandom((uint8_t *) &rl, 0, sizeof(RequestLog), RequestLog::type(), true, avoid, &chosen);
+                    inflightRequests.markSent(key, chosen);
                 }
             }
-            for (int i = 1; i < 5; i++)
+            // advance over the completed prefix of the window
+            bool advanced = false;
+            while (gCurrentFetchingLogTick < windowEnd && logFetchWindow.isComplete(gCurrentFetchingLogTick))
             {
-                if (!db_check_log_range(gCurrentFetchingLogTick + i))
-                {
-                    RequestAllLogIdRangesFromTick ralr{{0,0,0,0},gCurrentFetchingLogTick + i};
-                    connPoolWithPwd.sendWithPasscodeToRandom((uint8_t*)&ralr, 0, sizeof(RequestAllLogIdRangesFromTick), RequestAllLogIdRangesFromTick::type(), true);
-                }
+                const uint32_t done = gCurrentFetchingLogTick;
+                inflightRequests.completeAll(RequestLog::type(), done);
+                logFetchWindow.erase(done);
+                Logger::get()->trace("Advancing logEvent tick {}", done);
+                gCurrentFetchingLogTick++;
+                advanced = true;
+            }
+            if (advanced)
+            {
+                db_update_latest_event_tick_and_epoch(gCurrentFetchingLogTick, gCurrentProcessingEpoch);
             }
             SLEEP(idleBackoff);
         } catch (std::logic_error &ex) {
@@ -4,6 +4,7 @@
 #include "SpecialBufferStructs.h"
 #include "structs.h"
 #include "database/db.h"
+#include "database/Keyspace.h"
 #include "Logger.h"
 #include "K12AndKeyUtil.h"
 #include "GlobalVar.h"
@@ -54,7 +55,7 @@ static void indexTick(uint32_t tick, const TickData &td) {
         for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++) {
             if (td.transactionDigests[i] == m256i::zero()) continue;
             std::string txHash = getTransactionHash(td.transactionDigests[i].m256i_u8);
-            std::string key = "itx:" + txHash;
+            std::string key = Keyspace::indexedTx(txHash, td.transactionDigests[i].m256i_u8);
 
             LogEvent firstEvent;
             bool isExecuted = false;
@@ -84,7 +85,7 @@ static void indexTick(uint32_t tick, const TickData &td) {
     // handling 5 special events
     for (int i = SC_INITIALIZE_TX; i <= SC_END_EPOCH_TX; i++)
     {
-        std::string key = "itx:" + std::to_string(tick) + "_" + std::to_string(i);
+        std::string key = Keyspace::indexedTx(tick, i);
         db_set_indexed_tx(key.c_str(), i, logrange.fromLogId[i],
                           logrange.fromLogId[i] + logrange.length[i] - 1, timestamp,
                           true);
@@ -241,34 +242,34 @@ static void indexTick(uint32_t tick, const TickData &td) {
                 //bool db_add_indexer(const std::string &key, uint32_t tickNumber)
                 if (SC_index != 0)
                 {
-                    key = "indexed:" + std::to_string(SC_index);
+                    key = Keyspace::indexed(SC_index);
                     db_add_indexer(key, tick);
                 }
-                key = "indexed:" + std::to_string(SC_index) + ":" + std::to_string(logType);
+                key = Keyspace::indexed(SC_index, logType);
                 db_add_indexer(key, tick);
             }
             // populate all scenarios with topic1,2,3
             // 3 bits => 0=>7
             for (int bit = 1; bit < 8; bit++) // case 0,0,0 is already handled above
             {
-                key = "indexed:" + std::to_string(SC_index) + ":" + std::to_string(logType) + ":";
+                std::string topics[3];
                 int isSet = 0;
                 for (int j = 0; j < 3; j++)
                 {
                     const m256i &topic = (j == 0) ? topic1 : ((j == 1) ? topic2 : topic3);
                     if (topic == m256i::zero()) {
-                        key += std::string("ANY") + ((j == 2) ? "" : ":");
+                        topics[j] = "ANY";
                     } else if ((bit >> j) & 1) {
                         char qhash[64] = {0};
                         getIdentityFromPublicKey(topic.m256i_u8, qhash, true);
-                        std::string str_hash(qhash);
-                        key += str_hash + ((j == 2) ? "" : ":");
+                        topics[j] = qhash;
                         isSet++;
                     } else {
-                        key += std::string("ANY") + ((j == 2) ? "" : ":");
+                        topics[j] = "ANY";
                     }
                 }
-                if (isSet) db_add_indexer(key, tick);
+                if (isSet) db_add_indexer(Keyspace::indexed(SC_index, logType, topics[0], topics[1], topics[2],
+                                                            Keyspace::Origin::Computed), tick);
             }
         }
     }
@@ -276,6 +277,20 @@ static void indexTick(uint32_t tick, const TickData &td) {
     Logger::get()->trace("Indexed verified tick {}", tick);
 }
 
+// Index the ticks [fromTick, toTick) stored behind the indexer, i.e. those backfilled after a fast sync.
+// Returns the first tick left unindexed.
+uint32_t indexTickRange(uint32_t fromTick, uint32_t toTick, const std::atomic_bool& stopFlag)
+{
+    uint32_t tick = fromTick;
+    for (; tick < toTick && !stopFlag.load(std::memory_order_relaxed); tick++)
+    {
+        TickData td{};
+        db_try_get_tick_data(tick, td);
+        indexTick(tick, td);
+    }
+    return tick;
+}
+
 void indexVerifiedTicks(std::atomic_bool& stopFlag)
 {
     using namespace std::chrono_literals;
@@ -310,7 +325,9 @@ void indexVerifiedTicks(std::atomic_bool& stopFlag)
         indexTick(nextTick, td);
 
         // Persist progress.
-        if (!db_update_last_indexed_tick(nextTick)) {
+        StatusCommit commit;
+        commit.lastIndexedTick = nextTick;
+        if (!db_commit_status(commit)) {
             Logger::get()->warn("QubicIndexer: failed to update last_indexed_tick to {}", nextTick);
             // Best-effort sleep to avoid hammering DB if there's a transient error.
             SLEEP(1000);
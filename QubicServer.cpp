@@ -6,6 +6,7 @@
 #include <cstring>
 #include <unordered_map>
 #include <chrono>
+#include <algorithm>
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -20,7 +21,7 @@
 #include "shim.h"
 
 // Forward declaration from IOProcessor.cpp
-void connReceiver(QCPtr& conn, const bool isTrustedNode, std::atomic_bool& stopFlag);
+void connReceiver(QCPtr& conn, const bool isTrustedNode, const bool isBundlePeer, std::atomic_bool& stopFlag);
 
 namespace {
     // Simple connection limiter with global and per-IP limits
@@ -320,9 +321,11 @@ namespace {
 
                 // Non-trusted connections
                 const bool isTrustedNode = false;
+                // only the peers listed in bundle-peers may have us build tick bundles
+                const bool isBundlePeer = std::find(gBundlePeers.begin(), gBundlePeers.end(), client_ip) != gBundlePeers.end();
 
                 // Launch per-connection receiver thread
-                ctx->th = std::thread([this, ctx, isTrustedNode]() {
+                ctx->th = std::thread([this, ctx, isTrustedNode, isBundlePeer]() {
                     try {
                         // Set a timeout for handshake
                         auto handshake_deadline = std::chrono::steady_clock::now() +
@@ -338,7 +341,7 @@ namespace {
                         }
 
                         // Run the main receiver loop
-                        connReceiver(ctx->conn, isTrustedNode, ctx->stopFlag);
+                        connReceiver(ctx->conn, isTrustedNode, isBundlePeer, ctx->stopFlag);
 
                     } catch (const std::exception& ex) {
                         Logger::get()->debug("QubicServer: Exception for {}: {}",
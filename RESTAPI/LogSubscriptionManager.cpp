@@ -7,13 +7,24 @@
 #include <json/json.h>
 #include <sstream>
 #include <iomanip>
+#include <iterator>
 #include <drogon/drogon.h>
+#include <trantor/net/EventLoopThread.h>
+
+namespace {
+
+// Preliminary logs queued on the push thread beyond which new ones are dropped
+constexpr size_t kMaxQueuedPreliminaryLogs = 1 << 16;
+
+} // namespace
 
 LogSubscriptionManager& LogSubscriptionManager::instance() {
     static LogSubscriptionManager inst;
     return inst;
 }
 
+LogSubscriptionManager::~LogSubscriptionManager() = default;
+
 void LogSubscriptionManager::addClient(const drogon::WebSocketConnectionPtr& conn) {
     std::unique_lock lock(mutex_);
 
@@ -45,6 +56,7 @@ void LogSubscriptionManager::removeClient(const drogon::WebSocketConnectionPtr&
         }
     }
 
+    if (it->second.preliminary) preliminaryClients_--;
     clients_.erase(it);
 
     Logger::get()->info("WebSocket client disconnected. Total clients: {}", clients_.size());
@@ -78,6 +90,18 @@ void LogSubscriptionManager::setClientTransferMinAmount(const drogon::WebSocketC
     }
 }
 
+void LogSubscriptionManager::setClientPreliminary(const drogon::WebSocketConnectionPtr& conn) {
+    std::unique_lock lock(mutex_);
+
+    auto it = clients_.find(conn);
+    if (it == clients_.end() || it->second.preliminary) return;
+    // Logs of ticks up to the highest stored one may already be on their way to other clients,
+    // this client gets them once verified. Pairs with notePreliminaryLog: store tick, then read count.
+    it->second.preliminaryFromTick = highestStoredTick_.load() + 1;
+    it->second.preliminary = true;
+    preliminaryClients_++;
+}
+
 bool LogSubscriptionManager::subscribe(const drogon::WebSocketConnectionPtr& conn, uint32_t scIndex, uint32_t logType) {
     std::unique_lock lock(mutex_);
 
@@ -180,7 +204,20 @@ bool LogSubscriptionManager::extractSubscriptionKey(const LogEvent& log, Subscri
     }
 }
 
-void LogSubscriptionManager::pushVerifiedLogs(uint32_t tick, uint16_t epoch, const std::vector<LogEvent>& logs) {
+void LogSubscriptionManager::queuePush(std::function<void()>&& task) {
+    std::call_once(pushThreadOnce_, [this]() {
+        pushThread_ = std::make_unique<trantor::EventLoopThread>("ws-push");
+        pushThread_->run();
+        pushThread_->getLoop()->queueInLoop([]() { db_set_thread_workload(DbWorkload::Api); });
+    });
+    pushThread_->getLoop()->queueInLoop(std::move(task));
+}
+
+void LogSubscriptionManager::pushVerifiedLogs(uint32_t tick, uint16_t epoch, std::vector<LogEvent>&& logs) {
+    queuePush([this, tick, logs = std::move(logs)]() { pushVerifiedLogsNow(tick, logs); });
+}
+
+void LogSubscriptionManager::pushVerifiedLogsNow(uint32_t tick, const std::vector<LogEvent>& logs) {
     // Prepare messages under lock, then dispatch asynchronously
     std::vector<std::pair<drogon::WebSocketConnectionPtr, std::string>> pendingSends;
     TickData td{0};
@@ -273,6 +310,11 @@ void LogSubscriptionManager::pushVerifiedLogs(uint32_t tick, uint16_t epoch, con
                     if (clientIt->second.lastTick >= tick) {
                         continue;
                     }
+                    // Skip if the client got this tick on the preliminary stream
+                    if (clientIt->second.preliminarySentTicks.count(tick) &&
+                        !clientIt->second.preliminarySkippedTicks.count(tick)) {
+                        continue;
+                    }
                     // Skip if client's lastLogId is >= current log ID (client is ahead of system)
                     if (clientIt->second.lastLogId >= 0 && clientIt->second.lastLogId >= logId) {
                         continue;
@@ -288,23 +330,184 @@ void LogSubscriptionManager::pushVerifiedLogs(uint32_t tick, uint16_t epoch, con
         }
     }
 
-    // Dispatch sends asynchronously via Drogon's event loop
-    if (!pendingSends.empty()) {
-        auto loop = drogon::app().getIOLoop(0);
-        if (loop) {
-            loop->queueInLoop([sends = std::move(pendingSends)]() {
-                for (const auto& [conn, jsonStr] : sends) {
-                    try {
-                        if (conn->connected()) {
-                            conn->send(jsonStr);
-                        }
-                    } catch (const std::exception& e) {
-                        Logger::get()->warn("Failed to send WebSocket message: {}", e.what());
-                    }
-                }
-            });
+    dispatchSends(std::move(pendingSends));
+}
+
+bool LogSubscriptionManager::notePreliminaryLog(uint32_t tick) {
+    uint32_t highest = highestStoredTick_.load();
+    while (tick > highest && !highestStoredTick_.compare_exchange_weak(highest, tick)) {}
+    return preliminaryClients_.load() > 0;
+}
+
+void LogSubscriptionManager::pushPreliminaryLogs(std::vector<LogEvent>&& logs) {
+    const size_t count = logs.size();
+    if (queuedPreliminaryLogs_.fetch_add(count) + count > kMaxQueuedPreliminaryLogs) {
+        queuedPreliminaryLogs_ -= count;
+        // The ticks of these logs may be partly streamed already, they are sent whole once verified
+        const uint32_t verifiedTick = gCurrentVerifyLoggingTick.load();
+        std::unique_lock lock(mutex_);
+        for (auto& [conn, client] : clients_) {
+            if (!client.preliminary) continue;
+            for (const auto& log : logs) {
+                const uint32_t tick = log.getTick();
+                if (tick >= verifiedTick && tick >= client.preliminaryFromTick) client.preliminarySkippedTicks.insert(tick);
+            }
+        }
+        Logger::get()->debug("LogSubscriptionManager: push thread is behind, dropped {} preliminary logs", count);
+        return;
+    }
+    queuePush([this, count, logs = std::move(logs)]() {
+        pushPreliminaryLogsNow(logs);
+        queuedPreliminaryLogs_ -= count;
+    });
+}
+
+void LogSubscriptionManager::pushPreliminaryLogsNow(const std::vector<LogEvent>& logs) {
+    std::vector<std::pair<drogon::WebSocketConnectionPtr, std::string>> pendingSends;
+    // Ticks sent to or skipped for a client, recorded once the messages are built
+    std::vector<std::pair<drogon::WebSocketConnectionPtr, uint32_t>> sentTicks;
+    std::vector<std::pair<drogon::WebSocketConnectionPtr, uint32_t>> skippedTicks;
+    // Logs fetched by a fast sync backfill are old, only the ticks not verified yet are streamed
+    const uint32_t verifiedTick = gCurrentVerifyLoggingTick.load();
+
+    TickData td{0};
+    LogRangesPerTxInTick lr{-1};
+    bool hasTickData = false;
+    bool hasLogRanges = false;
+    uint32_t currentTick = 0;
+    std::vector<int> logTxOrder;
+    int logTxOrderIndex = 0;
+
+    std::shared_lock lock(mutex_);
+    if (clients_.empty() || subscriptionIndex_.empty()) return;
+
+    for (const auto& log : logs) {
+        uint32_t tick = log.getTick();
+        if (tick < verifiedTick) continue;
+        SubscriptionKey key;
+        if (!extractSubscriptionKey(log, key)) continue;
+        auto subIt = subscriptionIndex_.find(key);
+        if (subIt == subscriptionIndex_.end() || subIt->second.empty()) continue;
+        auto logId = log.getLogId();
+
+        // The tick data of a tick ahead of the quorum may not be there yet, the log then has no txHash
+        if (tick != currentTick) {
+            currentTick = tick;
+            hasTickData = db_try_get_tick_data(tick, td);
+            hasLogRanges = db_try_get_log_ranges(tick, lr);
+            if (hasLogRanges) {
+                logTxOrder = lr.sort();
+                logTxOrderIndex = lr.scanTxId(logTxOrder, 0, logId);
+            }
+        }
+        int txIndex = -1;
+        if (hasTickData && hasLogRanges) {
+            txIndex = logTxOrder[logTxOrderIndex];
+            auto e = lr.fromLogId[txIndex] + lr.length[txIndex] - 1;
+            if (logId > e) {
+                logTxOrderIndex = lr.scanTxId(logTxOrder, logTxOrderIndex + 1, logId);
+                txIndex = logTxOrder[logTxOrderIndex];
+            }
+        }
+
+        std::string parsedJson = const_cast<LogEvent&>(log).parseToJsonWithExtraData(td, txIndex);
+        Json::Value parsedLog;
+        Json::CharReaderBuilder builder;
+        std::string errors;
+        std::istringstream stream(parsedJson);
+        Json::parseFromStream(builder, stream, &parsedLog, &errors);
+
+        Json::Value msg;
+        msg["type"] = "log";
+        msg["scIndex"] = key.scIndex;
+        msg["logType"] = key.logType;
+        msg["isCatchUp"] = false;
+        msg["isPreliminary"] = true;
+        msg["message"] = parsedLog;
+        Json::FastWriter writer;
+        std::string jsonStr = writer.write(msg);
+
+        int64_t transferAmount = 0;
+        if (log.getType() == QU_TRANSFER) {
+            const QuTransfer* t = const_cast<LogEvent&>(log).getStruct<QuTransfer>();
+            if (t) transferAmount = t->amount;
+        }
+
+        for (const auto& conn : subIt->second) {
+            auto clientIt = clients_.find(conn);
+            if (clientIt == clients_.end()) continue;
+            const auto& client = clientIt->second;
+            if (!client.preliminary || tick < client.preliminaryFromTick) continue;
+            if (client.preliminarySkippedTicks.count(tick)) continue;
+            if (client.catchUpInProgress) {
+                skippedTicks.emplace_back(conn, tick);
+                continue;
+            }
+            if (client.lastTick >= tick) continue;
+            if (client.lastLogId >= 0 && client.lastLogId >= static_cast<int64_t>(logId)) continue;
+            if (log.getType() == QU_TRANSFER && client.transferMinAmount > 0 &&
+                transferAmount < client.transferMinAmount) {
+                continue;
+            }
+            pendingSends.emplace_back(conn, jsonStr);
+            sentTicks.emplace_back(conn, tick);
+        }
+    }
+    lock.unlock();
+
+    if (!sentTicks.empty() || !skippedTicks.empty()) {
+        std::unique_lock writeLock(mutex_);
+        for (const auto& [conn, tick] : sentTicks) {
+            auto it = clients_.find(conn);
+            if (it != clients_.end()) it->second.preliminarySentTicks.insert(tick);
+        }
+        for (const auto& [conn, tick] : skippedTicks) {
+            auto it = clients_.find(conn);
+            if (it != clients_.end()) it->second.preliminarySkippedTicks.insert(tick);
+        }
+    }
+
+    dispatchSends(std::move(pendingSends));
+}
+
+void LogSubscriptionManager::pushTickStatus(uint32_t fromTick, uint32_t toTick, bool confirmed) {
+    if (preliminaryClients_.load() == 0) return;
+    queuePush([this, fromTick, toTick, confirmed]() { pushTickStatusNow(fromTick, toTick, confirmed); });
+}
+
+void LogSubscriptionManager::pushTickStatusNow(uint32_t fromTick, uint32_t toTick, bool confirmed) {
+    std::vector<std::pair<drogon::WebSocketConnectionPtr, std::string>> pendingSends;
+    {
+        std::unique_lock lock(mutex_);
+        for (auto& [conn, client] : clients_) {
+            if (!client.preliminary) continue;
+            uint32_t from = std::max(fromTick, client.preliminaryFromTick);
+            uint32_t to = toTick;
+            if (from > to) continue;
+            auto& sent = client.preliminarySentTicks;
+            auto first = sent.lower_bound(from);
+            auto last = sent.upper_bound(to);
+            const bool streamed = first != last;
+            if (!confirmed && streamed) {
+                // Only what the client got since the last revert of these ticks is reverted
+                from = *first;
+                to = *std::prev(last);
+            }
+            sent.erase(first, last);
+            auto& skipped = client.preliminarySkippedTicks;
+            skipped.erase(skipped.lower_bound(fromTick), skipped.upper_bound(toTick));
+            if (!confirmed && !streamed) continue;
+
+            Json::Value msg;
+            msg["type"] = "tickStatus";
+            msg["fromTick"] = from;
+            msg["toTick"] = to;
+            msg["status"] = confirmed ? "confirmed" : "reverted";
+            Json::FastWriter writer;
+            pendingSends.emplace_back(conn, writer.write(msg));
         }
     }
+    dispatchSends(std::move(pendingSends));
 }
 
 void LogSubscriptionManager::performCatchUp(const drogon::WebSocketConnectionPtr& conn, uint32_t toTick) {
@@ -642,6 +845,25 @@ size_t LogSubscriptionManager::getTotalSubscriptionCount() const {
     return count;
 }
 
+void LogSubscriptionManager::dispatchSends(std::vector<std::pair<drogon::WebSocketConnectionPtr, std::string>>&& pendingSends) {
+    // Dispatch sends asynchronously via Drogon's event loop
+    if (pendingSends.empty()) return;
+    auto loop = drogon::app().getIOLoop(0);
+    if (loop) {
+        loop->queueInLoop([sends = std::move(pendingSends)]() {
+            for (const auto& [conn, jsonStr] : sends) {
+                try {
+                    if (conn->connected()) {
+                        conn->send(jsonStr);
+                    }
+                } catch (const std::exception& e) {
+                    Logger::get()->warn("Failed to send WebSocket message: {}", e.what());
+                }
+            }
+        });
+    }
+}
+
 void LogSubscriptionManager::sendJson(const drogon::WebSocketConnectionPtr& conn, const std::string& json) {
     try {
         conn->send(json);
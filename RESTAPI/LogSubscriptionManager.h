@@ -5,13 +5,21 @@
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
+#include <atomic>
 #include <shared_mutex>
 #include <chrono>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
 
 #include "drogon/WebSocketConnection.h"
 #include "LogEvent.h"
 
+namespace trantor {
+class EventLoopThread;
+}
+
 // Subscription key: (scIndex, logType) pair
 struct SubscriptionKey {
     uint32_t scIndex;
@@ -38,6 +46,10 @@ struct ClientState {
     bool catchUpInProgress{false};  // True while catch-up is running
     std::chrono::steady_clock::time_point connectedAt;
     int64_t transferMinAmount{0};   // Minimum amount for QU_TRANSFER events (0 = no filter)
+    bool preliminary{false};        // Receives logs before verification, then a tickStatus per tick range
+    uint32_t preliminaryFromTick{0};// First tick streamed preliminarily; older ticks come verified
+    std::set<uint32_t> preliminarySentTicks;    // Ticks with logs sent preliminarily, until confirmed or reverted
+    std::set<uint32_t> preliminarySkippedTicks; // Ticks with logs not sent preliminarily, they come verified
 };
 
 // Singleton manager for WebSocket log subscriptions
@@ -58,13 +70,32 @@ public:
     // Set minimum transfer amount filter for QU_TRANSFER events
     void setClientTransferMinAmount(const drogon::WebSocketConnectionPtr& conn, int64_t minAmount);
 
+    // Switch the client to the preliminary stream (stays on until the connection closes)
+    void setClientPreliminary(const drogon::WebSocketConnectionPtr& conn);
+
     // Subscription management
     bool subscribe(const drogon::WebSocketConnectionPtr& conn, uint32_t scIndex, uint32_t logType);
     bool unsubscribe(const drogon::WebSocketConnectionPtr& conn, uint32_t scIndex, uint32_t logType);
     void unsubscribeAll(const drogon::WebSocketConnectionPtr& conn);
 
+    // The three pushes below only queue the work on the push thread, which runs it in call order:
+    // the preliminary logs of a tick are handled before its verified logs and its status.
+
     // Push verified logs to matching subscribers (called from indexer thread)
-    void pushVerifiedLogs(uint32_t tick, uint16_t epoch, const std::vector<LogEvent>& logs);
+    void pushVerifiedLogs(uint32_t tick, uint16_t epoch, std::vector<LogEvent>&& logs);
+
+    // Called for every stored log (from log receiving threads). Returns true if the log should be
+    // collected for pushPreliminaryLogs, i.e. some client is on the preliminary stream.
+    bool notePreliminaryLog(uint32_t tick);
+
+    // Push logs that passed selfCheck but are not verified yet to preliminary subscribers. When the push
+    // thread lags too far behind, the logs are dropped and their ticks sent once verified instead.
+    void pushPreliminaryLogs(std::vector<LogEvent>&& logs);
+
+    // Tell preliminary subscribers that the logs of ticks [fromTick, toTick] are confirmed by the
+    // quorum digests, or reverted (dropped; the ticks are streamed again). One message per range;
+    // a client is only told of a revert if it got logs of those ticks since their last revert.
+    void pushTickStatus(uint32_t fromTick, uint32_t toTick, bool confirmed);
 
     // Perform catch-up: send historical logs from lastTick+1 to currentTick
     // This is async and should be called after subscriptions are set
@@ -79,13 +110,24 @@ public:
 
 private:
     LogSubscriptionManager() = default;
-    ~LogSubscriptionManager() = default;
+    ~LogSubscriptionManager();
     LogSubscriptionManager(const LogSubscriptionManager&) = delete;
     LogSubscriptionManager& operator=(const LogSubscriptionManager&) = delete;
 
     // Extract (scIndex, logType) from a LogEvent
     bool extractSubscriptionKey(const LogEvent& log, SubscriptionKey& key) const;
 
+    // Run a push on the push thread, started on first use
+    void queuePush(std::function<void()>&& task);
+
+    // The pushes themselves, on the push thread
+    void pushVerifiedLogsNow(uint32_t tick, const std::vector<LogEvent>& logs);
+    void pushPreliminaryLogsNow(const std::vector<LogEvent>& logs);
+    void pushTickStatusNow(uint32_t fromTick, uint32_t toTick, bool confirmed);
+
+    // Queue messages on Drogon's event loop, they are sent outside of the caller's thread
+    void dispatchSends(std::vector<std::pair<drogon::WebSocketConnectionPtr, std::string>>&& pendingSends);
+
     // Send a JSON message to a connection
     void sendJson(const drogon::WebSocketConnectionPtr& conn, const std::string& json);
 
@@ -94,6 +136,16 @@ private:
     // Connection pointer -> ClientState
     std::unordered_map<drogon::WebSocketConnectionPtr, ClientState> clients_;
 
+    // Highest tick of a stored log and number of preliminary clients, read without the mutex
+    std::atomic<uint32_t> highestStoredTick_{0};
+    std::atomic<size_t> preliminaryClients_{0};
+
+    // Builds the messages of the pushes off the log receiving and verifying threads
+    std::unique_ptr<trantor::EventLoopThread> pushThread_;
+    std::once_flag pushThreadOnce_;
+    // Preliminary logs queued on the push thread and not handled yet
+    std::atomic<size_t> queuedPreliminaryLogs_{0};
+
     // SubscriptionKey -> Set of connections subscribed to this key
     std::unordered_map<SubscriptionKey, std::unordered_set<drogon::WebSocketConnectionPtr>, SubscriptionKeyHash> subscriptionIndex_;
 };
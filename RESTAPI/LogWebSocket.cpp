@@ -102,6 +102,11 @@ void LogWebSocket::handleSubscribe(const drogon::WebSocketConnectionPtr& conn, c
         manager.setClientLastTick(conn, gCurrentVerifyLoggingTick.load());
     }
 
+    // Opt in to logs before verification; stays on for the connection
+    if (msg.isMember("preliminary") && msg["preliminary"].isBool() && msg["preliminary"].asBool()) {
+        manager.setClientPreliminary(conn);
+    }
+
     // Set transfer minimum amount filter (default 0 = no filter)
     if (msg.isMember("transferMinAmount") && !msg["transferMinAmount"].isNull()) {
         if (msg["transferMinAmount"].isInt64() || msg["transferMinAmount"].isUInt64() ||
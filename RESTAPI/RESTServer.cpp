@@ -17,6 +17,7 @@
 #include <sstream>
 
 #include "bob.h"
+#include "database/db.h"
 #include "Logger.h"
 #include "shim.h"
 
@@ -136,6 +137,44 @@ namespace {
             {Get}
         );
 
+        // GET /balance/{identity}/{tick}
+        app().registerHandler(
+                "/balance/{1}/{2}",
+                [](const HttpRequestPtr &req, std::function<void(const HttpResponsePtr &)> &&callback,
+                   const std::string &identity, const std::string &tickStr) {
+                    try {
+                        unsigned long long v = std::stoull(tickStr);
+                        if (v > std::numeric_limits<uint32_t>::max()) {
+                            callback(makeError("tick out of uint32 range"));
+                            return;
+                        }
+                        std::string result = bobGetBalanceAtTick(identity, static_cast<uint32_t>(v));
+                        callback(makeJsonResponse(result));
+                    } catch (const std::invalid_argument &) {
+                        callback(makeError("tick must be an integer"));
+                    } catch (const std::out_of_range &) {
+                        callback(makeError("tick out of range"));
+                    } catch (const std::exception &ex) {
+                        callback(makeError(std::string("balance error: ") + ex.what(), k500InternalServerError));
+                    }
+                },
+                {Get}
+        );
+
+        // GET /assets/{identity}
+        app().registerHandler(
+            "/assets/{1}",
+            [](const HttpRequestPtr& req, std::function<void (const HttpResponsePtr &)> &&callback, const std::string& identity) {
+                try {
+                    std::string result = bobGetAssetsOfIdentity(identity);
+                    callback(makeJsonResponse(result));
+                } catch (const std::exception& ex) {
+                    callback(makeError(std::string("assets error: ") + ex.what(), k500InternalServerError));
+                }
+            },
+            {Get}
+        );
+
         // GET /asset/{identity}/{issuer}/{asset_name}/{manageSCIndex}
         app().registerHandler(
                 "/asset/{1}/{2}/{3}/{4}",
@@ -162,6 +201,80 @@ namespace {
                 {Get}
         );
 
+        // GET /asset/{identity}/{issuer}/{asset_name}/{manageSCIndex}/{tick}
+        app().registerHandler(
+                "/asset/{1}/{2}/{3}/{4}/{5}",
+                [](const HttpRequestPtr &req, std::function<void(const HttpResponsePtr &)> &&callback,
+                   const std::string &identity, const std::string &issuer, const std::string &assetName,
+                   const std::string &manageSCIndexStr, const std::string &tickStr) {
+                    try {
+                        unsigned long long v = std::stoull(manageSCIndexStr);
+                        unsigned long long t = std::stoull(tickStr);
+                        if (v > std::numeric_limits<uint32_t>::max() || t > std::numeric_limits<uint32_t>::max()) {
+                            callback(makeError("manageSCIndex or tick out of uint32 range"));
+                            return;
+                        }
+                        std::string result = bobGetAssetAtTick(identity, assetName, issuer, static_cast<uint32_t>(v), static_cast<uint32_t>(t));
+                        callback(makeJsonResponse(result));
+                    } catch (const std::invalid_argument &) {
+                        callback(makeError("manageSCIndex and tick must be integers"));
+                    } catch (const std::out_of_range &) {
+                        callback(makeError("manageSCIndex or tick out of range"));
+                    } catch (const std::exception &ex) {
+                        callback(makeError(std::string("asset error: ") + ex.what(), k500InternalServerError));
+                    }
+                },
+                {Get}
+        );
+
+        // GET /richlist/{limit}
+        app().registerHandler(
+                "/richlist/{1}",
+                [](const HttpRequestPtr &req, std::function<void(const HttpResponsePtr &)> &&callback,
+                   const std::string &limitStr) {
+                    try {
+                        unsigned long long limit = std::stoull(limitStr);
+                        if (limit == 0 || limit > 1000) {
+                            callback(makeError("limit must be between 1 and 1000"));
+                            return;
+                        }
+                        std::string result = bobGetRichList(static_cast<uint32_t>(limit));
+                        callback(makeJsonResponse(result));
+                    } catch (const std::invalid_argument &) {
+                        callback(makeError("limit must be an integer"));
+                    } catch (const std::out_of_range &) {
+                        callback(makeError("limit out of range"));
+                    } catch (const std::exception &ex) {
+                        callback(makeError(std::string("richlist error: ") + ex.what(), k500InternalServerError));
+                    }
+                },
+                {Get}
+        );
+
+        // GET /richlist/{issuer}/{asset_name}/{limit}
+        app().registerHandler(
+                "/richlist/{1}/{2}/{3}",
+                [](const HttpRequestPtr &req, std::function<void(const HttpResponsePtr &)> &&callback,
+                   const std::string &issuer, const std::string &assetName, const std::string &limitStr) {
+                    try {
+                        unsigned long long limit = std::stoull(limitStr);
+                        if (limit == 0 || limit > 1000) {
+                            callback(makeError("limit must be between 1 and 1000"));
+                            return;
+                        }
+                        std::string result = bobGetAssetRichList(issuer, assetName, static_cast<uint32_t>(limit));
+                        callback(makeJsonResponse(result));
+                    } catch (const std::invalid_argument &) {
+                        callback(makeError("limit must be an integer"));
+                    } catch (const std::out_of_range &) {
+                        callback(makeError("limit out of range"));
+                    } catch (const std::exception &ex) {
+                        callback(makeError(std::string("richlist error: ") + ex.what(), k500InternalServerError));
+                    }
+                },
+                {Get}
+        );
+
         // GET /epochinfo/{epoch}
         app().registerHandler(
                 "/epochinfo/{1}",
@@ -692,8 +805,16 @@ namespace {
                 .reusePort()                        // Enable SO_REUSEADDR to avoid "Address already in use" errors
                 ;
 
+            // Handlers run on the IO loops: their KeyDB reads use the API pool (and replica, if configured)
+            drogon::app().registerBeginningAdvice([]() {
+                for (size_t i = 0; i < drogon::app().getThreadNum(); i++) {
+                    drogon::app().getIOLoop(i)->queueInLoop([]() { db_set_thread_workload(DbWorkload::Api); });
+                }
+            });
+
             // Run Drogon in a background thread so it doesn't block the main program
             std::thread([]() {
+                db_set_thread_workload(DbWorkload::Api);
                 drogon::app().run();
             }).detach();
         });
@@ -88,6 +88,202 @@ std::string bobGetAsset(const std::string identity, const std::string assetName,
     return writer.write(root);
 }
 
+// Value of a journaled record at the end of a tick of the current epoch. current must be read
+// before calling: a change missing from the database is still in the journal, and a record with
+// no change after the tick anywhere still holds current.
+static long long journaledValueAtTick(StateJournal::Kind kind, uint32_t index, uint32_t tick, long long current)
+{
+    long long unpersisted = 0;
+    const bool hasUnpersisted = stateJournal.firstUnpersistedOldValue(kind, index, tick, unpersisted);
+    long long value = 0;
+    if (db_get_state_value_at_tick(gCurrentProcessingEpoch, kind, index, tick, value)) return value;
+    return hasUnpersisted ? unpersisted : current;
+}
+
+// Empty if tick can be answered from the journal, otherwise the error message.
+static std::string checkJournaledTick(uint32_t tick)
+{
+    if (!stateJournal.enabled()) return "State journal is disabled on this node";
+    if (tick < gInitialTick) return "Tick is before the initial tick of the current epoch";
+    if (tick >= gCurrentVerifyLoggingTick) return "Tick is not verified yet";
+    return "";
+}
+
+std::string bobGetBalanceAtTick(const std::string identity, uint32_t tick)
+{
+    if (identity.size() < 60) return "{\"error\": \"Wrong identity format\"}";
+    const std::string error = checkJournaledTick(tick);
+    if (!error.empty()) return "{\"error\": \"" + error + "\"}";
+    m256i pk{};
+    getPublicKeyFromIdentity(identity.c_str(), pk.m256i_u8);
+    long long balance = 0;
+    int index = spectrumIndex(pk);
+    // entities are never removed within an epoch, so one that is not in the spectrum had no balance
+    if (index >= 0) balance = journaledValueAtTick(StateJournal::QU, index, tick, energy(index));
+    Json::Value root;
+    root["identity"] = identity;
+    root["tick"] = tick;
+    root["balance"] = Json::Int64(balance);
+    root["currentBobTick"] = gCurrentVerifyLoggingTick - 1;
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+std::string bobGetAssetAtTick(const std::string identity, const std::string assetName, const std::string assetIssuer,
+                              uint32_t manageSCIndex, uint32_t tick)
+{
+    if (identity.size() < 60) return "{\"error\": \"Wrong identity format\"}";
+    const std::string error = checkJournaledTick(tick);
+    if (!error.empty()) return "{\"error\": \"" + error + "\"}";
+    m256i pk{}, issuer{};
+    uint64_t asset_name = 0;
+    getPublicKeyFromIdentity(identity.c_str(), pk.m256i_u8);
+    getPublicKeyFromIdentity(assetIssuer.c_str(), issuer.m256i_u8);
+    memcpy(&asset_name, assetName.data(), std::min(7, int(assetName.size())));
+    long long ownershipBalance = 0, possessionBalance = 0;
+    int issuanceIndex, ownershipIndex, possessionIndex;
+    if (findIssuerIndex(issuer, asset_name, &issuanceIndex)
+        && findOwnershipIndex(issuanceIndex, pk, manageSCIndex, &ownershipIndex))
+    {
+        ownershipBalance = journaledValueAtTick(StateJournal::SHARES, ownershipIndex, tick,
+                                                assets[ownershipIndex].varStruct.ownership.numberOfShares);
+        if (findPossessionIndex(ownershipIndex, pk, manageSCIndex, &possessionIndex))
+        {
+            possessionBalance = journaledValueAtTick(StateJournal::SHARES, possessionIndex, tick,
+                                                     assets[possessionIndex].varStruct.possession.numberOfShares);
+        }
+    }
+    Json::Value root;
+    root["tick"] = tick;
+    root["ownershipBalance"] = Json::Int64(ownershipBalance);
+    root["possessionBalance"] = Json::Int64(possessionBalance);
+    root["currentBobTick"] = gCurrentVerifyLoggingTick - 1;
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+static std::string assetNameString(const char name[7])
+{
+    size_t len = 0;
+    while (len < 7 && name[len]) len++;
+    return std::string(name, len);
+}
+
+static std::string identityString(const m256i& pk)
+{
+    char identity[64] = {0};
+    getIdentityFromPublicKey(pk.m256i_u8, identity, false);
+    return identity;
+}
+
+std::string bobGetAssetsOfIdentity(const std::string identity)
+{
+    if (identity.size() < 60) return "{\"error\": \"Wrong identity format\"}";
+    m256i pk{};
+    getPublicKeyFromIdentity(identity.c_str(), pk.m256i_u8);
+    std::vector<uint32_t> records;
+    if (!assetHolderIndex.get(pk, records))
+    {
+        return "{\"error\":\"Asset index is not built yet\"}";
+    }
+    Json::Value root;
+    root["identity"] = identity;
+    root["issuances"] = Json::Value(Json::arrayValue);
+    root["ownerships"] = Json::Value(Json::arrayValue);
+    root["possessions"] = Json::Value(Json::arrayValue);
+    for (uint32_t i : records)
+    {
+        const AssetRecord& r = assets[i];
+        if (r.varStruct.issuance.publicKey != pk) continue;
+        if (r.varStruct.issuance.type == ISSUANCE)
+        {
+            Json::Value item;
+            item["assetName"] = assetNameString(r.varStruct.issuance.name);
+            item["numberOfDecimalPlaces"] = int(r.varStruct.issuance.numberOfDecimalPlaces);
+            item["index"] = i;
+            root["issuances"].append(item);
+        }
+        else if (r.varStruct.ownership.type == OWNERSHIP)
+        {
+            const auto& issuance = assets[r.varStruct.ownership.issuanceIndex & (ASSETS_CAPACITY - 1)].varStruct.issuance;
+            Json::Value item;
+            item["issuer"] = identityString(issuance.publicKey);
+            item["assetName"] = assetNameString(issuance.name);
+            item["managingContractIndex"] = r.varStruct.ownership.managingContractIndex;
+            item["numberOfShares"] = Json::Int64(r.varStruct.ownership.numberOfShares);
+            item["index"] = i;
+            root["ownerships"].append(item);
+        }
+        else if (r.varStruct.possession.type == POSSESSION)
+        {
+            const auto& ownership = assets[r.varStruct.possession.ownershipIndex & (ASSETS_CAPACITY - 1)].varStruct.ownership;
+            const auto& issuance = assets[ownership.issuanceIndex & (ASSETS_CAPACITY - 1)].varStruct.issuance;
+            Json::Value item;
+            item["issuer"] = identityString(issuance.publicKey);
+            item["assetName"] = assetNameString(issuance.name);
+            item["owner"] = identityString(ownership.publicKey);
+            item["managingContractIndex"] = r.varStruct.possession.managingContractIndex;
+            item["numberOfShares"] = Json::Int64(r.varStruct.possession.numberOfShares);
+            item["index"] = i;
+            root["possessions"].append(item);
+        }
+    }
+    root["currentBobTick"] = gCurrentVerifyLoggingTick - 1;
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+static Json::Value holdersToJson(const std::vector<HolderRanking::Entry>& top)
+{
+    Json::Value holders(Json::arrayValue);
+    for (const auto& e : top)
+    {
+        Json::Value item;
+        item["identity"] = identityString(e.publicKey);
+        item["balance"] = Json::Int64(e.balance);
+        holders.append(item);
+    }
+    return holders;
+}
+
+std::string bobGetRichList(uint32_t limit)
+{
+    std::vector<HolderRanking::Entry> top;
+    size_t holders = 0;
+    if (!richList.topQu(limit, top, holders))
+    {
+        return "{\"error\":\"Rich list is not built yet\"}";
+    }
+    Json::Value root;
+    root["numberOfHolders"] = Json::UInt64(holders);
+    root["holders"] = holdersToJson(top);
+    root["currentBobTick"] = gCurrentVerifyLoggingTick - 1;
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
+std::string bobGetAssetRichList(const std::string assetIssuer, const std::string assetName, uint32_t limit)
+{
+    m256i issuer{};
+    uint64_t asset_name = 0;
+    getPublicKeyFromIdentity(assetIssuer.c_str(), issuer.m256i_u8);
+    memcpy(&asset_name, assetName.data(), std::min(7, int(assetName.size())));
+    std::vector<HolderRanking::Entry> top;
+    size_t holders = 0;
+    if (!richList.topAsset(issuer, asset_name, limit, top, holders))
+    {
+        return "{\"error\":\"Rich list is not built yet\"}";
+    }
+    Json::Value root;
+    root["issuer"] = assetIssuer;
+    root["assetName"] = assetName;
+    root["numberOfHolders"] = Json::UInt64(holders);
+    root["holders"] = holdersToJson(top);
+    root["currentBobTick"] = gCurrentVerifyLoggingTick - 1;
+    Json::FastWriter writer;
+    return writer.write(root);
+}
+
 std::string bobGetTransaction(const char* txHash)
 {
     if (!txHash) return "{\"error\": \"Invalid transaction hash\"}";
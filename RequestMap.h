@@ -1,76 +1,157 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "connection/connection.h"
 // mapping from dejavu to requested data
 // usage: some response doesn't contain requested info
 // if code makes several queries, we need this map to know which
 // response to which request
+//
+// Layout: the key space is split over kShards independent shards, each one an
+// open-addressing (linear probing, backward-shift delete) table guarded by its
+// own mutex. Payloads up to kInlineSize bytes are stored inside the slot; larger
+// ones spill into a per-slot vector whose capacity is reused up to kSpillKeepCapacity
+// and freed above it. Expiry is driven by a per-shard timer wheel with one bucket
+// per second, so clean() only touches the buckets that became due instead of walking
+// the whole table. clean() also shrinks a table a burst left mostly empty.
 class RequestMap
 {
 public:
+    static constexpr uint32_t kShards = 16;
+    static constexpr uint32_t kInitialSlotsPerShard = 512; // power of two
+    static constexpr uint32_t kInlineSize = 64;            // covers every request we send
+    static constexpr uint32_t kWheelSlots = 64;            // max trackable age in seconds
+    static constexpr size_t kSpillKeepCapacity = 4096;      // spill/wheel buffers above this are freed when emptied
+
     // Convert input to RequestedData and add/replace entry for given dejavu.
     void add(const uint32_t dejavu, const uint8_t* data, const int size, QCPtr conn)
     {
-        std::lock_guard<std::mutex> lock(mtx_);
-
-        RequestedData rd;
-        const uint64_t now =
-                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
-                        std::chrono::system_clock::now().time_since_epoch())
-                        .count());
-        rd.timestamp = now;
+        Shard& s = shardOf(dejavu);
+        const uint64_t now = nowSeconds();
+        std::lock_guard<std::mutex> lock(s.mtx);
 
-        if (data != nullptr && size > 0) {
-            rd.data.assign(data, data + static_cast<size_t>(size));
-        } else {
-            rd.data.clear();
-        }
-        rd.conn = std::move(conn);
-        mem[dejavu] = std::move(rd);
+        s.advanceWheelTo(now);
+        Slot* slot = s.findOrInsert(dejavu);
+        slot->timestamp = now;
+        slot->conn = std::move(conn);
+        slot->setData(data, (data != nullptr && size > 0) ? static_cast<uint32_t>(size) : 0);
+        s.wheel[now % kWheelSlots].keys.push_back(dejavu);
     }
 
     // Look up dejavu; if found copy into dataOut; return true, else false.
     bool get(uint32_t dejavu, std::vector<uint8_t>& dataOut, QCPtr& conn)
     {
-        std::lock_guard<std::mutex> lock(mtx_);
+        Shard& s = shardOf(dejavu);
+        std::lock_guard<std::mutex> lock(s.mtx);
 
-        auto it = mem.find(dejavu);
-        if (it == mem.end()) {
+        const Slot* slot = s.find(dejavu);
+        if (slot == nullptr) {
             return false;
         }
-
-        dataOut = it->second.data;
-        conn = it->second.conn;
+        dataOut.assign(slot->bytes(), slot->bytes() + slot->size);
+        conn = slot->conn;
         return true;
     }
 
     bool get(uint32_t dejavu, std::vector<uint8_t>& dataOut)
     {
-        std::lock_guard<std::mutex> lock(mtx_);
+        Shard& s = shardOf(dejavu);
+        std::lock_guard<std::mutex> lock(s.mtx);
 
-        auto it = mem.find(dejavu);
-        if (it == mem.end()) {
+        const Slot* slot = s.find(dejavu);
+        if (slot == nullptr) {
             return false;
         }
+        dataOut.assign(slot->bytes(), slot->bytes() + slot->size);
+        return true;
+    }
+
+    /**
+     * @brief Removes the entry for dejavu and moves its payload and connection out.
+     * @param dejavu Key to look up.
+     * @param dataOut Receives the payload; its previous contents are discarded.
+     * @param conn Receives the connection stored with the entry.
+     * @return True if the entry existed.
+     */
+    bool take(uint32_t dejavu, std::vector<uint8_t>& dataOut, QCPtr& conn)
+    {
+        Shard& s = shardOf(dejavu);
+        std::lock_guard<std::mutex> lock(s.mtx);
+
+        Slot* slot = s.find(dejavu);
+        if (slot == nullptr) {
+            return false;
+        }
+        if (slot->size > kInlineSize) {
+            dataOut.swap(slot->spill);
+            dataOut.resize(slot->size);
+        } else {
+            dataOut.assign(slot->inlineData, slot->inlineData + slot->size);
+        }
+        conn = std::move(slot->conn);
+        s.erase(slot);
+        return true;
+    }
+
+    /**
+     * @brief Copies the connection stored for dejavu without removing the entry.
+     * Several packets can carry the same dejavu, so the entry stays until clean() expires it.
+     * @return True if the entry existed.
+     */
+    bool getConn(uint32_t dejavu, QCPtr& conn)
+    {
+        Shard& s = shardOf(dejavu);
+        std::lock_guard<std::mutex> lock(s.mtx);
 
-        dataOut = it->second.data;
+        const Slot* slot = s.find(dejavu);
+        if (slot == nullptr) {
+            return false;
+        }
+        conn = slot->conn;
         return true;
     }
 
-    // Remove entries older than 60 seconds.
+    /**
+     * @brief Copies the stored payload into a caller-provided buffer without removing the entry.
+     * @param dejavu Key to look up.
+     * @param out Destination buffer.
+     * @param capacity Size of the destination buffer in bytes.
+     * @return Stored payload size, or -1 if the entry does not exist. At most capacity bytes are copied.
+     */
+    int peek(uint32_t dejavu, void* out, uint32_t capacity)
+    {
+        Shard& s = shardOf(dejavu);
+        std::lock_guard<std::mutex> lock(s.mtx);
+
+        const Slot* slot = s.find(dejavu);
+        if (slot == nullptr) {
+            return -1;
+        }
+        memcpy(out, slot->bytes(), std::min(capacity, slot->size));
+        return static_cast<int>(slot->size);
+    }
+
+    bool contains(uint32_t dejavu)
+    {
+        Shard& s = shardOf(dejavu);
+        std::lock_guard<std::mutex> lock(s.mtx);
+        return s.find(dejavu) != nullptr;
+    }
+
+    // Remove entries older than period seconds (capped at kWheelSlots - 1).
     void clean(uint32_t period = 60)
     {
-        std::lock_guard<std::mutex> lock(mtx_);
-
-        const uint64_t now =
-                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
-                        std::chrono::system_clock::now().time_since_epoch())
-                        .count());
-        for (auto it = mem.begin(); it != mem.end(); ) {
-            const uint64_t age = (now >= it->second.timestamp) ? (now - it->second.timestamp) : 0;
-            if (age > period) {
-                it = mem.erase(it);
-            } else {
-                ++it;
-            }
+        if (period >= kWheelSlots) period = kWheelSlots - 1;
+        const uint64_t now = nowSeconds();
+        for (auto& s : shards_) {
+            std::lock_guard<std::mutex> lock(s.mtx);
+            s.advanceWheelTo(now);
+            s.expireOlderThan(now, period);
+            s.shrinkIfSparse();
         }
     }
 
@@ -79,17 +160,197 @@ public:
      * @return String with map size and entries count.
      */
     std::string GetMapUsageString() {
-        std::lock_guard<std::mutex> lock(mtx_);
-        return "Map Usage: " + std::to_string(mem.size()) + " entries";
+        size_t entries = 0;
+        size_t slots = 0;
+        for (auto& s : shards_) {
+            std::lock_guard<std::mutex> lock(s.mtx);
+            entries += s.count;
+            slots += s.slots.size();
+        }
+        return "Map Usage: " + std::to_string(entries) + " entries (" + std::to_string(slots) + " slots)";
     }
 
 private:
-    struct RequestedData
+    struct Slot
     {
-        uint64_t timestamp;
+        uint32_t dejavu = 0;
+        uint32_t size = 0;
+        uint64_t timestamp = 0;
+        bool used = false;
         QCPtr conn;
-        std::vector<uint8_t> data;
+        uint8_t inlineData[kInlineSize];
+        std::vector<uint8_t> spill;
+
+        const uint8_t* bytes() const { return size > kInlineSize ? spill.data() : inlineData; }
+
+        void setData(const uint8_t* data, uint32_t sz)
+        {
+            size = sz;
+            if (sz > kInlineSize) {
+                spill.assign(data, data + sz);
+                return;
+            }
+            releaseSpill();
+            if (sz != 0) memcpy(inlineData, data, sz);
+        }
+
+        // Called whenever the slot stops using its spill buffer: a small one is kept for the next
+        // payload, one grown by a burst is freed.
+        void releaseSpill()
+        {
+            if (spill.capacity() > kSpillKeepCapacity) std::vector<uint8_t>().swap(spill);
+            else spill.clear();
+        }
+
+        // Move the entry into an empty slot; the spill buffers are swapped so capacity stays pooled.
+        void moveTo(Slot& dst)
+        {
+            dst.dejavu = dejavu;
+            dst.size = size;
+            dst.timestamp = timestamp;
+            dst.used = true;
+            dst.conn = std::move(conn);
+            if (size > kInlineSize) {
+                dst.spill.swap(spill);
+            } else {
+                memcpy(dst.inlineData, inlineData, size);
+            }
+            used = false;
+            size = 0;
+        }
+    };
+
+    struct WheelBucket
+    {
+        uint64_t second = 0;
+        std::vector<uint32_t> keys; // cleared; freed above kSpillKeepCapacity keys
+    };
+
+    struct Shard
+    {
+        std::mutex mtx;
+        std::vector<Slot> slots = std::vector<Slot>(kInitialSlotsPerShard);
+        uint32_t count = 0;
+        std::array<WheelBucket, kWheelSlots> wheel{};
+        uint64_t expiredUpTo = 0; // every bucket with second <= expiredUpTo has been drained
+
+        uint32_t mask() const { return static_cast<uint32_t>(slots.size()) - 1; }
+
+        Slot* find(uint32_t dejavu)
+        {
+            uint32_t i = slotHash(dejavu) & mask();
+            while (slots[i].used) {
+                if (slots[i].dejavu == dejavu) return &slots[i];
+                i = (i + 1) & mask();
+            }
+            return nullptr;
+        }
+
+        Slot* findOrInsert(uint32_t dejavu)
+        {
+            if ((count + 1) * 2 > slots.size()) grow();
+            uint32_t i = slotHash(dejavu) & mask();
+            while (slots[i].used) {
+                if (slots[i].dejavu == dejavu) return &slots[i];
+                i = (i + 1) & mask();
+            }
+            slots[i].used = true;
+            slots[i].dejavu = dejavu;
+            count++;
+            return &slots[i];
+        }
+
+        // Backward-shift deletion keeps probe chains tombstone-free.
+        void erase(Slot* slot)
+        {
+            uint32_t hole = static_cast<uint32_t>(slot - slots.data());
+            slots[hole].used = false;
+            slots[hole].size = 0;
+            slots[hole].conn.reset();
+            slots[hole].releaseSpill();
+            count--;
+            uint32_t i = (hole + 1) & mask();
+            while (slots[i].used) {
+                const uint32_t home = slotHash(slots[i].dejavu) & mask();
+                // move i into the hole if its home is not in (hole, i]
+                if (((i - home) & mask()) >= ((i - hole) & mask())) {
+                    slots[i].moveTo(slots[hole]);
+                    hole = i;
+                }
+                i = (i + 1) & mask();
+            }
+        }
+
+        void grow() { rehash(slots.size() * 2); }
+
+        // Halve the table while it is less than 1/8 full, down to the initial size.
+        void shrinkIfSparse()
+        {
+            size_t target = slots.size();
+            while (target > kInitialSlotsPerShard && size_t(count) * 8 < target) target /= 2;
+            if (target != slots.size()) rehash(target);
+        }
+
+        void rehash(size_t newSize)
+        {
+            std::vector<Slot> old(newSize);
+            old.swap(slots);
+            for (auto& s : old) {
+                if (!s.used) continue;
+                uint32_t i = slotHash(s.dejavu) & mask();
+                while (slots[i].used) i = (i + 1) & mask();
+                s.moveTo(slots[i]);
+            }
+        }
+
+        // Drop the keys of a bucket whose entries were not refreshed since they were queued.
+        void drainBucket(WheelBucket& b)
+        {
+            for (uint32_t key : b.keys) {
+                Slot* slot = find(key);
+                if (slot != nullptr && slot->timestamp == b.second) erase(slot);
+            }
+            if (b.keys.capacity() > kSpillKeepCapacity) std::vector<uint32_t>().swap(b.keys);
+            else b.keys.clear();
+        }
+
+        // Reusing a bucket for a newer second: anything still in it is at least kWheelSlots old.
+        void advanceWheelTo(uint64_t now)
+        {
+            WheelBucket& b = wheel[now % kWheelSlots];
+            if (b.second != now) {
+                if (!b.keys.empty()) drainBucket(b);
+                b.second = now;
+            }
+        }
+
+        void expireOlderThan(uint64_t now, uint32_t period)
+        {
+            if (now <= period) return;
+            const uint64_t upTo = now - period - 1; // age > period
+            uint64_t from = expiredUpTo + 1;
+            if (from > upTo) return;
+            // buckets further back than one wheel turn were already recycled by advanceWheelTo
+            if (upTo - from >= kWheelSlots) from = upTo - kWheelSlots + 1;
+            for (uint64_t sec = from; sec <= upTo; sec++) {
+                WheelBucket& b = wheel[sec % kWheelSlots];
+                if (b.second == sec) drainBucket(b);
+            }
+            expiredUpTo = upTo;
+        }
     };
-    std::map <uint32_t, RequestedData> mem;
-    std::mutex mtx_;
-};
\ No newline at end of file
+
+    static uint32_t shardHash(uint32_t dejavu) { return (dejavu * 0x9E3779B1u) >> 28; }
+    static uint32_t slotHash(uint32_t dejavu) { return (dejavu ^ (dejavu >> 16)) * 0x85EBCA6Bu; }
+    static_assert(kShards == 16, "shardHash takes the top 4 bits");
+
+    Shard& shardOf(uint32_t dejavu) { return shards_[shardHash(dejavu)]; }
+
+    static uint64_t nowSeconds()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    std::array<Shard, kShards> shards_;
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "m256i.h"
+
+// Holders of one balance (QU or the shares of one asset) ordered by balance, largest first.
+// Only holders with a positive balance are kept, so count() is the number of holders.
+class HolderRanking
+{
+public:
+    struct Entry
+    {
+        long long balance;
+        m256i publicKey;
+    };
+
+    void set(const m256i& publicKey, long long balance)
+    {
+        auto it = balances_.find(publicKey);
+        if (it != balances_.end())
+        {
+            if (it->second == balance) return;
+            ranked_.erase(Entry{it->second, publicKey});
+            if (balance > 0)
+            {
+                it->second = balance;
+            }
+            else
+            {
+                balances_.erase(it);
+                return;
+            }
+        }
+        else
+        {
+            if (balance <= 0) return;
+            balances_.emplace(publicKey, balance);
+        }
+        ranked_.insert(Entry{balance, publicKey});
+    }
+
+    void add(const m256i& publicKey, long long delta)
+    {
+        auto it = balances_.find(publicKey);
+        set(publicKey, (it == balances_.end() ? 0 : it->second) + delta);
+    }
+
+    void top(size_t n, std::vector<Entry>& out) const
+    {
+        out.clear();
+        for (auto it = ranked_.begin(); it != ranked_.end() && out.size() < n; ++it) out.push_back(*it);
+    }
+
+    size_t count() const { return ranked_.size(); }
+
+private:
+    struct KeyHash
+    {
+        size_t operator()(const m256i& k) const { return static_cast<size_t>(k.m256i_u64[0]); }
+    };
+    struct ByBalance
+    {
+        bool operator()(const Entry& a, const Entry& b) const
+        {
+            if (a.balance != b.balance) return a.balance > b.balance;
+            return a.publicKey < b.publicKey;
+        }
+    };
+    std::set<Entry, ByBalance> ranked_;
+    std::unordered_map<m256i, long long, KeyHash> balances_;
+};
+
+// Rich list over the spectrum (QU) and the universe (owned shares per asset).
+// usage: increaseEnergy/decreaseEnergy and the share transfer helpers report every change while
+// logs are simulated; the whole list is rebuilt after the state is loaded or reorganized.
+// Updates are dropped until the first rebuild, the state is not consistent before that.
+class RichList
+{
+public:
+    // An asset is identified by its issuer and its name (7 chars packed into the low 56 bits).
+    struct AssetKey
+    {
+        m256i issuer;
+        uint64_t name;
+        bool operator<(const AssetKey& o) const
+        {
+            if (name != o.name) return name < o.name;
+            return issuer < o.issuer;
+        }
+    };
+    using AssetMap = std::map<AssetKey, HolderRanking>;
+
+    void setQu(const m256i& publicKey, long long balance)
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        if (ready_) qu_.set(publicKey, balance);
+    }
+
+    void addShares(const m256i& issuer, uint64_t name, const m256i& owner, long long delta)
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        if (ready_) assets_[AssetKey{issuer, name}].add(owner, delta);
+    }
+
+    // Replace the whole list, e.g. after a rebuild built off-line.
+    void reset(HolderRanking&& qu, AssetMap&& assets)
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        std::swap(qu_, qu);
+        std::swap(assets_, assets);
+        ready_ = true;
+    }
+
+    /**
+     * @brief Copies the n largest QU holders and the total number of holders.
+     * @return False if the list has not been built yet.
+     */
+    bool topQu(size_t n, std::vector<HolderRanking::Entry>& out, size_t& holders)
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        if (!ready_) return false;
+        qu_.top(n, out);
+        holders = qu_.count();
+        return true;
+    }
+
+    /**
+     * @brief Copies the n largest owners of an asset and its number of owners (0 for unknown assets).
+     * @return False if the list has not been built yet.
+     */
+    bool topAsset(const m256i& issuer, uint64_t name, size_t n, std::vector<HolderRanking::Entry>& out, size_t& holders)
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        out.clear();
+        holders = 0;
+        if (!ready_) return false;
+        auto it = assets_.find(AssetKey{issuer, name});
+        if (it != assets_.end())
+        {
+            it->second.top(n, out);
+            holders = it->second.count();
+        }
+        return true;
+    }
+
+private:
+    HolderRanking qu_;
+    AssetMap assets_;
+    bool ready_ = false;
+    std::shared_mutex mtx_;
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Journal of the balance changes made by the log simulator, one entry per changed record.
+// usage: increaseEnergy/decreaseEnergy and the share helpers in Asset.h call record() right after
+// they change a balance; the verifier persists the entries of a batch once its digests are verified
+// (take() + db_insert_state_deltas() + commit()). Until commit() the taken entries stay readable,
+// so a reader never misses a change that is on its way to the database.
+// Record indices are stable within an epoch (the tables only grow), so index + tick identify a balance.
+class StateJournal
+{
+public:
+    enum Kind : uint8_t
+    {
+        QU = 0,     // balance of a spectrum entity
+        SHARES = 1, // numberOfShares of an ownership or possession record
+    };
+
+    struct Delta
+    {
+        uint32_t tick;
+        uint32_t ordinal; // position among the changes of the same tick
+        uint32_t index;   // spectrum or universe slot
+        uint8_t kind;
+        long long oldValue;
+        long long newValue;
+    };
+
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    bool enabled() const { return enabled_; }
+
+    // Tick of the log event being simulated; set by the simulator before it applies the event.
+    void setTick(uint32_t tick) { tick_ = tick; }
+
+    void record(Kind kind, uint32_t index, long long oldValue, long long newValue)
+    {
+        if (!enabled_ || oldValue == newValue) return;
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (tick_ != lastTick_)
+        {
+            lastTick_ = tick_;
+            ordinal_ = 0;
+        }
+        pending_.push_back(Delta{tick_, ordinal_++, index, kind, oldValue, newValue});
+    }
+
+    // In-flight entries kept while persisting fails (about 160 MB).
+    static constexpr size_t kMaxInflight = size_t(1) << 22;
+
+    // Moves the pending entries to the in-flight set and returns a copy of them for persisting. When
+    // persisting keeps failing and the set outgrows kMaxInflight, its oldest entries are dropped and
+    // counted in dropped; the history of their ticks is lost.
+    std::vector<Delta> take(size_t& dropped)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        inflight_.insert(inflight_.end(), pending_.begin(), pending_.end());
+        pending_.clear();
+        dropped = 0;
+        if (inflight_.size() > kMaxInflight)
+        {
+            dropped = inflight_.size() - kMaxInflight;
+            inflight_.erase(inflight_.begin(), inflight_.begin() + dropped);
+        }
+        return inflight_;
+    }
+
+    // The entries returned by take() are persisted.
+    void commit()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        inflight_.clear();
+    }
+
+    // Drops the entries not taken yet, e.g. when the batch that made them is rolled back.
+    void discardPending()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        pending_.clear();
+        lastTick_ = 0;
+        ordinal_ = 0;
+    }
+
+    // Drops everything, e.g. before the state is reloaded from a file.
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        pending_.clear();
+        inflight_.clear();
+        lastTick_ = 0;
+        ordinal_ = 0;
+    }
+
+    /**
+     * @brief Finds the value a record had right before its first not yet persisted change after a tick.
+     * @return False if the record has no such change.
+     */
+    bool firstUnpersistedOldValue(Kind kind, uint32_t index, uint32_t afterTick, long long& value)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (const auto* list : {&inflight_, &pending_})
+        {
+            for (const auto& d : *list)
+            {
+                if (d.kind == kind && d.index == index && d.tick > afterTick)
+                {
+                    value = d.oldValue;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+    std::atomic_bool enabled_{false};
+    std::atomic<uint32_t> tick_{0};
+    uint32_t lastTick_ = 0;
+    uint32_t ordinal_ = 0;
+    std::vector<Delta> pending_;
+    std::vector<Delta> inflight_;
+    std::mutex mtx_;
+};
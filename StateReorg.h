@@ -0,0 +1,327 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "Entity.h"
+#include "Asset.h"
+
+// Parallel versions of reorganizeSpectrum (Entity.h) and assetsEndEpoch (Asset.h).
+//
+// Both rebuild a linear-probing hash table. Without deletions, the set of occupied slots of
+// such a table only depends on the home buckets of the inserted records, not on the insertion
+// order. A slot that stays empty is never crossed by a probe. So the table can be cut at slots
+// that will stay empty, and each segment can be rebuilt on its own by replaying, in the serial
+// order, only the inserts that start in it. The result is bit-identical to the serial loops.
+// Live records are first copied out in source order. The table is then cleared and rebuilt in
+// place, so no full-size temporary buffer is needed and nothing is copied back.
+namespace state_reorg
+{
+    static unsigned workerCount(unsigned workers)
+    {
+        if (workers == 0) workers = std::thread::hardware_concurrency();
+        return std::max(1u, workers);
+    }
+
+    // Runs fn(w) for w in [0, workers), the first one on the calling thread.
+    template <typename F>
+    static void runParallel(unsigned workers, F&& fn)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (unsigned w = 1; w < workers; w++) threads.emplace_back(fn, w);
+        fn(0);
+        for (auto& t : threads) t.join();
+    }
+
+    static uint64_t chunkBegin(uint64_t n, unsigned workers, unsigned w) { return n * w / workers; }
+
+    /**
+     * @brief Picks segment boundaries at slots that stay empty after the rebuild.
+     * @param homeCount Number of records per home bucket. An upper bound is fine: it only makes
+     *                  the occupancy estimate a superset of the real one.
+     * @param total Sum of homeCount.
+     * @param segments Wanted number of segments.
+     * @param bounds Receives the sorted first slot of every segment. The last segment wraps around.
+     * @return False if the table cannot be split (fewer than two boundaries).
+     */
+    static bool findSegmentBounds(const std::vector<uint32_t>& homeCount, uint64_t total, unsigned segments,
+                                  std::vector<uint32_t>& bounds)
+    {
+        const uint64_t n = homeCount.size();
+        bounds.clear();
+        if (total >= n) return false;
+        // Sweep the circle twice: the first lap settles the carry that wraps into slot 0,
+        // the second lap is then exact.
+        uint64_t carry = 0;
+        for (uint64_t s = 0; s < n; s++) {
+            carry += homeCount[s];
+            if (carry) carry--;
+        }
+        unsigned next = 0;
+        for (uint64_t s = 0; s < n; s++) {
+            carry += homeCount[s];
+            if (carry) {
+                carry--;
+                continue;
+            }
+            if (next < segments && s >= n * next / segments) {
+                bounds.push_back(static_cast<uint32_t>(s));
+                while (next < segments && n * next / segments <= s) next++;
+            }
+        }
+        return bounds.size() >= 2;
+    }
+
+    static unsigned segmentOf(const std::vector<uint32_t>& bounds, uint32_t home)
+    {
+        auto it = std::upper_bound(bounds.begin(), bounds.end(), home);
+        if (it == bounds.begin()) return static_cast<unsigned>(bounds.size() - 1); // wrapped part of the last segment
+        return static_cast<unsigned>(it - bounds.begin() - 1);
+    }
+
+    // Hands out segments to workers until all are done.
+    template <typename F>
+    static void forEachSegment(unsigned workers, unsigned segments, F&& fn)
+    {
+        std::atomic<unsigned> nextSegment{0};
+        runParallel(workers, [&](unsigned) {
+            for (unsigned s = nextSegment++; s < segments; s = nextSegment++) fn(s);
+        });
+    }
+
+    static bool sameIssuance(const AssetRecord& a, const AssetRecord& b)
+    {
+        return a.varStruct.issuance.publicKey == b.varStruct.issuance.publicKey
+               && memcmp(a.varStruct.issuance.name, b.varStruct.issuance.name, 7) == 0;
+    }
+}
+
+/**
+ * @brief Parallel reorganizeSpectrum. Produces exactly the same spectrum.
+ * @param workers Number of threads, 0 for one per hardware thread.
+ */
+static void reorganizeSpectrumParallel(unsigned workers = 0)
+{
+    using namespace state_reorg;
+    workers = workerCount(workers);
+    const uint64_t n = SPECTRUM_CAPACITY;
+
+    std::vector<std::vector<uint32_t>> live(workers);
+    std::vector<uint32_t> homeCount(n, 0);
+    runParallel(workers, [&](unsigned w) {
+        for (uint64_t i = chunkBegin(n, workers, w); i < chunkBegin(n, workers, w + 1); i++) {
+            if (spectrum[i].incomingAmount - spectrum[i].outgoingAmount) {
+                live[w].push_back(static_cast<uint32_t>(i));
+                __atomic_fetch_add(&homeCount[spectrum[i].publicKey.m256i_u32[0] & (SPECTRUM_CAPACITY - 1)], 1, __ATOMIC_RELAXED);
+            }
+        }
+    });
+    uint64_t total = 0;
+    for (const auto& l : live) total += l.size();
+
+    std::vector<uint32_t> bounds;
+    if (workers == 1 || !findSegmentBounds(homeCount, total, workers * 8, bounds)) {
+        reorganizeSpectrum();
+        return;
+    }
+    homeCount = std::vector<uint32_t>();
+    const unsigned segments = static_cast<unsigned>(bounds.size());
+
+    // copy live records out, bucketed by segment; worker order keeps the source order
+    std::vector<std::vector<std::vector<EntityRecord>>> parts(workers, std::vector<std::vector<EntityRecord>>(segments));
+    runParallel(workers, [&](unsigned w) {
+        for (uint32_t i : live[w]) {
+            const uint32_t home = spectrum[i].publicKey.m256i_u32[0] & (SPECTRUM_CAPACITY - 1);
+            parts[w][segmentOf(bounds, home)].push_back(spectrum[i]);
+        }
+    });
+    runParallel(workers, [&](unsigned w) {
+        const uint64_t from = chunkBegin(n, workers, w);
+        setMem(&spectrum[from], (chunkBegin(n, workers, w + 1) - from) * sizeof(EntityRecord), 0);
+    });
+
+    forEachSegment(workers, segments, [&](unsigned s) {
+        for (unsigned w = 0; w < workers; w++) {
+            for (const EntityRecord& rec : parts[w][s]) {
+                unsigned int index = rec.publicKey.m256i_u32[0] & (SPECTRUM_CAPACITY - 1);
+                while (!isZero(spectrum[index].publicKey)) index = (index + 1) & (SPECTRUM_CAPACITY - 1);
+                copyMem(&spectrum[index], &rec, sizeof(EntityRecord));
+            }
+        }
+    });
+}
+
+/**
+ * @brief Parallel assetsEndEpoch. Produces exactly the same universe and marks all of it as changed.
+ * @param workers Number of threads, 0 for one per hardware thread.
+ *
+ * Every live possession is one "move" that finds or inserts an issuance, an ownership and a
+ * possession, each in its own segment. While a segment is rebuilt, a new ownership stores the
+ * index of the move that created it in issuanceIndex, and a new possession does the same in
+ * ownershipIndex. Records are matched by comparing the moves' source records. The real indices
+ * are filled in once all segments are done.
+ */
+static void assetsEndEpochParallel(unsigned workers = 0)
+{
+    using namespace state_reorg;
+    workers = workerCount(workers);
+    const uint64_t n = ASSETS_CAPACITY;
+    constexpr uint32_t kIssuance = 0, kOwnership = 1, kPossession = 2;
+
+    ACQUIRE(universeLock);
+    std::vector<std::vector<uint32_t>> live(workers);
+    std::vector<uint32_t> homeCount(n, 0);
+    std::vector<uint64_t> counted(n / 64, 0); // old issuance/ownership slots already counted once
+    auto countOnce = [&](uint32_t oldIndex, uint32_t home) {
+        const uint64_t bit = 1ULL << (oldIndex & 63);
+        if (!(__atomic_fetch_or(&counted[oldIndex >> 6], bit, __ATOMIC_RELAXED) & bit)) {
+            __atomic_fetch_add(&homeCount[home], 1, __ATOMIC_RELAXED);
+        }
+    };
+    runParallel(workers, [&](unsigned w) {
+        for (uint64_t i = chunkBegin(n, workers, w); i < chunkBegin(n, workers, w + 1); i++) {
+            if (assets[i].varStruct.possession.type == POSSESSION
+                && assets[i].varStruct.possession.numberOfShares > 0)
+            {
+                const unsigned int oldOwnershipIndex = assets[i].varStruct.possession.ownershipIndex;
+                const unsigned int oldIssuanceIndex = assets[oldOwnershipIndex].varStruct.ownership.issuanceIndex;
+                live[w].push_back(static_cast<uint32_t>(i));
+                __atomic_fetch_add(&homeCount[assets[i].varStruct.possession.publicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1)], 1, __ATOMIC_RELAXED);
+                countOnce(oldOwnershipIndex, assets[oldOwnershipIndex].varStruct.ownership.publicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1));
+                countOnce(oldIssuanceIndex, assets[oldIssuanceIndex].varStruct.issuance.publicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1));
+            }
+        }
+    });
+    counted = std::vector<uint64_t>();
+    uint64_t total = 0;
+    std::vector<uint32_t> firstMove(workers + 1, 0);
+    for (unsigned w = 0; w < workers; w++) {
+        total += live[w].size();
+        firstMove[w + 1] = firstMove[w] + static_cast<uint32_t>(live[w].size());
+    }
+    // homeCount over-counts merged records, which only makes the occupancy estimate larger
+    uint64_t estimated = 0;
+    for (uint32_t c : homeCount) estimated += c;
+
+    std::vector<uint32_t> bounds;
+    if (workers == 1 || !findSegmentBounds(homeCount, estimated, workers * 8, bounds)) {
+        RELEASE(universeLock);
+        assetsEndEpoch();
+        return;
+    }
+    homeCount = std::vector<uint32_t>();
+    const unsigned segments = static_cast<unsigned>(bounds.size());
+
+    struct Move
+    {
+        AssetRecord issuance, ownership, possession;
+    };
+    std::vector<Move> moves(total);
+    // per segment, the inserts of every worker in source order: (move << 2) | kind
+    std::vector<std::vector<std::vector<uint32_t>>> parts(workers, std::vector<std::vector<uint32_t>>(segments));
+    runParallel(workers, [&](unsigned w) {
+        uint32_t k = firstMove[w];
+        for (uint32_t i : live[w]) {
+            Move& m = moves[k];
+            const unsigned int oldOwnershipIndex = assets[i].varStruct.possession.ownershipIndex;
+            const unsigned int oldIssuanceIndex = assets[oldOwnershipIndex].varStruct.ownership.issuanceIndex;
+            copyMem(&m.possession, &assets[i], sizeof(AssetRecord));
+            copyMem(&m.ownership, &assets[oldOwnershipIndex], sizeof(AssetRecord));
+            copyMem(&m.issuance, &assets[oldIssuanceIndex], sizeof(AssetRecord));
+            parts[w][segmentOf(bounds, m.issuance.varStruct.issuance.publicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1))].push_back((k << 2) | kIssuance);
+            parts[w][segmentOf(bounds, m.ownership.varStruct.ownership.publicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1))].push_back((k << 2) | kOwnership);
+            parts[w][segmentOf(bounds, m.possession.varStruct.possession.publicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1))].push_back((k << 2) | kPossession);
+            k++;
+        }
+    });
+    live = std::vector<std::vector<uint32_t>>();
+    runParallel(workers, [&](unsigned w) {
+        const uint64_t from = chunkBegin(n, workers, w);
+        setMem(&assets[from], (chunkBegin(n, workers, w + 1) - from) * sizeof(AssetRecord), 0);
+    });
+
+    std::vector<uint32_t> issuancePos(total), ownershipPos(total), possessionPos(total);
+    std::vector<uint8_t> createdOwnership(total, 0), createdPossession(total, 0);
+    auto sameOwnership = [&](uint32_t a, uint32_t b) {
+        return moves[a].ownership.varStruct.ownership.publicKey == moves[b].ownership.varStruct.ownership.publicKey
+               && moves[a].ownership.varStruct.ownership.managingContractIndex == moves[b].ownership.varStruct.ownership.managingContractIndex
+               && sameIssuance(moves[a].issuance, moves[b].issuance);
+    };
+    forEachSegment(workers, segments, [&](unsigned s) {
+        for (unsigned w = 0; w < workers; w++) {
+            for (uint32_t entry : parts[w][s]) {
+                const uint32_t k = entry >> 2;
+                const Move& m = moves[k];
+                if ((entry & 3) == kIssuance) {
+                    unsigned int index = m.issuance.varStruct.issuance.publicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1);
+                    while (!(assets[index].varStruct.issuance.type == EMPTY
+                             || (assets[index].varStruct.issuance.type == ISSUANCE && sameIssuance(assets[index], m.issuance))))
+                    {
+                        index = (index + 1) & (ASSETS_CAPACITY - 1);
+                    }
+                    if (assets[index].varStruct.issuance.type == EMPTY) copyMem(&assets[index], &m.issuance, sizeof(AssetRecord));
+                    issuancePos[k] = index;
+                } else if ((entry & 3) == kOwnership) {
+                    const auto& own = m.ownership.varStruct.ownership;
+                    unsigned int index = own.publicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1);
+                    while (!(assets[index].varStruct.ownership.type == EMPTY
+                             || (assets[index].varStruct.ownership.type == OWNERSHIP
+                                 && assets[index].varStruct.ownership.managingContractIndex == own.managingContractIndex
+                                 && assets[index].varStruct.ownership.publicKey == own.publicKey
+                                 && assets[index].varStruct.ownership.issuanceIndex < total
+                                 && sameIssuance(moves[assets[index].varStruct.ownership.issuanceIndex].issuance, m.issuance))))
+                    {
+                        index = (index + 1) & (ASSETS_CAPACITY - 1);
+                    }
+                    auto& dst = assets[index].varStruct.ownership;
+                    if (dst.type == EMPTY) {
+                        dst.publicKey = own.publicKey;
+                        dst.type = OWNERSHIP;
+                        dst.managingContractIndex = own.managingContractIndex;
+                        dst.issuanceIndex = k;
+                        createdOwnership[k] = 1;
+                    }
+                    dst.numberOfShares += m.possession.varStruct.possession.numberOfShares;
+                    ownershipPos[k] = index;
+                } else {
+                    const auto& pos = m.possession.varStruct.possession;
+                    unsigned int index = pos.publicKey.m256i_u32[0] & (ASSETS_CAPACITY - 1);
+                    while (!(assets[index].varStruct.possession.type == EMPTY
+                             || (assets[index].varStruct.possession.type == POSSESSION
+                                 && assets[index].varStruct.possession.managingContractIndex == pos.managingContractIndex
+                                 && assets[index].varStruct.possession.publicKey == pos.publicKey
+                                 && assets[index].varStruct.possession.ownershipIndex < total
+                                 && sameOwnership(assets[index].varStruct.possession.ownershipIndex, k))))
+                    {
+                        index = (index + 1) & (ASSETS_CAPACITY - 1);
+                    }
+                    auto& dst = assets[index].varStruct.possession;
+                    if (dst.type == EMPTY) {
+                        dst.publicKey = pos.publicKey;
+                        dst.type = POSSESSION;
+                        dst.managingContractIndex = pos.managingContractIndex;
+                        dst.ownershipIndex = k;
+                        createdPossession[k] = 1;
+                    }
+                    dst.numberOfShares += pos.numberOfShares;
+                    possessionPos[k] = index;
+                }
+            }
+        }
+    });
+
+    // replace the creating move ids by the final indices
+    runParallel(workers, [&](unsigned w) {
+        for (uint64_t k = chunkBegin(total, workers, w); k < chunkBegin(total, workers, w + 1); k++) {
+            if (createdOwnership[k]) assets[ownershipPos[k]].varStruct.ownership.issuanceIndex = issuancePos[k];
+            if (createdPossession[k]) assets[possessionPos[k]].varStruct.possession.ownershipIndex = ownershipPos[k];
+        }
+    });
+
+    setMem(assetChangeFlags, ASSETS_CAPACITY / 8, 0xFF);
+
+    RELEASE(universeLock);
+}
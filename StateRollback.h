@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include "Entity.h"
+#include "Asset.h"
+
+// Derived state (rich list, asset holder index) kept in step with the spectrum and universe, and the
+// batch rollback that restores all of them from the undo journal.
+
+// Rebuilds the rich list from the whole spectrum and universe. Call after loading or reorganizing them.
+static void rebuildRichList()
+{
+    HolderRanking qu;
+    for (unsigned int i = 0; i < SPECTRUM_CAPACITY; i++)
+    {
+        const long long balance = spectrum[i].incomingAmount - spectrum[i].outgoingAmount;
+        if (balance > 0) qu.set(spectrum[i].publicKey, balance);
+    }
+    RichList::AssetMap owners;
+    for (unsigned int i = 0; i < ASSETS_CAPACITY; i++)
+    {
+        const auto& ownership = assets[i].varStruct.ownership;
+        if (ownership.type != OWNERSHIP || ownership.numberOfShares <= 0) continue;
+        const auto& issuance = assets[ownership.issuanceIndex & (ASSETS_CAPACITY - 1)].varStruct.issuance;
+        const uint64_t name = (*((unsigned long long*)issuance.name)) & 0xFFFFFFFFFFFFFF;
+        owners[RichList::AssetKey{issuance.publicKey, name}].add(ownership.publicKey, ownership.numberOfShares);
+    }
+    richList.reset(std::move(qu), std::move(owners));
+}
+
+// Puts back the before-images of the undo journal and clears it. The rich list and the holder index are
+// moved back with the records; the restored slots are flagged so the caller can rehash them.
+static void restoreUndoJournal()
+{
+    // rich list and holder index need the records as the batch left them
+    for (const auto& img : undoJournal.assetImages())
+    {
+        const AssetRecord& current = assets[img.index];
+        const AssetRecord& before = *reinterpret_cast<const AssetRecord*>(img.bytes);
+        if (current.varStruct.ownership.type == OWNERSHIP)
+        {
+            const long long beforeShares = before.varStruct.ownership.type == OWNERSHIP ? before.varStruct.ownership.numberOfShares : 0;
+            rankOwnershipChange(img.index, beforeShares - current.varStruct.ownership.numberOfShares);
+        }
+        if (before.varStruct.issuance.type == EMPTY && current.varStruct.issuance.type != EMPTY)
+        {
+            assetHolderIndex.remove(current.varStruct.issuance.publicKey, img.index);
+        }
+    }
+    for (const auto& img : undoJournal.assetImages())
+    {
+        memcpy(&assets[img.index], img.bytes, sizeof(AssetRecord));
+        assetChangeFlags[img.index >> 6] |= (1ULL << (img.index & 63));
+    }
+    for (const auto& img : undoJournal.spectrumImages())
+    {
+        const m256i publicKey = spectrum[img.index].publicKey;
+        memcpy(&spectrum[img.index], img.bytes, sizeof(EntityRecord));
+        richList.setQu(publicKey, energy(img.index));
+        spectrumChangeFlags[img.index >> 6] |= (1ULL << (img.index & 63));
+    }
+    undoJournal.clear();
+}
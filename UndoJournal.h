@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Before-images of the spectrum and universe records changed by the batch being verified.
+// usage: the verifier calls clear() before it simulates a batch; increaseEnergy/decreaseEnergy and
+// the asset helpers call save*() right before they change a record. Only the first change of a
+// record in the batch is kept, so putting the images back restores the state before the batch.
+// Only the verify thread touches it, there is no locking.
+class UndoJournal
+{
+public:
+    static constexpr size_t kSpectrumRecordSize = 64; // sizeof(EntityRecord)
+    static constexpr size_t kAssetRecordSize = 48;    // sizeof(AssetRecord)
+
+    struct Image
+    {
+        uint32_t index;
+        uint8_t bytes[kSpectrumRecordSize];
+    };
+
+    void saveSpectrum(uint32_t index, const void* record) { save(spectrum_, index, record, kSpectrumRecordSize); }
+    void saveAsset(uint32_t index, const void* record) { save(assets_, index, record, kAssetRecordSize); }
+
+    const std::vector<Image>& spectrumImages() const { return spectrum_.images; }
+    const std::vector<Image>& assetImages() const { return assets_.images; }
+
+    void clear()
+    {
+        reset(spectrum_);
+        reset(assets_);
+    }
+
+private:
+    struct Table
+    {
+        std::vector<Image> images;
+        std::vector<uint64_t> saved; // one bit per slot, sized on first use
+    };
+
+    static void save(Table& t, uint32_t index, const void* record, size_t size)
+    {
+        const size_t word = index >> 6;
+        if (word >= t.saved.size()) t.saved.resize(word + 1, 0);
+        const uint64_t bit = 1ULL << (index & 63);
+        if (t.saved[word] & bit) return;
+        t.saved[word] |= bit;
+        t.images.emplace_back();
+        t.images.back().index = index;
+        memcpy(t.images.back().bytes, record, size);
+    }
+
+    // Clears only the bits that were set, the bitsets span the whole tables.
+    static void reset(Table& t)
+    {
+        for (const auto& img : t.images) t.saved[img.index >> 6] = 0;
+        t.images.clear();
+    }
+
+    Table spectrum_;
+    Table assets_;
+};
@@ -18,10 +18,11 @@
 #include "Version.h"
 void IOVerifyThread(std::atomic_bool& stopFlag);
 void IORequestThread(ConnectionPool& conn_pool, std::atomic_bool& stopFlag, std::chrono::milliseconds requestCycle, uint32_t futureOffset);
-void EventRequestFromTrustedNode(ConnectionPool& connPoolWithPwd, std::atomic_bool& stopFlag, std::chrono::milliseconds request_logging_cycle_ms);
-void connReceiver(QCPtr& conn, const bool isTrustedNode, std::atomic_bool& stopFlag);
+void EventRequestFromTrustedNode(ConnectionPool& connPoolWithPwd, std::atomic_bool& stopFlag, std::chrono::milliseconds request_logging_cycle_ms, uint32_t fetchWindow, uint32_t speculativeTicks);
+void connReceiver(QCPtr& conn, const bool isTrustedNode, const bool isBundlePeer, std::atomic_bool& stopFlag);
 void DataProcessorThread(std::atomic_bool& exitFlag);
 void RequestProcessorThread(std::atomic_bool& exitFlag);
+void TickBundleServerThread(std::atomic_bool& exitFlag);
 void verifyLoggingEvent(std::atomic_bool& stopFlag);
 void indexVerifiedTicks(std::atomic_bool& stopFlag);
 void querySmartContractThread(ConnectionPool& connPoolAll, std::atomic_bool& stopFlag);
@@ -29,6 +30,8 @@ void querySmartContractThread(ConnectionPool& connPoolAll, std::atomic_bool& sto
 bool StartQubicServer(uint16_t port = 21842);
 void StopQubicServer();
 void garbageCleaner(std::atomic_bool& stopFlag);
+bool fastSyncFromBobPeer(ConnectionPool& cp);
+void backfillThread(ConnectionPool& cp, std::atomic_bool& stopFlag);
 
 std::atomic_bool stopFlag{false};
 
@@ -76,6 +79,8 @@ int runBob(int argc, char *argv[])
     std::string log_level = cfg.log_level;
     Logger::init(log_level);
     printVersionInfo();
+    configureGlobalStateMemory(cfg.huge_pages, cfg.numa_node);
+    Logger::get()->info("Global state: {}", globalStateMemoryInfo());
     {
         getSubseedFromSeed((uint8_t *) cfg.node_seed.c_str(), nodeSubseed.m256i_u8);
         getPrivateKeyFromSubSeed(nodeSubseed.m256i_u8, nodePrivatekey.m256i_u8);
@@ -90,8 +95,12 @@ int runBob(int argc, char *argv[])
     gTxStorageMode = cfg.tx_storage_mode;
     gTxTickToLive = cfg.tx_tick_to_live;
     gSpamThreshold = cfg.spam_qu_threshold;
+    gBundlePeers = cfg.bundle_peers;
     gMaxThreads = cfg.max_thread;
     gKvrocksTTL = cfg.kvrocks_ttl;
+    gVtickCompressionLevel = cfg.vtick_compression_level;
+    gVtickDictionary = cfg.vtick_dictionary;
+    stateJournal.setEnabled(cfg.state_journal);
 
     // Defaults for new knobs are already in AppConfig
     unsigned int request_cycle_ms = cfg.request_cycle_ms;
@@ -118,7 +127,18 @@ int runBob(int argc, char *argv[])
     }
 
     {
-        db_connect(KEYDB_CONNECTION_STRING);
+        if (cfg.storage_backend == StorageBackendMode::Embedded)
+            db_open_embedded(cfg.embedded_storage_path);
+        else
+        {
+            DbPoolOptions pools;
+            pools.ingestPoolSize = cfg.keydb_ingest_pool_size;
+            pools.backgroundPoolSize = cfg.keydb_background_pool_size;
+            pools.apiPoolSize = cfg.keydb_api_pool_size;
+            pools.replicaUrl = cfg.keydb_replica_url;
+            pools.replicaMaxLagTicks = cfg.keydb_replica_max_lag;
+            db_connect(KEYDB_CONNECTION_STRING, pools);
+        }
         uint32_t tick;
         uint16_t epoch;
         db_get_latest_tick_and_epoch(tick, epoch);
@@ -135,12 +155,25 @@ int runBob(int argc, char *argv[])
 
     if (gTickStorageMode == TickStorageMode::Kvrocks)
     {
-        db_kvrocks_connect(cfg.kvrocks_url);
-        Logger::get()->info("Connected to kvrocks");
+        if (cfg.storage_backend == StorageBackendMode::Embedded)
+        {
+            db_kvrocks_open_embedded(cfg.embedded_storage_path);
+            Logger::get()->info("Opened embedded cold storage in {}", cfg.embedded_storage_path);
+        }
+        else
+        {
+            db_kvrocks_connect(cfg.kvrocks_url);
+            Logger::get()->info("Connected to kvrocks");
+        }
+    }
+    if (!cfg.log_segment_path.empty())
+    {
+        db_open_log_segments(cfg.log_segment_path);
     }
     // Collect endpoints from config
     ConnectionPool connPool; // conn pool with passcode
-    if (cfg.p2p_nodes.empty())
+    const bool peersFromDNS = cfg.p2p_nodes.empty();
+    if (peersFromDNS)
     {
         Logger::get()->info("Getting peers info from qubic.global");
         cfg.p2p_nodes = GetPeerFromDNS();
@@ -151,205 +184,276 @@ int runBob(int argc, char *argv[])
         Logger::get()->error("0 valid connection");
         exit(1);
     }
-    while (connPool.size() > 4) connPool.randomlyRemove();
-
-
-    uint32_t initTick = 0;
-    uint16_t initEpoch = 0;
-    uint32_t endEpochTick = 0;
-    std::string key = "end_epoch_tick:" + std::to_string(gCurrentProcessingEpoch);
-    bool isThisEpochAlreadyEnd = db_get_u32(key, endEpochTick);
-    int retryCount = 0;
-    while ((initTick == 0 ||
-            ( (initEpoch < gCurrentProcessingEpoch && !isThisEpochAlreadyEnd) ||
-              (initEpoch <= gCurrentProcessingEpoch && isThisEpochAlreadyEnd)
-            ))
-            && (!stopFlag.load())
-    )
+    // endpoints not kept in the pool; used to replace peers that stay slow or dead
+    std::vector<std::string> sparePeers;
+    connPool.trimTo(4, sparePeers);
+
+
+    // One iteration per epoch. The fetch/verify/index pipeline stops at the end of an epoch and is
+    // started again for the next one; only a user stop or a fault leaves the loop.
+    std::atomic_bool epochStopFlag{false};
+    while (!stopFlag.load())
     {
-        doHandshakeAndGetBootstrapInfo(connPool, true, initTick, initEpoch);
-        if (isThisEpochAlreadyEnd) Logger::get()->info("Waiting for new epoch info from peers | PeerInitTick: {} PeerInitEpoch {}...", initTick, initEpoch);
-        else Logger::get()->info("Doing handshakes and ask for bootstrap info | PeerInitTick: {} PeerInitEpoch {}...", initTick, initEpoch);
-        if (initTick == 0 || initEpoch <= gCurrentProcessingEpoch) SLEEP(1000);
-        if (retryCount++ > 300)
+        epochStopFlag = false;
+        uint32_t initTick = 0;
+        uint16_t initEpoch = 0;
+        uint32_t endEpochTick = 0;
+        std::string key = "end_epoch_tick:" + std::to_string(gCurrentProcessingEpoch);
+        bool isThisEpochAlreadyEnd = db_get_u32(key, endEpochTick);
+        int retryCount = 0;
+        while ((initTick == 0 ||
+                ( (initEpoch < gCurrentProcessingEpoch && !isThisEpochAlreadyEnd) ||
+                  (initEpoch <= gCurrentProcessingEpoch && isThisEpochAlreadyEnd)
+                ))
+                && (!stopFlag.load())
+        )
         {
-            Logger::get()->info("No meaningful response after 5 minutes. Exiting bob to get new peers");
-            stopFlag = true;
+            doHandshakeAndGetBootstrapInfo(connPool, true, initTick, initEpoch);
+            if (isThisEpochAlreadyEnd) Logger::get()->info("Waiting for new epoch info from peers | PeerInitTick: {} PeerInitEpoch {}...", initTick, initEpoch);
+            else Logger::get()->info("Doing handshakes and ask for bootstrap info | PeerInitTick: {} PeerInitEpoch {}...", initTick, initEpoch);
+            if (initTick == 0 || initEpoch <= gCurrentProcessingEpoch) SLEEP(1000);
+            if (retryCount++ > 300)
+            {
+                Logger::get()->info("No meaningful response after 5 minutes. Exiting bob to get new peers");
+                stopFlag = true;
+            }
+        }
+        db_insert_u32("init_tick:"+std::to_string(initEpoch), initTick);
+        gInitialTick = initTick;
+        if (initTick > gCurrentFetchingTick.load())
+        {
+            gCurrentFetchingTick = initTick;
+        }
+        if (initTick > gCurrentFetchingLogTick.load())
+        {
+            gCurrentFetchingLogTick = initTick;
         }
-    }
-    db_insert_u32("init_tick:"+std::to_string(initEpoch), initTick);
-    gInitialTick = initTick;
-    if (initTick > gCurrentFetchingTick.load())
-    {
-        gCurrentFetchingTick = initTick;
-    }
-    if (initTick > gCurrentFetchingLogTick.load())
-    {
-        gCurrentFetchingLogTick = initTick;
-    }
-
-    if (initEpoch > gCurrentProcessingEpoch.load())
-    {
-        gCurrentProcessingEpoch = initEpoch;
-    }
 
-    if (computorsList.epoch != gCurrentProcessingEpoch.load())
-    {
-        while (computorsList.epoch != gCurrentProcessingEpoch.load())
+        if (initEpoch > gCurrentProcessingEpoch.load())
         {
-            getComputorList(connPool, cfg.arbitrator_identity);
-            SLEEP(1000);
+            gCurrentProcessingEpoch = initEpoch;
         }
-    }
 
+        if (computorsList.epoch != gCurrentProcessingEpoch.load())
+        {
+            while (computorsList.epoch != gCurrentProcessingEpoch.load())
+            {
+                getComputorList(connPool, cfg.arbitrator_identity);
+                SLEEP(1000);
+            }
+        }
 
-    auto request_thread = std::thread(
-            [&](){
-                set_this_thread_name("io-req");
-                IORequestThread(
-                        std::ref(connPool),
-                        std::ref(stopFlag),
-                        std::chrono::milliseconds(request_cycle_ms),
-                        static_cast<uint32_t>(future_offset)
-                );
+        if (cfg.fast_sync && db_get_latest_verified_tick() < (long long)gInitialTick.load())
+        {
+            if (!fastSyncFromBobPeer(connPool))
+            {
+                Logger::get()->info("Fast sync: no bob peer offered a valid checkpoint, replaying the epoch");
             }
-    );
-    auto verify_thread = std::thread([&](){
-        set_this_thread_name("verify");
-        IOVerifyThread(std::ref(stopFlag));
-    });
-    auto log_request_trusted_nodes_thread = std::thread([&](){
-        set_this_thread_name("trusted-log-req");
-        EventRequestFromTrustedNode(std::ref(connPool), std::ref(stopFlag),
-                                    std::chrono::milliseconds(request_logging_cycle_ms));
-    });
-    auto indexer_thread = std::thread([&](){
-        set_this_thread_name("indexer");
-        indexVerifiedTicks(std::ref(stopFlag));
-    });
-    auto sc_thread = std::thread([&](){
-        set_this_thread_name("sc");
-        querySmartContractThread(connPool, std::ref(stopFlag));
-    });
-    int pool_size = connPool.size();
-    std::vector<std::thread> v_recv_thread;
-    std::vector<std::thread> v_data_thread;
-    Logger::get()->info("Starting {} data processor threads", pool_size);
-    const bool isTrustedNode = true;
-    gNumBMConnection = 0;
-    for (int i = 0; i < pool_size; i++)
-    {
-        v_recv_thread.emplace_back([&, i](){
-            char nm[16];
-            std::snprintf(nm, sizeof(nm), "recv-%d", i);
-            set_this_thread_name(nm);
-            connReceiver(std::ref(connPool.get(i)), isTrustedNode, std::ref(stopFlag));
+        }
+
+
+        auto request_thread = std::thread(
+                [&](){
+                    set_this_thread_name("io-req");
+                    IORequestThread(
+                            std::ref(connPool),
+                            std::ref(epochStopFlag),
+                            std::chrono::milliseconds(request_cycle_ms),
+                            static_cast<uint32_t>(future_offset)
+                    );
+                }
+        );
+        auto verify_thread = std::thread([&](){
+            set_this_thread_name("verify");
+            db_set_thread_workload(DbWorkload::Background);
+            IOVerifyThread(std::ref(epochStopFlag));
         });
-        if (connPool.get(i)->isBM()) gNumBMConnection++;
-    }
-    for (int i = 0; i < std::max(gMaxThreads, pool_size); i++)
-    {
-        v_data_thread.emplace_back([&](){
-            set_this_thread_name("data");
-            DataProcessorThread(std::ref(stopFlag));
+        auto log_request_trusted_nodes_thread = std::thread([&](){
+            set_this_thread_name("trusted-log-req");
+            EventRequestFromTrustedNode(std::ref(connPool), std::ref(epochStopFlag),
+                                        std::chrono::milliseconds(request_logging_cycle_ms),
+                                        cfg.log_fetch_window, cfg.speculative_ticks);
         });
-        v_data_thread.emplace_back([&, i](){
-            char nm[16];
-            std::snprintf(nm, sizeof(nm), "reqp-%d", i);
-            set_this_thread_name(nm);
-            RequestProcessorThread(std::ref(stopFlag));
+        auto indexer_thread = std::thread([&](){
+            set_this_thread_name("indexer");
+            db_set_thread_workload(DbWorkload::Background);
+            indexVerifiedTicks(std::ref(epochStopFlag));
         });
-    }
-    std::thread log_event_verifier_thread;
-    log_event_verifier_thread = std::thread([&](){
-        set_this_thread_name("log-ver");
-        verifyLoggingEvent(std::ref(stopFlag));
-    });
-    std::thread garbage_thread;
-    if (cfg.tick_storage_mode != TickStorageMode::Free || cfg.tx_storage_mode != TxStorageMode::Free)
-    {
-        garbage_thread = std::thread(garbageCleaner, std::ref(stopFlag));
-    }
+        auto sc_thread = std::thread([&](){
+            set_this_thread_name("sc");
+            querySmartContractThread(connPool, std::ref(epochStopFlag));
+        });
+        auto backfill_thread = std::thread([&](){
+            set_this_thread_name("backfill");
+            db_set_thread_workload(DbWorkload::Background);
+            backfillThread(connPool, std::ref(epochStopFlag));
+        });
+        auto bundle_thread = std::thread([&](){
+            set_this_thread_name("bundle-srv");
+            db_set_thread_workload(DbWorkload::Background);
+            TickBundleServerThread(std::ref(epochStopFlag));
+        });
+        int pool_size = connPool.size();
+        std::vector<std::thread> v_recv_thread;
+        std::vector<std::thread> v_data_thread;
+        Logger::get()->info("Starting {} data processor threads", pool_size);
+        const bool isTrustedNode = true;
+        const bool isBundlePeer = true; // peers we connect to ourselves
+        gNumBMConnection = 0;
+        for (int i = 0; i < pool_size; i++)
+        {
+            v_recv_thread.emplace_back([&, i](){
+                char nm[16];
+                std::snprintf(nm, sizeof(nm), "recv-%d", i);
+                set_this_thread_name(nm);
+                connReceiver(std::ref(connPool.get(i)), isTrustedNode, isBundlePeer, std::ref(epochStopFlag));
+            });
+            if (connPool.get(i)->isBM()) gNumBMConnection++;
+        }
+        for (int i = 0; i < std::max(gMaxThreads, pool_size); i++)
+        {
+            v_data_thread.emplace_back([&](){
+                set_this_thread_name("data");
+                DataProcessorThread(std::ref(epochStopFlag));
+            });
+            v_data_thread.emplace_back([&, i](){
+                char nm[16];
+                std::snprintf(nm, sizeof(nm), "reqp-%d", i);
+                set_this_thread_name(nm);
+                db_set_thread_workload(DbWorkload::Api);
+                RequestProcessorThread(std::ref(epochStopFlag));
+            });
+        }
+        std::thread log_event_verifier_thread;
+        log_event_verifier_thread = std::thread([&](){
+            set_this_thread_name("log-ver");
+            db_set_thread_workload(DbWorkload::Background);
+            verifyLoggingEvent(std::ref(epochStopFlag));
+        });
+        std::thread garbage_thread;
+        if (cfg.tick_storage_mode != TickStorageMode::Free || cfg.tx_storage_mode != TxStorageMode::Free)
+        {
+            garbage_thread = std::thread([&](){
+                db_set_thread_workload(DbWorkload::Background);
+                garbageCleaner(epochStopFlag);
+            });
+        }
 
 
-    uint32_t prevFetchingTickData = 0;
-    uint32_t prevLoggingEventTick = 0;
-    uint32_t prevVerifyEventTick = 0;
-    uint32_t prevIndexingTick = 0;
-    const long long sleep_time = 5;
-    auto start_time = std::chrono::high_resolution_clock::now();
-    while (!stopFlag.load())
-    {
-        auto current_time = std::chrono::high_resolution_clock::now();
-        float duration_ms = float(std::chrono::duration_cast<std::chrono::milliseconds>(current_time - start_time).count());
-        start_time = std::chrono::high_resolution_clock::now();
-
-        float fetching_td_speed = (prevFetchingTickData == 0) ? 0: float(gCurrentFetchingTick.load() - prevFetchingTickData) / duration_ms * 1000.0f;
-        float fetching_le_speed = (prevLoggingEventTick == 0) ? 0: float(gCurrentFetchingLogTick.load() - prevLoggingEventTick) / duration_ms * 1000.0f;
-        float verify_le_speed = (prevVerifyEventTick == 0) ? 0: float(gCurrentVerifyLoggingTick.load() - prevVerifyEventTick) / duration_ms * 1000.0f;
-        float indexing_speed = (prevIndexingTick == 0) ? 0: float(gCurrentIndexingTick.load() - prevIndexingTick) / duration_ms * 1000.0f;
-        prevFetchingTickData = gCurrentFetchingTick.load();
-        prevLoggingEventTick = gCurrentFetchingLogTick.load();
-        prevVerifyEventTick = gCurrentVerifyLoggingTick.load();
-        prevIndexingTick = gCurrentIndexingTick.load();
-        Logger::get()->info(
-                "Current state: FetchingTick: {} ({:.1f}) | FetchingLog: {} ({:.1f}) | Indexing: {} ({:.1f}) | Verifying: {} ({:.1f})",
-                gCurrentFetchingTick.load(), fetching_td_speed,
-                gCurrentFetchingLogTick.load(), fetching_le_speed,
-                gCurrentIndexingTick.load(), indexing_speed,
-                gCurrentVerifyLoggingTick.load(), verify_le_speed);
-        requestMapperFrom.clean();
-        requestMapperTo.clean();
-        responseSCData.clean(10);
-
-        int count = 0;
-        while (count++ < sleep_time*10 && !stopFlag.load()) SLEEP(100);
-    }
-    // Signal stop, disconnect sockets first to break any blocking I/O.
-    for (int i = 0; i < connPool.size(); i++) connPool.get(i)->disconnect();
-    // Stop and join producer/request threads first so they cannot enqueue more work.
-    verify_thread.join();
-    Logger::get()->info("Exited Verifying thread");
-    request_thread.join();
-    Logger::get()->info("Exited TickDataRequest thread");
-    log_request_trusted_nodes_thread.join();
-    Logger::get()->info("Exited LogEventRequestTrustedNodes thread");
-    indexer_thread.join();
-    Logger::get()->info("Exited indexer thread");
-    sc_thread.join();
-    if (log_event_verifier_thread.joinable())
-    {
-        Logger::get()->info("Exiting verifyLoggingEvent thread");
-        log_event_verifier_thread.join();
-        Logger::get()->info("Exited verifyLoggingEvent thread");
-    }
+        uint32_t prevFetchingTickData = 0;
+        uint32_t prevLoggingEventTick = 0;
+        uint32_t prevVerifyEventTick = 0;
+        uint32_t prevIndexingTick = 0;
+        const long long sleep_time = 5;
+        unsigned peerCheckCounter = 0;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        while (!stopFlag.load() && !epochStopFlag.load())
+        {
+            auto current_time = std::chrono::high_resolution_clock::now();
+            float duration_ms = float(std::chrono::duration_cast<std::chrono::milliseconds>(current_time - start_time).count());
+            start_time = std::chrono::high_resolution_clock::now();
 
-    // Now the receivers can drain and exit.
-    for (auto& thr : v_recv_thread) thr.join();
-    Logger::get()->info("Exited recv threads");
+            float fetching_td_speed = (prevFetchingTickData == 0) ? 0: float(gCurrentFetchingTick.load() - prevFetchingTickData) / duration_ms * 1000.0f;
+            float fetching_le_speed = (prevLoggingEventTick == 0) ? 0: float(gCurrentFetchingLogTick.load() - prevLoggingEventTick) / duration_ms * 1000.0f;
+            float verify_le_speed = (prevVerifyEventTick == 0) ? 0: float(gCurrentVerifyLoggingTick.load() - prevVerifyEventTick) / duration_ms * 1000.0f;
+            float indexing_speed = (prevIndexingTick == 0) ? 0: float(gCurrentIndexingTick.load() - prevIndexingTick) / duration_ms * 1000.0f;
+            prevFetchingTickData = gCurrentFetchingTick.load();
+            prevLoggingEventTick = gCurrentFetchingLogTick.load();
+            prevVerifyEventTick = gCurrentVerifyLoggingTick.load();
+            prevIndexingTick = gCurrentIndexingTick.load();
+            Logger::get()->info(
+                    "Current state: FetchingTick: {} ({:.1f}) | FetchingLog: {} ({:.1f}) | Indexing: {} ({:.1f}) | Verifying: {} ({:.1f})",
+                    gCurrentFetchingTick.load(), fetching_td_speed,
+                    gCurrentFetchingLogTick.load(), fetching_le_speed,
+                    gCurrentIndexingTick.load(), indexing_speed,
+                    gCurrentVerifyLoggingTick.load(), verify_le_speed);
+            requestMapperFrom.clean();
+            requestMapperTo.clean();
+            responseSCData.clean(10);
+            Logger::get()->trace("{}", inflightRequests.GetUsageString());
+            db_refresh_keyspace(); // follows a running keyspace migration
 
-    // Wake all data threads so none remain blocked on MRB.
-    {
-        const size_t wake_count = v_data_thread.size() * 8; // ensure enough tokens
-        std::vector<RequestResponseHeader> tokens(wake_count);
-        for (auto& t : tokens) {
-            t.randomizeDejavu();
-            t.setType(35); // NOP
-            t.setSize(8);
+            connPool.updateScores(duration_ms / 1000.0f);
+            if (++peerCheckCounter % 12 == 0) // every minute
+            {
+                for (int i = 0; i < connPool.size(); i++) Logger::get()->debug("Peer {}", connPool.get(i)->getStatsString());
+                if (sparePeers.empty() && peersFromDNS)
+                {
+                    sparePeers = GetPeerFromDNS();
+                }
+                connPool.replaceSlowPeer(sparePeers);
+            }
+
+            int count = 0;
+            while (count++ < sleep_time*10 && !stopFlag.load() && !epochStopFlag.load()) SLEEP(100);
         }
-        for (size_t i = 0; i < wake_count; ++i) {
-            MRB_Data.EnqueuePacket(reinterpret_cast<uint8_t*>(&tokens[i]));
-            MRB_Request.EnqueuePacket(reinterpret_cast<uint8_t*>(&tokens[i]));
+        epochStopFlag = true;
+        // Signal stop, disconnect sockets first to break any blocking I/O.
+        for (int i = 0; i < connPool.size(); i++) connPool.get(i)->disconnect();
+        // Stop and join producer/request threads first so they cannot enqueue more work.
+        verify_thread.join();
+        Logger::get()->info("Exited Verifying thread");
+        request_thread.join();
+        Logger::get()->info("Exited TickDataRequest thread");
+        log_request_trusted_nodes_thread.join();
+        Logger::get()->info("Exited LogEventRequestTrustedNodes thread");
+        indexer_thread.join();
+        Logger::get()->info("Exited indexer thread");
+        sc_thread.join();
+        backfill_thread.join();
+        bundle_thread.join();
+        if (log_event_verifier_thread.joinable())
+        {
+            Logger::get()->info("Exiting verifyLoggingEvent thread");
+            log_event_verifier_thread.join();
+            Logger::get()->info("Exited verifyLoggingEvent thread");
         }
 
-        // Keep tokens alive until all data threads exit
-        for (auto& thr : v_data_thread) thr.join();
-    }
-    Logger::get()->info("Exited data threads");
-    if (cfg.tick_storage_mode != TickStorageMode::Free)
-    {
-        Logger::get()->info("Exiting garbage cleaner");
-        garbage_thread.join();
+        // Now the receivers can drain and exit.
+        for (auto& thr : v_recv_thread) thr.join();
+        Logger::get()->info("Exited recv threads");
+
+        // Wake all data threads so none remain blocked on MRB.
+        {
+            const size_t wake_count = v_data_thread.size() * 8; // ensure enough tokens
+            std::vector<RequestResponseHeader> tokens(wake_count);
+            for (auto& t : tokens) {
+                t.randomizeDejavu();
+                t.setType(35); // NOP
+                t.setSize(8);
+            }
+            for (size_t i = 0; i < wake_count; ++i) {
+                MRB_Data.EnqueuePacket(reinterpret_cast<uint8_t*>(&tokens[i]));
+                MRB_Request.EnqueuePacket(reinterpret_cast<uint8_t*>(&tokens[i]));
+            }
+
+            // Keep tokens alive until all data threads exit
+            for (auto& thr : v_data_thread) thr.join();
+        }
+        Logger::get()->info("Exited data threads");
+        if (garbage_thread.joinable())
+        {
+            Logger::get()->info("Exiting garbage cleaner");
+            garbage_thread.join();
+        }
+
+        if (stopFlag.load() || !gIsEndEpoch) break;
+        // Roll over to the next epoch in process: servers, DB connections and the reorganized
+        // spectrum/universe stay as they are, only the per-epoch pipeline is restarted.
+        Logger::get()->info("Epoch {} ended. Waiting for the next epoch without restarting", gCurrentProcessingEpoch.load());
+        gIsEndEpoch = false;
+        refetchFromId = -1;
+        refetchToId = -1;
+        refetchLogFromTick = -1;
+        refetchLogToTick = -1;
+        refetchTickVotes = -1;
+        gBundlePeerClaimedTick = 0;
+        gBundlePeerVerifiedTick = 0;
+        gBackfillFromTick = 0;
+        gBackfillToTick = 0;
+        inflightRequests.expire(std::chrono::milliseconds(0));
+        logFetchWindow.eraseBelow(UINT32_MAX);
+        for (int i = 0; i < connPool.size(); i++) connPool.get(i)->reconnect();
     }
     if (gIsEndEpoch)
     {
@@ -372,6 +476,7 @@ int runBob(int argc, char *argv[])
         db_kvrocks_close();
         Logger::get()->info("Closed KVROCKS connection");
     }
+    db_close_log_segments();
     ProfilerRegistry::instance().printSummary();
     Logger::get()->info("Shutting down logger");
     spdlog::shutdown();
@@ -14,6 +14,11 @@ void startRESTServer();
 void stopRESTServer();
 std::string bobGetBalance(const char* identity);
 std::string bobGetAsset(const std::string identity, const std::string assetName, const std::string issuer, uint32_t manageSCIndex);
+std::string bobGetBalanceAtTick(const std::string identity, uint32_t tick); // from the state journal
+std::string bobGetAssetAtTick(const std::string identity, const std::string assetName, const std::string issuer, uint32_t manageSCIndex, uint32_t tick);
+std::string bobGetAssetsOfIdentity(const std::string identity); // all issuances/ownerships/possessions of an identity
+std::string bobGetRichList(uint32_t limit); // largest QU balances
+std::string bobGetAssetRichList(const std::string issuer, const std::string assetName, uint32_t limit); // largest owners of an asset
 std::string bobGetTransaction(const char* txHash);
 std::string bobGetLog(uint16_t epoch, int64_t start, int64_t end); // inclusive
 std::string bobGetTick(const uint32_t tick); // return Data And Votes and LogRanges
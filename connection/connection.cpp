@@ -17,6 +17,16 @@
 #include "Logger.h"
 #include "GlobalVar.h"
 #include "shim.h"
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+static uint32_t nowMs32()
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
 static int do_connect(const char* nodeIp, int nodePort)
 {
     int serverSocket = socket(AF_INET, SOCK_STREAM, 0);
@@ -91,7 +101,9 @@ QubicConnection::QubicConnection(const char* nodeIp, int nodePort)
     mNodeIp[sizeof(mNodeIp) - 1] = '\0';
     mNodePort = nodePort;
     mSocket = -1;
+    const uint32_t t0 = nowMs32();
     mSocket = do_connect(mNodeIp, mNodePort);
+    if (mSocket >= 0) mLatencyMs = double(nowMs32() - t0); // TCP handshake as the first latency estimate
     mReconnectable = true;
     initSendThread();
     nodeType = "null";
@@ -207,6 +219,8 @@ int QubicConnection::enqueueSend(uint8_t* buffer, int sz)
         if (dejavu)
         {
             requestMapperFrom.add(dejavu, buffer, sz, nullptr);
+            mProbes[dejavu % kProbeSlots].store((uint64_t(dejavu) << 32) | nowMs32(), std::memory_order_relaxed);
+            mRequestsSent.fetch_add(1, std::memory_order_relaxed);
         }
     }
     mBuffer->EnqueuePacket(buffer);
@@ -317,6 +331,8 @@ void QubicConnection::disconnect()
         close(mSocket);
         mSocket = -1;
     }
+    // a reconnect or retarget may reach another peer, and an inbound connection is freed after this
+    inflightRequests.forgetPeer(this);
 }
 
 bool QubicConnection::reconnect()
@@ -330,11 +346,19 @@ bool QubicConnection::reconnect()
         close(mSocket);
         mSocket = -1;
     }
+    mReconnects.fetch_add(1, std::memory_order_relaxed);
 
+    char ip[sizeof(mNodeIp)];
+    int port;
+    {
+        std::lock_guard<std::mutex> lock(mTargetMtx);
+        memcpy(ip, mNodeIp, sizeof(ip));
+        port = mNodePort;
+    }
     // Attempt to re-establish connection
-    int newSocket = do_connect(mNodeIp, mNodePort);
+    int newSocket = do_connect(ip, port);
     if (newSocket < 0) {
-        Logger::get()->trace("Failed to reconnect {}:{}", mNodeIp, mNodePort);
+        Logger::get()->trace("Failed to reconnect {}:{}", ip, port);
         return false;
     }
 
@@ -342,6 +366,111 @@ bool QubicConnection::reconnect()
     return true;
 }
 
+void QubicConnection::recordReceived(uint32_t dejavu, uint32_t size)
+{
+    mBytesReceived.fetch_add(size, std::memory_order_relaxed);
+    if (!dejavu) return;
+    auto& probe = mProbes[dejavu % kProbeSlots];
+    uint64_t v = probe.load(std::memory_order_relaxed);
+    if (uint32_t(v >> 32) != dejavu) return;
+    // only the first response to a request is a latency sample
+    if (!probe.compare_exchange_strong(v, 0, std::memory_order_relaxed)) return;
+    const double sample = double(nowMs32() - uint32_t(v));
+    const double prev = mLatencyMs.load(std::memory_order_relaxed);
+    mLatencyMs.store(prev <= 0 ? sample : prev + (sample - prev) / 8.0, std::memory_order_relaxed);
+    mAnswered.fetch_add(1, std::memory_order_relaxed);
+}
+
+void QubicConnection::updateScore(double elapsedSec)
+{
+    if (elapsedSec <= 0) return;
+    const uint64_t sent = mRequestsSent.exchange(0, std::memory_order_relaxed);
+    const uint64_t answered = mAnswered.exchange(0, std::memory_order_relaxed);
+    const uint64_t bytes = mBytesReceived.exchange(0, std::memory_order_relaxed);
+    const uint64_t errors = mErrors.exchange(0, std::memory_order_relaxed) + mReconnects.exchange(0, std::memory_order_relaxed);
+
+    const double alpha = 0.3;
+    if (sent) mAnswerRatio += alpha * (std::min(1.0, double(answered) / double(sent)) - mAnswerRatio);
+    mBytesPerSec += alpha * (double(bytes) / elapsedSec - mBytesPerSec);
+    mErrorsPerMin += alpha * (double(errors) * 60.0 / elapsedSec - mErrorsPerMin);
+
+    if (!isSocketValid())
+    {
+        mScore = 0;
+        return;
+    }
+    double latency = mLatencyMs.load(std::memory_order_relaxed);
+    if (latency <= 0) latency = 200; // no sample yet
+    // answered share dominates, then latency; throughput is a mild bonus, errors a divisor
+    const double score = (0.05 + mAnswerRatio)
+                         * (1000.0 / (latency + 20.0))
+                         * (1.0 + std::log10(1.0 + mBytesPerSec / 1024.0) / 4.0)
+                         / (1.0 + mErrorsPerMin);
+    mScore = score;
+}
+
+std::string QubicConnection::getStatsString()
+{
+    std::ostringstream ss;
+    ss.setf(std::ios::fixed);
+    ss.precision(2);
+    ss << getEndpointString() << " | score " << mScore.load()
+       << " | latency " << mLatencyMs.load() << "ms"
+       << " | answered " << mAnswerRatio * 100.0 << "%"
+       << " | " << mBytesPerSec / 1024.0 << " KiB/s"
+       << " | errors " << mErrorsPerMin << "/min"
+       << (isSocketValid() ? "" : " | disconnected");
+    return ss.str();
+}
+
+bool QubicConnection::retarget(const std::string& ip, int port, const uint64_t passcode[4])
+{
+    if (!mReconnectable || ip.size() >= sizeof(mNodeIp)) return false;
+    {
+        std::lock_guard<std::mutex> lock(mTargetMtx);
+        memset(mNodeIp, 0, sizeof(mNodeIp));
+        memcpy(mNodeIp, ip.data(), ip.size());
+        mNodePort = port;
+        memcpy(mPasscode, passcode, sizeof(mPasscode));
+    }
+    for (auto& probe : mProbes) probe.store(0, std::memory_order_relaxed);
+    mLatencyMs = 0;
+    mScore = 0;
+    mAnswerRatio = 0.5;
+    mBytesPerSec = 0;
+    mErrorsPerMin = 0;
+    mLowScoreWindows = 0;
+    // the receiver thread sees the closed socket and reconnects to the new target
+    disconnect();
+    return true;
+}
+
+std::string QubicConnection::getNodeIp()
+{
+    std::lock_guard<std::mutex> lock(mTargetMtx);
+    return mNodeIp;
+}
+
+void QubicConnection::updatePasscode(const uint64_t passcode[4])
+{
+    std::lock_guard<std::mutex> lock(mTargetMtx);
+    memcpy(mPasscode, passcode, sizeof(mPasscode));
+}
+
+void QubicConnection::getPasscode(uint64_t* passcode)
+{
+    std::lock_guard<std::mutex> lock(mTargetMtx);
+    memcpy(passcode, mPasscode, sizeof(mPasscode));
+}
+
+std::string QubicConnection::getEndpointString()
+{
+    std::lock_guard<std::mutex> lock(mTargetMtx);
+    return nodeType + ":" + mNodeIp + ":" + std::to_string(mNodePort) + ":" +
+           std::to_string(mPasscode[0]) + "-" + std::to_string(mPasscode[1]) + "-" +
+           std::to_string(mPasscode[2]) + "-" + std::to_string(mPasscode[3]);
+}
+
 QubicConnection::QubicConnection(int existingSocket)
 {
     memset(mPasscode, 0xff, 8*4);
@@ -369,89 +498,99 @@ QubicConnection::QubicConnection(int existingSocket)
     nodeType = "client";
 }
 
-void parseConnection(ConnectionPool& connPoolAll,
-                     std::vector<std::string>& endpoints)
+bool parseEndpoint(const std::string& endpoint, std::string& nodeType, std::string& ip, int& port,
+                   bool& hasPasscode, uint64_t passcode[4])
 {
-    // Try endpoints in order, connect to the first that works
+    // Expected format: nodeType:ip:port[:pass0-pass1-pass2-pass3]
+    // nodeType must be "BM" (baremetal) or "bob"
+    auto p0 = endpoint.find(':');
+    if (p0 == std::string::npos || p0 == 0 || p0 == endpoint.size() - 1) {
+        Logger::get()->warn("Skipping invalid endpoint '{}', expected nodeType:ip:port or nodeType:ip:port:pass0-pass1-pass2-pass3", endpoint);
+        return false;
+    }
+    nodeType = endpoint.substr(0, p0);
+    if (nodeType != "BM" && nodeType != "bob") {
+        Logger::get()->warn("Skipping endpoint '{}': nodeType must be 'BM' or 'bob'", endpoint);
+        return false;
+    }
+    std::string rest = endpoint.substr(p0 + 1);
 
-    for (const auto& endpoint : endpoints) {
-        // Expected format: nodeType:ip:port[:pass0-pass1-pass2-pass3]
-        // nodeType must be "BM" (baremetal) or "bob"
-        auto p0 = endpoint.find(':');
-        if (p0 == std::string::npos || p0 == 0 || p0 == endpoint.size() - 1) {
-            Logger::get()->warn("Skipping invalid endpoint '{}', expected nodeType:ip:port or nodeType:ip:port:pass0-pass1-pass2-pass3", endpoint);
-            continue;
-        }
-        std::string nodeType = endpoint.substr(0, p0);
-        if (nodeType != "BM" && nodeType != "bob") {
-            Logger::get()->warn("Skipping endpoint '{}': nodeType must be 'BM' or 'bob'", endpoint);
-            continue;
+    // Parse ip:port[:pass0-pass1-pass2-pass3] from rest
+    auto p1 = rest.find(':');
+    if (p1 == std::string::npos || p1 == 0 || p1 == rest.size() - 1) {
+        Logger::get()->warn("Skipping invalid endpoint '{}', expected nodeType:ip:port or nodeType:ip:port:pass0-pass1-pass2-pass3", endpoint);
+        return false;
+    }
+    auto p2 = rest.find(':', p1 + 1);
+    ip = rest.substr(0, p1);
+    std::string port_str;
+    std::string passcode_str;
+
+    if (p2 == std::string::npos) {
+        port_str = rest.substr(p1 + 1);
+    } else {
+        if (p2 == rest.size() - 1) {
+            Logger::get()->warn("Skipping endpoint '{}': missing passcode after second ':'", endpoint);
+            return false;
         }
-        std::string rest = endpoint.substr(p0 + 1);
+        port_str = rest.substr(p1 + 1, p2 - (p1 + 1));
+        passcode_str = rest.substr(p2 + 1);
+    }
 
-        // Parse ip:port[:pass0-pass1-pass2-pass3] from rest
-        auto p1 = rest.find(':');
-        if (p1 == std::string::npos || p1 == 0 || p1 == rest.size() - 1) {
-            Logger::get()->warn("Skipping invalid endpoint '{}', expected nodeType:ip:port or nodeType:ip:port:pass0-pass1-pass2-pass3", endpoint);
-            continue;
+    port = 0;
+    try {
+        port = std::stoi(port_str);
+        if (port <= 0 || port > 65535) {
+            throw std::out_of_range("port out of range");
         }
-        auto p2 = rest.find(':', p1 + 1);
-        std::string ip = rest.substr(0, p1);
-        std::string port_str;
-        std::string passcode_str;
+    } catch (...) {
+        Logger::get()->warn("Skipping endpoint '{}': invalid port '{}'", endpoint, port_str);
+        return false;
+    }
 
-        if (p2 == std::string::npos) {
-            port_str = rest.substr(p1 + 1);
-        } else {
-            if (p2 == rest.size() - 1) {
-                Logger::get()->warn("Skipping endpoint '{}': missing passcode after second ':'", endpoint);
-                continue;
+    // Optional passcode parsing
+    hasPasscode = false;
+    if (!passcode_str.empty()) {
+        // Split by '-'
+        uint64_t parsed[4];
+        size_t start = 0;
+        int idx = 0;
+        while (idx < 4 && start <= passcode_str.size()) {
+            size_t dash = passcode_str.find('-', start);
+            auto token = passcode_str.substr(start, (dash == std::string::npos) ? std::string::npos : (dash - start));
+            if (token.empty()) break;
+            try {
+                parsed[idx] = static_cast<uint64_t>(std::stoull(token, nullptr, 10));
+            } catch (...) {
+                idx = -1; // mark error
+                break;
             }
-            port_str = rest.substr(p1 + 1, p2 - (p1 + 1));
-            passcode_str = rest.substr(p2 + 1);
+            idx++;
+            if (dash == std::string::npos) break;
+            start = dash + 1;
         }
-
-        int port = 0;
-        try {
-            port = std::stoi(port_str);
-            if (port <= 0 || port > 65535) {
-                throw std::out_of_range("port out of range");
-            }
-        } catch (...) {
-            Logger::get()->warn("Skipping endpoint '{}': invalid port '{}'", endpoint, port_str);
-            continue;
+        if (idx == 4) {
+            memcpy(passcode, parsed, sizeof(parsed));
+            hasPasscode = true;
+        } else {
+            Logger::get()->warn("Skipping endpoint '{}': invalid passcode format, expected 4 uint64 separated by '-'", endpoint);
+            return false;
         }
+    }
+    return true;
+}
+
+void parseConnection(ConnectionPool& connPoolAll,
+                     std::vector<std::string>& endpoints)
+{
+    // Try endpoints in order, connect to the first that works
 
-        // Optional passcode parsing
+    for (const auto& endpoint : endpoints) {
+        std::string nodeType, ip;
+        int port = 0;
         bool has_passcode = false;
         uint64_t passcode_arr[4] = {0,0,0,0};
-        if (!passcode_str.empty()) {
-            // Split by '-'
-            uint64_t parsed[4];
-            size_t start = 0;
-            int idx = 0;
-            while (idx < 4 && start <= passcode_str.size()) {
-                size_t dash = passcode_str.find('-', start);
-                auto token = passcode_str.substr(start, (dash == std::string::npos) ? std::string::npos : (dash - start));
-                if (token.empty()) break;
-                try {
-                    parsed[idx] = static_cast<uint64_t>(std::stoull(token, nullptr, 10));
-                } catch (...) {
-                    idx = -1; // mark error
-                    break;
-                }
-                idx++;
-                if (dash == std::string::npos) break;
-                start = dash + 1;
-            }
-            if (idx == 4) {
-                memcpy(passcode_arr, parsed, sizeof(parsed));
-                has_passcode = true;
-            } else {
-                Logger::get()->warn("Skipping endpoint '{}': invalid passcode format, expected 4 uint64 separated by '-'", endpoint);
-                continue;
-            }
-        }
+        if (!parseEndpoint(endpoint, nodeType, ip, port, has_passcode, passcode_arr)) continue;
 
         QCPtr conn = make_qc(ip.c_str(), port);
         conn->setNodeType(nodeType);
@@ -463,6 +602,90 @@ void parseConnection(ConnectionPool& connPoolAll,
     }
 }
 
+void ConnectionPool::trimTo(std::size_t keep, std::vector<std::string>& spare)
+{
+    if (keep == 0 || conns_.size() <= keep) return;
+    // connected peers first, ordered by their TCP handshake time
+    auto rank = [](const QCPtr& c) {
+        return c->isSocketValid() ? c->latencyMs() : std::numeric_limits<double>::max();
+    };
+    std::stable_sort(conns_.begin(), conns_.end(), [&](const QCPtr& a, const QCPtr& b) { return rank(a) < rank(b); });
+
+    // smart contract queries need a BM peer, keep one if any is reachable
+    auto isLiveBM = [](const QCPtr& c) { return c->isSocketValid() && c->isBM(); };
+    if (std::none_of(conns_.begin(), conns_.begin() + keep, isLiveBM))
+    {
+        auto it = std::find_if(conns_.begin() + keep, conns_.end(), isLiveBM);
+        if (it != conns_.end()) std::iter_swap(conns_.begin() + keep - 1, it);
+    }
+    for (std::size_t i = keep; i < conns_.size(); i++)
+    {
+        spare.push_back(conns_[i]->getEndpointString());
+    }
+    conns_.resize(keep);
+}
+
+void ConnectionPool::updateScores(double elapsedSec)
+{
+    std::vector<double> live;
+    for (auto& c : conns_)
+    {
+        c->updateScore(elapsedSec);
+        if (c->isSocketValid()) live.push_back(c->score());
+    }
+    double median = 0;
+    if (!live.empty())
+    {
+        std::nth_element(live.begin(), live.begin() + live.size() / 2, live.end());
+        median = live[live.size() / 2];
+    }
+    // a peer far below the median (or disconnected) accumulates low-score windows
+    for (auto& c : conns_)
+    {
+        bool slow = !c->isSocketValid() || c->score() < median * 0.2;
+        c->setLowScoreWindows(slow ? c->lowScoreWindows() + 1 : 0);
+    }
+}
+
+bool ConnectionPool::replaceSlowPeer(std::vector<std::string>& spare)
+{
+    const int minLowWindows = 6; // about 30s with the 5s status loop
+    QubicConnection* worst = nullptr;
+    for (auto& c : conns_)
+    {
+        if (!c->isReconnectable() || c->lowScoreWindows() < minLowWindows) continue;
+        if (!worst || c->score() < worst->score()) worst = c.get();
+    }
+    if (!worst) return false;
+
+    for (std::size_t k = 0; k < spare.size(); k++)
+    {
+        std::string nodeType, ip;
+        int port = 0;
+        bool hasPasscode = false;
+        uint64_t passcode[4];
+        if (!parseEndpoint(spare[k], nodeType, ip, port, hasPasscode, passcode))
+        {
+            spare.erase(spare.begin() + k--);
+            continue;
+        }
+        if ((nodeType == "BM") != worst->isBM()) continue;
+        bool inPool = std::any_of(conns_.begin(), conns_.end(), [&](const QCPtr& c) {
+            auto ep = c->getEndpointString();
+            return ep.find(":" + ip + ":" + std::to_string(port) + ":") != std::string::npos;
+        });
+        if (inPool) continue;
+        if (!hasPasscode) memset(passcode, 0xff, sizeof(passcode));
+
+        std::string from = worst->getStatsString();
+        if (!worst->retarget(ip, port, passcode)) return false;
+        Logger::get()->info("Replacing slow peer [{}] with {}:{}", from, ip, port);
+        spare.erase(spare.begin() + k);
+        return true;
+    }
+    return false;
+}
+
 void doHandshakeAndGetBootstrapInfo(ConnectionPool& cp, bool isTrusted, uint32_t& maxInitTick, uint16_t& maxInitEpoch)
 {
     const auto errorBackoff = 1000;
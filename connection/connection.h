@@ -5,6 +5,9 @@
 #include <memory>
 #include <random>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
 #include "structs.h"
 #include "SpecialBufferStructs.h"
 
@@ -24,9 +27,10 @@ public:
     {
         return mSocket>=0;
     }
-    char* getNodeIp() { return mNodeIp;}
-    void updatePasscode(const uint64_t passcode[4]){ memcpy(mPasscode, passcode, 8*4); }
-    void getPasscode(uint64_t* passcode){ memcpy(passcode, mPasscode, 8*4); }
+    // Copies taken under mTargetMtx: retarget() may change the target at any time
+    std::string getNodeIp();
+    void updatePasscode(const uint64_t passcode[4]);
+    void getPasscode(uint64_t* passcode);
     // Construct from an already-open socket; this connection is NON-reconnectable.
     QubicConnection(int existingSocket);
     // Expose whether this connection is allowed to reconnect.
@@ -47,9 +51,28 @@ public:
         return nodeType == "BM";
     }
     bool isBob(){ return nodeType == "bob";}
+
+    // Peer statistics, fed by the send path (requests with a dejavu) and by connReceiver.
+    // A response whose dejavu matches a recent request gives a latency sample.
+    void recordReceived(uint32_t dejavu, uint32_t size);
+    void recordError() { mErrors.fetch_add(1, std::memory_order_relaxed); }
+    // Fold the counters of the last window (elapsedSec long) into the smoothed stats and the score.
+    // Only called from one thread (the status loop).
+    void updateScore(double elapsedSec);
+    double score() const { return mScore.load(std::memory_order_relaxed); }
+    double latencyMs() const { return mLatencyMs.load(std::memory_order_relaxed); }
+    int lowScoreWindows() const { return mLowScoreWindows; }
+    void setLowScoreWindows(int n) { mLowScoreWindows = n; }
+    std::string getStatsString();
+    // Point a reconnectable connection to another peer of the same node type; the receiver
+    // thread picks up the new target on its next reconnect.
+    bool retarget(const std::string& ip, int port, const uint64_t passcode[4]);
+    // nodeType:ip:port:p0-p1-p2-p3, the format parseConnection accepts
+    std::string getEndpointString();
 private:
     char mNodeIp[32];
     int mNodePort;
+    std::mutex mTargetMtx; // guards mNodeIp/mNodePort/mPasscode against retarget()
     int mSocket;
     std::unique_ptr<MutexRoundBuffer> mBuffer;
     uint64_t mPasscode[4]; // for loggingEvent
@@ -60,6 +83,22 @@ private:
     void sendThread();
     std::thread sendThreadHDL;
     bool shouldStop;
+
+    static constexpr uint32_t kProbeSlots = 256;
+    // (dejavu << 32) | send time in ms (mod 2^32), indexed by dejavu
+    std::atomic<uint64_t> mProbes[kProbeSlots]{};
+    std::atomic<uint64_t> mRequestsSent{0};
+    std::atomic<uint64_t> mAnswered{0};
+    std::atomic<uint64_t> mBytesReceived{0};
+    std::atomic<uint64_t> mErrors{0};
+    std::atomic<uint64_t> mReconnects{0};
+    std::atomic<double> mLatencyMs{0};
+    std::atomic<double> mScore{0};
+    // smoothed over score windows; status loop only
+    double mAnswerRatio = 0.5;
+    double mBytesPerSec = 0;
+    double mErrorsPerMin = 0;
+    int mLowScoreWindows = 0;
 };
 typedef std::shared_ptr<QubicConnection> QCPtr;
 static QCPtr make_qc(const char* nodeIp, int nodePort)
@@ -96,115 +135,131 @@ public:
         conns_.erase(conns_.begin() + idx);
     }
 
-    // Sends to one random valid connection. Returns bytes sent, or -1 if none could be used.
-    int sendToRandomBM(uint8_t* buffer, int sz, uint8_t type, bool randomDejavu) {
-        if (conns_.empty()) return -1;
+    // Keep the 'keep' connected peers with the lowest connect latency (and at least one BM if any
+    // connected); the endpoints of the dropped peers are appended to 'spare' for later replacement.
+    // Must be called before receiver threads hold references into the pool.
+    void trimTo(std::size_t keep, std::vector<std::string>& spare);
 
-        // Build an index list of currently valid connections
-        std::vector<std::size_t> idx;
-        idx.reserve(conns_.size());
-        for (std::size_t i = 0; i < conns_.size(); ++i) {
-            if (conns_[i] && conns_[i]->isSocketValid() && conns_[i]->isBM()) {
-                idx.push_back(i);
-            }
-        }
-        if (idx.empty()) return -1;
+    // Recompute every peer's score from the last window; call periodically.
+    void updateScores(double elapsedSec);
+
+    // Retarget at most one chronically slow or dead peer to an endpoint taken from 'spare'.
+    // Returns true if a peer was replaced.
+    bool replaceSlowPeer(std::vector<std::string>& spare);
 
-        std::uniform_int_distribution<std::size_t> dist(0, idx.size() - 1);
-        auto chosen = idx[dist(rng_)];
+    // Sends to one score-weighted valid BM connection. Returns bytes sent, or -1 if none could be used.
+    int sendToRandomBM(uint8_t* buffer, int sz, uint8_t type, bool randomDejavu) {
+        long chosen = pickWeighted([](QubicConnection* c) { return c->isBM(); }, nullptr);
+        if (chosen < 0) return -1;
         return conns_[chosen]->enqueueWithHeader(buffer, sz, type, randomDejavu);
     }
 
-    // Sends to one random valid connection. Returns bytes sent, or -1 if none could be used.
+    // Sends to one score-weighted valid BM connection. Returns bytes sent, or -1 if none could be used.
     int sendToRandomBM(uint8_t* buffer, int sz) {
-        if (conns_.empty()) return -1;
-
-        // Build an index list of currently valid connections
-        std::vector<std::size_t> idx;
-        idx.reserve(conns_.size());
-        for (std::size_t i = 0; i < conns_.size(); ++i) {
-            if (conns_[i] && conns_[i]->isSocketValid() && conns_[i]->isBM()) {
-                idx.push_back(i);
-            }
-        }
-        if (idx.empty()) return -1;
-
-        std::uniform_int_distribution<std::size_t> dist(0, idx.size() - 1);
-        auto chosen = idx[dist(rng_)];
+        long chosen = pickWeighted([](QubicConnection* c) { return c->isBM(); }, nullptr);
+        if (chosen < 0) return -1;
         return conns_[chosen]->enqueueSend(buffer, sz);
     }
     
-    // Sends to one random valid connection. Returns bytes sent, or -1 if none could be used.
-    int sendToRandom(uint8_t* buffer, int sz, uint8_t type, bool randomDejavu) {
-        if (conns_.empty()) return -1;
-
-        // Build an index list of currently valid connections
-        std::vector<std::size_t> idx;
-        idx.reserve(conns_.size());
-        for (std::size_t i = 0; i < conns_.size(); ++i) {
-            if (conns_[i] && conns_[i]->isSocketValid()) {
-                idx.push_back(i);
-            }
-        }
-        if (idx.empty()) return -1;
+    // Sends to one score-weighted valid connection. Returns bytes sent, or -1 if none could be used.
+    // 'avoid' is skipped unless it is the only valid connection; 'chosenOut' receives the peer used.
+    int sendToRandom(uint8_t* buffer, int sz, uint8_t type, bool randomDejavu,
+                     const QubicConnection* avoid = nullptr, const QubicConnection** chosenOut = nullptr) {
+        if (chosenOut) *chosenOut = nullptr;
+        long chosen = pickWeighted([](QubicConnection*) { return true; }, avoid);
+        if (chosen < 0) return -1;
+        if (chosenOut) *chosenOut = conns_[chosen].get();
+        return conns_[chosen]->enqueueWithHeader(buffer, sz, type, randomDejavu);
+    }
 
-        std::uniform_int_distribution<std::size_t> dist(0, idx.size() - 1);
-        auto chosen = idx[dist(rng_)];
+    // Same as sendToRandom, restricted to bob peers.
+    int sendToRandomBob(uint8_t* buffer, int sz, uint8_t type, bool randomDejavu,
+                        const QubicConnection* avoid = nullptr, const QubicConnection** chosenOut = nullptr) {
+        if (chosenOut) *chosenOut = nullptr;
+        long chosen = pickWeighted([](QubicConnection* c) { return c->isBob(); }, avoid);
+        if (chosen < 0) return -1;
+        if (chosenOut) *chosenOut = conns_[chosen].get();
         return conns_[chosen]->enqueueWithHeader(buffer, sz, type, randomDejavu);
     }
 
-    // Sends to 'howMany' distinct random valid connections (or fewer if not enough are valid).
+    // Sends to 'howMany' distinct score-weighted valid connections (or fewer if not enough are valid).
     // Returns a vector of bytes-sent per selected connection, in the order of selection.
     std::vector<int> sendToMany(uint8_t* buffer, int sz, std::size_t howMany, uint8_t type, bool randomDejavu) {
         std::vector<int> results;
         if (conns_.empty() || howMany == 0) return results;
 
-        // Collect indices of valid connections
-        std::vector<std::size_t> idx;
-        idx.reserve(conns_.size());
-        for (std::size_t i = 0; i < conns_.size(); ++i) {
-            if (conns_[i] && conns_[i]->isSocketValid()) {
-                idx.push_back(i);
-            }
-        }
-        if (idx.empty()) return results;
-
-        // Shuffle and take first K
-        std::shuffle(idx.begin(), idx.end(), rng_);
-        if (howMany < idx.size()) {
-            idx.resize(howMany);
+        std::vector<QubicConnection*> picked;
+        picked.reserve(std::min(howMany, conns_.size()));
+        while (picked.size() < howMany) {
+            long chosen = pickWeighted([&](QubicConnection* c) {
+                return std::find(picked.begin(), picked.end(), c) == picked.end();
+            }, nullptr);
+            if (chosen < 0) break;
+            picked.push_back(conns_[chosen].get());
         }
 
-        results.reserve(idx.size());
-        for (auto i : idx) {
-            results.push_back(conns_[i]->enqueueWithHeader(buffer, sz, type, randomDejavu));
+        results.reserve(picked.size());
+        for (auto* c : picked) {
+            results.push_back(c->enqueueWithHeader(buffer, sz, type, randomDejavu));
         }
         return results;
     }
 
-    int sendWithPasscodeToRandom(uint8_t* buffer, int passcodeOffset, int sz, uint8_t type, bool randomDejavu) {
-        if (conns_.empty()) return -1;
-
-        // Build an index list of currently valid connections
-        std::vector<std::size_t> idx;
-        idx.reserve(conns_.size());
-        for (std::size_t i = 0; i < conns_.size(); ++i) {
-            if (conns_[i] && conns_[i]->isSocketValid()) {
-                idx.push_back(i);
-            }
-        }
-        if (idx.empty()) return -1;
-        std::uniform_int_distribution<std::size_t> dist(0, idx.size() - 1);
-        auto chosen = idx[dist(rng_)];
+    int sendWithPasscodeToRandom(uint8_t* buffer, int passcodeOffset, int sz, uint8_t type, bool randomDejavu,
+                                 const QubicConnection* avoid = nullptr, const QubicConnection** chosenOut = nullptr) {
+        if (chosenOut) *chosenOut = nullptr;
+        long chosen = pickWeighted([](QubicConnection*) { return true; }, avoid);
+        if (chosen < 0) return -1;
+        if (chosenOut) *chosenOut = conns_[chosen].get();
         conns_[chosen]->getPasscode((uint64_t*)(buffer+passcodeOffset));
         return conns_[chosen]->enqueueWithHeader(buffer, sz, type, randomDejavu);
     }
 
 private:
+    // Share of the best score that every valid peer keeps, so new or recovering peers still get sampled.
+    static constexpr double kExploreShare = 0.05;
+
+    // Picks a valid connection accepted by 'eligible' with probability proportional to its score,
+    // in two passes without allocating. 'avoid' is only returned when nothing else qualifies.
+    template <typename Pred>
+    long pickWeighted(Pred eligible, const QubicConnection* avoid) {
+        long avoided = -1;
+        long last = -1;
+        double maxScore = 0;
+        for (std::size_t i = 0; i < conns_.size(); ++i) {
+            QubicConnection* c = conns_[i].get();
+            if (!c || !c->isSocketValid() || !eligible(c)) continue;
+            if (c == avoid) { avoided = (long)i; continue; }
+            maxScore = std::max(maxScore, c->score());
+            last = (long)i;
+        }
+        if (last < 0) return avoided;
+
+        const double floor = maxScore > 0 ? maxScore * kExploreShare : 1.0;
+        double total = 0;
+        for (std::size_t i = 0; i < conns_.size(); ++i) {
+            QubicConnection* c = conns_[i].get();
+            if (!c || !c->isSocketValid() || !eligible(c) || c == avoid) continue;
+            total += std::max(c->score(), floor);
+        }
+        std::uniform_real_distribution<double> dist(0.0, total);
+        double r = dist(rng_);
+        for (std::size_t i = 0; i < conns_.size(); ++i) {
+            QubicConnection* c = conns_[i].get();
+            if (!c || !c->isSocketValid() || !eligible(c) || c == avoid) continue;
+            r -= std::max(c->score(), floor);
+            if (r <= 0) return (long)i;
+        }
+        return last; // scores moved between passes
+    }
+
     std::vector<QCPtr> conns_;
     std::mt19937 rng_;
 };
 
+// Parse one nodeType:ip:port[:pass0-pass1-pass2-pass3] endpoint. Logs and returns false if invalid.
+bool parseEndpoint(const std::string& endpoint, std::string& nodeType, std::string& ip, int& port,
+                   bool& hasPasscode, uint64_t passcode[4]);
 void parseConnection(ConnectionPool& connPoolAll,
                      std::vector<std::string>& endpoints);
 void doHandshakeAndGetBootstrapInfo(ConnectionPool& cp, bool isTrusted, uint32_t& maxInitTick, uint16_t& maxInitEpoch);
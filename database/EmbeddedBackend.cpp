@@ -0,0 +1,755 @@
+#include "EmbeddedBackend.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unordered_map>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// op, key size, a size, b size, extra
+constexpr size_t kHeaderSize = 1 + 4 + 4 + 4 + 8;
+int64_t toBits(double d)
+{
+    int64_t v;
+    memcpy(&v, &d, sizeof(v));
+    return v;
+}
+
+double fromBits(int64_t v)
+{
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+void writeAll(int fd, const std::string& buf)
+{
+    size_t done = 0;
+    while (done < buf.size()) {
+        ssize_t n = ::write(fd, buf.data() + done, buf.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw StorageError(std::string("embedded storage write failed: ") + strerror(errno));
+        }
+        done += static_cast<size_t>(n);
+    }
+}
+
+void encode(std::string& buf, uint8_t op, const std::string& key, std::string_view a, std::string_view b, int64_t extra)
+{
+    const uint32_t keySize = static_cast<uint32_t>(key.size());
+    const uint32_t aSize = static_cast<uint32_t>(a.size());
+    const uint32_t bSize = static_cast<uint32_t>(b.size());
+    const size_t at = buf.size();
+    buf.resize(at + kHeaderSize);
+    char* p = &buf[at];
+    p[0] = static_cast<char>(op);
+    memcpy(p + 1, &keySize, 4);
+    memcpy(p + 5, &aSize, 4);
+    memcpy(p + 9, &bSize, 4);
+    memcpy(p + 13, &extra, 8);
+    buf.append(key);
+    buf.append(a.data(), a.size());
+    buf.append(b.data(), b.size());
+}
+
+std::string readAt(int fd, uint64_t offset, uint32_t size)
+{
+    std::string out(size, '\0');
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = ::pread(fd, &out[done], out.size() - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throw StorageError("embedded storage: cannot read value at offset " + std::to_string(offset));
+        done += static_cast<size_t>(n);
+    }
+    return out;
+}
+
+// Appends bytes [from, to) of the log in to out, returns the number of bytes copied
+uint64_t copyRange(int in, uint64_t from, uint64_t to, int out)
+{
+    const uint64_t chunk = 1u << 20;
+    for (uint64_t at = from; at < to; at += chunk) {
+        writeAll(out, readAt(in, at, static_cast<uint32_t>(std::min(chunk, to - at))));
+    }
+    return to - from;
+}
+
+bool inRange(double score, const StorageBackend::ScoreRange& r)
+{
+    if (r.minOpen ? score <= r.min : score < r.min) return false;
+    if (r.maxOpen ? score >= r.max : score > r.max) return false;
+    return true;
+}
+
+} // namespace
+
+EmbeddedBackend::EmbeddedBackend(const Options& options) : options_(options)
+{
+    if (options_.path.empty()) {
+        if (options_.valuesOnDisk) throw StorageError("embedded storage: valuesOnDisk needs a path");
+        return;
+    }
+    fd_ = ::open(options_.path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd_ < 0) {
+        throw StorageError("embedded storage: cannot open " + options_.path + ": " + strerror(errno));
+    }
+    replay();
+    rewrite();
+    Logger::get()->info("Embedded storage {}: {} keys, {} MiB on disk", options_.path, size(), fileSize_ >> 20);
+    if (options_.compactIntervalSec > 0) compactor_ = std::thread(&EmbeddedBackend::compactLoop, this);
+}
+
+EmbeddedBackend::~EmbeddedBackend()
+{
+    {
+        std::lock_guard<std::mutex> lock(compactMtx_);
+        stopping_ = true;
+    }
+    compactCv_.notify_all();
+    if (compactor_.joinable()) compactor_.join();
+    if (fd_ >= 0) ::close(fd_);
+}
+
+EmbeddedBackend::Shard& EmbeddedBackend::shardOf(const std::string& key)
+{
+    return shards_[std::hash<std::string>()(key) % kShards];
+}
+
+int64_t EmbeddedBackend::nowMs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+EmbeddedBackend::Entry* EmbeddedBackend::find(Shard& shard, const std::string& key, Type type)
+{
+    auto it = shard.map.find(key);
+    if (it == shard.map.end() || !live(it->second, nowMs())) return nullptr;
+    if (it->second.type != type) {
+        throw StorageError("WRONGTYPE Operation against a key holding the wrong kind of value: " + key);
+    }
+    return &it->second;
+}
+
+std::string EmbeddedBackend::readValue(const Entry& e)
+{
+    if (!options_.valuesOnDisk) return e.value;
+    return readAt(fd_, e.valueOffset, e.valueSize);
+}
+
+uint64_t EmbeddedBackend::append(Op op, const std::string& key, std::string_view a, std::string_view b, int64_t extra)
+{
+    if (fd_ < 0) return 0;
+    std::string buf;
+    encode(buf, op, key, a, b, extra);
+    std::lock_guard<std::mutex> lock(fileMtx_);
+    const uint64_t aOffset = fileSize_ + kHeaderSize + key.size();
+    writeAll(fd_, buf);
+    fileSize_ += buf.size();
+    appendedSinceCompact_ += buf.size();
+    if (appendedSinceCompact_ >= options_.minRewriteWaste && compactor_.joinable()) {
+        appendedSinceCompact_ = 0;
+        compactCv_.notify_one();
+    }
+    return aOffset;
+}
+
+void EmbeddedBackend::replay()
+{
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) throw StorageError("embedded storage: cannot stat " + options_.path);
+    const uint64_t onDisk = static_cast<uint64_t>(st.st_size);
+    FILE* f = fopen(options_.path.c_str(), "rb");
+    if (!f) throw StorageError("embedded storage: cannot read " + options_.path);
+    uint64_t pos = 0;
+    std::string key, a, b;
+    char header[kHeaderSize];
+    while (true) {
+        if (fread(header, 1, kHeaderSize, f) != kHeaderSize) break;
+        const uint8_t op = static_cast<uint8_t>(header[0]);
+        uint32_t keySize, aSize, bSize;
+        int64_t extra;
+        memcpy(&keySize, header + 1, 4);
+        memcpy(&aSize, header + 5, 4);
+        memcpy(&bSize, header + 9, 4);
+        memcpy(&extra, header + 13, 8);
+        const uint64_t aOffset = pos + kHeaderSize + keySize;
+        key.resize(keySize);
+        if (keySize && fread(&key[0], 1, keySize, f) != keySize) break;
+        const bool skipValue = options_.valuesOnDisk && op == OP_SET;
+        if (skipValue) {
+            if (fseeko(f, static_cast<off_t>(aSize), SEEK_CUR) != 0) break;
+            a.clear();
+        } else {
+            a.resize(aSize);
+            if (aSize && fread(&a[0], 1, aSize, f) != aSize) break;
+        }
+        b.resize(bSize);
+        if (bSize && fread(&b[0], 1, bSize, f) != bSize) break;
+        const uint64_t next = aOffset + aSize + bSize;
+        // fseek succeeds past the end of the file, make sure a skipped value is really there
+        if (next > onDisk) break;
+
+        auto& map = shardOf(key).map;
+        switch (op) {
+            case OP_SET: {
+                Entry e;
+                e.expireAtMs = extra;
+                if (skipValue) {
+                    e.valueOffset = aOffset;
+                    e.valueSize = aSize;
+                } else {
+                    e.value = a;
+                }
+                map[key] = std::move(e);
+                break;
+            }
+            case OP_DEL:
+                map.erase(key);
+                break;
+            case OP_HSET: {
+                auto& e = map[key];
+                if (e.type != HASH || !e.hash) {
+                    e = Entry{};
+                    e.type = HASH;
+                    e.hash = std::make_unique<std::unordered_map<std::string, std::string>>();
+                }
+                (*e.hash)[a] = b;
+                break;
+            }
+            case OP_ZADD: {
+                auto& e = map[key];
+                if (e.type != ZSET || !e.zset) {
+                    e = Entry{};
+                    e.type = ZSET;
+                    e.zset = std::make_unique<ZSet>();
+                }
+                const double score = fromBits(extra);
+                auto it = e.zset->scores.find(a);
+                if (it != e.zset->scores.end()) e.zset->ordered.erase({it->second, a});
+                e.zset->scores[a] = score;
+                e.zset->ordered.insert({score, a});
+                break;
+            }
+            case OP_RENAME: {
+                auto it = map.find(key);
+                if (it == map.end()) break;
+                Entry moved = std::move(it->second);
+                map.erase(it);
+                shardOf(a).map[a] = std::move(moved);
+                break;
+            }
+            case OP_EXPIRE: {
+                auto it = map.find(key);
+                if (it != map.end()) it->second.expireAtMs = extra;
+                break;
+            }
+            default:
+                Logger::get()->warn("Embedded storage {}: unknown record {} at offset {}", options_.path, op, pos);
+                break;
+        }
+        pos = next;
+    }
+    fclose(f);
+    if (onDisk > pos) {
+        // a crash in the middle of an append leaves a torn record at the end
+        Logger::get()->warn("Embedded storage {}: dropping {} bytes of a torn record", options_.path, onDisk - pos);
+        if (::ftruncate(fd_, static_cast<off_t>(pos)) != 0) {
+            throw StorageError("embedded storage: cannot truncate " + options_.path);
+        }
+    }
+    fileSize_ = pos;
+}
+
+size_t EmbeddedBackend::liveBytes()
+{
+    const int64_t now = nowMs();
+    size_t total = 0;
+    for (auto& shard : shards_) {
+        for (const auto& [key, e] : shard.map) {
+            if (!live(e, now)) continue;
+            if (e.type == STRING) {
+                total += kHeaderSize + key.size() + (options_.valuesOnDisk ? e.valueSize : e.value.size());
+            } else if (e.type == HASH) {
+                for (const auto& [f, v] : *e.hash) total += kHeaderSize + key.size() + f.size() + v.size();
+            } else {
+                for (const auto& [m, s] : e.zset->scores) total += kHeaderSize + key.size() + m.size();
+            }
+        }
+    }
+    return total;
+}
+
+bool EmbeddedBackend::rewriteDue(uint64_t live) const
+{
+    return fileSize_ > 2 * live && fileSize_ - live >= options_.minRewriteWaste;
+}
+
+size_t EmbeddedBackend::sweepExpired()
+{
+    const int64_t now = nowMs();
+    size_t dropped = 0;
+    // one shard at a time; the log needs no record, the expiration time in it is absolute
+    for (auto& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+        for (auto it = shard.map.begin(); it != shard.map.end();) {
+            if (live(it->second, now)) {
+                ++it;
+            } else {
+                it = shard.map.erase(it);
+                dropped++;
+            }
+        }
+    }
+    return dropped;
+}
+
+void EmbeddedBackend::compact()
+{
+    const size_t dropped = sweepExpired();
+    if (dropped) Logger::get()->debug("Embedded storage {}: dropped {} expired keys", options_.path, dropped);
+    if (fd_ < 0) return;
+    std::lock_guard<std::mutex> rewriteLock(rewriteMtx_);
+    {
+        std::lock_guard<std::mutex> fileLock(fileMtx_);
+        appendedSinceCompact_ = 0;
+    }
+    rewrite();
+}
+
+void EmbeddedBackend::compactLoop()
+{
+    std::unique_lock<std::mutex> lock(compactMtx_);
+    while (!stopping_) {
+        // woken early by append once another minRewriteWaste bytes are in the file
+        compactCv_.wait_for(lock, std::chrono::seconds(options_.compactIntervalSec));
+        if (stopping_) break;
+        lock.unlock();
+        try {
+            compact();
+        } catch (const StorageError& e) {
+            Logger::get()->warn("Embedded storage {}: compaction failed: {}", options_.path, e.what());
+        }
+        lock.lock();
+    }
+}
+
+void EmbeddedBackend::rewrite()
+{
+    // 1. Snapshot the live keys at one log position. Every shard is locked shared, so no mutation is
+    // half applied and none appends meanwhile. Values on disk are only referenced, the rest is encoded.
+    struct DiskValue
+    {
+        std::string key;
+        uint64_t offset;
+        uint32_t size;
+        int64_t expireAtMs;
+    };
+    std::vector<std::string> chunks; // encoded records, one chunk per shard
+    std::vector<DiskValue> diskValues;
+    uint64_t snapshotEnd = 0;
+    const int in = fd_; // only replaced by the swap below
+    {
+        std::vector<std::shared_lock<std::shared_mutex>> locks;
+        locks.reserve(kShards);
+        for (auto& shard : shards_) locks.emplace_back(shard.mtx);
+        {
+            std::lock_guard<std::mutex> fileLock(fileMtx_);
+            if (!rewriteDue(liveBytes())) return;
+            snapshotEnd = fileSize_;
+        }
+        const int64_t now = nowMs();
+        chunks.reserve(kShards);
+        for (auto& shard : shards_) {
+            std::string buf;
+            for (const auto& [key, e] : shard.map) {
+                if (!live(e, now)) continue;
+                if (e.type == STRING) {
+                    if (options_.valuesOnDisk) diskValues.push_back({key, e.valueOffset, e.valueSize, e.expireAtMs});
+                    else encode(buf, OP_SET, key, e.value, {}, e.expireAtMs);
+                    continue;
+                }
+                if (e.type == HASH) {
+                    for (const auto& [f, v] : *e.hash) encode(buf, OP_HSET, key, f, v, 0);
+                } else {
+                    for (const auto& [m, sc] : e.zset->scores) encode(buf, OP_ZADD, key, m, {}, toBits(sc));
+                }
+                if (e.expireAtMs) encode(buf, OP_EXPIRE, key, {}, {}, e.expireAtMs);
+            }
+            chunks.push_back(std::move(buf));
+        }
+    }
+
+    // 2. Write the snapshot to a new log without holding any lock. The old log is only appended to,
+    // so the snapshot's values stay where they are; so do the records appended since, which are
+    // copied as they are while their amount is still large.
+    const std::string tmpPath = options_.path + ".rewrite";
+    int out = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        Logger::get()->warn("Embedded storage {}: cannot rewrite: {}", options_.path, strerror(errno));
+        return;
+    }
+    const uint64_t kTailUnderLock = 1u << 20;
+    uint64_t size = 0;
+    uint64_t tailBase = 0; // offset of the first appended record in the new log
+    uint64_t copied = snapshotEnd;
+    std::unordered_map<uint64_t, uint64_t> moved; // value offset in the old log -> in the new one
+    auto fail = [&](const char* what) {
+        Logger::get()->warn("Embedded storage {}: rewrite failed: {}", options_.path, what);
+        ::close(out);
+        ::unlink(tmpPath.c_str());
+    };
+    try {
+        for (auto& chunk : chunks) {
+            writeAll(out, chunk);
+            size += chunk.size();
+            std::string().swap(chunk);
+        }
+        std::string buf;
+        for (const auto& v : diskValues) {
+            const std::string value = readAt(in, v.offset, v.size);
+            moved[v.offset] = size + buf.size() + kHeaderSize + v.key.size();
+            encode(buf, OP_SET, v.key, value, {}, v.expireAtMs);
+            if (buf.size() >= (1u << 20)) {
+                writeAll(out, buf);
+                size += buf.size();
+                buf.clear();
+            }
+        }
+        writeAll(out, buf);
+        size += buf.size();
+        tailBase = size;
+        while (true) {
+            uint64_t end;
+            {
+                std::lock_guard<std::mutex> fileLock(fileMtx_);
+                end = fileSize_;
+            }
+            if (end - copied < kTailUnderLock) break;
+            size += copyRange(in, copied, end, out);
+            copied = end;
+        }
+    } catch (const StorageError& e) {
+        fail(e.what());
+        return;
+    }
+
+    // 3. Every shard, then the file, in the order the mutations take them: copy the last appended
+    // records, swap the files and point the values on disk to the new log.
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(kShards);
+    for (auto& shard : shards_) locks.emplace_back(shard.mtx);
+    std::lock_guard<std::mutex> fileLock(fileMtx_);
+    try {
+        size += copyRange(in, copied, fileSize_, out);
+        if (::fsync(out) != 0) throw StorageError("fsync failed");
+    } catch (const StorageError& e) {
+        fail(e.what());
+        return;
+    }
+    ::close(out);
+    if (::rename(tmpPath.c_str(), options_.path.c_str()) != 0) {
+        Logger::get()->warn("Embedded storage {}: cannot replace the log: {}", options_.path, strerror(errno));
+        ::unlink(tmpPath.c_str());
+        return;
+    }
+    ::close(fd_);
+    fd_ = ::open(options_.path.c_str(), O_RDWR | O_APPEND);
+    if (fd_ < 0) throw StorageError("embedded storage: cannot reopen " + options_.path);
+    Logger::get()->info("Embedded storage {}: rewrote the log, {} MiB -> {} MiB", options_.path, fileSize_ >> 20, size >> 20);
+    fileSize_ = size;
+    if (!options_.valuesOnDisk) return;
+    for (auto& shard : shards_) {
+        for (auto it = shard.map.begin(); it != shard.map.end();) {
+            Entry& e = it->second;
+            if (e.type != STRING) {
+                ++it;
+            } else if (e.valueOffset >= snapshotEnd) {
+                e.valueOffset = tailBase + (e.valueOffset - snapshotEnd);
+                ++it;
+            } else if (auto m = moved.find(e.valueOffset); m != moved.end()) {
+                e.valueOffset = m->second;
+                ++it;
+            } else {
+                // expired before the snapshot, its value was not copied
+                it = shard.map.erase(it);
+            }
+        }
+    }
+}
+
+size_t EmbeddedBackend::size()
+{
+    const int64_t now = nowMs();
+    size_t n = 0;
+    for (auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mtx);
+        for (const auto& kv : shard.map) n += live(kv.second, now) ? 1 : 0;
+    }
+    return n;
+}
+
+StorageBackend::OptionalString EmbeddedBackend::get(const std::string& key)
+{
+    auto& shard = shardOf(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mtx);
+    const Entry* e = find(shard, key, STRING);
+    if (!e) return std::nullopt;
+    return readValue(*e);
+}
+
+void EmbeddedBackend::mget(const std::vector<std::string>& keys, std::vector<OptionalString>& out)
+{
+    out.clear();
+    out.reserve(keys.size());
+    for (const auto& key : keys) {
+        auto& shard = shardOf(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mtx);
+        auto it = shard.map.find(key);
+        // like MGET, keys of another type read as missing
+        if (it == shard.map.end() || it->second.type != STRING || !live(it->second, nowMs())) {
+            out.emplace_back(std::nullopt);
+        } else {
+            out.emplace_back(readValue(it->second));
+        }
+    }
+}
+
+bool EmbeddedBackend::set(const std::string& key, std::string_view value, std::chrono::seconds ttl, bool onlyIfAbsent)
+{
+    auto& shard = shardOf(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mtx);
+    auto it = shard.map.find(key);
+    if (onlyIfAbsent && it != shard.map.end() && live(it->second, nowMs())) return false;
+    const int64_t expireAt = ttl.count() > 0 ? nowMs() + ttl.count() * 1000 : 0;
+    const uint64_t offset = append(OP_SET, key, value, {}, expireAt);
+    Entry e;
+    e.expireAtMs = expireAt;
+    if (options_.valuesOnDisk) {
+        e.valueOffset = offset;
+        e.valueSize = static_cast<uint32_t>(value.size());
+    } else {
+        e.value.assign(value.data(), value.size());
+    }
+    shard.map[key] = std::move(e);
+    return true;
+}
+
+void EmbeddedBackend::mset(const Fields& entries, std::chrono::seconds ttl)
+{
+    for (const auto& [key, value] : entries) set(key, value, ttl, false);
+}
+
+bool EmbeddedBackend::exists(const std::string& key)
+{
+    auto& shard = shardOf(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mtx);
+    auto it = shard.map.find(key);
+    return it != shard.map.end() && live(it->second, nowMs());
+}
+
+void EmbeddedBackend::exists(const std::vector<std::string>& keys, std::vector<uint8_t>& out)
+{
+    out.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) out[i] = exists(keys[i]) ? 1 : 0;
+}
+
+void EmbeddedBackend::unlink(const std::vector<std::string>& keys)
+{
+    for (const auto& key : keys) {
+        auto& shard = shardOf(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) continue;
+        append(OP_DEL, key);
+        shard.map.erase(it);
+    }
+}
+
+void EmbeddedBackend::rename(const std::string& from, const std::string& to)
+{
+    if (from == to) {
+        if (!exists(from)) throw StorageError("ERR no such key");
+        return;
+    }
+    auto& src = shardOf(from);
+    auto& dst = shardOf(to);
+    // lock both shards in a fixed order
+    std::unique_lock<std::shared_mutex> first((&src < &dst ? src : dst).mtx);
+    std::unique_lock<std::shared_mutex> second;
+    if (&src != &dst) second = std::unique_lock<std::shared_mutex>((&src < &dst ? dst : src).mtx);
+    auto it = src.map.find(from);
+    if (it == src.map.end() || !live(it->second, nowMs())) throw StorageError("ERR no such key");
+    append(OP_RENAME, from, to);
+    Entry moved = std::move(it->second);
+    src.map.erase(it);
+    dst.map[to] = std::move(moved);
+}
+
+void EmbeddedBackend::expire(const std::string& key, std::chrono::seconds ttl)
+{
+    if (ttl.count() <= 0) {
+        unlink(key);
+        return;
+    }
+    auto& shard = shardOf(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mtx);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end() || !live(it->second, nowMs())) return;
+    const int64_t expireAt = nowMs() + ttl.count() * 1000;
+    append(OP_EXPIRE, key, {}, {}, expireAt);
+    it->second.expireAtMs = expireAt;
+}
+
+StorageBackend::OptionalString EmbeddedBackend::hget(const std::string& key, const std::string& field)
+{
+    auto& shard = shardOf(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mtx);
+    const Entry* e = find(shard, key, HASH);
+    if (!e) return std::nullopt;
+    auto it = e->hash->find(field);
+    if (it == e->hash->end()) return std::nullopt;
+    return it->second;
+}
+
+void EmbeddedBackend::hmget(const std::string& key, const std::vector<std::string>& fields, std::vector<OptionalString>& out)
+{
+    out.assign(fields.size(), std::nullopt);
+    auto& shard = shardOf(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mtx);
+    const Entry* e = find(shard, key, HASH);
+    if (!e) return;
+    for (size_t i = 0; i < fields.size(); i++) {
+        auto it = e->hash->find(fields[i]);
+        if (it != e->hash->end()) out[i] = it->second;
+    }
+}
+
+void EmbeddedBackend::hset(const std::string& key, const Fields& fields)
+{
+    auto& shard = shardOf(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mtx);
+    Entry* e = find(shard, key, HASH);
+    if (!e) {
+        Entry fresh;
+        fresh.type = HASH;
+        fresh.hash = std::make_unique<std::unordered_map<std::string, std::string>>();
+        e = &(shard.map[key] = std::move(fresh));
+    }
+    for (const auto& [f, v] : fields) {
+        append(OP_HSET, key, f, v);
+        (*e->hash)[f] = v;
+    }
+}
+
+bool EmbeddedBackend::hsetIfGreater(const std::string& key, const std::string& field, long long value,
+                                    long long missingValue, const Fields& extraFields)
+{
+    auto& shard = shardOf(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mtx);
+    return applyIfGreater(shard, {key, field, value, missingValue, extraFields});
+}
+
+size_t EmbeddedBackend::hsetIfGreaterAll(const std::vector<GreaterUpdate>& updates)
+{
+    // lock every shard involved, in a fixed order
+    std::vector<Shard*> involved;
+    for (const auto& u : updates) involved.push_back(&shardOf(u.key));
+    std::sort(involved.begin(), involved.end());
+    involved.erase(std::unique(involved.begin(), involved.end()), involved.end());
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    for (Shard* shard : involved) locks.emplace_back(shard->mtx);
+    size_t applied = 0;
+    for (const auto& u : updates) applied += applyIfGreater(shardOf(u.key), u) ? 1 : 0;
+    return applied;
+}
+
+bool EmbeddedBackend::applyIfGreater(Shard& shard, const GreaterUpdate& u)
+{
+    const std::string& key = u.key;
+    const long long value = u.value;
+    Entry* e = find(shard, key, HASH);
+    long long current = u.missingValue;
+    if (e) {
+        auto it = e->hash->find(u.field);
+        if (it != e->hash->end()) {
+            char* end = nullptr;
+            long long parsed = strtoll(it->second.c_str(), &end, 10);
+            if (end && *end == '\0' && !it->second.empty()) current = parsed;
+        }
+    }
+    if (value <= current) return false;
+    if (!e) {
+        Entry fresh;
+        fresh.type = HASH;
+        fresh.hash = std::make_unique<std::unordered_map<std::string, std::string>>();
+        e = &(shard.map[key] = std::move(fresh));
+    }
+    const std::string v = std::to_string(value);
+    append(OP_HSET, key, u.field, v);
+    (*e->hash)[u.field] = v;
+    for (const auto& [f, x] : u.extraFields) {
+        append(OP_HSET, key, f, x);
+        (*e->hash)[f] = x;
+    }
+    return true;
+}
+
+void EmbeddedBackend::zadd(const std::vector<ZMember>& members, bool onlyIfAbsent)
+{
+    for (const auto& m : members) {
+        auto& shard = shardOf(m.key);
+        std::unique_lock<std::shared_mutex> lock(shard.mtx);
+        Entry* e = find(shard, m.key, ZSET);
+        if (!e) {
+            Entry fresh;
+            fresh.type = ZSET;
+            fresh.zset = std::make_unique<ZSet>();
+            e = &(shard.map[m.key] = std::move(fresh));
+        }
+        auto it = e->zset->scores.find(m.member);
+        if (it != e->zset->scores.end()) {
+            if (onlyIfAbsent || it->second == m.score) continue;
+            e->zset->ordered.erase({it->second, m.member});
+        }
+        append(OP_ZADD, m.key, m.member, {}, toBits(m.score));
+        e->zset->scores[m.member] = m.score;
+        e->zset->ordered.insert({m.score, m.member});
+    }
+}
+
+void EmbeddedBackend::zrangeByScore(const std::string& key, const ScoreRange& range, bool descending, size_t limit,
+                                    std::vector<std::string>& out)
+{
+    out.clear();
+    auto& shard = shardOf(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mtx);
+    const Entry* e = find(shard, key, ZSET);
+    if (!e) return;
+    const auto& ordered = e->zset->ordered;
+    auto full = [&]() { return limit != 0 && out.size() >= limit; };
+    if (!descending) {
+        for (auto it = ordered.lower_bound({range.min, std::string()}); it != ordered.end() && !full(); ++it) {
+            if (it->first > range.max) break;
+            if (inRange(it->first, range)) out.push_back(it->second);
+        }
+    } else {
+        // first member scored above max
+        auto upper = std::isinf(range.max) && range.max > 0
+                     ? ordered.end()
+                     : ordered.lower_bound({std::nextafter(range.max, std::numeric_limits<double>::infinity()), std::string()});
+        auto it = std::make_reverse_iterator(upper);
+        for (; it != ordered.rend() && !full(); ++it) {
+            if (it->first < range.min) break;
+            if (inRange(it->first, range)) out.push_back(it->second);
+        }
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include "StorageBackend.h"
+
+// In-process StorageBackend: no server, no RESP round trips.
+// usage: every key lives in memory (sharded hash tables behind shared mutexes). With a path, every
+// mutation is appended to a log file first and the file is replayed when the backend is opened again,
+// so the data survives restarts. The file is only ever appended to; it is rewritten with the live
+// keys when it has grown to more than twice their size, on open and by a background compactor that
+// checks every compactIntervalSec and whenever another minRewriteWaste bytes have been appended.
+// The live keys are copied to the new file without holding locks; mutations only wait while the records
+// appended during the copy are added and the files are swapped.
+// With valuesOnDisk, string values are not kept in memory: the index remembers where the value sits
+// in the log file and reads it back with pread (a log-structured store, used for the cold tier).
+// Expired keys read as missing; the compactor drops them from memory and the rewrite from the file.
+class EmbeddedBackend : public StorageBackend
+{
+public:
+    struct Options
+    {
+        std::string path;          // log file; empty keeps the data in memory only
+        bool valuesOnDisk = false; // needs a path
+        uint64_t minRewriteWaste = 64ull << 20; // rewrite only when it reclaims at least this much
+        int compactIntervalSec = 60;            // 0 disables the background compactor
+    };
+
+    // Opens (and replays) the log file; throws StorageError if it cannot be opened.
+    explicit EmbeddedBackend(const Options& options);
+    ~EmbeddedBackend() override;
+
+    void ping() override {}
+
+    OptionalString get(const std::string& key) override;
+    void mget(const std::vector<std::string>& keys, std::vector<OptionalString>& out) override;
+    bool set(const std::string& key, std::string_view value, std::chrono::seconds ttl, bool onlyIfAbsent) override;
+    void mset(const Fields& entries, std::chrono::seconds ttl) override;
+
+    bool exists(const std::string& key) override;
+    void exists(const std::vector<std::string>& keys, std::vector<uint8_t>& out) override;
+    using StorageBackend::unlink;
+    void unlink(const std::vector<std::string>& keys) override;
+    void rename(const std::string& from, const std::string& to) override;
+    void expire(const std::string& key, std::chrono::seconds ttl) override;
+
+    OptionalString hget(const std::string& key, const std::string& field) override;
+    void hmget(const std::string& key, const std::vector<std::string>& fields, std::vector<OptionalString>& out) override;
+    void hset(const std::string& key, const Fields& fields) override;
+    bool hsetIfGreater(const std::string& key, const std::string& field, long long value,
+                       long long missingValue, const Fields& extraFields) override;
+    size_t hsetIfGreaterAll(const std::vector<GreaterUpdate>& updates) override;
+
+    void zadd(const std::vector<ZMember>& members, bool onlyIfAbsent) override;
+    void zrangeByScore(const std::string& key, const ScoreRange& range, bool descending, size_t limit,
+                       std::vector<std::string>& out) override;
+
+    // Number of live keys, for stats and tests.
+    size_t size();
+    // Drops expired keys and rewrites the log if it is mostly garbage. The background compactor calls it.
+    void compact();
+
+private:
+    enum Op : uint8_t
+    {
+        OP_SET = 1,
+        OP_DEL = 2,
+        OP_HSET = 3,
+        OP_ZADD = 4,
+        OP_RENAME = 5,
+        OP_EXPIRE = 6,
+    };
+    enum Type : uint8_t
+    {
+        STRING = 0,
+        HASH = 1,
+        ZSET = 2,
+    };
+
+    struct ZSet
+    {
+        std::unordered_map<std::string, double> scores;
+        std::set<std::pair<double, std::string>> ordered;
+    };
+
+    struct Entry
+    {
+        Type type = STRING;
+        int64_t expireAtMs = 0; // 0 = no expiration
+        std::string value;      // STRING kept in memory
+        uint64_t valueOffset = 0; // STRING kept in the log file
+        uint32_t valueSize = 0;
+        std::unique_ptr<std::unordered_map<std::string, std::string>> hash;
+        std::unique_ptr<ZSet> zset;
+    };
+
+    struct Shard
+    {
+        std::shared_mutex mtx;
+        std::unordered_map<std::string, Entry> map;
+    };
+    static constexpr size_t kShards = 64;
+
+    Shard& shardOf(const std::string& key);
+    static int64_t nowMs();
+    static bool live(const Entry& e, int64_t now) { return e.expireAtMs == 0 || e.expireAtMs > now; }
+    // Finds a live entry of the given type; throws StorageError on a type mismatch.
+    Entry* find(Shard& shard, const std::string& key, Type type);
+    // hsetIfGreater with the shard of u.key locked.
+    bool applyIfGreater(Shard& shard, const GreaterUpdate& u);
+    std::string readValue(const Entry& e);
+
+    // Appends one record to the log file; returns the file offset of a (0 without a file).
+    uint64_t append(Op op, const std::string& key, std::string_view a = {}, std::string_view b = {}, int64_t extra = 0);
+    void replay();
+    // Rewrites the log with the live keys when rewriteDue; callers hold rewriteMtx_ (or run alone).
+    void rewrite();
+    size_t liveBytes();
+    bool rewriteDue(uint64_t live) const;
+    size_t sweepExpired();
+    void compactLoop();
+
+    Options options_;
+    int fd_ = -1;
+    uint64_t fileSize_ = 0;
+    uint64_t appendedSinceCompact_ = 0; // guarded by fileMtx_
+    std::mutex fileMtx_;
+    std::mutex rewriteMtx_; // one rewrite at a time
+    std::array<Shard, kShards> shards_;
+
+    std::mutex compactMtx_;
+    std::condition_variable compactCv_;
+    bool stopping_ = false;
+    std::thread compactor_;
+};
@@ -0,0 +1,392 @@
+#include "Keyspace.h"
+#include "K12AndKeyUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace Keyspace {
+
+namespace {
+
+std::atomic<Version> gVersion{Version::V1};
+std::atomic<bool> gMigrating{false};
+
+constexpr char kV2Marker = static_cast<char>(0xB2);
+
+// v2 family bytes
+constexpr char kLog = 'L';
+constexpr char kLogRanges = 'R';
+constexpr char kTickLogRange = 'S';
+constexpr char kEndEpochTickLogRange = 'E';
+constexpr char kTickData = 'D';
+constexpr char kTickVote = 'V';
+constexpr char kTickVotes = 'P';
+constexpr char kTransaction = 'T';
+constexpr char kVtick = 'K';
+constexpr char kCLogRange = 'C';
+constexpr char kIndexedTx = 'X';
+constexpr char kIndexedSpecialTx = 'Y';
+constexpr char kIndexed = 'I';
+
+// 26^7, the weight of the upper 7 letters of one 64-bit identity fragment
+constexpr uint64_t kPow26_7 = 26ull * 26 * 26 * 26 * 26 * 26 * 26;
+
+// hash encodings inside a v2 key
+constexpr char kRawHash = 'h';
+constexpr char kStringHash = 's';
+constexpr char kAnyTopic = 0;
+
+// A v2 key assembled in a fixed buffer; only a key with an oversized non-identity hash spills to the heap.
+class KeyBuilder
+{
+public:
+    explicit KeyBuilder(char family)
+    {
+        buf_[0] = kV2Marker;
+        buf_[1] = family;
+        size_ = 2;
+    }
+
+    KeyBuilder& be16(uint16_t v) { return be(v, 2); }
+    KeyBuilder& be32(uint32_t v) { return be(v, 4); }
+    KeyBuilder& be64(uint64_t v) { return be(v, 8); }
+
+    KeyBuilder& bytes(const void* data, size_t size)
+    {
+        if (!spill_.empty() || size_ + size > sizeof(buf_)) {
+            if (spill_.empty()) spill_.assign(buf_, size_);
+            spill_.append(static_cast<const char*>(data), size);
+        } else {
+            memcpy(buf_ + size_, data, size);
+        }
+        size_ += size;
+        return *this;
+    }
+
+    KeyBuilder& byte(char c) { return bytes(&c, 1); }
+
+    // A canonical lowercase identity as its 32 bytes, anything else as is.
+    KeyBuilder& hash(std::string_view h, Origin origin)
+    {
+        uint8_t raw[32];
+        if (decodeIdentity(h, raw, origin == Origin::Request)) return byte(kRawHash).bytes(raw, sizeof(raw));
+        return byte(kStringHash).be16(static_cast<uint16_t>(std::min<size_t>(h.size(), UINT16_MAX)))
+                .bytes(h.data(), std::min<size_t>(h.size(), UINT16_MAX));
+    }
+
+    KeyBuilder& hash(const uint8_t* digest) { return byte(kRawHash).bytes(digest, 32); }
+
+    KeyBuilder& topic(std::string_view t, Origin origin)
+    {
+        if (t == "ANY") return byte(kAnyTopic);
+        return hash(t, origin);
+    }
+
+    std::string str() const { return spill_.empty() ? std::string(buf_, size_) : spill_; }
+
+private:
+    KeyBuilder& be(uint64_t v, size_t width)
+    {
+        char out[8];
+        for (size_t i = 0; i < width; i++) out[i] = static_cast<char>(v >> (8 * (width - 1 - i)));
+        return bytes(out, width);
+    }
+
+    // The letters decode to at most one 32-byte value (overflowing fragments are refused). Names that
+    // differ only in their checksum would share it, so the checksum is checked unless told otherwise.
+    static bool decodeIdentity(std::string_view h, uint8_t* out, bool untrusted)
+    {
+        if (h.size() != 60) return false;
+        if (untrusted) {
+            unsigned bad = 0;
+            for (int i = 0; i < 56; i++) bad |= static_cast<unsigned>(static_cast<unsigned char>(h[i] - 'a')) >= 26u;
+            if (bad) return false;
+        }
+        for (int i = 0; i < 4; i++) {
+            // letter j weighs 26^j; each half of 7 letters stays below 26^7, so only joining them can overflow
+            const char* letters = h.data() + i * 14;
+            uint64_t low = 0, high = 0, fragment;
+            for (int j = 6; j >= 0; j--) {
+                low = low * 26 + static_cast<uint64_t>(letters[j] - 'a');
+                high = high * 26 + static_cast<uint64_t>(letters[j + 7] - 'a');
+            }
+            if (__builtin_mul_overflow(high, kPow26_7, &fragment) ||
+                __builtin_add_overflow(fragment, low, &fragment)) {
+                return false;
+            }
+            memcpy(out + i * 8, &fragment, 8);
+        }
+        if (!untrusted) return true;
+        unsigned int checksum = 0;
+        KangarooTwelve(out, 32, reinterpret_cast<uint8_t*>(&checksum), 3);
+        checksum &= 0x3FFFF;
+        for (int i = 56; i < 60; i++) {
+            if (h[i] != static_cast<char>('a' + checksum % 26)) return false;
+            checksum /= 26;
+        }
+        return true;
+    }
+
+    char buf_[128];
+    size_t size_;
+    std::string spill_;
+};
+
+// Decimal as written by std::to_string: digits only, no leading zero, at most max.
+bool parseNumber(std::string_view s, uint64_t max, uint64_t& out)
+{
+    if (s.empty() || s.size() > 20 || (s.size() > 1 && s[0] == '0')) return false;
+    out = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        if (__builtin_mul_overflow(out, 10u, &out) || __builtin_add_overflow(out, static_cast<uint64_t>(c - '0'), &out)) {
+            return false;
+        }
+    }
+    return out <= max;
+}
+
+bool consumePrefix(std::string_view& s, std::string_view prefix)
+{
+    if (s.substr(0, prefix.size()) != prefix) return false;
+    s.remove_prefix(prefix.size());
+    return true;
+}
+
+// Splits s at the first sep.
+bool split(std::string_view s, char sep, std::string_view& head, std::string_view& tail)
+{
+    const size_t pos = s.find(sep);
+    if (pos == std::string_view::npos) return false;
+    head = s.substr(0, pos);
+    tail = s.substr(pos + 1);
+    return true;
+}
+
+std::optional<std::string> tickKey(std::string_view rest, std::string (*make)(uint32_t, Version))
+{
+    uint64_t tick;
+    if (!parseNumber(rest, UINT32_MAX, tick)) return std::nullopt;
+    return make(static_cast<uint32_t>(tick), Version::V2);
+}
+
+std::optional<std::string> indexedToV2(std::string_view rest)
+{
+    std::string_view sc, logType, topics;
+    uint64_t scIndex, type;
+    if (!split(rest, ':', sc, logType)) {
+        if (!parseNumber(rest, UINT32_MAX, scIndex)) return std::nullopt;
+        return indexed(static_cast<uint32_t>(scIndex), Version::V2);
+    }
+    if (!parseNumber(sc, UINT32_MAX, scIndex)) return std::nullopt;
+    std::string_view t1, t2, t3;
+    if (!split(logType, ':', logType, topics)) {
+        if (!parseNumber(logType, UINT32_MAX, type)) return std::nullopt;
+        return indexed(static_cast<uint32_t>(scIndex), static_cast<uint32_t>(type), Version::V2);
+    }
+    if (!parseNumber(logType, UINT32_MAX, type) || !split(topics, ':', t1, topics) || !split(topics, ':', t2, t3) ||
+        t3.find(':') != std::string_view::npos) {
+        return std::nullopt;
+    }
+    return indexed(static_cast<uint32_t>(scIndex), static_cast<uint32_t>(type), t1, t2, t3, Version::V2);
+}
+
+} // namespace
+
+Version active()
+{
+    return gVersion.load(std::memory_order_relaxed);
+}
+
+bool migrating()
+{
+    return gMigrating.load(std::memory_order_relaxed);
+}
+
+void setState(Version version, bool migrating)
+{
+    gVersion = version;
+    gMigrating = migrating;
+}
+
+std::string log(uint16_t epoch, uint64_t logId, Version v)
+{
+    if (v == Version::V1) return "log:" + std::to_string(epoch) + ":" + std::to_string(logId);
+    return KeyBuilder(kLog).be16(epoch).be64(logId).str();
+}
+
+std::string logRanges(uint32_t tick, Version v)
+{
+    if (v == Version::V1) return "log_ranges:" + std::to_string(tick);
+    return KeyBuilder(kLogRanges).be32(tick).str();
+}
+
+std::string tickLogRange(uint32_t tick, Version v)
+{
+    if (v == Version::V1) return "tick_log_range:" + std::to_string(tick);
+    return KeyBuilder(kTickLogRange).be32(tick).str();
+}
+
+std::string endEpochTickLogRange(uint16_t epoch, Version v)
+{
+    if (v == Version::V1) return "end_epoch:tick_log_range:" + std::to_string(epoch);
+    return KeyBuilder(kEndEpochTickLogRange).be16(epoch).str();
+}
+
+std::string tickData(uint32_t tick, Version v)
+{
+    if (v == Version::V1) return "tick_data:" + std::to_string(tick);
+    return KeyBuilder(kTickData).be32(tick).str();
+}
+
+std::string tickVote(uint32_t tick, uint16_t computorIndex, Version v)
+{
+    if (v == Version::V1) return "tick_vote:" + std::to_string(tick) + ":" + std::to_string(computorIndex);
+    return KeyBuilder(kTickVote).be32(tick).be16(computorIndex).str();
+}
+
+std::string tickVotes(uint32_t tick, Version v)
+{
+    if (v == Version::V1) return "tick_votes:" + std::to_string(tick);
+    return KeyBuilder(kTickVotes).be32(tick).str();
+}
+
+std::string transaction(std::string_view txHash, Version v)
+{
+    return transaction(txHash, Origin::Request, v);
+}
+
+std::string transaction(std::string_view txHash, Origin origin, Version v)
+{
+    if (v == Version::V1) return "transaction:" + std::string(txHash);
+    return KeyBuilder(kTransaction).hash(txHash, origin).str();
+}
+
+std::string transaction(std::string_view txHash, const uint8_t* digest, Version v)
+{
+    if (v == Version::V1) return "transaction:" + std::string(txHash);
+    return KeyBuilder(kTransaction).hash(digest).str();
+}
+
+std::string vtick(uint32_t tick, Version v)
+{
+    if (v == Version::V1) return "vtick:" + std::to_string(tick);
+    return KeyBuilder(kVtick).be32(tick).str();
+}
+
+std::string cLogRange(uint32_t tick, Version v)
+{
+    if (v == Version::V1) return "cLogRange:" + std::to_string(tick);
+    return KeyBuilder(kCLogRange).be32(tick).str();
+}
+
+std::string indexedTx(std::string_view txHash, Version v)
+{
+    return indexedTx(txHash, Origin::Request, v);
+}
+
+std::string indexedTx(std::string_view txHash, Origin origin, Version v)
+{
+    if (v == Version::V1) return "itx:" + std::string(txHash);
+    return KeyBuilder(kIndexedTx).hash(txHash, origin).str();
+}
+
+std::string indexedTx(std::string_view txHash, const uint8_t* digest, Version v)
+{
+    if (v == Version::V1) return "itx:" + std::string(txHash);
+    return KeyBuilder(kIndexedTx).hash(digest).str();
+}
+
+std::string indexedTx(uint32_t tick, uint32_t txIndex, Version v)
+{
+    if (v == Version::V1) return "itx:" + std::to_string(tick) + "_" + std::to_string(txIndex);
+    return KeyBuilder(kIndexedSpecialTx).be32(tick).be32(txIndex).str();
+}
+
+std::string indexed(uint32_t scIndex, Version v)
+{
+    if (v == Version::V1) return "indexed:" + std::to_string(scIndex);
+    return KeyBuilder(kIndexed).be32(scIndex).str();
+}
+
+std::string indexed(uint32_t scIndex, uint32_t logType, Version v)
+{
+    if (v == Version::V1) return "indexed:" + std::to_string(scIndex) + ":" + std::to_string(logType);
+    return KeyBuilder(kIndexed).be32(scIndex).be32(logType).str();
+}
+
+std::string indexed(uint32_t scIndex, uint32_t logType, std::string_view topic1, std::string_view topic2,
+                    std::string_view topic3, Version v)
+{
+    return indexed(scIndex, logType, topic1, topic2, topic3, Origin::Request, v);
+}
+
+std::string indexed(uint32_t scIndex, uint32_t logType, std::string_view topic1, std::string_view topic2,
+                    std::string_view topic3, Origin origin, Version v)
+{
+    if (v == Version::V1) {
+        return "indexed:" + std::to_string(scIndex) + ":" + std::to_string(logType) + ":" + std::string(topic1) +
+               ":" + std::string(topic2) + ":" + std::string(topic3);
+    }
+    return KeyBuilder(kIndexed).be32(scIndex).be32(logType).topic(topic1, origin).topic(topic2, origin)
+            .topic(topic3, origin).str();
+}
+
+std::string encodeLogRange(long long fromLogId, long long length)
+{
+    const int64_t values[2] = {fromLogId, length};
+    return std::string(reinterpret_cast<const char*>(values), sizeof(values));
+}
+
+bool decodeLogRange(std::string_view value, long long& fromLogId, long long& length)
+{
+    int64_t values[2];
+    if (value.size() != sizeof(values)) return false;
+    memcpy(values, value.data(), sizeof(values));
+    fromLogId = values[0];
+    length = values[1];
+    return true;
+}
+
+std::optional<std::string> toV2(std::string_view key, bool* isLogRangeHash)
+{
+    if (isLogRangeHash) *isLogRangeHash = false;
+    std::string_view head, tail;
+    uint64_t a, b;
+    if (consumePrefix(key, "log:")) {
+        if (!split(key, ':', head, tail) || !parseNumber(head, UINT16_MAX, a) || !parseNumber(tail, UINT64_MAX, b)) {
+            return std::nullopt;
+        }
+        return log(static_cast<uint16_t>(a), b, Version::V2);
+    }
+    if (consumePrefix(key, "tick_vote:")) {
+        if (!split(key, ':', head, tail) || !parseNumber(head, UINT32_MAX, a) || !parseNumber(tail, UINT16_MAX, b)) {
+            return std::nullopt;
+        }
+        return tickVote(static_cast<uint32_t>(a), static_cast<uint16_t>(b), Version::V2);
+    }
+    if (consumePrefix(key, "tick_log_range:")) {
+        if (isLogRangeHash) *isLogRangeHash = true;
+        return tickKey(key, tickLogRange);
+    }
+    if (consumePrefix(key, "end_epoch:tick_log_range:")) {
+        if (!parseNumber(key, UINT16_MAX, a)) return std::nullopt;
+        if (isLogRangeHash) *isLogRangeHash = true;
+        return endEpochTickLogRange(static_cast<uint16_t>(a), Version::V2);
+    }
+    if (consumePrefix(key, "log_ranges:")) return tickKey(key, logRanges);
+    if (consumePrefix(key, "tick_data:")) return tickKey(key, tickData);
+    if (consumePrefix(key, "tick_votes:")) return tickKey(key, tickVotes);
+    if (consumePrefix(key, "vtick:")) return tickKey(key, vtick);
+    if (consumePrefix(key, "cLogRange:")) return tickKey(key, cLogRange);
+    if (consumePrefix(key, "transaction:")) return transaction(key, Version::V2);
+    if (consumePrefix(key, "itx:")) {
+        if (!split(key, '_', head, tail)) return indexedTx(key, Version::V2);
+        if (!parseNumber(head, UINT32_MAX, a) || !parseNumber(tail, UINT32_MAX, b)) return std::nullopt;
+        return indexedTx(static_cast<uint32_t>(a), static_cast<uint32_t>(b), Version::V2);
+    }
+    if (consumePrefix(key, "indexed:")) return indexedToV2(key);
+    return std::nullopt;
+}
+
+} // namespace Keyspace
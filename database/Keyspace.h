@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Names of the keys bob stores per tick, log and transaction.
+//
+// v1 names are decimal strings ("log:<epoch>:<logId>", "transaction:<60-char hash>", ...).
+// v2 names are binary: the byte 0xB2, a family byte, then fixed-width big-endian ids and 32-byte hashes
+// (a hash that is not a canonical lowercase identity is kept as a length-prefixed string). They are built
+// in a fixed stack buffer and copied into the returned string once: tick and log keys (up to 12 bytes) fit
+// std::string's inline storage, hash keys (35 bytes and more) take that one allocation.
+// A hash is decoded from its 56 base-26 letters. Its 4 checksum letters are only checked for hashes that
+// come from a request (Origin::Request); hashes bob computed itself (Origin::Computed) skip both the
+// letter validation and the K12. Callers that still hold the 32 bytes a hash was made from pass them
+// instead and skip the decoding.
+// v2 keys of one family sort like their ids. tick_log_range also changes value: v1 is a hash with the
+// decimal fields fromLogId and length, v2 the two numbers as 16 bytes (encodeLogRange).
+//
+// The version in use is kept in db_status (keyspace_version, see db.cpp); migrator/migrator.cpp moves a
+// v1 database to v2 while bob runs. During the migration (migrating()) keys are written under v2 names and
+// a key missing under its v2 name is read under its v1 name.
+// Low-volume keys (db_status, computor:, end_epoch: signatures, state history, ...) keep their v1 names.
+namespace Keyspace {
+
+enum class Version : uint8_t
+{
+    V1 = 1,
+    V2 = 2,
+};
+
+// Where a hash or identity passed to the functions below comes from.
+enum class Origin : uint8_t
+{
+    Request,  // from a client or peer: must be canonical, checksum included, to be stored as its 32 bytes
+    Computed, // made by getIdentityFromPublicKey/getTransactionHash: trusted to be a canonical lowercase identity
+};
+
+Version active();
+bool migrating();
+void setState(Version version, bool migrating);
+
+std::string log(uint16_t epoch, uint64_t logId, Version v = active());
+std::string logRanges(uint32_t tick, Version v = active());
+std::string tickLogRange(uint32_t tick, Version v = active());
+std::string endEpochTickLogRange(uint16_t epoch, Version v = active());
+std::string tickData(uint32_t tick, Version v = active());
+std::string tickVote(uint32_t tick, uint16_t computorIndex, Version v = active());
+std::string tickVotes(uint32_t tick, Version v = active());
+std::string transaction(std::string_view txHash, Version v = active());
+std::string transaction(std::string_view txHash, Origin origin, Version v = active());
+// txHash together with the 32 bytes it was made from (getIdentityFromPublicKey(digest)); v2 takes the bytes.
+std::string transaction(std::string_view txHash, const uint8_t* digest, Version v = active());
+std::string vtick(uint32_t tick, Version v = active());
+std::string cLogRange(uint32_t tick, Version v = active());
+// Indexer keys: itx:<txHash>, itx:<tick>_<txIndex> for the special events, and the sorted sets
+// indexed:<scIndex>[:<logType>[:<topic1>:<topic2>:<topic3>]] where a topic is an identity or "ANY".
+std::string indexedTx(std::string_view txHash, Version v = active());
+std::string indexedTx(std::string_view txHash, Origin origin, Version v = active());
+std::string indexedTx(std::string_view txHash, const uint8_t* digest, Version v = active());
+std::string indexedTx(uint32_t tick, uint32_t txIndex, Version v = active());
+std::string indexed(uint32_t scIndex, Version v = active());
+std::string indexed(uint32_t scIndex, uint32_t logType, Version v = active());
+std::string indexed(uint32_t scIndex, uint32_t logType, std::string_view topic1, std::string_view topic2,
+                    std::string_view topic3, Version v = active());
+std::string indexed(uint32_t scIndex, uint32_t logType, std::string_view topic1, std::string_view topic2,
+                    std::string_view topic3, Origin origin, Version v = active());
+
+// v2 value of tick_log_range:<tick>; length -1 marks a tick without logs.
+std::string encodeLogRange(long long fromLogId, long long length);
+bool decodeLogRange(std::string_view value, long long& fromLogId, long long& length);
+
+// The v2 name of a v1 key of the families above (nullopt for other keys), and whether its value is the
+// tick_log_range hash that has to be converted.
+std::optional<std::string> toV2(std::string_view v1Key, bool* isLogRangeHash = nullptr);
+
+} // namespace Keyspace
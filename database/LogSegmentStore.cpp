@@ -0,0 +1,275 @@
+#include "LogSegmentStore.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <shared_mutex>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct IndexSlot
+{
+    uint64_t offset;
+    uint32_t size; // 0 = not stored
+    uint32_t reserved;
+};
+static_assert(sizeof(IndexSlot) == 16, "index slots are stored as is");
+
+// The index grows by at least this many slots (16 MiB, sparse until written).
+constexpr uint64_t kIndexGrowth = 1ull << 20;
+// Upper bound of one pread when a range is read.
+constexpr size_t kMaxReadSize = 4u << 20;
+
+bool writeAll(int fd, const char* data, size_t size)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::write(fd, data + done, size - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size, uint64_t offset)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::pread(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+struct LogSegmentStore::Segment
+{
+    std::shared_mutex mtx; // shared for reads, unique for appends (which may remap the index)
+    std::string dataPath;
+    int dataFd = -1;
+    int indexFd = -1;
+    uint64_t dataSize = 0;
+    IndexSlot* index = nullptr;
+    uint64_t capacity = 0; // slots
+
+    ~Segment()
+    {
+        if (index) ::munmap(index, capacity * sizeof(IndexSlot));
+        if (indexFd >= 0) ::close(indexFd);
+        if (dataFd >= 0) ::close(dataFd);
+    }
+
+    bool map(uint64_t slots)
+    {
+        if (index) {
+            ::munmap(index, capacity * sizeof(IndexSlot));
+            index = nullptr;
+        }
+        capacity = 0;
+        void* p = ::mmap(nullptr, slots * sizeof(IndexSlot), PROT_READ | PROT_WRITE, MAP_SHARED, indexFd, 0);
+        if (p == MAP_FAILED) return false;
+        index = static_cast<IndexSlot*>(p);
+        capacity = slots;
+        return true;
+    }
+
+    // Makes room for slot logId.
+    bool reserve(uint64_t logId)
+    {
+        if (logId < capacity) return true;
+        const uint64_t slots = std::max({logId + 1, capacity * 2, kIndexGrowth});
+        if (::ftruncate(indexFd, static_cast<off_t>(slots * sizeof(IndexSlot))) != 0) return false;
+        return map(slots);
+    }
+
+    const IndexSlot* slot(uint64_t logId) const
+    {
+        if (logId >= capacity || index[logId].size == 0) return nullptr;
+        return &index[logId];
+    }
+};
+
+LogSegmentStore::LogSegmentStore(const std::string& directory, std::chrono::seconds retention)
+    : directory_(directory), retention_(retention)
+{
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+    if (ec) throw std::runtime_error("Cannot create log segment directory " + directory_ + ": " + ec.message());
+    prune();
+}
+
+LogSegmentStore::~LogSegmentStore() = default;
+
+std::shared_ptr<LogSegmentStore::Segment> LogSegmentStore::segment(uint16_t epoch, bool create)
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    auto it = segments_.find(epoch);
+    if (it != segments_.end()) return it->second;
+
+    const std::string base = (fs::path(directory_) / std::to_string(epoch)).string();
+    auto seg = std::make_shared<Segment>();
+    seg->dataPath = base + ".seg";
+    if (!create && !fs::exists(seg->dataPath)) return nullptr;
+    const bool fresh = !fs::exists(seg->dataPath);
+
+    seg->dataFd = ::open(seg->dataPath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    seg->indexFd = ::open((base + ".idx").c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat dataStat, indexStat;
+    if (seg->dataFd < 0 || seg->indexFd < 0 || ::fstat(seg->dataFd, &dataStat) != 0 || ::fstat(seg->indexFd, &indexStat) != 0) {
+        Logger::get()->error("Cannot open log segment {}: {}", base, strerror(errno));
+        return nullptr;
+    }
+    seg->dataSize = static_cast<uint64_t>(dataStat.st_size);
+    const uint64_t slots = static_cast<uint64_t>(indexStat.st_size) / sizeof(IndexSlot);
+    if (slots == 0 ? !seg->reserve(0) : !seg->map(slots)) {
+        Logger::get()->error("Cannot map log segment index {}.idx: {}", base, strerror(errno));
+        return nullptr;
+    }
+    // slots written before their data reached the disk (power loss)
+    uint64_t dropped = 0;
+    for (uint64_t i = 0; i < seg->capacity; i++) {
+        IndexSlot& s = seg->index[i];
+        if (s.size != 0 && s.offset + s.size > seg->dataSize) {
+            s = IndexSlot{};
+            dropped++;
+        }
+    }
+    if (dropped) Logger::get()->warn("Log segment {}: dropped {} index slots past the end of the data", base, dropped);
+
+    segments_[epoch] = seg;
+    lock.unlock();
+    // a new epoch started: a good time to drop old ones
+    if (fresh) prune();
+    return seg;
+}
+
+void LogSegmentStore::prune()
+{
+    if (retention_.count() <= 0) return;
+    const auto cutoff = fs::file_time_type::clock::now() - retention_;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory_, ec)) {
+        const fs::path& path = entry.path();
+        if (path.extension() != ".seg") continue;
+        const auto modified = fs::last_write_time(path, ec);
+        if (ec || modified >= cutoff) continue;
+        uint16_t epoch;
+        try {
+            epoch = static_cast<uint16_t>(std::stoul(path.stem().string()));
+        } catch (const std::exception&) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            segments_.erase(epoch);
+        }
+        fs::path indexPath = path;
+        indexPath.replace_extension(".idx");
+        fs::remove(path, ec);
+        fs::remove(indexPath, ec);
+        Logger::get()->info("Deleted expired log segment of epoch {}", epoch);
+    }
+}
+
+bool LogSegmentStore::append(uint16_t epoch, const std::vector<Record>& logs)
+{
+    if (logs.empty()) return true;
+    auto seg = segment(epoch, true);
+    if (!seg) return false;
+    std::unique_lock<std::shared_mutex> lock(seg->mtx);
+
+    std::string buf;
+    std::vector<std::pair<uint64_t, IndexSlot>> slots;
+    slots.reserve(logs.size());
+    uint64_t minLogId = UINT64_MAX, maxLogId = 0;
+    for (const auto& r : logs) {
+        if (r.data.empty() || seg->slot(r.logId)) continue;
+        slots.push_back({r.logId, IndexSlot{seg->dataSize + buf.size(), static_cast<uint32_t>(r.data.size()), 0}});
+        buf.append(r.data.data(), r.data.size());
+        minLogId = std::min(minLogId, r.logId);
+        maxLogId = std::max(maxLogId, r.logId);
+    }
+    if (slots.empty()) return true;
+    // data first, and on disk before any slot is published: the kernel may write the mapped index pages
+    // back at any time, and a slot must never point at bytes that are not in the file
+    if (!seg->reserve(maxLogId) || !writeAll(seg->dataFd, buf.data(), buf.size()) || ::fdatasync(seg->dataFd) != 0) {
+        Logger::get()->error("Cannot append to log segment of epoch {}: {}", epoch, strerror(errno));
+        return false;
+    }
+    seg->dataSize += buf.size();
+    for (const auto& [logId, s] : slots) seg->index[logId] = s;
+    // the caller deletes the hot copy once this returns, so the slots must be durable too
+    const uintptr_t page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const uintptr_t from = reinterpret_cast<uintptr_t>(&seg->index[minLogId]) & ~(page - 1);
+    const uintptr_t to = reinterpret_cast<uintptr_t>(&seg->index[maxLogId + 1]);
+    if (::msync(reinterpret_cast<void*>(from), to - from, MS_SYNC) != 0) {
+        Logger::get()->error("Cannot sync log segment index of epoch {}: {}", epoch, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool LogSegmentStore::get(uint16_t epoch, uint64_t logId, std::string& out)
+{
+    auto seg = segment(epoch, false);
+    if (!seg) return false;
+    std::shared_lock<std::shared_mutex> lock(seg->mtx);
+    const IndexSlot* s = seg->slot(logId);
+    if (!s) return false;
+    out.resize(s->size);
+    return readAll(seg->dataFd, &out[0], s->size, s->offset);
+}
+
+bool LogSegmentStore::readRange(uint16_t epoch, uint64_t fromLogId, uint64_t toLogId, const Visitor& visit)
+{
+    auto seg = segment(epoch, false);
+    if (!seg) return true;
+    std::shared_lock<std::shared_mutex> lock(seg->mtx);
+    if (seg->capacity == 0 || fromLogId > toLogId) return true;
+    std::vector<char> buf;
+    uint64_t id = fromLogId;
+    const uint64_t last = std::min(toLogId, seg->capacity - 1);
+    while (id <= last) {
+        const IndexSlot* first = seg->slot(id);
+        if (!first) {
+            id++;
+            continue;
+        }
+        // extend the run while the next log follows this one in the file
+        uint64_t end = id + 1;
+        uint64_t runSize = first->size;
+        while (end <= last) {
+            const IndexSlot* next = seg->slot(end);
+            if (!next || next->offset != first->offset + runSize || runSize + next->size > kMaxReadSize) break;
+            runSize += next->size;
+            end++;
+        }
+        buf.resize(runSize);
+        if (!readAll(seg->dataFd, buf.data(), runSize, first->offset)) {
+            Logger::get()->error("Cannot read log segment of epoch {} at offset {}", epoch, first->offset);
+            return false;
+        }
+        uint64_t pos = 0;
+        for (uint64_t i = id; i < end; i++) {
+            const uint32_t size = seg->index[i].size;
+            visit(i, reinterpret_cast<const uint8_t*>(buf.data() + pos), size);
+            pos += size;
+        }
+        id = end;
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Cold-tier store for log events, one segment per epoch (see log-segment-path in CONFIG_FILE.MD).
+// Log ids are dense within an epoch, so instead of one key per event a segment is two files:
+//  - <epoch>.seg: the raw log events, appended back to back and never rewritten
+//  - <epoch>.idx: a memory-mapped array of {offset, size} slots indexed by logId (size 0 = not stored)
+// Logs of a tick are moved together, so they sit next to each other in the .seg file and a range read
+// is a single pread instead of one lookup per event.
+// After a crash, slots pointing past the end of the .seg file are cleared when the segment is opened;
+// the data is written and fdatasync'ed before the slots are set, so a stored slot always has its bytes on
+// disk, and the slots are msync'ed before append() returns.
+// Thread-safe: appends to a segment are serialized, reads of a segment run concurrently.
+class LogSegmentStore
+{
+public:
+    struct Record
+    {
+        uint64_t logId;
+        std::string_view data;
+    };
+    // Called for every stored log of a range, in logId order. data is only valid during the call.
+    using Visitor = std::function<void(uint64_t logId, const uint8_t* data, size_t size)>;
+
+    // Opens the store under directory (created if missing) and deletes the segments whose last write is
+    // older than retention (0 keeps everything). Throws std::runtime_error if directory cannot be created.
+    LogSegmentStore(const std::string& directory, std::chrono::seconds retention);
+    ~LogSegmentStore();
+
+    // Appends logs of one epoch with a single write; logs already stored are skipped.
+    // Returns false on an I/O error.
+    bool append(uint16_t epoch, const std::vector<Record>& logs);
+
+    bool get(uint16_t epoch, uint64_t logId, std::string& out);
+
+    // Visits the stored logs in [fromLogId, toLogId]. Records that sit back to back in the segment file
+    // are fetched with one pread. Returns false on an I/O error.
+    bool readRange(uint16_t epoch, uint64_t fromLogId, uint64_t toLogId, const Visitor& visit);
+
+private:
+    struct Segment;
+
+    // Returns the open segment of epoch, opening it if its files exist (or create is set); nullptr otherwise.
+    // Shared because prune() may drop it from segments_ while it is in use.
+    std::shared_ptr<Segment> segment(uint16_t epoch, bool create);
+    void prune();
+
+    std::string directory_;
+    std::chrono::seconds retention_;
+    std::mutex mtx_; // guards segments_
+    std::map<uint16_t, std::shared_ptr<Segment>> segments_;
+};
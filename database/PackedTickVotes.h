@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "structs.h"
+
+// The votes of a verified tick packed into one KeyDB value (tick_votes:<tick>) in place of the
+// 676 tick_vote:<tick>:<computorIndex> keys:
+//  - a presence bitmap, bit i set if computor i voted
+//  - the present votes in computorIndex order
+namespace PackedTickVotes {
+
+constexpr size_t kComputors = 676;
+constexpr size_t kBitmapSize = (kComputors + 7) / 8;
+
+inline bool present(std::string_view blob, size_t computorIndex)
+{
+    return (static_cast<uint8_t>(blob[computorIndex >> 3]) >> (computorIndex & 7)) & 1;
+}
+
+inline size_t count(std::string_view blob)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < kBitmapSize; i++) n += __builtin_popcount(static_cast<uint8_t>(blob[i]));
+    return n;
+}
+
+inline bool valid(std::string_view blob)
+{
+    return blob.size() >= kBitmapSize && blob.size() == kBitmapSize + count(blob) * sizeof(TickVote);
+}
+
+// Votes with an out-of-range or repeated computorIndex are dropped.
+inline std::string pack(const std::vector<TickVote>& votes)
+{
+    std::string blob(kBitmapSize, '\0');
+    const TickVote* byIndex[kComputors] = {};
+    for (const auto& vote : votes) {
+        if (vote.computorIndex < kComputors && !byIndex[vote.computorIndex]) byIndex[vote.computorIndex] = &vote;
+    }
+    for (size_t i = 0; i < kComputors; i++) {
+        if (!byIndex[i]) continue;
+        blob[i >> 3] = static_cast<char>(static_cast<uint8_t>(blob[i >> 3]) | (1 << (i & 7)));
+        blob.append(reinterpret_cast<const char*>(byIndex[i]), sizeof(TickVote));
+    }
+    return blob;
+}
+
+// Appends the votes of blob to out; false if blob is malformed.
+inline bool unpack(std::string_view blob, std::vector<TickVote>& out)
+{
+    if (!valid(blob)) return false;
+    const size_t n = (blob.size() - kBitmapSize) / sizeof(TickVote);
+    const size_t first = out.size();
+    out.resize(first + n);
+    memcpy((void*)&out[first], blob.data() + kBitmapSize, n * sizeof(TickVote));
+    return true;
+}
+
+// The vote of one computor; false if it did not vote or blob is malformed.
+inline bool find(std::string_view blob, uint16_t computorIndex, TickVote& vote)
+{
+    if (computorIndex >= kComputors || !valid(blob) || !present(blob, computorIndex)) return false;
+    size_t slot = 0;
+    for (size_t i = 0; i < computorIndex; i++) slot += present(blob, i);
+    memcpy((void*)&vote, blob.data() + kBitmapSize + slot * sizeof(TickVote), sizeof(TickVote));
+    return true;
+}
+
+} // namespace PackedTickVotes
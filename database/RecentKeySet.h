@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+
+// The keys of one family (transactions, logs, log ranges) that this process wrote or saw in KeyDB
+// recently, so an existence check can answer "yes" without a round trip. A hit is exact as long as every
+// delete of a key also erases it here. A miss says nothing: the key may predate this process or have aged
+// out, so the caller asks KeyDB.
+// Each shard keeps two generations of keys; when the current one is full the older one is dropped, which
+// bounds the set to about `capacity` keys and keeps the most recent ones. All methods are thread-safe.
+//
+// A write or EXISTS that saw a key can finish after a delete unlinked it and erased it here. Such a late
+// insert must not bring the key back, so the caller takes a stamp() before the storage call and passes it
+// to insert(), which drops the key if its shard had an erase in between (at worst a few unrelated keys
+// miss the set and cost one more round trip).
+class RecentKeySet
+{
+public:
+    explicit RecentKeySet(size_t capacity) : generationCapacity_(capacity / (2 * kShards) + 1) {}
+
+    uint64_t stamp(uint64_t key)
+    {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        return shard.erasures;
+    }
+
+    void insert(uint64_t key) { insert(key, stamp(key)); }
+
+    void insert(uint64_t key, uint64_t stamp)
+    {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        if (shard.erasures != stamp || shard.previous.count(key)) return;
+        if (shard.current.size() >= generationCapacity_) {
+            shard.previous.swap(shard.current);
+            shard.current.clear();
+        }
+        shard.current.insert(key);
+    }
+
+    bool contains(uint64_t key)
+    {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        return shard.current.count(key) || shard.previous.count(key);
+    }
+
+    void erase(uint64_t key)
+    {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        shard.erasures++;
+        shard.current.erase(key);
+        shard.previous.erase(key);
+    }
+
+    void clear()
+    {
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            shard.erasures++;
+            shard.current.clear();
+            shard.previous.clear();
+        }
+    }
+
+    size_t size()
+    {
+        size_t n = 0;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            n += shard.current.size() + shard.previous.size();
+        }
+        return n;
+    }
+
+private:
+    static constexpr size_t kShards = 16;
+
+    struct Shard
+    {
+        std::mutex mtx;
+        std::unordered_set<uint64_t> current;
+        std::unordered_set<uint64_t> previous;
+        uint64_t erasures = 0; // erase() and clear() calls, see stamp()
+    };
+
+    // Consecutive keys (log ids, ticks) spread over all shards
+    Shard& shardOf(uint64_t key) { return shards_[(key * 0x9E3779B97F4A7C15ull) >> 60]; }
+
+    const size_t generationCapacity_;
+    Shard shards_[kShards];
+};
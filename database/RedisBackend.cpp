@@ -0,0 +1,270 @@
+#include "RedisBackend.h"
+#include "sw/redis++/redis++.h"
+#include <cmath>
+#include <iterator>
+
+namespace {
+
+// Runs a redis++ call, turning its errors into StorageError.
+template <typename F>
+auto call(F&& f) -> decltype(f())
+{
+    try {
+        return f();
+    } catch (const sw::redis::Error& e) {
+        throw StorageError(e.what());
+    }
+}
+
+// Calls f with the redis++ interval matching a score range.
+template <typename F>
+void withInterval(const StorageBackend::ScoreRange& r, F&& f)
+{
+    using namespace sw::redis;
+    const bool hasMin = std::isfinite(r.min);
+    const bool hasMax = std::isfinite(r.max);
+    if (hasMin && hasMax) {
+        BoundType type = r.minOpen ? (r.maxOpen ? BoundType::OPEN : BoundType::LEFT_OPEN)
+                                   : (r.maxOpen ? BoundType::RIGHT_OPEN : BoundType::CLOSED);
+        f(BoundedInterval<double>(r.min, r.max, type));
+    } else if (hasMin) {
+        f(LeftBoundedInterval<double>(r.min, r.minOpen ? BoundType::OPEN : BoundType::RIGHT_OPEN));
+    } else if (hasMax) {
+        f(RightBoundedInterval<double>(r.max, r.maxOpen ? BoundType::OPEN : BoundType::LEFT_OPEN));
+    } else {
+        f(UnboundedInterval<double>{});
+    }
+}
+
+const char* kHsetIfGreaterScript = R"lua(
+local current = tonumber(redis.call('hget', KEYS[1], ARGV[1])) or tonumber(ARGV[3])
+local new_value = tonumber(ARGV[2])
+if new_value > current then
+    redis.call('hset', KEYS[1], ARGV[1], ARGV[2])
+    for i = 4, #ARGV, 2 do
+        redis.call('hset', KEYS[1], ARGV[i], ARGV[i + 1])
+    end
+    return 1
+end
+return 0
+)lua";
+
+// hsetIfGreater over many hashes. ARGV holds per key: field, value, missingValue, number of extra fields,
+// then the extra field/value pairs.
+const char* kHsetIfGreaterAllScript = R"lua(
+local applied = 0
+local a = 1
+for k = 1, #KEYS do
+    local current = tonumber(redis.call('hget', KEYS[k], ARGV[a])) or tonumber(ARGV[a + 2])
+    local extra = tonumber(ARGV[a + 3])
+    if tonumber(ARGV[a + 1]) > current then
+        redis.call('hset', KEYS[k], ARGV[a], ARGV[a + 1])
+        for i = a + 4, a + 3 + 2 * extra, 2 do
+            redis.call('hset', KEYS[k], ARGV[i], ARGV[i + 1])
+        end
+        applied = applied + 1
+    end
+    a = a + 4 + 2 * extra
+end
+return applied
+)lua";
+
+} // namespace
+
+RedisBackend::RedisBackend(const std::string& uri)
+{
+    call([&] {
+        redis_ = std::make_unique<sw::redis::Redis>(uri);
+        redis_->ping();
+    });
+    hsetIfGreaterScript_ = loadScript(kHsetIfGreaterScript);
+    hsetIfGreaterAllScript_ = loadScript(kHsetIfGreaterAllScript);
+}
+
+RedisBackend::Script RedisBackend::loadScript(const char* source)
+{
+    Script script;
+    script.source = source;
+    try {
+        script.sha = redis_->script_load(source);
+    } catch (const sw::redis::Error&) {
+        // scripting commands may be restricted; every call then sends the source
+    }
+    return script;
+}
+
+long long RedisBackend::runScript(const Script& script, const std::vector<std::string>& keys,
+                                  const std::vector<std::string>& args)
+{
+    return call([&] {
+        if (!script.sha.empty()) {
+            try {
+                return redis_->evalsha<long long>(script.sha, keys.begin(), keys.end(), args.begin(), args.end());
+            } catch (const sw::redis::ReplyError& e) {
+                // the server dropped its script cache (restart, failover, SCRIPT FLUSH); EVAL caches it again
+                if (std::string(e.what()).find("NOSCRIPT") == std::string::npos) throw;
+            }
+        }
+        return redis_->eval<long long>(script.source, keys.begin(), keys.end(), args.begin(), args.end());
+    });
+}
+
+RedisBackend::~RedisBackend() = default;
+
+void RedisBackend::ping()
+{
+    call([&] { redis_->ping(); });
+}
+
+StorageBackend::OptionalString RedisBackend::get(const std::string& key)
+{
+    return call([&] { return redis_->get(key); });
+}
+
+void RedisBackend::mget(const std::vector<std::string>& keys, std::vector<OptionalString>& out)
+{
+    out.clear();
+    if (keys.empty()) return;
+    call([&] { redis_->mget(keys.begin(), keys.end(), std::back_inserter(out)); });
+}
+
+bool RedisBackend::set(const std::string& key, std::string_view value, std::chrono::seconds ttl, bool onlyIfAbsent)
+{
+    return call([&] {
+        sw::redis::StringView val(value.data(), value.size());
+        return redis_->set(key, val, std::chrono::duration_cast<std::chrono::milliseconds>(ttl),
+                           onlyIfAbsent ? sw::redis::UpdateType::NOT_EXIST : sw::redis::UpdateType::ALWAYS);
+    });
+}
+
+void RedisBackend::mset(const Fields& entries, std::chrono::seconds ttl)
+{
+    if (entries.empty()) return;
+    call([&] {
+        if (ttl.count() <= 0) {
+            redis_->mset(entries.begin(), entries.end());
+            return;
+        }
+        // MSET has no expiration: pipeline SET ... EX instead
+        auto pipe = redis_->pipeline(false);
+        for (const auto& [key, value] : entries) pipe.set(key, value, ttl);
+        pipe.exec();
+    });
+}
+
+bool RedisBackend::exists(const std::string& key)
+{
+    return call([&] { return redis_->exists(key) > 0; });
+}
+
+void RedisBackend::exists(const std::vector<std::string>& keys, std::vector<uint8_t>& out)
+{
+    out.assign(keys.size(), 0);
+    if (keys.empty()) return;
+    call([&] {
+        auto pipe = redis_->pipeline(false);
+        for (const auto& key : keys) pipe.exists(key);
+        auto replies = pipe.exec();
+        for (size_t i = 0; i < keys.size(); i++) out[i] = replies.get<long long>(i) ? 1 : 0;
+    });
+}
+
+void RedisBackend::unlink(const std::vector<std::string>& keys)
+{
+    if (keys.empty()) return;
+    call([&] { redis_->unlink(keys.begin(), keys.end()); });
+}
+
+void RedisBackend::rename(const std::string& from, const std::string& to)
+{
+    call([&] { redis_->rename(from, to); });
+}
+
+void RedisBackend::expire(const std::string& key, std::chrono::seconds ttl)
+{
+    call([&] { redis_->expire(key, ttl); });
+}
+
+StorageBackend::OptionalString RedisBackend::hget(const std::string& key, const std::string& field)
+{
+    return call([&] { return redis_->hget(key, field); });
+}
+
+void RedisBackend::hmget(const std::string& key, const std::vector<std::string>& fields, std::vector<OptionalString>& out)
+{
+    out.clear();
+    if (fields.empty()) return;
+    call([&] { redis_->hmget(key, fields.begin(), fields.end(), std::back_inserter(out)); });
+}
+
+void RedisBackend::hset(const std::string& key, const Fields& fields)
+{
+    if (fields.empty()) return;
+    call([&] { redis_->hset(key, fields.begin(), fields.end()); });
+}
+
+bool RedisBackend::hsetIfGreater(const std::string& key, const std::string& field, long long value,
+                                 long long missingValue, const Fields& extraFields)
+{
+    std::vector<std::string> keys = {key};
+    std::vector<std::string> args = {field, std::to_string(value), std::to_string(missingValue)};
+    for (const auto& [f, v] : extraFields) {
+        args.push_back(f);
+        args.push_back(v);
+    }
+    return runScript(hsetIfGreaterScript_, keys, args) == 1;
+}
+
+size_t RedisBackend::hsetIfGreaterAll(const std::vector<GreaterUpdate>& updates)
+{
+    if (updates.empty()) return 0;
+    std::vector<std::string> keys;
+    std::vector<std::string> args;
+    for (const auto& u : updates) {
+        keys.push_back(u.key);
+        args.push_back(u.field);
+        args.push_back(std::to_string(u.value));
+        args.push_back(std::to_string(u.missingValue));
+        args.push_back(std::to_string(u.extraFields.size()));
+        for (const auto& [f, v] : u.extraFields) {
+            args.push_back(f);
+            args.push_back(v);
+        }
+    }
+    return static_cast<size_t>(runScript(hsetIfGreaterAllScript_, keys, args));
+}
+
+void RedisBackend::zadd(const std::vector<ZMember>& members, bool onlyIfAbsent)
+{
+    if (members.empty()) return;
+    const auto type = onlyIfAbsent ? sw::redis::UpdateType::NOT_EXIST : sw::redis::UpdateType::ALWAYS;
+    call([&] {
+        if (members.size() == 1) {
+            redis_->zadd(members[0].key, members[0].member, members[0].score, type);
+            return;
+        }
+        auto pipe = redis_->pipeline(false);
+        for (const auto& m : members) pipe.zadd(m.key, m.member, m.score, type);
+        pipe.exec();
+    });
+}
+
+void RedisBackend::zrangeByScore(const std::string& key, const ScoreRange& range, bool descending, size_t limit,
+                                 std::vector<std::string>& out)
+{
+    out.clear();
+    call([&] {
+        withInterval(range, [&](const auto& interval) {
+            if (limit == 0) {
+                if (descending) redis_->zrevrangebyscore(key, interval, std::back_inserter(out));
+                else redis_->zrangebyscore(key, interval, std::back_inserter(out));
+                return;
+            }
+            sw::redis::LimitOptions opts;
+            opts.offset = 0;
+            opts.count = static_cast<long long>(limit);
+            if (descending) redis_->zrevrangebyscore(key, interval, opts, std::back_inserter(out));
+            else redis_->zrangebyscore(key, interval, opts, std::back_inserter(out));
+        });
+    });
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include "StorageBackend.h"
+
+namespace sw { namespace redis { class Redis; }}
+
+// StorageBackend on a KeyDB, Redis or kvrocks server, through a redis++ connection pool.
+class RedisBackend : public StorageBackend
+{
+public:
+    // Connects and pings the server; throws StorageError if it cannot be reached.
+    explicit RedisBackend(const std::string& uri);
+    ~RedisBackend() override;
+
+    void ping() override;
+
+    OptionalString get(const std::string& key) override;
+    void mget(const std::vector<std::string>& keys, std::vector<OptionalString>& out) override;
+    bool set(const std::string& key, std::string_view value, std::chrono::seconds ttl, bool onlyIfAbsent) override;
+    void mset(const Fields& entries, std::chrono::seconds ttl) override;
+
+    bool exists(const std::string& key) override;
+    void exists(const std::vector<std::string>& keys, std::vector<uint8_t>& out) override;
+    using StorageBackend::unlink;
+    void unlink(const std::vector<std::string>& keys) override;
+    void rename(const std::string& from, const std::string& to) override;
+    void expire(const std::string& key, std::chrono::seconds ttl) override;
+
+    OptionalString hget(const std::string& key, const std::string& field) override;
+    void hmget(const std::string& key, const std::vector<std::string>& fields, std::vector<OptionalString>& out) override;
+    void hset(const std::string& key, const Fields& fields) override;
+    bool hsetIfGreater(const std::string& key, const std::string& field, long long value,
+                       long long missingValue, const Fields& extraFields) override;
+    size_t hsetIfGreaterAll(const std::vector<GreaterUpdate>& updates) override;
+
+    void zadd(const std::vector<ZMember>& members, bool onlyIfAbsent) override;
+    void zrangeByScore(const std::string& key, const ScoreRange& range, bool descending, size_t limit,
+                       std::vector<std::string>& out) override;
+
+private:
+    // A Lua script loaded once at connect time and run with EVALSHA.
+    struct Script
+    {
+        const char* source = nullptr;
+        std::string sha; // empty if the server refused SCRIPT LOAD: EVAL is used
+    };
+
+    Script loadScript(const char* source);
+    long long runScript(const Script& script, const std::vector<std::string>& keys,
+                        const std::vector<std::string>& args);
+
+    std::unique_ptr<sw::redis::Redis> redis_;
+    Script hsetIfGreaterScript_;
+    Script hsetIfGreaterAllScript_;
+};
@@ -0,0 +1,191 @@
+#include "ReplicaRoutingBackend.h"
+#include "Logger.h"
+
+namespace {
+
+constexpr int64_t kFreshnessCheckMs = 1000;
+
+int64_t steadyMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+ReplicaRoutingBackend::ReplicaRoutingBackend(std::unique_ptr<StorageBackend> primary,
+                                             std::unique_ptr<StorageBackend> replica, long long maxLagTicks)
+    : primary_(std::move(primary)), replica_(std::move(replica)), maxLagTicks_(maxLagTicks)
+{
+}
+
+long long ReplicaRoutingBackend::verifiedTick(StorageBackend& db)
+{
+    auto val = db.hget("db_status", "latest_verified_tick");
+    if (!val) return -1;
+    try {
+        return std::stoll(*val);
+    } catch (const std::logic_error&) {
+        return -1;
+    }
+}
+
+bool ReplicaRoutingBackend::replicaFresh()
+{
+    const int64_t now = steadyMs();
+    int64_t next = nextCheckMs_.load(std::memory_order_relaxed);
+    // one caller per period refreshes the state, the others use the last one
+    if (now < next || !nextCheckMs_.compare_exchange_strong(next, now + kFreshnessCheckMs)) {
+        return fresh_.load(std::memory_order_relaxed);
+    }
+    bool fresh = false;
+    long long primaryTick = -1, replicaTick = -1;
+    try {
+        primaryTick = verifiedTick(*primary_);
+        replicaTick = verifiedTick(*replica_);
+        fresh = replicaTick >= 0 && primaryTick - replicaTick <= maxLagTicks_;
+    } catch (const StorageError& e) {
+        Logger::get()->debug("Replica freshness check failed: {}", e.what());
+    }
+    if (fresh_.exchange(fresh) != fresh) {
+        if (fresh) Logger::get()->info("KeyDB replica caught up (verified tick {}), API reads use it", replicaTick);
+        else Logger::get()->info("KeyDB replica is stale (verified tick {} vs {}), API reads use the primary",
+                                 replicaTick, primaryTick);
+    }
+    return fresh;
+}
+
+StorageBackend& ReplicaRoutingBackend::reader()
+{
+    return replicaFresh() ? *replica_ : *primary_;
+}
+
+void ReplicaRoutingBackend::ping()
+{
+    primary_->ping();
+}
+
+StorageBackend::OptionalString ReplicaRoutingBackend::get(const std::string& key)
+{
+    StorageBackend& db = reader();
+    auto val = db.get(key);
+    if (!val && &db != primary_.get()) val = primary_->get(key);
+    return val;
+}
+
+void ReplicaRoutingBackend::mget(const std::vector<std::string>& keys, std::vector<OptionalString>& out)
+{
+    StorageBackend& db = reader();
+    db.mget(keys, out);
+    if (&db == primary_.get()) return;
+    std::vector<std::string> missing;
+    std::vector<size_t> slots;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (out[i]) continue;
+        missing.push_back(keys[i]);
+        slots.push_back(i);
+    }
+    if (missing.empty()) return;
+    std::vector<OptionalString> vals;
+    primary_->mget(missing, vals);
+    for (size_t j = 0; j < slots.size(); j++) out[slots[j]] = std::move(vals[j]);
+}
+
+bool ReplicaRoutingBackend::set(const std::string& key, std::string_view value, std::chrono::seconds ttl,
+                                bool onlyIfAbsent)
+{
+    return primary_->set(key, value, ttl, onlyIfAbsent);
+}
+
+void ReplicaRoutingBackend::mset(const Fields& entries, std::chrono::seconds ttl)
+{
+    primary_->mset(entries, ttl);
+}
+
+bool ReplicaRoutingBackend::exists(const std::string& key)
+{
+    StorageBackend& db = reader();
+    return db.exists(key) || (&db != primary_.get() && primary_->exists(key));
+}
+
+void ReplicaRoutingBackend::exists(const std::vector<std::string>& keys, std::vector<uint8_t>& out)
+{
+    StorageBackend& db = reader();
+    db.exists(keys, out);
+    if (&db == primary_.get()) return;
+    std::vector<std::string> missing;
+    std::vector<size_t> slots;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (out[i]) continue;
+        missing.push_back(keys[i]);
+        slots.push_back(i);
+    }
+    if (missing.empty()) return;
+    std::vector<uint8_t> found;
+    primary_->exists(missing, found);
+    for (size_t j = 0; j < slots.size(); j++) out[slots[j]] = found[j];
+}
+
+void ReplicaRoutingBackend::unlink(const std::vector<std::string>& keys)
+{
+    primary_->unlink(keys);
+}
+
+void ReplicaRoutingBackend::rename(const std::string& from, const std::string& to)
+{
+    primary_->rename(from, to);
+}
+
+void ReplicaRoutingBackend::expire(const std::string& key, std::chrono::seconds ttl)
+{
+    primary_->expire(key, ttl);
+}
+
+StorageBackend::OptionalString ReplicaRoutingBackend::hget(const std::string& key, const std::string& field)
+{
+    StorageBackend& db = reader();
+    auto val = db.hget(key, field);
+    if (!val && &db != primary_.get()) val = primary_->hget(key, field);
+    return val;
+}
+
+void ReplicaRoutingBackend::hmget(const std::string& key, const std::vector<std::string>& fields,
+                                  std::vector<OptionalString>& out)
+{
+    StorageBackend& db = reader();
+    db.hmget(key, fields, out);
+    if (&db == primary_.get()) return;
+    for (const auto& val : out) {
+        if (val) continue;
+        primary_->hmget(key, fields, out);
+        return;
+    }
+}
+
+void ReplicaRoutingBackend::hset(const std::string& key, const Fields& fields)
+{
+    primary_->hset(key, fields);
+}
+
+bool ReplicaRoutingBackend::hsetIfGreater(const std::string& key, const std::string& field, long long value,
+                                          long long missingValue, const Fields& extraFields)
+{
+    return primary_->hsetIfGreater(key, field, value, missingValue, extraFields);
+}
+
+size_t ReplicaRoutingBackend::hsetIfGreaterAll(const std::vector<GreaterUpdate>& updates)
+{
+    return primary_->hsetIfGreaterAll(updates);
+}
+
+void ReplicaRoutingBackend::zadd(const std::vector<ZMember>& members, bool onlyIfAbsent)
+{
+    primary_->zadd(members, onlyIfAbsent);
+}
+
+void ReplicaRoutingBackend::zrangeByScore(const std::string& key, const ScoreRange& range, bool descending,
+                                          size_t limit, std::vector<std::string>& out)
+{
+    // members cannot be told apart from missing ones: within the lag only the newest ticks can be absent
+    reader().zrangeByScore(key, range, descending, limit, out);
+}
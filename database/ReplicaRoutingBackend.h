@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include "StorageBackend.h"
+
+// Sends reads to a KeyDB replica and everything else to the primary.
+// A read goes to the replica only while the replica is fresh: its db_status latest_verified_tick is at most
+// maxLagTicks behind the primary's (checked at most once per second). A key or field the replica does not
+// have yet is read from the primary, so a fresh replica never hides data bob has already written.
+class ReplicaRoutingBackend : public StorageBackend
+{
+public:
+    ReplicaRoutingBackend(std::unique_ptr<StorageBackend> primary, std::unique_ptr<StorageBackend> replica,
+                          long long maxLagTicks);
+
+    void ping() override;
+
+    OptionalString get(const std::string& key) override;
+    void mget(const std::vector<std::string>& keys, std::vector<OptionalString>& out) override;
+    bool set(const std::string& key, std::string_view value, std::chrono::seconds ttl, bool onlyIfAbsent) override;
+    void mset(const Fields& entries, std::chrono::seconds ttl) override;
+
+    bool exists(const std::string& key) override;
+    void exists(const std::vector<std::string>& keys, std::vector<uint8_t>& out) override;
+    using StorageBackend::unlink;
+    void unlink(const std::vector<std::string>& keys) override;
+    void rename(const std::string& from, const std::string& to) override;
+    void expire(const std::string& key, std::chrono::seconds ttl) override;
+
+    OptionalString hget(const std::string& key, const std::string& field) override;
+    void hmget(const std::string& key, const std::vector<std::string>& fields, std::vector<OptionalString>& out) override;
+    void hset(const std::string& key, const Fields& fields) override;
+    bool hsetIfGreater(const std::string& key, const std::string& field, long long value,
+                       long long missingValue, const Fields& extraFields) override;
+    size_t hsetIfGreaterAll(const std::vector<GreaterUpdate>& updates) override;
+
+    void zadd(const std::vector<ZMember>& members, bool onlyIfAbsent) override;
+    void zrangeByScore(const std::string& key, const ScoreRange& range, bool descending, size_t limit,
+                       std::vector<std::string>& out) override;
+
+    // Whether reads currently go to the replica.
+    bool replicaFresh();
+
+private:
+    // The replica if fresh, else the primary.
+    StorageBackend& reader();
+    static long long verifiedTick(StorageBackend& db);
+
+    std::unique_ptr<StorageBackend> primary_;
+    std::unique_ptr<StorageBackend> replica_;
+    const long long maxLagTicks_;
+    std::atomic<bool> fresh_{false};
+    std::atomic<int64_t> nextCheckMs_{0};
+};
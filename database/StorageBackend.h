@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Raised by a backend when the store cannot be reached or a command fails.
+class StorageError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Key-value primitives the db_* functions are written against.
+// Two implementations exist: RedisBackend talks to KeyDB/kvrocks over RESP, EmbeddedBackend keeps the
+// data in-process (see storage-backend in CONFIG_FILE.MD). The command set mirrors the subset of Redis
+// bob uses: strings, hashes and sorted sets, with optional expiration.
+// All methods are thread-safe and throw StorageError on failure.
+class StorageBackend
+{
+public:
+    using OptionalString = std::optional<std::string>;
+    using Fields = std::vector<std::pair<std::string, std::string>>;
+
+    // One update of hsetIfGreaterAll.
+    struct GreaterUpdate
+    {
+        std::string key;
+        std::string field;
+        long long value;
+        long long missingValue;
+        Fields extraFields;
+    };
+
+    struct ZMember
+    {
+        std::string key;
+        std::string member;
+        double score;
+    };
+
+    // Score interval of a sorted set query; an open bound excludes its value.
+    struct ScoreRange
+    {
+        double min = -std::numeric_limits<double>::infinity();
+        double max = std::numeric_limits<double>::infinity();
+        bool minOpen = false;
+        bool maxOpen = false;
+    };
+
+    virtual ~StorageBackend() = default;
+
+    virtual void ping() = 0;
+
+    // Strings. A ttl of 0 means no expiration. set() returns false if onlyIfAbsent is set and the key exists.
+    virtual OptionalString get(const std::string& key) = 0;
+    virtual void mget(const std::vector<std::string>& keys, std::vector<OptionalString>& out) = 0;
+    virtual bool set(const std::string& key, std::string_view value,
+                     std::chrono::seconds ttl = std::chrono::seconds(0), bool onlyIfAbsent = false) = 0;
+    // Sets many keys in one round trip, all with the same ttl.
+    virtual void mset(const Fields& entries, std::chrono::seconds ttl = std::chrono::seconds(0)) = 0;
+
+    // Keys of any type.
+    virtual bool exists(const std::string& key) = 0;
+    virtual void exists(const std::vector<std::string>& keys, std::vector<uint8_t>& out) = 0;
+    virtual void unlink(const std::vector<std::string>& keys) = 0;
+    void unlink(const std::string& key) { unlink(std::vector<std::string>{key}); }
+    virtual void rename(const std::string& from, const std::string& to) = 0; // throws if from is missing
+    virtual void expire(const std::string& key, std::chrono::seconds ttl) = 0;
+
+    // Hashes.
+    virtual OptionalString hget(const std::string& key, const std::string& field) = 0;
+    virtual void hmget(const std::string& key, const std::vector<std::string>& fields, std::vector<OptionalString>& out) = 0;
+    virtual void hset(const std::string& key, const Fields& fields) = 0;
+    /**
+     * @brief Atomically sets a numeric hash field if the new value is greater than the current one
+     *        (a missing or unparsable field counts as missingValue), together with extraFields.
+     * @return True if the hash was updated.
+     */
+    virtual bool hsetIfGreater(const std::string& key, const std::string& field, long long value,
+                               long long missingValue, const Fields& extraFields = {}) = 0;
+    /**
+     * @brief Applies hsetIfGreater for every update in one atomic step (one round trip on a server).
+     * @return The number of updates that changed their hash.
+     */
+    virtual size_t hsetIfGreaterAll(const std::vector<GreaterUpdate>& updates) = 0;
+
+    // Sorted sets. limit 0 returns every member in the range.
+    virtual void zadd(const std::vector<ZMember>& members, bool onlyIfAbsent = false) = 0;
+    virtual void zrangeByScore(const std::string& key, const ScoreRange& range, bool descending, size_t limit,
+                               std::vector<std::string>& out) = 0;
+};
@@ -0,0 +1,437 @@
+#include "VtickCodec.h"
+#include "zstd.h"
+#include "zdict.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+constexpr char kColumnarTag[4] = {'V', 'T', 'K', 1};
+constexpr char kFramedTag[4] = {'V', 'T', 'K', 2};
+constexpr size_t kTagSize = sizeof(kColumnarTag);
+constexpr uint32_t kZstdMagic = 0xFD2FB528;
+constexpr size_t kVotes = sizeof(FullTickStruct::tv) / sizeof(TickVote);
+constexpr size_t kBlocks = (kVotes + VtickCodec::kVotesPerBlock - 1) / VtickCodec::kVotesPerBlock;
+// tag, votes per block, section count
+constexpr size_t kFramedFixedSize = kTagSize + 2 * sizeof(uint16_t);
+
+struct Column
+{
+    size_t offset;
+    size_t size;
+};
+
+#define VOTE_COLUMN(field) Column{offsetof(TickVote, field), sizeof(TickVote::field)}
+constexpr Column kVoteColumns[] = {
+        VOTE_COLUMN(computorIndex), VOTE_COLUMN(epoch), VOTE_COLUMN(tick),
+        VOTE_COLUMN(millisecond), VOTE_COLUMN(second), VOTE_COLUMN(minute), VOTE_COLUMN(hour),
+        VOTE_COLUMN(day), VOTE_COLUMN(month), VOTE_COLUMN(year),
+        VOTE_COLUMN(prevResourceTestingDigest), VOTE_COLUMN(saltedResourceTestingDigest),
+        VOTE_COLUMN(prevTransactionBodyDigest), VOTE_COLUMN(saltedTransactionBodyDigest),
+        VOTE_COLUMN(prevSpectrumDigest), VOTE_COLUMN(prevUniverseDigest), VOTE_COLUMN(prevComputerDigest),
+        VOTE_COLUMN(saltedSpectrumDigest), VOTE_COLUMN(saltedUniverseDigest), VOTE_COLUMN(saltedComputerDigest),
+        VOTE_COLUMN(transactionDigest), VOTE_COLUMN(expectedNextTickTransactionDigest),
+        VOTE_COLUMN(signature),
+};
+#undef VOTE_COLUMN
+
+constexpr size_t columnBytes()
+{
+    size_t total = 0;
+    for (const auto& c : kVoteColumns) total += c.size;
+    return total;
+}
+// every byte of a vote belongs to exactly one column (no padding)
+static_assert(columnBytes() == sizeof(TickVote), "TickVote columns out of date");
+
+void votesToColumns(const TickVote* votes, size_t count, char* out)
+{
+    for (const auto& c : kVoteColumns) {
+        for (size_t v = 0; v < count; v++, out += c.size) {
+            memcpy(out, reinterpret_cast<const char*>(&votes[v]) + c.offset, c.size);
+        }
+    }
+}
+
+void votesFromColumns(const char* data, size_t count, TickVote* out)
+{
+    for (const auto& c : kVoteColumns) {
+        for (size_t v = 0; v < count; v++, data += c.size) {
+            memcpy(reinterpret_cast<char*>(&out[v]) + c.offset, data, c.size);
+        }
+    }
+}
+
+bool isZero(const char* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (data[i]) return false;
+    }
+    return true;
+}
+
+size_t blockVotes(size_t block, size_t votesPerBlock)
+{
+    return std::min(votesPerBlock, kVotes - block * votesPerBlock);
+}
+
+// Section table of a framed blob (see VtickCodec.h).
+struct FramedView
+{
+    size_t votesPerBlock = 0;
+    size_t sections = 0;
+    const char* table = nullptr;
+    const char* data = nullptr;
+    size_t dataSize = 0;
+
+    bool parse(std::string_view blob)
+    {
+        if (blob.size() < kFramedFixedSize || memcmp(blob.data(), kFramedTag, kTagSize) != 0) return false;
+        uint16_t perBlock, count;
+        memcpy(&perBlock, blob.data() + kTagSize, sizeof(perBlock));
+        memcpy(&count, blob.data() + kTagSize + sizeof(perBlock), sizeof(count));
+        if (perBlock == 0 || count != 1 + (kVotes + perBlock - 1) / perBlock) return false;
+        const size_t header = kFramedFixedSize + count * sizeof(uint32_t);
+        if (blob.size() < header) return false;
+        votesPerBlock = perBlock;
+        sections = count;
+        table = blob.data() + kFramedFixedSize;
+        data = blob.data() + header;
+        dataSize = blob.size() - header;
+        return true;
+    }
+
+    // An empty section stands for zero bytes.
+    bool section(size_t i, std::string_view& out) const
+    {
+        uint32_t begin = 0, end;
+        if (i > 0) memcpy(&begin, table + (i - 1) * sizeof(uint32_t), sizeof(begin));
+        memcpy(&end, table + i * sizeof(uint32_t), sizeof(end));
+        if (begin > end || end > dataSize) return false;
+        out = std::string_view(data + begin, end - begin);
+        return true;
+    }
+};
+
+struct CCtxDeleter { void operator()(ZSTD_CCtx* c) const { ZSTD_freeCCtx(c); } };
+struct DCtxDeleter { void operator()(ZSTD_DCtx* d) const { ZSTD_freeDCtx(d); } };
+
+// One context of each kind per thread: creating them costs more than compressing a tick.
+ZSTD_CCtx* threadCCtx()
+{
+    thread_local std::unique_ptr<ZSTD_CCtx, CCtxDeleter> ctx(ZSTD_createCCtx());
+    return ctx.get();
+}
+
+ZSTD_DCtx* threadDCtx()
+{
+    thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> ctx(ZSTD_createDCtx());
+    return ctx.get();
+}
+
+} // namespace
+
+struct VtickCodec::Dictionary
+{
+    uint32_t id = 0;
+    std::string bytes;
+    ZSTD_DDict* ddict = nullptr;
+    // CDicts are bound to a level; the level rarely changes, so one is enough
+    mutable std::mutex cdictMtx;
+    mutable ZSTD_CDict* cdict = nullptr;
+    mutable int cdictLevel = 0;
+
+    ~Dictionary()
+    {
+        if (cdict) ZSTD_freeCDict(cdict);
+        if (ddict) ZSTD_freeDDict(ddict);
+    }
+
+    const ZSTD_CDict* forLevel(int level) const
+    {
+        std::lock_guard<std::mutex> lock(cdictMtx);
+        if (!cdict || cdictLevel != level) {
+            if (cdict) ZSTD_freeCDict(cdict);
+            cdict = ZSTD_createCDict(bytes.data(), bytes.size(), level);
+            cdictLevel = level;
+        }
+        return cdict;
+    }
+};
+
+VtickCodec::VtickCodec() = default;
+VtickCodec::~VtickCodec() = default;
+
+void VtickCodec::setDictionaryLoader(DictionaryLoader loader)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    loader_ = std::move(loader);
+}
+
+void VtickCodec::toColumns(const FullTickStruct& tick, std::string& out)
+{
+    out.resize(sizeof(FullTickStruct));
+    memcpy(&out[0], &tick.td, sizeof(TickData));
+    votesToColumns(tick.tv, kVotes, &out[sizeof(TickData)]);
+}
+
+void VtickCodec::fromColumns(const char* data, FullTickStruct& out)
+{
+    memcpy((void*)&out.td, data, sizeof(TickData));
+    votesFromColumns(data + sizeof(TickData), kVotes, out.tv);
+}
+
+bool VtickCodec::encode(const FullTickStruct& tick, int level, std::string& out)
+{
+    ZSTD_CCtx* cctx = threadCCtx();
+    if (!cctx) return false;
+    std::shared_ptr<const Dictionary> dict;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        dict = current_;
+    }
+    const ZSTD_CDict* cdict = dict ? dict->forLevel(level) : nullptr;
+
+    // raw sections: the TickData, then every block of votes in columnar layout
+    std::string raw(sizeof(FullTickStruct), '\0');
+    memcpy(&raw[0], &tick.td, sizeof(TickData));
+    std::vector<size_t> rawSizes{sizeof(TickData)};
+    size_t pos = sizeof(TickData);
+    for (size_t b = 0; b < kBlocks; b++) {
+        const size_t count = blockVotes(b, kVotesPerBlock);
+        votesToColumns(&tick.tv[b * kVotesPerBlock], count, &raw[pos]);
+        rawSizes.push_back(count * sizeof(TickVote));
+        pos += rawSizes.back();
+    }
+
+    const size_t header = kFramedFixedSize + rawSizes.size() * sizeof(uint32_t);
+    out.assign(header, '\0');
+    memcpy(&out[0], kFramedTag, kTagSize);
+    const uint16_t perBlock = kVotesPerBlock, count = static_cast<uint16_t>(rawSizes.size());
+    memcpy(&out[kTagSize], &perBlock, sizeof(perBlock));
+    memcpy(&out[kTagSize + sizeof(perBlock)], &count, sizeof(count));
+
+    Sample sample;
+    pos = 0;
+    for (size_t i = 0; i < rawSizes.size(); pos += rawSizes[i], i++) {
+        const char* src = raw.data() + pos;
+        // votes that never arrived are zero: store nothing for a block without any
+        if (!isZero(src, rawSizes[i])) {
+            const size_t offset = out.size();
+            out.resize(offset + ZSTD_compressBound(rawSizes[i]));
+            const size_t size = cdict
+                    ? ZSTD_compress_usingCDict(cctx, &out[offset], out.size() - offset, src, rawSizes[i], cdict)
+                    : ZSTD_compressCCtx(cctx, &out[offset], out.size() - offset, src, rawSizes[i], level);
+            if (ZSTD_isError(size)) return false;
+            out.resize(offset + size);
+            if (sampling_) {
+                sample.bytes.append(src, rawSizes[i]);
+                sample.sizes.push_back(rawSizes[i]);
+            }
+        }
+        const uint32_t end = static_cast<uint32_t>(out.size() - header);
+        memcpy(&out[kFramedFixedSize + i * sizeof(uint32_t)], &end, sizeof(end));
+    }
+
+    encodedSinceDictionary_++;
+    if (sampling_) addSample(std::move(sample));
+    return true;
+}
+
+bool VtickCodec::decompress(std::string_view frame, char* dst, size_t size)
+{
+    if (frame.empty()) {
+        memset(dst, 0, size);
+        return true;
+    }
+    ZSTD_DCtx* dctx = threadDCtx();
+    if (!dctx) return false;
+    size_t n;
+    if (const uint32_t dictId = ZSTD_getDictID_fromFrame(frame.data(), frame.size())) {
+        auto dict = dictionaryFor(dictId);
+        if (!dict) return false;
+        n = ZSTD_decompress_usingDDict(dctx, dst, size, frame.data(), frame.size(), dict->ddict);
+    } else {
+        n = ZSTD_decompressDCtx(dctx, dst, size, frame.data(), frame.size());
+    }
+    return !ZSTD_isError(n) && n == size;
+}
+
+bool VtickCodec::decode(std::string_view blob, FullTickStruct& out)
+{
+    if (blob.size() < kTagSize) return false;
+    uint32_t magic;
+    memcpy(&magic, blob.data(), sizeof(magic));
+    if (magic == kZstdMagic) {
+        // legacy blob: the raw struct
+        return decompress(blob, reinterpret_cast<char*>(&out), sizeof(FullTickStruct));
+    }
+    if (memcmp(blob.data(), kColumnarTag, kTagSize) == 0) {
+        std::string columns(sizeof(FullTickStruct), '\0');
+        if (!decompress(blob.substr(kTagSize), &columns[0], columns.size())) return false;
+        fromColumns(columns.data(), out);
+        return true;
+    }
+    FramedView view;
+    std::string_view frame;
+    if (!view.parse(blob) || !view.section(0, frame) ||
+        !decompress(frame, reinterpret_cast<char*>(&out.td), sizeof(TickData))) {
+        return false;
+    }
+    for (size_t b = 0; b + 1 < view.sections; b++) {
+        const size_t count = blockVotes(b, view.votesPerBlock);
+        if (!view.section(b + 1, frame) || !decodeBlock(frame, count, &out.tv[b * view.votesPerBlock])) return false;
+    }
+    return true;
+}
+
+bool VtickCodec::decodeBlock(std::string_view frame, size_t count, TickVote* out)
+{
+    std::string columns(count * sizeof(TickVote), '\0');
+    if (!decompress(frame, &columns[0], columns.size())) return false;
+    votesFromColumns(columns.data(), count, out);
+    return true;
+}
+
+bool VtickCodec::decodeTickData(std::string_view blob, TickData& out)
+{
+    FramedView view;
+    if (!view.parse(blob)) {
+        auto full = std::make_unique<FullTickStruct>();
+        if (!decode(blob, *full)) return false;
+        out = full->td;
+        return true;
+    }
+    std::string_view frame;
+    return view.section(0, frame) && decompress(frame, reinterpret_cast<char*>(&out), sizeof(TickData));
+}
+
+bool VtickCodec::decodeVote(std::string_view blob, uint16_t computorIndex, TickVote& out)
+{
+    if (computorIndex >= kVotes) return false;
+    FramedView view;
+    if (!view.parse(blob)) {
+        auto full = std::make_unique<FullTickStruct>();
+        if (!decode(blob, *full)) return false;
+        out = full->tv[computorIndex];
+        return true;
+    }
+    const size_t block = computorIndex / view.votesPerBlock;
+    const size_t count = blockVotes(block, view.votesPerBlock);
+    std::string_view frame;
+    std::vector<TickVote> votes(count);
+    if (!view.section(block + 1, frame) || !decodeBlock(frame, count, votes.data())) return false;
+    out = votes[computorIndex % view.votesPerBlock];
+    return true;
+}
+
+bool VtickCodec::decodeVotes(std::string_view blob, std::vector<TickVote>& out)
+{
+    FramedView view;
+    if (!view.parse(blob)) {
+        auto full = std::make_unique<FullTickStruct>();
+        if (!decode(blob, *full)) return false;
+        out.assign(std::begin(full->tv), std::end(full->tv));
+        return true;
+    }
+    out.resize(kVotes);
+    for (size_t b = 0; b + 1 < view.sections; b++) {
+        const size_t count = blockVotes(b, view.votesPerBlock);
+        std::string_view frame;
+        if (!view.section(b + 1, frame) || !decodeBlock(frame, count, &out[b * view.votesPerBlock])) return false;
+    }
+    return true;
+}
+
+uint32_t VtickCodec::useDictionary(const std::string& bytes)
+{
+    const uint32_t id = ZDICT_getDictID(bytes.data(), bytes.size());
+    if (id == 0) return 0;
+    auto dict = std::make_shared<Dictionary>();
+    dict->id = id;
+    dict->bytes = bytes;
+    dict->ddict = ZSTD_createDDict(bytes.data(), bytes.size());
+    if (!dict->ddict) return 0;
+    std::lock_guard<std::mutex> lock(mtx_);
+    current_ = dict;
+    known_[id] = dict;
+    encodedSinceDictionary_ = 0;
+    return id;
+}
+
+uint32_t VtickCodec::currentDictionaryId() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return current_ ? current_->id : 0;
+}
+
+std::shared_ptr<const VtickCodec::Dictionary> VtickCodec::dictionaryFor(uint32_t dictId)
+{
+    DictionaryLoader loader;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = known_.find(dictId);
+        if (it != known_.end()) return it->second;
+        loader = loader_;
+    }
+    if (!loader) return nullptr;
+    auto bytes = loader(dictId);
+    if (!bytes || ZDICT_getDictID(bytes->data(), bytes->size()) != dictId) return nullptr;
+    auto dict = std::make_shared<Dictionary>();
+    dict->id = dictId;
+    dict->bytes = std::move(*bytes);
+    dict->ddict = ZSTD_createDDict(dict->bytes.data(), dict->bytes.size());
+    if (!dict->ddict) return nullptr;
+    std::lock_guard<std::mutex> lock(mtx_);
+    return known_.emplace(dictId, std::move(dict)).first->second;
+}
+
+void VtickCodec::addSample(Sample sample)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (samples_.size() < kSampleTicks) {
+        samples_.push_back(std::move(sample));
+    } else {
+        samples_[nextSample_] = std::move(sample);
+        nextSample_ = (nextSample_ + 1) % kSampleTicks;
+    }
+}
+
+bool VtickCodec::shouldTrain()
+{
+    if (!sampling_ || training_) return false;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (samples_.size() < kSampleTicks || encodedSinceDictionary_ < trainAfter_) return false;
+    }
+    bool expected = false;
+    return training_.compare_exchange_strong(expected, true);
+}
+
+std::string VtickCodec::trainDictionary()
+{
+    std::string samples;
+    std::vector<size_t> sizes;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        // one sample per section, as sections are compressed one by one
+        for (const auto& sample : samples_) {
+            samples += sample.bytes;
+            sizes.insert(sizes.end(), sample.sizes.begin(), sample.sizes.end());
+        }
+    }
+    std::string dict(kDictionarySize, '\0');
+    const size_t size = ZDICT_trainFromBuffer(&dict[0], dict.size(), samples.data(), sizes.data(),
+                                              static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(size)) {
+        dict.clear();
+        encodedSinceDictionary_ = 0;
+    } else {
+        dict.resize(size);
+    }
+    // after a failure too: training is expensive, do not retry on every tick
+    trainAfter_ = kRetrainInterval;
+    training_ = false;
+    return dict;
+}
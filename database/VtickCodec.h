@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "structs.h"
+
+// Compression of the FullTickStruct stored under vtick:<tick> in the cold tier.
+//
+// Blob formats (told apart by their first four bytes):
+//  - legacy: a plain zstd frame of the FullTickStruct bytes
+//  - columnar: "VTK" + 0x01, then a zstd frame of the columnar layout. The TickData comes first, then every
+//    TickVote field for all 676 votes in a row. Votes of one tick agree on most digests, so identical values
+//    end up next to each other.
+//  - framed (written by encode()): "VTK" + 0x02, u16 votes per block, u16 section count, then one u32 end
+//    offset per section (relative to the end of this header), then the sections. Section 0 is the TickData,
+//    section 1 + b holds the votes of block b in columnar layout. Each section is its own zstd frame, so a
+//    reader of the TickData or of one vote decompresses only that section. An empty section is all zeros
+//    (a block whose votes never arrived).
+// A frame compressed with a dictionary carries the dictionary id in its header; decoding asks the
+// DictionaryLoader for unknown ids, so older dictionaries stay usable after a new one is trained.
+// Compression and decompression contexts are reused per thread. All methods are thread-safe.
+class VtickCodec
+{
+public:
+    // Returns the dictionary with the given id from storage.
+    using DictionaryLoader = std::function<std::optional<std::string>(uint32_t dictId)>;
+
+    // Ticks kept as training samples, and dictionary size.
+    static constexpr size_t kSampleTicks = 32;
+    static constexpr size_t kDictionarySize = 64 * 1024;
+    // Ticks compressed with a dictionary before a new one is trained from recent ticks.
+    static constexpr uint64_t kRetrainInterval = 100000;
+    // Votes per section of the framed format.
+    static constexpr size_t kVotesPerBlock = 32;
+
+    VtickCodec();
+    ~VtickCodec();
+
+    void setDictionaryLoader(DictionaryLoader loader);
+
+    // Compresses with the current dictionary, if any, at the given zstd level.
+    bool encode(const FullTickStruct& tick, int level, std::string& out);
+    // Read all formats; only the framed one avoids decompressing the whole tick.
+    bool decode(std::string_view blob, FullTickStruct& out);
+    bool decodeTickData(std::string_view blob, TickData& out);
+    bool decodeVote(std::string_view blob, uint16_t computorIndex, TickVote& out);
+    // All votes in computor order, including the empty ones.
+    bool decodeVotes(std::string_view blob, std::vector<TickVote>& out);
+
+    /**
+     * @brief Makes dict the dictionary new blobs are compressed with.
+     * @return Its id, or 0 if dict is not a zstd dictionary.
+     */
+    uint32_t useDictionary(const std::string& dict);
+    uint32_t currentDictionaryId() const;
+
+    /**
+     * @brief Keeps samples of the encoded ticks while enabled. Returns true once, to a single caller, when
+     *        enough samples are collected and there is no dictionary yet or the current one is kRetrainInterval
+     *        ticks old; that caller should then call trainDictionary().
+     */
+    bool shouldTrain();
+    // Trains a dictionary from the samples; empty on failure. Ends the training claimed by shouldTrain().
+    std::string trainDictionary();
+    void setSampling(bool enabled) { sampling_ = enabled; }
+
+    // Columnar layout of a tick, exposed for tests.
+    static void toColumns(const FullTickStruct& tick, std::string& out);
+    static void fromColumns(const char* data, FullTickStruct& out);
+
+private:
+    struct Dictionary;
+    // Sections of an encoded tick, for training.
+    struct Sample
+    {
+        std::string bytes;
+        std::vector<size_t> sizes;
+    };
+
+    // Decompresses a frame of exactly size bytes; an empty frame gives zeros.
+    bool decompress(std::string_view frame, char* dst, size_t size);
+    bool decodeBlock(std::string_view frame, size_t count, TickVote* out);
+    std::shared_ptr<const Dictionary> dictionaryFor(uint32_t dictId);
+    void addSample(Sample sample);
+
+    DictionaryLoader loader_;
+    mutable std::mutex mtx_;
+    std::shared_ptr<const Dictionary> current_;
+    std::map<uint32_t, std::shared_ptr<const Dictionary>> known_;
+    std::vector<Sample> samples_; // ring of kSampleTicks ticks
+    size_t nextSample_ = 0;
+    std::atomic<uint64_t> encodedSinceDictionary_{0};
+    std::atomic<uint64_t> trainAfter_{kSampleTicks}; // encodes before the next training
+    std::atomic<bool> training_{false};
+    std::atomic<bool> sampling_{true};
+};
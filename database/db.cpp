@@ -1,56 +1,296 @@
 #include "db.h"
-#include "sw/redis++/redis++.h"
+#include "StorageBackend.h"
+#include "RedisBackend.h"
+#include "ReplicaRoutingBackend.h"
+#include "EmbeddedBackend.h"
+#include "LogSegmentStore.h"
+#include "VtickCodec.h"
+#include "PackedTickVotes.h"
+#include "Keyspace.h"
+#include "RecentKeySet.h"
+#include <filesystem>
 #include <stdexcept>
 #include <vector>
+#include <unordered_set>
 #include <sstream>
 #include <iomanip>
 #include <future>
 #include "zstd.h" // zstd compression/decompression
+#include "zdict.h"
 #include "Logger.h"
 #include "K12AndKeyUtil.h"
 #include <cstdlib> // std::exit
 #include "shim.h"
-// Global Redis client handle
-static std::unique_ptr<sw::redis::Redis> g_redis = nullptr;
-static std::unique_ptr<sw::redis::Redis> g_kvrocks = nullptr;
+static thread_local DbWorkload t_workload = DbWorkload::Ingest;
 
-void db_connect(const std::string& connectionString) {
-    if (g_redis) {
+void db_set_thread_workload(DbWorkload workload)
+{
+    t_workload = workload;
+}
+
+// The hot tier as seen by the calling thread. Against KeyDB each workload class has its own client pool,
+// so a burst of API reads cannot take the connections ingestion needs; the embedded engine serves them all.
+class HotTier
+{
+public:
+    StorageBackend* get() const { return pools_[static_cast<size_t>(t_workload)].get(); }
+    StorageBackend* operator->() const { return get(); }
+    StorageBackend& operator*() const { return *get(); }
+    explicit operator bool() const { return pools_[0] != nullptr; }
+
+    // One backend for every workload
+    HotTier& operator=(std::unique_ptr<StorageBackend> backend)
+    {
+        std::shared_ptr<StorageBackend> shared = std::move(backend);
+        for (auto& pool : pools_) pool = shared;
+        return *this;
+    }
+    void set(DbWorkload workload, std::unique_ptr<StorageBackend> backend)
+    {
+        pools_[static_cast<size_t>(workload)] = std::move(backend);
+    }
+    void reset()
+    {
+        for (auto& pool : pools_) pool.reset();
+    }
+
+private:
+    std::shared_ptr<StorageBackend> pools_[3];
+};
+
+// Hot tier (KeyDB or the embedded engine) and cold tier (kvrocks or the embedded engine's on-disk store)
+static HotTier g_hot;
+static std::unique_ptr<StorageBackend> g_cold = nullptr;
+// Cold tier of log events when log-segment-path is set (replaces log:<epoch>:<id> keys in kvrocks)
+static std::unique_ptr<LogSegmentStore> g_logSegments = nullptr;
+// Compression of vtick:<tick>; its dictionaries live in the cold tier
+static VtickCodec g_vtickCodec;
+// Transactions, logs and log ranges known to be in the hot tier, so the existence checks of the
+// verifier and the request threads skip KeyDB for them. Filled on insert and on a positive EXISTS,
+// erased once a delete or rename has unlinked them. A fill carries the stamp() taken before its storage
+// call, so one that saw the key before the unlink but lands after the erase is dropped.
+static RecentKeySet g_recentTransactions(1 << 20);
+static RecentKeySet g_recentLogs(1 << 21);
+static RecentKeySet g_recentLogRanges(1 << 16);
+
+static uint64_t transactionFingerprint(const std::string& hash)
+{
+    uint64_t fingerprint;
+    KangarooTwelve(reinterpret_cast<const uint8_t*>(hash.data()), static_cast<unsigned>(hash.size()),
+                   reinterpret_cast<uint8_t*>(&fingerprint), sizeof(fingerprint));
+    return fingerprint;
+}
+
+static uint64_t logFingerprint(uint16_t epoch, uint64_t logId)
+{
+    return (static_cast<uint64_t>(epoch) << 48) | (logId & 0xFFFFFFFFFFFFull);
+}
+
+using Keyspace::Version;
+
+// Reads the keyspace version (see Keyspace.h) from db_status and acknowledges it with keyspace_ack, which
+// the migrator waits for. A database without a tick yet starts at v2; one written by an older bob stays at
+// v1 until migrator/migrator.cpp moves it.
+static void loadKeyspaceState()
+{
+    std::vector<StorageBackend::OptionalString> vals;
+    g_hot->hmget("db_status", {"keyspace_version", "keyspace_migrating", "latest_tick"}, vals);
+    if (!vals[0] && !vals[2]) {
+        g_hot->hset("db_status", {{"keyspace_version", "2"}});
+        vals[0] = "2";
+    }
+    const Version version = vals[0] && *vals[0] == "2" ? Version::V2 : Version::V1;
+    const bool migrating = vals[1] && *vals[1] == "1";
+    if (version != Keyspace::active() || migrating != Keyspace::migrating()) {
+        Logger::get()->info("Keyspace v{}{}", static_cast<int>(version), migrating ? " (migrating from v1)" : "");
+    }
+    Keyspace::setState(version, migrating);
+    g_hot->hset("db_status", {{"keyspace_ack", std::to_string(static_cast<int>(version))}});
+}
+
+bool db_refresh_keyspace()
+{
+    if (!g_hot) return false;
+    try {
+        loadKeyspaceState();
+    } catch (const StorageError& e) {
+        Logger::get()->error("Redis error in db_refresh_keyspace: {}\n", e.what());
+        return false;
+    }
+    return true;
+}
+
+// While the migrator runs, keys it has not reached yet still have their v1 names: these fall back to the
+// v1 name (legacy()) of a key that is missing under its active name.
+template <typename Legacy>
+static StorageBackend::OptionalString getKey(StorageBackend& db, const std::string& key, Legacy&& legacy)
+{
+    auto val = db.get(key);
+    if (!val && Keyspace::migrating()) val = db.get(legacy());
+    return val;
+}
+
+template <typename Legacy>
+static bool keyExists(StorageBackend& db, const std::string& key, Legacy&& legacy)
+{
+    return db.exists(key) || (Keyspace::migrating() && db.exists(legacy()));
+}
+
+// legacy(i) is the v1 name of keys[i].
+template <typename Legacy>
+static void mgetKeys(StorageBackend& db, const std::vector<std::string>& keys,
+                     std::vector<StorageBackend::OptionalString>& out, Legacy&& legacy)
+{
+    db.mget(keys, out);
+    if (!Keyspace::migrating()) return;
+    std::vector<std::string> missing;
+    std::vector<size_t> slots;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (out[i]) continue;
+        missing.push_back(legacy(i));
+        slots.push_back(i);
+    }
+    if (missing.empty()) return;
+    std::vector<StorageBackend::OptionalString> vals;
+    db.mget(missing, vals);
+    for (size_t j = 0; j < slots.size(); j++) out[slots[j]] = std::move(vals[j]);
+}
+
+template <typename Legacy>
+static void existKeys(StorageBackend& db, const std::vector<std::string>& keys, std::vector<uint8_t>& out,
+                      Legacy&& legacy)
+{
+    db.exists(keys, out);
+    if (!Keyspace::migrating()) return;
+    std::vector<std::string> missing;
+    std::vector<size_t> slots;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (out[i]) continue;
+        missing.push_back(legacy(i));
+        slots.push_back(i);
+    }
+    if (missing.empty()) return;
+    std::vector<uint8_t> found;
+    db.exists(missing, found);
+    for (size_t j = 0; j < slots.size(); j++) out[slots[j]] = found[j];
+}
+
+// Adds the v1 names of keys about to be deleted, so a key the migrator has not reached yet goes too.
+template <typename Legacy>
+static void addLegacyKeys(std::vector<std::string>& keys, size_t count, Legacy&& legacy)
+{
+    if (!Keyspace::migrating()) return;
+    for (size_t i = 0; i < count; i++) keys.push_back(legacy(i));
+}
+
+// tick_log_range:<tick> holds (fromLogId, length): a hash under v1, Keyspace::encodeLogRange under v2.
+static void setLogRange(StorageBackend& db, const std::string& key, long long fromLogId, long long length,
+                        std::chrono::seconds ttl)
+{
+    if (Keyspace::active() == Version::V1) {
+        db.hset(key, {{"fromLogId", std::to_string(fromLogId)}, {"length", std::to_string(length)}});
+        if (ttl.count() > 0) db.expire(key, ttl);
+        return;
+    }
+    db.set(key, Keyspace::encodeLogRange(fromLogId, length), ttl);
+}
+
+// Reads a range written by setLogRange; throws std::logic_error on an unparsable v1 hash.
+template <typename Legacy>
+static bool getLogRange(StorageBackend& db, const std::string& key, Legacy&& legacy, long long& fromLogId,
+                        long long& length)
+{
+    auto readHash = [&](const std::string& hashKey) {
+        std::vector<StorageBackend::OptionalString> vals;
+        db.hmget(hashKey, {"fromLogId", "length"}, vals);
+        if (vals.size() != 2 || !vals[0] || !vals[1]) return false;
+        fromLogId = std::stoll(*vals[0]);
+        length = std::stoll(*vals[1]);
+        return true;
+    };
+    if (Keyspace::active() == Version::V1) return readHash(key);
+    if (auto val = db.get(key)) return Keyspace::decodeLogRange(*val, fromLogId, length);
+    return Keyspace::migrating() && readHash(legacy());
+}
+
+// redis++ sizes its connection pool from the `pool_size` URI parameter.
+static std::string withPoolSize(const std::string& connectionString, unsigned poolSize)
+{
+    const char sep = connectionString.find('?') == std::string::npos ? '?' : '&';
+    return connectionString + sep + "pool_size=" + std::to_string(poolSize);
+}
+
+void db_connect(const std::string& connectionString, const DbPoolOptions& pools) {
+    if (g_hot) {
         Logger::get()->info("Database connection already open.\n");
         return;
     }
     try {
-        // Ensure a Redis connection pool with 16 connections is used.
-        // redis++ supports configuring pool size via URI query parameter `pool_size`.
-        std::string uri_with_pool = connectionString;
-        if (uri_with_pool.find('?') == std::string::npos) {
-            uri_with_pool += "?pool_size=32";
+        g_hot.set(DbWorkload::Ingest, std::make_unique<RedisBackend>(withPoolSize(connectionString, pools.ingestPoolSize)));
+        g_hot.set(DbWorkload::Background,
+                  std::make_unique<RedisBackend>(withPoolSize(connectionString, pools.backgroundPoolSize)));
+        auto api = std::make_unique<RedisBackend>(withPoolSize(connectionString, pools.apiPoolSize));
+        if (pools.replicaUrl.empty()) {
+            g_hot.set(DbWorkload::Api, std::move(api));
         } else {
-            uri_with_pool += "&pool_size=32";
+            auto replica = std::make_unique<RedisBackend>(withPoolSize(pools.replicaUrl, pools.apiPoolSize));
+            g_hot.set(DbWorkload::Api, std::make_unique<ReplicaRoutingBackend>(std::move(api), std::move(replica),
+                                                                               pools.replicaMaxLagTicks));
+            Logger::get()->info("API reads use the KeyDB replica {} while it is at most {} verified ticks behind",
+                                pools.replicaUrl, pools.replicaMaxLagTicks);
         }
-
-        g_redis = std::make_unique<sw::redis::Redis>(uri_with_pool);
-        g_redis->ping();
-    } catch (const sw::redis::Error& e) {
-        g_redis.reset();
+    } catch (const StorageError& e) {
+        g_hot.reset();
         throw std::runtime_error("Cannot connect to KeyDB: " + std::string(e.what()));
-        exit(1);
+    }
+    try {
+        loadKeyspaceState();
+    } catch (const StorageError& e) {
+        g_hot.reset();
+        throw std::runtime_error("Cannot read the keyspace version: " + std::string(e.what()));
     }
     Logger::get()->trace("Connected to DB!");
 }
 
 void db_close() {
-    g_redis.reset();
+    g_hot.reset();
+    g_recentTransactions.clear();
+    g_recentLogs.clear();
+    g_recentLogRanges.clear();
     Logger::get()->info("Closed keydb DB connections");
 }
 
+// Opens one embedded log file under directory, creating the directory if needed.
+static std::unique_ptr<StorageBackend> openEmbedded(const std::string& directory, const char* file, bool valuesOnDisk)
+{
+    try {
+        std::filesystem::create_directories(directory);
+        EmbeddedBackend::Options options;
+        options.path = (std::filesystem::path(directory) / file).string();
+        options.valuesOnDisk = valuesOnDisk;
+        return std::make_unique<EmbeddedBackend>(options);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Cannot open embedded storage: " + std::string(e.what()));
+    }
+}
+
+void db_open_embedded(const std::string& directory) {
+    if (g_hot) {
+        Logger::get()->info("Database connection already open.\n");
+        return;
+    }
+    g_hot = openEmbedded(directory, "hot.log", false);
+    loadKeyspaceState();
+    Logger::get()->trace("Opened embedded storage!");
+}
+
 bool db_insert_tick_vote(const TickVote& vote) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        std::string key = "tick_vote:" + std::to_string(vote.tick) + ":" + std::to_string(vote.computorIndex);
-        sw::redis::StringView val(reinterpret_cast<const char *>(&vote), sizeof(vote));
-        g_redis->set(key, val, std::chrono::milliseconds(0), sw::redis::UpdateType::NOT_EXIST);
-    } catch (const sw::redis::Error& e) {
+        std::string key = Keyspace::tickVote(vote.tick, vote.computorIndex);
+        std::string_view val(reinterpret_cast<const char *>(&vote), sizeof(vote));
+        g_hot->set(key, val, std::chrono::seconds(0), true);
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error: {}\n", e.what());
         return false;
     }
@@ -58,12 +298,12 @@ bool db_insert_tick_vote(const TickVote& vote) {
 }
 
 bool db_insert_tick_data(const TickData& data) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        std::string key = "tick_data:" + std::to_string(data.tick);
-        sw::redis::StringView val(reinterpret_cast<const char*>(&data), sizeof(data));
-        g_redis->set(key, val);
-    } catch (const sw::redis::Error& e) {
+        std::string key = Keyspace::tickData(data.tick);
+        std::string_view val(reinterpret_cast<const char*>(&data), sizeof(data));
+        g_hot->set(key, val);
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error: {}\n", e.what());
         return false;
     }
@@ -71,67 +311,135 @@ bool db_insert_tick_data(const TickData& data) {
 }
 
 bool db_insert_transaction(const Transaction* tx) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
         size_t tx_size = sizeof(Transaction) + tx->inputSize + SIGNATURE_SIZE;
+        uint8_t digest[32];
         char hash[64] = {0};
-        getQubicHash(reinterpret_cast<const unsigned char*>(tx), tx_size, hash);
+        KangarooTwelve(reinterpret_cast<const uint8_t*>(tx), tx_size, digest, 32);
+        getIdentityFromPublicKey(digest, hash, true);
         std::string hash_str(hash);
         // Store by transaction hash only; tick is no longer part of the key.
-        std::string key = "transaction:" + hash_str;
-        sw::redis::StringView val(reinterpret_cast<const char*>(tx), tx_size);
-        g_redis->set(key, val, std::chrono::milliseconds(0), sw::redis::UpdateType::NOT_EXIST);
-    } catch (const sw::redis::Error& e) {
+        std::string key = Keyspace::transaction(hash_str, digest);
+        std::string_view val(reinterpret_cast<const char*>(tx), tx_size);
+        const uint64_t fingerprint = transactionFingerprint(hash_str);
+        const uint64_t stamp = g_recentTransactions.stamp(fingerprint);
+        g_hot->set(key, val, std::chrono::seconds(0), true);
+        g_recentTransactions.insert(fingerprint, stamp);
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error: {}\n", e.what());
         return false;
     }
     return true;
 }
 
+// Keys per MGET/UNLINK/pipeline when the garbage cleaner moves or deletes data in bulk.
+static constexpr size_t kBulkBatch = 1024;
+
+// Deletes keys from KeyDB with multi-key UNLINKs.
+static void unlinkHotKeys(const std::vector<std::string>& keys)
+{
+    std::vector<std::string> batch;
+    for (size_t off = 0; off < keys.size(); off += kBulkBatch) {
+        batch.assign(keys.begin() + off, keys.begin() + std::min(keys.size(), off + kBulkBatch));
+        g_hot->unlink(batch);
+    }
+}
+
+// Copies keys from KeyDB to kvrocks (with gKvrocksTTL) using MGET and pipelined SET batches; a key found
+// under its v1 name (legacy(i) for keys[i]) is stored under its active name.
+// Returns the number of keys that were not in KeyDB.
+template <typename Legacy>
+static size_t copyHotKeysToKvrocks(const std::vector<std::string>& keys, Legacy&& legacy)
+{
+    size_t missing = 0;
+    std::vector<std::string> batch;
+    std::vector<StorageBackend::OptionalString> values;
+    StorageBackend::Fields entries;
+    for (size_t off = 0; off < keys.size(); off += kBulkBatch) {
+        batch.assign(keys.begin() + off, keys.begin() + std::min(keys.size(), off + kBulkBatch));
+        mgetKeys(*g_hot, batch, values, [&](size_t i) { return legacy(off + i); });
+        entries.clear();
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (!values[i]) {
+                missing++;
+                continue;
+            }
+            entries.emplace_back(std::move(batch[i]), std::move(*values[i]));
+        }
+        g_cold->mset(entries, std::chrono::seconds(gKvrocksTTL));
+    }
+    return missing;
+}
+
 bool db_delete_transaction(std::string hash)
 {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
+    bool ok = true;
     try {
-        std::string key = "transaction:" + hash;
-        g_redis->unlink(key);
-    } catch (const sw::redis::Error& e) {
+        std::vector<std::string> keys{Keyspace::transaction(hash)};
+        addLegacyKeys(keys, 1, [&](size_t) { return Keyspace::transaction(hash, Version::V1); });
+        g_hot->unlink(keys);
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error: {}\n", e.what());
-        return false;
+        ok = false;
     }
-    return true;
+    // only after the unlink; a fill that raced with it is dropped by its stamp
+    g_recentTransactions.erase(transactionFingerprint(hash));
+    return ok;
+}
+
+bool db_delete_transactions(const std::vector<std::string>& hashes)
+{
+    if (!g_hot) return false;
+    bool ok = true;
+    try {
+        std::vector<std::string> keys;
+        keys.reserve(hashes.size());
+        for (const auto& hash : hashes) keys.push_back(Keyspace::transaction(hash, Keyspace::Origin::Computed));
+        addLegacyKeys(keys, hashes.size(), [&](size_t i) { return Keyspace::transaction(hashes[i], Version::V1); });
+        unlinkHotKeys(keys);
+    } catch (const StorageError& e) {
+        Logger::get()->error("Redis error in db_delete_transactions: {}\n", e.what());
+        ok = false;
+    }
+    for (const auto& hash : hashes) g_recentTransactions.erase(transactionFingerprint(hash));
+    return ok;
 }
 
 bool db_delete_logs(uint16_t epoch, long long start, long long end)
 {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
+    bool ok = true;
     try {
+        std::vector<std::string> keys;
         for (long long i = start; i <= end; i++)
         {
-            std::string key = "log:" +
-                              std::to_string(epoch) + ":" +
-                              std::to_string(i);
-            g_redis->unlink(key);
+            keys.push_back(Keyspace::log(epoch, i));
         }
-    } catch (const sw::redis::Error& e) {
+        addLegacyKeys(keys, keys.size(), [&](size_t i) { return Keyspace::log(epoch, start + i, Version::V1); });
+        unlinkHotKeys(keys);
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error: {}\n", e.what());
-        return false;
+        ok = false;
     }
-    return true;
+    for (long long i = start; i <= end; i++) g_recentLogs.erase(logFingerprint(epoch, i));
+    return ok;
 }
 
 bool db_insert_log(uint16_t epoch, uint32_t tick, uint64_t logId, int logSize, const uint8_t* content) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        std::string key = "log:" +
-                          std::to_string(epoch) + ":" +
-                          std::to_string(logId);
+        std::string key = Keyspace::log(epoch, logId);
         // Store the raw log bytes directly as the key value instead of using a hash field.
-        sw::redis::StringView val(reinterpret_cast<const char*>(content), static_cast<size_t>(logSize));
-        g_redis->set(key, val, std::chrono::milliseconds(0), sw::redis::UpdateType::NOT_EXIST);
+        std::string_view val(reinterpret_cast<const char*>(content), static_cast<size_t>(logSize));
+        const uint64_t stamp = g_recentLogs.stamp(logFingerprint(epoch, logId));
+        g_hot->set(key, val, std::chrono::seconds(0), true);
+        g_recentLogs.insert(logFingerprint(epoch, logId), stamp);
         // Removed: stop tracking per-tick log index (log_index:<epoch>:<tick>)
         // std::string index_key = "log_index:" + std::to_string(epoch) + ":" + std::to_string(tick);
-        // g_redis->sadd(index_key, key);
-    } catch (const sw::redis::Error& e) {
+        // g_hot->sadd(index_key, key);
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error: {}\n", e.what());
         return false;
     }
@@ -139,9 +447,9 @@ bool db_insert_log(uint16_t epoch, uint32_t tick, uint64_t logId, int logSize, c
 }
 
 bool db_insert_log_range(uint32_t tick, const LogRangesPerTxInTick& logRange) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        std::string key_struct = "log_ranges:" + std::to_string(tick);
+        std::string key_struct = Keyspace::logRanges(tick);
         if (isArrayZero((uint8_t*)&logRange, sizeof(LogRangesPerTxInTick)))
         {
             return false;
@@ -172,15 +480,14 @@ bool db_insert_log_range(uint32_t tick, const LogRangesPerTxInTick& logRange) {
         }
 
         // Store the whole struct for the tick
-        sw::redis::StringView val(reinterpret_cast<const char*>(&logRange), sizeof(LogRangesPerTxInTick));
-        g_redis->set(key_struct, val, std::chrono::milliseconds(0), sw::redis::UpdateType::NOT_EXIST);
-
-        std::string key_summary = "tick_log_range:" + std::to_string(tick);
-        std::unordered_map<std::string, std::string> fields;
-        fields["fromLogId"] = std::to_string(min_log_id);
-        fields["length"] = (min_log_id == -1) ? std::to_string(-1) : std::to_string(max_log_id - min_log_id);
-        g_redis->hmset(key_summary, fields.begin(), fields.end());
-    } catch (const sw::redis::Error& e) {
+        std::string_view val(reinterpret_cast<const char*>(&logRange), sizeof(LogRangesPerTxInTick));
+        const uint64_t stamp = g_recentLogRanges.stamp(tick);
+        g_hot->set(key_struct, val, std::chrono::seconds(0), true);
+        g_recentLogRanges.insert(tick, stamp);
+
+        setLogRange(*g_hot, Keyspace::tickLogRange(tick), min_log_id,
+                    (min_log_id == -1) ? -1 : max_log_id - min_log_id, std::chrono::seconds(0));
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_insert_log_range: %s\n", e.what());
         return false;
     }
@@ -189,11 +496,16 @@ bool db_insert_log_range(uint32_t tick, const LogRangesPerTxInTick& logRange) {
 
 bool db_check_log_range(uint32_t tick)
 {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
+    if (g_recentLogRanges.contains(tick)) return true;
+    const uint64_t stamp = g_recentLogRanges.stamp(tick);
     try {
-        std::string key = "log_ranges:" + std::to_string(tick);
-        return g_redis->exists(key);
-    } catch (const sw::redis::Error &e) {
+        if (!keyExists(*g_hot, Keyspace::logRanges(tick), [&] { return Keyspace::logRanges(tick, Version::V1); })) {
+            return false;
+        }
+        g_recentLogRanges.insert(tick, stamp);
+        return true;
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in check_log_range: %s\n", e.what());
         return false;
     }
@@ -201,37 +513,79 @@ bool db_check_log_range(uint32_t tick)
 }
 
 bool db_log_exists(uint16_t epoch, uint64_t logId) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
+    if (g_recentLogs.contains(logFingerprint(epoch, logId))) return true;
+    const uint64_t stamp = g_recentLogs.stamp(logFingerprint(epoch, logId));
     try {
-        std::string key = "log:" + std::to_string(epoch) + ":" + std::to_string(logId);
-        return g_redis->exists(key);
-    } catch (const sw::redis::Error &e) {
+        if (!keyExists(*g_hot, Keyspace::log(epoch, logId), [&] { return Keyspace::log(epoch, logId, Version::V1); })) {
+            return false;
+        }
+        g_recentLogs.insert(logFingerprint(epoch, logId), stamp);
+        return true;
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_log_exists: %s\n", e.what());
         return false;
     }
     return false;
 }
 
+bool db_check_logs_exist(uint16_t epoch, long long fromLogId, long long count, std::vector<uint8_t>& exists) {
+    exists.assign(count > 0 ? count : 0, 0);
+    if (!g_hot) return false;
+    try {
+        const long long batch = 1024;
+        std::vector<long long> unknown; // offsets the recent set does not answer
+        std::vector<uint64_t> stamps;
+        std::vector<std::string> keys;
+        std::vector<uint8_t> found;
+        for (long long off = 0; off < count; off += batch) {
+            const long long n = std::min(batch, count - off);
+            unknown.clear();
+            stamps.clear();
+            keys.clear();
+            for (long long i = off; i < off + n; i++) {
+                if (g_recentLogs.contains(logFingerprint(epoch, fromLogId + i))) {
+                    exists[i] = 1;
+                    continue;
+                }
+                unknown.push_back(i);
+                stamps.push_back(g_recentLogs.stamp(logFingerprint(epoch, fromLogId + i)));
+                keys.push_back(Keyspace::log(epoch, fromLogId + i));
+            }
+            if (keys.empty()) continue;
+            existKeys(*g_hot, keys, found,
+                      [&](size_t j) { return Keyspace::log(epoch, fromLogId + unknown[j], Version::V1); });
+            for (size_t j = 0; j < unknown.size(); j++) {
+                exists[unknown[j]] = found[j];
+                if (found[j]) g_recentLogs.insert(logFingerprint(epoch, fromLogId + unknown[j]), stamps[j]);
+            }
+        }
+        return true;
+    } catch (const StorageError &e) {
+        Logger::get()->error("Redis error in db_check_logs_exist: %s\n", e.what());
+        return false;
+    }
+}
+
 bool _db_get_log_ranges(uint32_t tick, LogRangesPerTxInTick &logRange) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
         // Default to -1s
         memset(&logRange, -1, sizeof(LogRangesPerTxInTick));
 
         // Fetch the whole struct for the tick
-        std::string key = "log_ranges:" + std::to_string(tick);
-        auto val = g_redis->get(key);
+        auto val = getKey(*g_hot, Keyspace::logRanges(tick), [&] { return Keyspace::logRanges(tick, Version::V1); });
         if (!val) {
             return false;
         }
         if (val->size() != sizeof(LogRangesPerTxInTick)) {
-            Logger::get()->warn("LogRange size mismatch for key %s: got %zu, expected %zu",
-                                key.c_str(), val->size(), sizeof(LogRangesPerTxInTick));
+            Logger::get()->warn("LogRange size mismatch for tick %u: got %zu, expected %zu",
+                                tick, val->size(), sizeof(LogRangesPerTxInTick));
             return false;
         }
         memcpy((void*)&logRange, val->data(), sizeof(LogRangesPerTxInTick));
         return true;
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_try_get_log_ranges: %s\n", e.what());
         return false;
     }
@@ -239,18 +593,19 @@ bool _db_get_log_ranges(uint32_t tick, LogRangesPerTxInTick &logRange) {
 }
 
 bool db_delete_log_ranges(uint32_t tick) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
+    bool ok = true;
     try {
-        const std::string key = "log_ranges:" + std::to_string(tick);
-        g_redis->unlink(key);
-
-        const std::string key_log_range = "tick_log_range:" + std::to_string(tick);
-        g_redis->unlink(key_log_range);
-        return true;
-    } catch (const sw::redis::Error& e) {
+        std::vector<std::string> keys{Keyspace::logRanges(tick), Keyspace::tickLogRange(tick)};
+        addLegacyKeys(keys, 1, [&](size_t) { return Keyspace::logRanges(tick, Version::V1); });
+        addLegacyKeys(keys, 1, [&](size_t) { return Keyspace::tickLogRange(tick, Version::V1); });
+        g_hot->unlink(keys);
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_delete_log_ranges: %s\n", e.what());
-        return false;
+        ok = false;
     }
+    g_recentLogRanges.erase(tick);
+    return ok;
 }
 
 
@@ -271,15 +626,12 @@ bool db_try_get_log_range_for_tick(uint32_t tick, long long& fromLogId, long lon
     fromLogId = -1;
     length = -1;
 
-    auto fetchFromDB = [&](sw::redis::Redis* db) -> bool {
+    auto fetchFromDB = [&](StorageBackend* db) -> bool {
         if (!db) return false;
         try {
-            const std::string key = "tick_log_range:" + std::to_string(tick);
-            std::vector<sw::redis::Optional<std::string>> vals;
-            db->hmget(key, {"fromLogId", "length"}, std::back_inserter(vals));
-            if (vals.size() == 2 && vals[0] && vals[1]) {
-                long long min_id = std::stoll(*vals[0]);
-                long long len = std::stoll(*vals[1]);
+            long long min_id, len;
+            if (getLogRange(*db, Keyspace::tickLogRange(tick), [&] { return Keyspace::tickLogRange(tick, Version::V1); },
+                            min_id, len)) {
                 if (min_id == -1 || len == -1) {
                     fromLogId = -1;
                     length = -1;
@@ -290,7 +642,7 @@ bool db_try_get_log_range_for_tick(uint32_t tick, long long& fromLogId, long lon
                 return true;
             }
             return false;
-        } catch (const sw::redis::Error &e) {
+        } catch (const StorageError &e) {
             Logger::get()->error("Redis error in db_try_get_log_range_for_tick: %s\n", e.what());
             return false;
         } catch (const std::logic_error &e) {
@@ -299,8 +651,8 @@ bool db_try_get_log_range_for_tick(uint32_t tick, long long& fromLogId, long lon
         }
     };
 
-    if (g_redis && fetchFromDB(g_redis.get())) return true;
-    if (g_kvrocks && fetchFromDB(g_kvrocks.get())) return true;
+    if (g_hot && fetchFromDB(g_hot.get())) return true;
+    if (g_cold && fetchFromDB(g_cold.get())) return true;
 
     return false;
 }
@@ -310,7 +662,7 @@ bool
 db_get_combined_log_range_for_ticks(uint32_t startTick, uint32_t endTick, long long &fromLogId, long long &length) {
     fromLogId = -1;
     length = -1;
-    if (!g_redis || startTick > endTick) return false;
+    if (!g_hot || startTick > endTick) return false;
 
     long long minId = LLONG_MAX;
     long long maxId = -1;
@@ -338,33 +690,18 @@ db_get_combined_log_range_for_ticks(uint32_t startTick, uint32_t endTick, long l
 }
 
 bool db_update_latest_tick_and_epoch(uint32_t tick, uint16_t epoch) {
-    if (!g_redis) return false;
-    try {
-        const char* script = R"lua(
-local new_tick = tonumber(ARGV[1])
-local current_tick = tonumber(redis.call('hget', KEYS[1], 'latest_tick')) or 0
-if new_tick > current_tick then
-    redis.call('hset', KEYS[1], 'latest_tick', new_tick, 'latest_epoch', ARGV[2])
-    return 1
-end
-return 0
-)lua";
-        std::vector<std::string> keys = {"db_status"};
-        std::vector<std::string> args = {std::to_string(tick), std::to_string(epoch)};
-        g_redis->eval<long long>(script, keys.begin(), keys.end(), args.begin(), args.end());
-    } catch (const sw::redis::Error& e) {
-        Logger::get()->error("Redis error: {}\n", e.what());
-        return false;
-    }
-    return true;
+    StatusCommit commit;
+    commit.epoch = epoch;
+    commit.latestTick = tick;
+    return db_commit_status(commit);
 }
 
 bool db_get_latest_tick_and_epoch(uint32_t& tick, uint16_t& epoch)
 {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        std::vector<sw::redis::Optional<std::string>> vals;
-        g_redis->hmget("db_status", {"latest_tick", "latest_epoch"}, std::back_inserter(vals));
+        std::vector<StorageBackend::OptionalString> vals;
+        g_hot->hmget("db_status", {"latest_tick", "latest_epoch"}, vals);
 
         tick = 0;
         epoch = 0;
@@ -375,7 +712,7 @@ bool db_get_latest_tick_and_epoch(uint32_t& tick, uint16_t& epoch)
         if (vals.size() > 1 && vals[1]) {
             epoch = std::stoi(*vals[1]);
         }
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error: {}\n", e.what());
         return false;
     } catch (const std::logic_error& e) {
@@ -388,14 +725,13 @@ bool db_get_latest_tick_and_epoch(uint32_t& tick, uint16_t& epoch)
 /*LOGGING EVENTS*/
 
 bool db_update_latest_event_tick_and_epoch(uint32_t tick, uint16_t epoch) {
-    if (!g_redis) return false;
-    try {
-        g_redis->hset("db_status",
-                      std::initializer_list<std::pair<std::string, std::string>>{
-                              {"latest_event_tick", std::to_string(tick)},
-                              {"latest_event_epoch", std::to_string(epoch)}
-                      });
-    } catch (const sw::redis::Error& e) {
+    if (!g_hot) return false;
+    try {
+        g_hot->hset("db_status", {
+                {"latest_event_tick", std::to_string(tick)},
+                {"latest_event_epoch", std::to_string(epoch)}
+        });
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error: {}\n", e.what());
         return false;
     }
@@ -404,10 +740,10 @@ bool db_update_latest_event_tick_and_epoch(uint32_t tick, uint16_t epoch) {
 
 bool db_get_latest_event_tick_and_epoch(uint32_t& tick, uint16_t& epoch)
 {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        std::vector<sw::redis::Optional<std::string>> vals;
-        g_redis->hmget("db_status", {"latest_event_tick", "latest_event_epoch"}, std::back_inserter(vals));
+        std::vector<StorageBackend::OptionalString> vals;
+        g_hot->hmget("db_status", {"latest_event_tick", "latest_event_epoch"}, vals);
 
         tick = 0;
         epoch = 0;
@@ -418,7 +754,7 @@ bool db_get_latest_event_tick_and_epoch(uint32_t& tick, uint16_t& epoch)
         if (vals.size() > 1 && vals[1]) {
             epoch = std::stoi(*vals[1]);
         }
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error: {}\n", e.what());
         return false;
     } catch (const std::logic_error& e) {
@@ -431,17 +767,15 @@ bool db_get_latest_event_tick_and_epoch(uint32_t& tick, uint16_t& epoch)
 bool db_get_end_epoch_log_range(uint16_t epoch, long long &fromLogId, long long &length) {
     fromLogId = -1;
     length = -1;
-    if (!g_redis) return false;
-    try {
-        const std::string key = "end_epoch:tick_log_range:" + std::to_string(epoch);
-        std::vector<sw::redis::Optional<std::string>> vals;
-        g_redis->hmget(key, {"fromLogId", "length"}, std::back_inserter(vals));
-        if (vals.size() == 2 && vals[0] && vals[1]) {
-            fromLogId = std::stoll(*vals[0]);
-            length = std::stoll(*vals[1]);
+    if (!g_hot) return false;
+    try {
+        if (getLogRange(*g_hot, Keyspace::endEpochTickLogRange(epoch),
+                        [&] { return Keyspace::endEpochTickLogRange(epoch, Version::V1); }, fromLogId, length)) {
             return true;
         }
-    } catch (const sw::redis::Error &e) {
+        fromLogId = -1;
+        length = -1;
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_get_end_epoch_log_range: %s\n", e.what());
     } catch (const std::logic_error &e) {
         Logger::get()->error("Parsing error in db_get_end_epoch_log_range: %s\n", e.what());
@@ -450,40 +784,21 @@ bool db_get_end_epoch_log_range(uint16_t epoch, long long &fromLogId, long long
 }
 
 bool db_update_latest_log_id(uint16_t epoch, long long logId) {
-    if (!g_redis) return false;
-    try {
-        const std::string key = "db_status:epoch:" + std::to_string(epoch);
-        const char *script = R"lua(
-local current_id = tonumber(redis.call('hget', KEYS[1], 'latest_log_id')) or -1
-local new_id = tonumber(ARGV[1]) or -1
-if new_id > current_id then
-    redis.call('hset', KEYS[1], 'latest_log_id', new_id)
-    return 1
-end
-return 0
-)lua";
-        std::vector<std::string> keys = {key};
-        std::vector<std::string> args = {std::to_string(logId)};
-        g_redis->eval<long long>(script, keys.begin(), keys.end(), args.begin(), args.end());
-    } catch (const sw::redis::Error &e) {
-        Logger::get()->error("Redis error: {}\n", e.what());
-        return false;
-    } catch (const std::logic_error &e) {
-        Logger::get()->error("Parsing error in db_update_latest_log_id: %s\n", e.what());
-        return false;
-    }
-    return true;
+    StatusCommit commit;
+    commit.epoch = epoch;
+    commit.latestLogId = logId;
+    return db_commit_status(commit);
 }
 
 long long db_get_latest_log_id(uint16_t epoch) {
-    if (!g_redis) return -1;
+    if (!g_hot) return -1;
     try {
         const std::string key = "db_status:epoch:" + std::to_string(epoch);
-        auto result = g_redis->hget(key, "latest_log_id");
+        auto result = g_hot->hget(key, "latest_log_id");
         if (result) {
             return std::stoll(*result);
         }
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_get_latest_log_id: {}\n", e.what());
     } catch (const std::exception &e) {
         Logger::get()->error("Exception in db_get_latest_log_id: {}\n", e.what());
@@ -492,37 +807,39 @@ long long db_get_latest_log_id(uint16_t epoch) {
 }
 
 bool db_update_latest_verified_tick(uint32_t tick) {
-    if (!g_redis) return false;
-    try {
-        const char *script = R"lua(
-local current_tick = tonumber(redis.call('hget', KEYS[1], 'latest_verified_tick')) or -1
-local new_tick = tonumber(ARGV[1])
-if new_tick > current_tick then
-    redis.call('hset', KEYS[1], 'latest_verified_tick', new_tick)
-    return 1
-end
-return 0
-)lua";
-        std::vector<std::string> keys = {"db_status"};
-        std::vector<std::string> args = {std::to_string(tick)};
-        g_redis->eval<long long>(script, keys.begin(), keys.end(), args.begin(), args.end());
+    StatusCommit commit;
+    commit.latestVerifiedTick = tick;
+    return db_commit_status(commit);
+}
+
+bool db_commit_status(const StatusCommit& commit) {
+    if (!g_hot) return false;
+    std::vector<StorageBackend::GreaterUpdate> updates;
+    if (commit.latestTick >= 0) {
+        updates.push_back({"db_status", "latest_tick", commit.latestTick, 0, {{"latest_epoch", std::to_string(commit.epoch)}}});
+    }
+    if (commit.latestVerifiedTick >= 0) updates.push_back({"db_status", "latest_verified_tick", commit.latestVerifiedTick, -1, {}});
+    if (commit.lastIndexedTick >= 0) updates.push_back({"db_status", "last_indexed_tick", commit.lastIndexedTick, -1, {}});
+    if (commit.latestLogId >= 0) {
+        updates.push_back({"db_status:epoch:" + std::to_string(commit.epoch), "latest_log_id", commit.latestLogId, -1, {}});
+    }
+    try {
+        g_hot->hsetIfGreaterAll(updates);
         return true;
-    } catch (const sw::redis::Error &e) {
-        Logger::get()->error("Redis error in db_update_latest_verified_tick: %s\n", e.what());
+    } catch (const StorageError &e) {
+        Logger::get()->error("Redis error in db_commit_status: {}\n", e.what());
         return false;
     }
-    return false;
 }
 
-
 long long db_get_latest_verified_tick() {
-    if (!g_redis) return -1;
+    if (!g_hot) return -1;
     try {
-        auto val = g_redis->hget("db_status", "latest_verified_tick");
+        auto val = g_hot->hget("db_status", "latest_verified_tick");
         if (val) {
             return std::stoll(*val);
         }
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_get_latest_verified_tick: %s\n", e.what());
     } catch (const std::logic_error &e) {
         Logger::get()->error("Parsing error while getting latest verified tick: %s\n", e.what());
@@ -530,30 +847,34 @@ long long db_get_latest_verified_tick() {
     return -1;
 }
 
+// Loads a stored log event into log. Basic sanity: the header must exist and match epoch/logId.
+static bool loadStoredLog(const uint8_t* data, size_t size, uint16_t epoch, uint64_t logId, LogEvent& log)
+{
+    // Store raw bytes directly into LogEvent
+    log.updateContent(data, static_cast<int>(size));
+    if (!log.hasPackedHeader()) {
+        Logger::get()->warn("db_try_get_log: value too small for header of log {}:{}", epoch, logId);
+        return false;
+    }
+    if (log.getEpoch() != epoch || log.getLogId() != logId) {
+        Logger::get()->warn("db_try_get_log: header mismatch for log {}:{}, got epoch {}, logId {}",
+                            epoch, logId, log.getEpoch(), log.getLogId());
+        // Not fatal, but indicate bad record
+        return false;
+    }
+    return true;
+}
+
 bool _db_get_log(uint16_t epoch, uint64_t logId, LogEvent &log) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     log.clear();
     try {
-        std::string key = "log:" + std::to_string(epoch) + ":" + std::to_string(logId);
-        auto val = g_redis->get(key);
+        auto val = getKey(*g_hot, Keyspace::log(epoch, logId), [&] { return Keyspace::log(epoch, logId, Version::V1); });
         if (!val) {
             return false;
         }
-        // Store raw bytes directly into LogEvent
-        log.updateContent(reinterpret_cast<const uint8_t*>(val->data()), static_cast<int>(val->size()));
-
-        // Basic sanity: header must exist and match epoch/logId
-        if (!log.hasPackedHeader()) {
-            Logger::get()->warn("db_try_get_log: value too small for header at key {}", key);
-            return false;
-        }
-        if (log.getEpoch() != epoch || log.getLogId() != logId) {
-            Logger::get()->warn("db_try_get_log: header mismatch for key {}, got epoch {}, logId {}", key, log.getEpoch(), log.getLogId());
-            // Not fatal, but indicate bad record
-            return false;
-        }
-        return true;
-    } catch (const sw::redis::Error &e) {
+        return loadStoredLog(reinterpret_cast<const uint8_t*>(val->data()), val->size(), epoch, logId, log);
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_try_get_log: %s\n", e.what());
         return false;
     }
@@ -566,28 +887,23 @@ bool db_try_get_log(uint16_t epoch, uint64_t logId, LogEvent &log)
         return true;
     }
 
-    // Fall back to kvrocks
-    if (!g_kvrocks) return false;
-    try {
-        const std::string key = "log:" + std::to_string(epoch) + ":" + std::to_string(logId);
-        auto val = g_kvrocks->get(key);
-        if (!val) {
-            return false;
+    // Then the log segments
+    if (g_logSegments) {
+        std::string val;
+        if (g_logSegments->get(epoch, logId, val)) {
+            return loadStoredLog(reinterpret_cast<const uint8_t*>(val.data()), val.size(), epoch, logId, log);
         }
-        log.updateContent(reinterpret_cast<const uint8_t *>(val->data()), static_cast<int>(val->size()));
+    }
 
-        // Basic sanity: header must exist and match epoch/logId
-        if (!log.hasPackedHeader()) {
-            Logger::get()->warn("db_try_get_log: value too small for header at key {}", key);
-            return false;
-        }
-        if (log.getEpoch() != epoch || log.getLogId() != logId) {
-            Logger::get()->warn("db_try_get_log: header mismatch for key {}, got epoch {}, logId {}",
-                                key, log.getEpoch(), log.getLogId());
+    // Fall back to kvrocks (logs moved there before log segments were enabled)
+    if (!g_cold) return false;
+    try {
+        auto val = getKey(*g_cold, Keyspace::log(epoch, logId), [&] { return Keyspace::log(epoch, logId, Version::V1); });
+        if (!val) {
             return false;
         }
-        return true;
-    } catch (const sw::redis::Error &e) {
+        return loadStoredLog(reinterpret_cast<const uint8_t*>(val->data()), val->size(), epoch, logId, log);
+    } catch (const StorageError &e) {
         Logger::get()->error("Kvrocks error in db_try_get_log: {}\n", e.what());
         return false;
     }
@@ -596,21 +912,59 @@ bool db_try_get_log(uint16_t epoch, uint64_t logId, LogEvent &log)
 std::vector<LogEvent> db_try_get_logs(uint16_t epoch, long long logIdStart, long long logIdEnd)
 {
     std::vector<LogEvent> results;
+    if (logIdStart < 0 || logIdEnd < logIdStart) return results;
+    if (!g_logSegments)
+    {
+        for (long long l = logIdStart; l <= logIdEnd; l++)
+        {
+            LogEvent le;
+            if (db_try_get_log(epoch, l, le))
+            {
+                results.push_back(le);
+            }
+        }
+        return results;
+    }
+
+    // Recent logs are in the hot tier, older ones in a segment where the range is one sequential read
+    const size_t count = static_cast<size_t>(logIdEnd - logIdStart + 1);
+    std::vector<LogEvent> slots(count);
+    std::vector<uint8_t> found(count, 0);
+    long long firstMissing = -1, lastMissing = -1;
     for (long long l = logIdStart; l <= logIdEnd; l++)
     {
-        LogEvent le;
-        if (db_try_get_log(epoch, l, le))
+        const size_t i = static_cast<size_t>(l - logIdStart);
+        if (_db_get_log(epoch, l, slots[i])) {
+            found[i] = 1;
+            continue;
+        }
+        if (firstMissing < 0) firstMissing = l;
+        lastMissing = l;
+    }
+    if (firstMissing >= 0)
+    {
+        g_logSegments->readRange(epoch, firstMissing, lastMissing, [&](uint64_t logId, const uint8_t* data, size_t size) {
+            const size_t i = static_cast<size_t>(logId - logIdStart);
+            if (!found[i]) found[i] = loadStoredLog(data, size, epoch, logId, slots[i]) ? 1 : 0;
+        });
+        // anything still missing may have been moved to kvrocks before log segments were enabled
+        for (long long l = firstMissing; g_cold && l <= lastMissing; l++)
         {
-            results.push_back(le);
+            const size_t i = static_cast<size_t>(l - logIdStart);
+            if (!found[i]) found[i] = db_try_get_log(epoch, l, slots[i]) ? 1 : 0;
         }
     }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (found[i]) results.push_back(std::move(slots[i]));
+    }
     return results;
 }
 
 std::vector<LogEvent> db_get_logs_by_tick_range(uint16_t epoch, uint32_t start_tick, uint32_t end_tick, bool& success) {
     success = false;
     std::vector<LogEvent> out;
-    if (!g_redis) return out;
+    if (!g_hot) return out;
 
     try {
         // We rely on the aggregated range for each tick in [start_tick, end_tick].
@@ -670,7 +1024,7 @@ std::vector<LogEvent> db_get_logs_by_tick_range(uint16_t epoch, uint32_t start_t
                 out.emplace_back(std::move(le));
             }
         }
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_get_logs_by_tick_range: %s\n", e.what());
         out.clear();
         return out;
@@ -685,14 +1039,16 @@ std::vector<LogEvent> db_get_logs_by_tick_range(uint16_t epoch, uint32_t start_t
 
 
 long long db_get_tick_vote_count(uint32_t tick) {
-    if (!g_redis) return -1;
+    if (!g_hot) return -1;
     try {
+        if (auto packed = getKey(*g_hot, Keyspace::tickVotes(tick), [&] { return Keyspace::tickVotes(tick, Version::V1); })) {
+            if (PackedTickVotes::valid(*packed)) return static_cast<long long>(PackedTickVotes::count(*packed));
+        }
         // Deterministic bounded check: keys tick_vote:<tick>:0..675
         constexpr int MAX_COMPUTORS = 676;
         constexpr int BATCH_SIZE = 128; // smaller, short-lived operations
 
         long long count = 0;
-        const std::string prefix = "tick_vote:" + std::to_string(tick) + ":";
 
         std::vector<std::string> keys;
         keys.reserve(BATCH_SIZE);
@@ -702,14 +1058,14 @@ long long db_get_tick_vote_count(uint32_t tick) {
 
             keys.clear();
             for (int i = start; i < end; ++i) {
-                keys.emplace_back(prefix + std::to_string(i));
+                keys.emplace_back(Keyspace::tickVote(tick, i));
             }
 
-            std::vector<sw::redis::OptionalString> vals;
+            std::vector<StorageBackend::OptionalString> vals;
             vals.reserve(keys.size());
 
             // MGET for a short chunk to avoid holding a connection too long.
-            g_redis->mget(keys.begin(), keys.end(), std::back_inserter(vals));
+            mgetKeys(*g_hot, keys, vals, [&](size_t i) { return Keyspace::tickVote(tick, start + i, Version::V1); });
 
             for (const auto &opt : vals) {
                 if (opt) {
@@ -718,7 +1074,7 @@ long long db_get_tick_vote_count(uint32_t tick) {
             }
         }
         return count;
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error: {}\n", e.what());
         return -1;
     }
@@ -726,16 +1082,21 @@ long long db_get_tick_vote_count(uint32_t tick) {
 
 
 bool db_get_tick_vote(uint32_t tick, uint16_t computorIndex, TickVote& vote) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
         // Key is unique; fetch directly.
-        const std::string key = "tick_vote:" + std::to_string(tick) + ":" + std::to_string(computorIndex);
-        auto val = g_redis->get(key);
+        auto val = getKey(*g_hot, Keyspace::tickVote(tick, computorIndex),
+                          [&] { return Keyspace::tickVote(tick, computorIndex, Version::V1); });
         if (val && val->size() == sizeof(TickVote)) {
             memcpy((void*)&vote, val->data(), sizeof(TickVote));
             return true;
         }
-    } catch (const sw::redis::Error& e) {
+        // verified ticks keep their votes packed; the single key is checked first for the ticks being verified
+        auto packed = getKey(*g_hot, Keyspace::tickVotes(tick), [&] { return Keyspace::tickVotes(tick, Version::V1); });
+        if (packed && PackedTickVotes::find(*packed, computorIndex, vote)) {
+            return true;
+        }
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_get_tick_vote: %s\n", e.what());
     }
     return false;
@@ -743,7 +1104,7 @@ bool db_get_tick_vote(uint32_t tick, uint16_t computorIndex, TickVote& vote) {
 
 std::vector<TickVote> db_get_tick_votes(uint32_t tick) {
     std::vector<TickVote> votes;
-    if (!g_redis) return votes;
+    if (!g_hot) return votes;
     try {
         // Deterministic bounded fetch: keys tick_vote:<tick>:0..675
         constexpr int MAX_COMPUTORS = 676;
@@ -751,7 +1112,10 @@ std::vector<TickVote> db_get_tick_votes(uint32_t tick) {
 
         votes.reserve(MAX_COMPUTORS);
 
-        const std::string prefix = "tick_vote:" + std::to_string(tick) + ":";
+        if (auto packed = getKey(*g_hot, Keyspace::tickVotes(tick), [&] { return Keyspace::tickVotes(tick, Version::V1); })) {
+            if (PackedTickVotes::unpack(*packed, votes)) return votes;
+            Logger::get()->warn("Ignoring malformed tick_votes:{} ({} bytes)", tick, packed->size());
+        }
 
         std::vector<std::string> keys;
         keys.reserve(BATCH_SIZE);
@@ -761,14 +1125,14 @@ std::vector<TickVote> db_get_tick_votes(uint32_t tick) {
 
             keys.clear();
             for (int i = start; i < end; ++i) {
-                keys.emplace_back(prefix + std::to_string(i));
+                keys.emplace_back(Keyspace::tickVote(tick, i));
             }
 
-            std::vector<sw::redis::OptionalString> vals;
+            std::vector<StorageBackend::OptionalString> vals;
             vals.reserve(keys.size());
 
             // MGET for a short chunk
-            g_redis->mget(keys.begin(), keys.end(), std::back_inserter(vals));
+            mgetKeys(*g_hot, keys, vals, [&](size_t i) { return Keyspace::tickVote(tick, start + i, Version::V1); });
 
             for (const auto &opt : vals) {
                 if (!opt) continue;
@@ -780,45 +1144,43 @@ std::vector<TickVote> db_get_tick_votes(uint32_t tick) {
                 votes.push_back(vote);
             }
         }
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_get_tick_votes: {}\n", e.what());
     }
     return votes;
 }
 
 bool db_get_tick_data(uint32_t tick, TickData& data) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        const std::string key = "tick_data:" + std::to_string(tick);
-        auto val = g_redis->get(key);
+        auto val = getKey(*g_hot, Keyspace::tickData(tick), [&] { return Keyspace::tickData(tick, Version::V1); });
         if (!val) {
             return false;
         }
         if (val->size() != sizeof(TickData)) {
-            Logger::get()->warn("TickData size mismatch for key %s: got %zu, expected %zu",
-                                key.c_str(), val->size(), sizeof(TickData));
+            Logger::get()->warn("TickData size mismatch for tick %u: got %zu, expected %zu",
+                                tick, val->size(), sizeof(TickData));
             return false;
         }
         memcpy((void*)&data, val->data(), sizeof(TickData));
         return true;
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_get_tick_data: %s\n", e.what());
     }
     return false;
 }
 
 bool _db_get_transaction(const std::string& tx_hash, std::vector<uint8_t>& tx_data) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
         // Tick is no longer used in the key; fetch by hash only.
-        const std::string key = "transaction:" + tx_hash;
-        auto val = g_redis->get(key);
+        auto val = getKey(*g_hot, Keyspace::transaction(tx_hash), [&] { return Keyspace::transaction(tx_hash, Version::V1); });
         if (!val) {
             return false;
         }
         tx_data.assign(val->begin(), val->end());
         return true;
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_try_get_transaction (by hash, tick ignored): %s\n", e.what());
     }
     return false;
@@ -831,16 +1193,15 @@ bool db_try_get_transaction(const std::string& tx_hash, std::vector<uint8_t>& tx
     }
 
     // Fall back to kvrocks
-    if (!g_kvrocks) return false;
+    if (!g_cold) return false;
     try {
-        const std::string key = "transaction:" + tx_hash;
-        auto val = g_kvrocks->get(key);
+        auto val = getKey(*g_cold, Keyspace::transaction(tx_hash), [&] { return Keyspace::transaction(tx_hash, Version::V1); });
         if (!val) {
             return false;
         }
         tx_data.assign(val->begin(), val->end());
         return true;
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Kvrocks error in db_try_get_transaction: %s\n", e.what());
     }
     return false;
@@ -848,11 +1209,18 @@ bool db_try_get_transaction(const std::string& tx_hash, std::vector<uint8_t>& tx
 
 
 bool db_check_transaction_exist(const std::string& tx_hash) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
+    const uint64_t fingerprint = transactionFingerprint(tx_hash);
+    if (g_recentTransactions.contains(fingerprint)) return true;
+    const uint64_t stamp = g_recentTransactions.stamp(fingerprint);
     try {
-        const std::string key = "transaction:" + tx_hash;
-        return g_redis->exists(key);
-    } catch (const sw::redis::Error& e) {
+        if (!keyExists(*g_hot, Keyspace::transaction(tx_hash),
+                       [&] { return Keyspace::transaction(tx_hash, Version::V1); })) {
+            return false;
+        }
+        g_recentTransactions.insert(fingerprint, stamp);
+        return true;
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_check_transaction_exist: %s\n", e.what());
     }
     return false;
@@ -860,12 +1228,11 @@ bool db_check_transaction_exist(const std::string& tx_hash) {
 
 
 bool db_has_tick_data(uint32_t tick) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        const std::string key = "tick_data:" + std::to_string(tick);
-        const std::string key2 = "vtick:" + std::to_string(tick);
-        return g_redis->exists(key) || g_redis->exists(key2);
-    } catch (const sw::redis::Error &e) {
+        return keyExists(*g_hot, Keyspace::tickData(tick), [&] { return Keyspace::tickData(tick, Version::V1); }) ||
+               keyExists(*g_hot, Keyspace::vtick(tick), [&] { return Keyspace::vtick(tick, Version::V1); });
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_has_tick_data: %s\n", e.what());
         return false;
     }
@@ -874,16 +1241,11 @@ bool db_has_tick_data(uint32_t tick) {
 
 std::vector<TickVote> db_get_tick_votes_from_vtick(uint32_t tick) {
     std::vector<TickVote> votes;
-    if (!g_redis) return votes;
+    if (!g_hot) return votes;
 
     try {
-        FullTickStruct fts;
-        if (!db_get_vtick_from_kvrocks(tick, fts)) {
-            return votes;
-        }
-
-        for (const auto &vote: fts.tv) {
-            votes.push_back(vote);
+        if (!db_get_vtick_votes_from_kvrocks(tick, votes)) {
+            votes.clear();
         }
         return votes;
     } catch (const std::exception &e) {
@@ -903,12 +1265,12 @@ std::vector<TickVote> db_try_to_get_votes(uint32_t tick) {
 
 // Store the whole Computors struct per epoch; key = "computor:<epoch>"
 bool db_insert_computors(const Computors& comps) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        sw::redis::StringView val(reinterpret_cast<const char*>(&comps), sizeof(Computors));
+        std::string_view val(reinterpret_cast<const char*>(&comps), sizeof(Computors));
         std::string key = "computor:" + std::to_string(comps.epoch);
-        g_redis->set(key, val);
-    } catch (const sw::redis::Error& e) {
+        g_hot->set(key, val);
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_insert_computors: %s\n", e.what());
         return false;
     }
@@ -917,10 +1279,10 @@ bool db_insert_computors(const Computors& comps) {
 
 // Retrieve the whole Computors struct by epoch; key = "computor:<epoch>"
 bool db_get_computors(uint16_t epoch, Computors& comps) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
         const std::string key = "computor:" + std::to_string(epoch);
-        auto val = g_redis->get(key);
+        auto val = g_hot->get(key);
         if (!val) {
             return false;
         }
@@ -931,7 +1293,7 @@ bool db_get_computors(uint16_t epoch, Computors& comps) {
         }
         std::memcpy((void*)&comps, val->data(), sizeof(Computors));
         return true;
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_get_computors: %s\n", e.what());
         return false;
     }
@@ -939,50 +1301,117 @@ bool db_get_computors(uint16_t epoch, Computors& comps) {
 }
 
 bool db_delete_tick_data(uint32_t tick) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        const std::string key = "tick_data:" + std::to_string(tick);
-        g_redis->unlink(key);
+        std::vector<std::string> keys{Keyspace::tickData(tick)};
+        addLegacyKeys(keys, 1, [&](size_t) { return Keyspace::tickData(tick, Version::V1); });
+        g_hot->unlink(keys);
         return true;
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_delete_tick_data: %s\n", e.what());
         return false;
     }
 }
 
 bool db_delete_tick_vote(uint32_t tick) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
         // Delete all tick vote records for computor indices 0-675
         constexpr int MAX_COMPUTORS = 676;
-        const std::string prefix = "tick_vote:" + std::to_string(tick) + ":";
 
         std::vector<std::string> keys;
-        keys.reserve(MAX_COMPUTORS);
+        keys.reserve(MAX_COMPUTORS + 1);
 
         // Build deterministic set of keys to delete
+        keys.push_back(Keyspace::tickVotes(tick));
         for (int i = 0; i < MAX_COMPUTORS; i++) {
-            keys.push_back(prefix + std::to_string(i));
+            keys.push_back(Keyspace::tickVote(tick, i));
         }
+        addLegacyKeys(keys, 1, [&](size_t) { return Keyspace::tickVotes(tick, Version::V1); });
+        addLegacyKeys(keys, MAX_COMPUTORS, [&](size_t i) { return Keyspace::tickVote(tick, i, Version::V1); });
 
         if (!keys.empty()) {
-            g_redis->unlink(keys.begin(), keys.end());
+            g_hot->unlink(keys);
         }
         return true;
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_delete_tick_vote: %s\n", e.what());
         return false;
     }
 }
 
+bool db_delete_ticks(uint32_t fromTick, uint32_t toTick) {
+    if (!g_hot) return false;
+    try {
+        constexpr int MAX_COMPUTORS = 676;
+        std::vector<std::string> keys;
+        keys.reserve(static_cast<size_t>(toTick - fromTick + 1) * (MAX_COMPUTORS + 2));
+        for (uint32_t tick = fromTick; tick <= toTick; tick++) {
+            keys.push_back(Keyspace::tickData(tick));
+            keys.push_back(Keyspace::tickVotes(tick));
+            for (int i = 0; i < MAX_COMPUTORS; i++) keys.push_back(Keyspace::tickVote(tick, i));
+            addLegacyKeys(keys, 1, [&](size_t) { return Keyspace::tickData(tick, Version::V1); });
+            addLegacyKeys(keys, 1, [&](size_t) { return Keyspace::tickVotes(tick, Version::V1); });
+            addLegacyKeys(keys, MAX_COMPUTORS, [&](size_t i) { return Keyspace::tickVote(tick, i, Version::V1); });
+        }
+        unlinkHotKeys(keys);
+        return true;
+    } catch (const StorageError &e) {
+        Logger::get()->error("Redis error in db_delete_ticks: {}\n", e.what());
+        return false;
+    }
+}
+
+bool db_pack_tick_votes(uint32_t fromTick, uint32_t toTick) {
+    if (!g_hot) return false;
+    try {
+        constexpr int MAX_COMPUTORS = 676;
+        std::vector<std::string> keys, packedKeys;
+        std::vector<StorageBackend::OptionalString> vals, packed;
+        StorageBackend::Fields blobs;
+        std::vector<TickVote> votes;
+        // ticks packed before (verified again after a rollback, or late votes) are merged
+        keys.clear();
+        for (uint32_t tick = fromTick; tick <= toTick; tick++) keys.push_back(Keyspace::tickVotes(tick));
+        mgetKeys(*g_hot, keys, packed, [&](size_t i) { return Keyspace::tickVotes(fromTick + i, Version::V1); });
+        for (uint32_t tick = fromTick; tick <= toTick; tick++) {
+            keys.clear();
+            for (int i = 0; i < MAX_COMPUTORS; i++) keys.push_back(Keyspace::tickVote(tick, i));
+            mgetKeys(*g_hot, keys, vals, [&](size_t i) { return Keyspace::tickVote(tick, i, Version::V1); });
+            votes.clear();
+            for (size_t i = 0; i < vals.size(); i++) {
+                if (!vals[i]) continue;
+                packedKeys.push_back(std::move(keys[i]));
+                addLegacyKeys(packedKeys, 1, [&](size_t) { return Keyspace::tickVote(tick, i, Version::V1); });
+                if (vals[i]->size() != sizeof(TickVote)) continue;
+                TickVote vote{};
+                memcpy((void*)&vote, vals[i]->data(), sizeof(TickVote));
+                if (vote.computorIndex == i) votes.push_back(vote);
+            }
+            if (votes.empty()) continue;
+            const auto& previous = packed[tick - fromTick];
+            if (previous) PackedTickVotes::unpack(*previous, votes);
+            blobs.emplace_back(Keyspace::tickVotes(tick), PackedTickVotes::pack(votes));
+        }
+        if (blobs.empty()) return true;
+        // the packed votes are stored before the single ones are dropped
+        g_hot->mset(blobs);
+        unlinkHotKeys(packedKeys);
+        return true;
+    } catch (const StorageError &e) {
+        Logger::get()->error("Redis error in db_pack_tick_votes: {}\n", e.what());
+        return false;
+    }
+}
+
 long long db_get_last_indexed_tick() {
-    if (!g_redis) return -1;
+    if (!g_hot) return -1;
     try {
-        auto val = g_redis->hget("db_status", "last_indexed_tick");
+        auto val = g_hot->hget("db_status", "last_indexed_tick");
         if (val) {
             return std::stoll(*val);
         }
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_get_last_indexed_tick: %s\n", e.what());
     } catch (const std::logic_error &e) {
         Logger::get()->error("Parsing error while getting last_indexed_tick: %s\n", e.what());
@@ -991,35 +1420,131 @@ long long db_get_last_indexed_tick() {
 }
 
 bool db_update_last_indexed_tick(uint32_t tick) {
-    if (!g_redis) return false;
-    try {
-        const char *script = R"lua(
-local current_tick = tonumber(redis.call('hget', KEYS[1], 'last_indexed_tick')) or -1
-local new_tick = tonumber(ARGV[1])
-if new_tick > current_tick then
-    redis.call('hset', KEYS[1], 'last_indexed_tick', new_tick)
-    return 1
-end
-return 0
-)lua";
-        std::vector<std::string> keys = {"db_status"};
-        std::vector<std::string> args = {std::to_string(tick)};
-        g_redis->eval<long long>(script, keys.begin(), keys.end(), args.begin(), args.end());
+    StatusCommit commit;
+    commit.lastIndexedTick = tick;
+    return db_commit_status(commit);
+}
+
+static std::string stateHistoryKey(uint16_t epoch, uint8_t kind, uint32_t index)
+{
+    return std::string(kind == StateJournal::QU ? "balance_history:" : "share_history:") +
+           std::to_string(epoch) + ":" + std::to_string(index);
+}
+
+// Sorted set of the history keys an epoch wrote, scored (kind << 32) | index so it can be paged by score
+static std::string stateHistoryIndexKey(uint16_t epoch)
+{
+    return "state_history_keys:" + std::to_string(epoch);
+}
+
+bool db_insert_state_deltas(uint16_t epoch, const std::vector<StateJournal::Delta>& deltas)
+{
+    if (!g_hot) return false;
+    try {
+        const size_t batch = 4096;
+        const std::string indexKey = stateHistoryIndexKey(epoch);
+        char member[64];
+        std::vector<StorageBackend::ZMember> members;
+        std::unordered_set<uint64_t> indexed;
+        for (size_t off = 0; off < deltas.size(); off += batch) {
+            const size_t n = std::min(batch, deltas.size() - off);
+            members.clear();
+            for (size_t i = off; i < off + n; i++) {
+                const auto& d = deltas[i];
+                const uint64_t slot = (uint64_t(d.kind) << 32) | d.index;
+                // the index entry goes first, so no history key is ever written without it
+                if (indexed.insert(slot).second) {
+                    members.push_back({indexKey, std::to_string(slot), static_cast<double>(slot)});
+                }
+                snprintf(member, sizeof(member), "%010u:%lld:%lld", d.ordinal, d.oldValue, d.newValue);
+                members.push_back({stateHistoryKey(epoch, d.kind, d.index), member, static_cast<double>(d.tick)});
+            }
+            g_hot->zadd(members);
+        }
+        return true;
+    } catch (const StorageError &e) {
+        Logger::get()->error("Redis error in db_insert_state_deltas: {}\n", e.what());
+        return false;
+    }
+}
+
+bool db_get_state_value_at_tick(uint16_t epoch, uint8_t kind, uint32_t index, uint32_t tick, long long& value)
+{
+    if (!g_hot) return false;
+    try {
+        const std::string key = stateHistoryKey(epoch, kind, index);
+        std::vector<std::string> members;
+        // last change at or before the tick: its new value
+        StorageBackend::ScoreRange upTo;
+        upTo.max = tick;
+        g_hot->zrangeByScore(key, upTo, true, 1, members);
+        bool useNewValue = true;
+        if (members.empty()) {
+            // otherwise the first change after it: its old value
+            StorageBackend::ScoreRange after;
+            after.min = tick;
+            after.minOpen = true;
+            g_hot->zrangeByScore(key, after, false, 1, members);
+            useNewValue = false;
+        }
+        if (members.empty()) return false;
+        unsigned ordinal = 0;
+        long long oldValue = 0, newValue = 0;
+        if (sscanf(members[0].c_str(), "%u:%lld:%lld", &ordinal, &oldValue, &newValue) != 3) {
+            Logger::get()->warn("Malformed state journal member in {}: {}", key, members[0]);
+            return false;
+        }
+        value = useNewValue ? newValue : oldValue;
         return true;
-    } catch (const sw::redis::Error &e) {
-        Logger::get()->error("Redis error in db_update_last_indexed_tick: %s\n", e.what());
+    } catch (const StorageError &e) {
+        Logger::get()->error("Redis error in db_get_state_value_at_tick: {}\n", e.what());
+        return false;
+    }
+}
+
+bool db_delete_state_history(uint16_t epoch, const std::atomic_bool& stopFlag)
+{
+    if (!g_hot) return false;
+    try {
+        const size_t batch = 4096;
+        const std::string indexKey = stateHistoryIndexKey(epoch);
+        StorageBackend::ScoreRange range;
+        std::vector<std::string> slots;
+        std::vector<std::string> keys;
+        keys.reserve(batch);
+        do {
+            if (stopFlag.load()) return false;
+            slots.clear();
+            g_hot->zrangeByScore(indexKey, range, false, batch, slots);
+            keys.clear();
+            for (const auto& member : slots) {
+                const uint64_t slot = std::stoull(member);
+                keys.push_back(stateHistoryKey(epoch, static_cast<uint8_t>(slot >> 32), static_cast<uint32_t>(slot)));
+                range.min = static_cast<double>(slot);
+                range.minOpen = true;
+            }
+            if (!keys.empty()) g_hot->unlink(keys);
+        } while (slots.size() == batch);
+        // an interrupted delete starts over from the index, which is only dropped at the end
+        g_hot->unlink({indexKey});
+        return true;
+    } catch (const StorageError &e) {
+        Logger::get()->error("Redis error in db_delete_state_history: {}\n", e.what());
+        return false;
+    } catch (const std::logic_error &e) {
+        Logger::get()->error("Malformed state history index of epoch {}: {}", epoch, e.what());
         return false;
     }
 }
 
 bool db_add_indexer(const std::string &key, uint32_t tickNumber)
 {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
         const std::string member = std::to_string(tickNumber);
-        g_redis->zadd(key, member, static_cast<double>(tickNumber), sw::redis::UpdateType::NOT_EXIST);
+        g_hot->zadd({{key, member, static_cast<double>(tickNumber)}}, true);
         return true;
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_add_indexer: {}\n", e.what());
         return false;
     }
@@ -1032,7 +1557,7 @@ bool db_set_indexed_tx(const char *key,
                        long long to_log_id,
                        uint64_t timestamp,
                        bool isExecuted) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
         indexedTxData data{
             static_cast<int32_t>(tx_index),
@@ -1041,10 +1566,10 @@ bool db_set_indexed_tx(const char *key,
             static_cast<int64_t>(to_log_id),
             static_cast<uint64_t>(timestamp)
         };
-        sw::redis::StringView val(reinterpret_cast<const char*>(&data), sizeof(data));
-        g_redis->set(key, val);
+        std::string_view val(reinterpret_cast<const char*>(&data), sizeof(data));
+        g_hot->set(key, val);
         return true;
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_set_indexed_tx: {}", e.what());
         return false;
     }
@@ -1056,17 +1581,16 @@ bool db_get_indexed_tx(const char* tx_hash,
                        long long& to_log_id,
                        uint64_t& timestamp,
                        bool& executed) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
         // Indexed TX stored under "itx:<hash>"
-        std::string key = std::string("itx:") + tx_hash;
-        auto val = g_redis->get(key);
+        auto val = getKey(*g_hot, Keyspace::indexedTx(tx_hash), [&] { return Keyspace::indexedTx(tx_hash, Version::V1); });
         if (!val) {
             return false;
         }
         if (val->size() != sizeof(indexedTxData)) {
-            Logger::get()->warn("db_get_indexed_tx: size mismatch for key {}. got={}, expected={}",
-                                key, val->size(), sizeof(indexedTxData));
+            Logger::get()->warn("db_get_indexed_tx: size mismatch for tx {}. got={}, expected={}",
+                                tx_hash, val->size(), sizeof(indexedTxData));
             return false;
         }
 
@@ -1079,7 +1603,7 @@ bool db_get_indexed_tx(const char* tx_hash,
         to_log_id    = static_cast<long long>(data.to_log_id);
         timestamp    = static_cast<uint64_t>(data.timestamp);
         return true;
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_get_indexed_tx: {}", e.what());
         return false;
     }
@@ -1090,7 +1614,7 @@ std::vector<uint32_t> db_search_log(uint32_t scIndex, uint32_t scLogType, uint32
                                     std::string topic1, std::string topic2, std::string topic3)
 {
     std::vector<uint32_t> result;
-    if (!g_redis) return result;
+    if (!g_hot) return result;
     if (topic1.size() != 60) {
         Logger::get()->error("db_search_log: Error topic1 size, expect 60 but get {}", topic1.size());
         return result;
@@ -1112,39 +1636,45 @@ std::vector<uint32_t> db_search_log(uint32_t scIndex, uint32_t scLogType, uint32
         auto toPart = [](const std::string& t) -> std::string {
             return (t == "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaafxib") ? std::string("ANY") : t;
         };
-        std::string key = "";
-        if (topic1 == "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaafxib" &&
-                topic2 == "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaafxib" &&
-                topic3 == "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaafxib")
-        {
-            // all topic is empty
-            if (scLogType == 0xffffffff)
+        auto keyOf = [&](Version v) -> std::string {
+            if (topic1 == "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaafxib" &&
+                    topic2 == "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaafxib" &&
+                    topic3 == "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaafxib")
             {
-                // log type is also empty
-                key = "indexed:" + std::to_string(scIndex);
+                // all topic is empty
+                if (scLogType == 0xffffffff)
+                {
+                    // log type is also empty
+                    return Keyspace::indexed(scIndex, v);
+                }
+                else
+                {
+                    return Keyspace::indexed(scIndex, scLogType, v);
+                }
             }
             else
             {
-                key = "indexed:" + std::to_string(scIndex) + ":" + std::to_string(scLogType) ;
+                // have at least 1 non zero topic
+                return Keyspace::indexed(scIndex, scLogType, toPart(topic1), toPart(topic2), toPart(topic3), v);
             }
-        }
-        else
-        {
-            // have at least 1 non zero topic
-            key =   std::string("indexed:") +
-                    std::to_string(scIndex) + ":" +
-                    std::to_string(scLogType) + ":" +
-                    toPart(topic1) + ":" +
-                    toPart(topic2) + ":" +
-                    toPart(topic3);
-        }
+        };
         std::vector<std::string> members;
-        sw::redis::BoundedInterval<double> range(fromTick, toTick,
-                                                 sw::redis::BoundType::CLOSED);
-
-        g_redis->zrangebyscore(key,
-                               range,
-                               std::back_inserter(members));
+        StorageBackend::ScoreRange range;
+        range.min = fromTick;
+        range.max = toTick;
+        g_hot->zrangeByScore(keyOf(Keyspace::active()), range, false, 0, members);
+        if (Keyspace::migrating()) {
+            // the v1 set keeps the older ticks until the migrator merges it; members are ticks, so sort numerically
+            std::vector<std::string> legacy;
+            g_hot->zrangeByScore(keyOf(Version::V1), range, false, 0, legacy);
+            if (!legacy.empty()) {
+                members.insert(members.end(), legacy.begin(), legacy.end());
+                std::sort(members.begin(), members.end(), [](const std::string& a, const std::string& b) {
+                    return a.size() != b.size() ? a.size() < b.size() : a < b;
+                });
+                members.erase(std::unique(members.begin(), members.end()), members.end());
+            }
+        }
 
         result.reserve(members.size());
         for (const auto& m : members) {
@@ -1154,7 +1684,7 @@ std::vector<uint32_t> db_search_log(uint32_t scIndex, uint32_t scLogType, uint32
                 // Skip malformed members
             }
         }
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("Redis error in db_search_log: {}\n", e.what());
         result.clear();
     }
@@ -1163,56 +1693,83 @@ std::vector<uint32_t> db_search_log(uint32_t scIndex, uint32_t scLogType, uint32
 }
 
 bool db_update_field(const std::string key, const std::string field, const std::string value) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        g_redis->hset(key, field, value);
+        g_hot->hset(key, {{field, value}});
         return true;
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_update_field: {}\n", e.what());
         return false;
     }
 }
 
+bool db_copy_transactions_to_kvrocks(const std::vector<std::string>& txHashes) {
+    if (!g_hot || !g_cold) return false;
+    try {
+        std::vector<std::string> keys;
+        keys.reserve(txHashes.size());
+        for (const auto& hash : txHashes) keys.push_back(Keyspace::transaction(hash, Keyspace::Origin::Computed));
+        copyHotKeysToKvrocks(keys, [&](size_t i) { return Keyspace::transaction(txHashes[i], Version::V1); });
+        return true;
+    } catch (const StorageError &e) {
+        Logger::get()->error("Redis error in db_copy_transactions_to_kvrocks: {}\n", e.what());
+        return false;
+    }
+}
+
 bool db_copy_transaction_to_kvrocks(const std::string &tx_hash) {
-    if (!g_redis || !g_kvrocks) return false;
+    if (!g_hot || !g_cold) return false;
     try {
-        const std::string key = "transaction:" + tx_hash;
+        const std::string key = Keyspace::transaction(tx_hash);
 
         // Read transaction data from KeyDB
-        auto val = g_redis->get(key);
+        auto val = getKey(*g_hot, key, [&] { return Keyspace::transaction(tx_hash, Version::V1); });
         if (!val) {
             return false; // nothing to migrate for this transaction
         }
 
         // Write to Kvrocks
-        sw::redis::StringView view(val->data(), val->size());
+        std::string_view view(val->data(), val->size());
 
-        g_kvrocks->set(key, view, std::chrono::seconds(gKvrocksTTL));
+        g_cold->set(key, view, std::chrono::seconds(gKvrocksTTL));
 
         return true;
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_migrate_transaction: {}\n", e.what());
         return false;
     }
 }
 
 bool db_rename(const std::string &key1, const std::string &key2) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        g_redis->rename(key1, key2);
+        g_hot->rename(key1, key2);
         return true;
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
 //        Logger::get()->error("Redis error in db_rename: {} {}=>{}\n", e.what(), key1, key2);
         return false;
     }
 }
 
+bool db_rename_end_epoch_log_ranges(uint32_t endTick, uint16_t epoch) {
+    const std::string endEpochLogRanges = "end_epoch:log_ranges:" + std::to_string(epoch);
+    bool ok = db_rename(Keyspace::tickLogRange(endTick), Keyspace::endEpochTickLogRange(epoch));
+    if (!ok && Keyspace::migrating()) {
+        // not migrated yet: keep the v1 value format, the migrator converts end_epoch:tick_log_range too
+        ok = db_rename(Keyspace::tickLogRange(endTick, Version::V1), Keyspace::endEpochTickLogRange(epoch, Version::V1));
+    }
+    bool okRanges = db_rename(Keyspace::logRanges(endTick), endEpochLogRanges);
+    if (!okRanges && Keyspace::migrating()) okRanges = db_rename(Keyspace::logRanges(endTick, Version::V1), endEpochLogRanges);
+    g_recentLogRanges.erase(endTick);
+    return ok && okRanges;
+}
+
 bool db_insert_u32(const std::string key, uint32_t value) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        g_redis->set(key, std::to_string(value));
+        g_hot->set(key, std::to_string(value));
         return true;
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_insert_u32: {}\n", e.what());
         return false;
     }
@@ -1221,25 +1778,25 @@ bool db_insert_u32(const std::string key, uint32_t value) {
 
 
 bool db_key_exists(const std::string &key) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        return g_redis->exists(key);
-    } catch (const sw::redis::Error &e) {
+        return g_hot->exists(key);
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_key_exists: {}\n", e.what());
         return false;
     }
 }
 
 bool db_get_u32(const std::string key, uint32_t &value) {
-    if (!g_redis) return false;
+    if (!g_hot) return false;
     try {
-        auto val = g_redis->get(key);
+        auto val = g_hot->get(key);
         if (!val) {
             return false;
         }
         value = static_cast<uint32_t>(std::stoul(*val));
         return true;
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_get_u32: {}\n", e.what());
         return false;
     } catch (const std::logic_error &e) {
@@ -1253,9 +1810,7 @@ bool db_try_get_tick_data(uint32_t tick, TickData& data)
     if (db_get_tick_data(tick, data)) {
         return true;
     }
-    FullTickStruct full;
-    if (db_get_vtick_from_kvrocks(tick, full)) {
-        data = full.td;
+    if (db_get_vtick_data_from_kvrocks(tick, data)) {
         return true;
     }
     memset((void*)&data, 0, sizeof(TickData));
@@ -1268,144 +1823,215 @@ std::vector<TickVote> db_try_get_tick_vote(uint32_t tick)
     if (!result.empty()) {
         return result;
     }
-    FullTickStruct full;
-    if (db_get_vtick_from_kvrocks(tick, full)) {
-        for (int i = 0; i < 676; i++) if (full.tv[i].tick == tick) result.push_back(full.tv[i]);
-        return result;
+    std::vector<TickVote> votes;
+    if (db_get_vtick_votes_from_kvrocks(tick, votes)) {
+        for (const auto& vote : votes) if (vote.tick == tick) result.push_back(vote);
     }
     return result;
 }
 
+bool db_try_get_tick_vote(uint32_t tick, uint16_t computorIndex, TickVote& vote)
+{
+    if (db_get_tick_vote(tick, computorIndex, vote)) {
+        return true;
+    }
+    return db_get_vtick_vote_from_kvrocks(tick, computorIndex, vote) && vote.tick == tick;
+}
+
 bool db_move_log_to_kvrocks(uint16_t epoch, uint64_t logId) {
-    if (!g_redis || !g_kvrocks) return false;
+    if (!g_hot || !g_cold) return false;
 
     try {
-        const std::string key = "log:" + std::to_string(epoch) + ":" + std::to_string(logId);
+        const std::string key = Keyspace::log(epoch, logId);
 
-        if (!g_redis->exists(key)) return false;
         // Read log data from KeyDB
-        auto val = g_redis->get(key);
+        auto val = getKey(*g_hot, key, [&] { return Keyspace::log(epoch, logId, Version::V1); });
         if (!val) {
             return false; // nothing to migrate for this log
         }
 
         // Write to Kvrocks
-        sw::redis::StringView view(val->data(), val->size());
-        g_kvrocks->set(key, view, std::chrono::seconds(gKvrocksTTL));
+        std::string_view view(val->data(), val->size());
+        g_cold->set(key, view, std::chrono::seconds(gKvrocksTTL));
 
         return true;
-    } catch (const sw::redis::Error &e) {
+    } catch (const StorageError &e) {
         Logger::get()->error("Redis error in db_migrate_log: {}\n", e.what());
         return false;
     }
 }
 
-bool db_move_logs_to_kvrocks_by_range(uint16_t epoch, long long fromLogId, long long toLogId) {
-    if (!g_redis || !g_kvrocks || fromLogId < 0 || toLogId < fromLogId) return false;
-
+// Appends the logs of a range to the epoch's log segment, reading them from KeyDB in batches.
+static bool moveLogsToSegment(uint16_t epoch, long long fromLogId, long long toLogId)
+{
     try {
-        bool success = true;
-        for (long long logId = fromLogId; logId <= toLogId; logId++) {
-            if (!db_move_log_to_kvrocks(epoch, logId)) {
-                Logger::get()->warn("Failed to migrate log {}:{}", epoch, logId);
-                success = false;
+        const long long batch = static_cast<long long>(kBulkBatch);
+        std::vector<std::string> keys;
+        std::vector<StorageBackend::OptionalString> values;
+        std::vector<LogSegmentStore::Record> records;
+        long long missing = 0;
+        for (long long off = fromLogId; off <= toLogId; off += batch) {
+            const long long end = std::min(toLogId, off + batch - 1);
+            keys.clear();
+            for (long long logId = off; logId <= end; logId++) keys.push_back(Keyspace::log(epoch, logId));
+            mgetKeys(*g_hot, keys, values, [&](size_t i) { return Keyspace::log(epoch, off + i, Version::V1); });
+            records.clear();
+            for (size_t i = 0; i < values.size(); i++) {
+                if (!values[i]) {
+                    missing++;
+                    continue;
+                }
+                records.push_back({static_cast<uint64_t>(off) + i, *values[i]});
             }
+            if (!g_logSegments->append(epoch, records)) return false;
         }
-        return success;
-    } catch (const std::exception &e) {
-        Logger::get()->error("Error in db_migrate_logs_by_range: {}\n", e.what());
+        if (missing) {
+            Logger::get()->warn("Failed to migrate {} logs of {}:[{}, {}]: not in KeyDB", missing, epoch, fromLogId, toLogId);
+        }
+        return true;
+    } catch (const StorageError &e) {
+        Logger::get()->error("Redis error in db_move_logs_to_kvrocks_by_range: {}\n", e.what());
         return false;
     }
 }
 
-// Insert FullTickStruct compressed with zstd under key "vtick:<tick>"
-bool db_insert_vtick_to_kvrocks(uint32_t tick, const FullTickStruct& fullTick)
-{
-    if (!g_kvrocks) return false;
-    try {
-        const size_t srcSize = sizeof(FullTickStruct);
-        const size_t maxCompressed = ZSTD_compressBound(srcSize);
-
-        std::string compressed;
-        compressed.resize(maxCompressed);
-
-        size_t const cSize = ZSTD_compress(
-                compressed.data(),
-                compressed.size(),
-                reinterpret_cast<const void*>(&fullTick),
-                srcSize,
-                ZSTD_defaultCLevel()
-        );
+bool db_move_logs_to_kvrocks_by_range(uint16_t epoch, long long fromLogId, long long toLogId) {
+    if (!g_hot || fromLogId < 0 || toLogId < fromLogId) return false;
+    if (g_logSegments) return moveLogsToSegment(epoch, fromLogId, toLogId);
+    if (!g_cold) return false;
 
-        if (ZSTD_isError(cSize)) {
-            Logger::get()->error("ZSTD_compress error in db_insert_vtick: %s",
-                                 ZSTD_getErrorName(cSize));
-            return false;
+    try {
+        std::vector<std::string> keys;
+        for (long long logId = fromLogId; logId <= toLogId; logId++) keys.push_back(Keyspace::log(epoch, logId));
+        const size_t missing = copyHotKeysToKvrocks(keys, [&](size_t i) {
+            return Keyspace::log(epoch, fromLogId + i, Version::V1);
+        });
+        if (missing) {
+            Logger::get()->warn("Failed to migrate {} logs of {}:[{}, {}]: not in KeyDB", missing, epoch, fromLogId, toLogId);
         }
-
-        // shrink to actual compressed size
-        compressed.resize(cSize);
-
-        const std::string key = "vtick:" + std::to_string(tick);
-        sw::redis::StringView val(compressed.data(), compressed.size());
-        g_kvrocks->set(key, val, std::chrono::seconds(gKvrocksTTL));
         return true;
-    } catch (const sw::redis::Error& e) {
-        Logger::get()->error("KVROCKS error in db_insert_vtick: %s\n", e.what());
+    } catch (const StorageError &e) {
+        Logger::get()->error("Redis error in db_move_logs_to_kvrocks_by_range: {}\n", e.what());
         return false;
     }
 }
 
+// Trains a vtick dictionary from the recently compressed ticks and stores it before using it,
+// so every blob compressed with it can be read back.
+static void trainVtickDictionary()
+{
+    const std::string dict = g_vtickCodec.trainDictionary();
+    if (dict.empty()) {
+        Logger::get()->warn("Failed to train a vtick dictionary, keeping the current one");
+        return;
+    }
+    const uint32_t id = ZDICT_getDictID(dict.data(), dict.size());
+    try {
+        g_cold->set("vtick_dict:" + std::to_string(id), dict);
+        g_cold->set("vtick_dict:current", std::to_string(id));
+    } catch (const StorageError& e) {
+        Logger::get()->error("KVROCKS error while storing vtick dictionary {}: {}", id, e.what());
+        return;
+    }
+    g_vtickCodec.useDictionary(dict);
+    Logger::get()->info("Trained vtick dictionary {} ({} bytes)", id, dict.size());
+}
 
+// Points the codec at the cold tier's dictionaries and loads the current one.
+static void loadVtickDictionary()
+{
+    g_vtickCodec.setSampling(gVtickDictionary);
+    g_vtickCodec.setDictionaryLoader([](uint32_t id) -> std::optional<std::string> {
+        if (!g_cold) return std::nullopt;
+        try {
+            return g_cold->get("vtick_dict:" + std::to_string(id));
+        } catch (const StorageError& e) {
+            Logger::get()->error("KVROCKS error while loading vtick dictionary {}: {}", id, e.what());
+            return std::nullopt;
+        }
+    });
+    if (!gVtickDictionary) return;
+    try {
+        auto current = g_cold->get("vtick_dict:current");
+        if (!current) return;
+        auto dict = g_cold->get("vtick_dict:" + *current);
+        if (dict && g_vtickCodec.useDictionary(*dict)) {
+            Logger::get()->info("Loaded vtick dictionary {}", *current);
+        }
+    } catch (const StorageError& e) {
+        Logger::get()->error("KVROCKS error while loading the vtick dictionary: {}", e.what());
+    }
+}
 
-bool db_get_vtick_from_kvrocks(uint32_t tick, FullTickStruct& outFullTick)
+// Insert FullTickStruct compressed with zstd under key "vtick:<tick>" (see VtickCodec.h for the format)
+bool db_insert_vtick_to_kvrocks(uint32_t tick, const FullTickStruct& fullTick)
 {
-    if (!g_kvrocks) return false;
+    if (!g_cold) return false;
     try {
-        const std::string key = "vtick:" + std::to_string(tick);
-        auto val = g_kvrocks->get(key);
-        if (!val) {
+        std::string compressed;
+        if (!g_vtickCodec.encode(fullTick, gVtickCompressionLevel, compressed)) {
+            Logger::get()->error("Failed to compress vtick {}", tick);
             return false;
         }
+        g_cold->set(Keyspace::vtick(tick), compressed, std::chrono::seconds(gKvrocksTTL));
+    } catch (const StorageError& e) {
+        Logger::get()->error("KVROCKS error in db_insert_vtick: {}\n", e.what());
+        return false;
+    }
+    if (g_vtickCodec.shouldTrain()) trainVtickDictionary();
+    return true;
+}
 
-        const size_t dstSize = sizeof(FullTickStruct);
-        size_t const dSize = ZSTD_decompress(
-                reinterpret_cast<void*>(&outFullTick),
-                dstSize,
-                val->data(),
-                val->size()
-        );
-
-        if (ZSTD_isError(dSize)) {
-            Logger::get()->error("ZSTD_decompress error in db_get_vtick: %s",
-                                 ZSTD_getErrorName(dSize));
+// Fetches vtick:<tick> and hands it to decode, which decompresses the part it needs.
+template <typename Decode>
+static bool getVtick(uint32_t tick, Decode&& decode)
+{
+    if (!g_cold) return false;
+    try {
+        auto val = getKey(*g_cold, Keyspace::vtick(tick), [&] { return Keyspace::vtick(tick, Version::V1); });
+        if (!val) {
             return false;
         }
-
-        if (dSize != dstSize) {
-            Logger::get()->warn("Decompressed FullTickStruct size mismatch for key %s: got %zu, expected %zu",
-                                key.c_str(), dSize, dstSize);
+        if (!decode(std::string_view(*val))) {
+            Logger::get()->error("Failed to decompress vtick:{} ({} bytes)", tick, val->size());
             return false;
         }
         return true;
-    } catch (const sw::redis::Error& e) {
-        Logger::get()->error("KVROCKs error in db_get_vtick: %s\n", e.what());
+    } catch (const StorageError& e) {
+        Logger::get()->error("KVROCKs error in db_get_vtick: {}\n", e.what());
         return false;
     }
 }
 
+bool db_get_vtick_from_kvrocks(uint32_t tick, FullTickStruct& outFullTick)
+{
+    return getVtick(tick, [&](std::string_view blob) { return g_vtickCodec.decode(blob, outFullTick); });
+}
+
+bool db_get_vtick_data_from_kvrocks(uint32_t tick, TickData& outData)
+{
+    return getVtick(tick, [&](std::string_view blob) { return g_vtickCodec.decodeTickData(blob, outData); });
+}
+
+bool db_get_vtick_vote_from_kvrocks(uint32_t tick, uint16_t computorIndex, TickVote& outVote)
+{
+    return getVtick(tick, [&](std::string_view blob) {
+        return g_vtickCodec.decodeVote(blob, computorIndex, outVote);
+    });
+}
+
+bool db_get_vtick_votes_from_kvrocks(uint32_t tick, std::vector<TickVote>& outVotes)
+{
+    return getVtick(tick, [&](std::string_view blob) { return g_vtickCodec.decodeVotes(blob, outVotes); });
+}
+
 bool db_insert_TickLogRange_to_kvrocks(uint32_t tick, long long& logStart, long long& logLen)
 {
-    if (!g_kvrocks) return false;
-    try {
-        std::string key_summary = "tick_log_range:" + std::to_string(tick);
-        std::unordered_map<std::string, std::string> fields;
-        fields["fromLogId"] = std::to_string(logStart);
-        fields["length"] = std::to_string(logLen);
-        g_kvrocks->hmset(key_summary, fields.begin(), fields.end());
-        g_kvrocks->expire(key_summary, std::chrono::seconds(gKvrocksTTL));
+    if (!g_cold) return false;
+    try {
+        setLogRange(*g_cold, Keyspace::tickLogRange(tick), logStart, logLen, std::chrono::seconds(gKvrocksTTL));
         return true;
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("KVROCKS error in db_insert_TickLogRange_to_kvrocks: %s\n", e.what());
         return false;
     }
@@ -1415,7 +2041,7 @@ bool db_insert_TickLogRange_to_kvrocks(uint32_t tick, long long& logStart, long
 // Compress and insert ResponseAllLogIdRangesFromTick under key "cLogRange:<tick>"
 bool db_insert_cLogRange_to_kvrocks(uint32_t tick, const LogRangesPerTxInTick& logRange)
 {
-    if (!g_kvrocks) return false;
+    if (!g_cold) return false;
     try {
         const size_t srcSize = sizeof(LogRangesPerTxInTick);
         const size_t maxCompressed = ZSTD_compressBound(srcSize);
@@ -1439,11 +2065,10 @@ bool db_insert_cLogRange_to_kvrocks(uint32_t tick, const LogRangesPerTxInTick& l
 
         compressed.resize(cSize);
 
-        const std::string key = "cLogRange:" + std::to_string(tick);
-        sw::redis::StringView val(compressed.data(), compressed.size());
-        g_kvrocks->set(key, val, std::chrono::seconds(gKvrocksTTL));
+        std::string_view val(compressed.data(), compressed.size());
+        g_cold->set(Keyspace::cLogRange(tick), val, std::chrono::seconds(gKvrocksTTL));
         return true;
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("KVROCKS error in db_insert_cLogRange_to_kvrocks: %s\n", e.what());
         return false;
     }
@@ -1452,10 +2077,9 @@ bool db_insert_cLogRange_to_kvrocks(uint32_t tick, const LogRangesPerTxInTick& l
 // Get and decompress ResponseAllLogIdRangesFromTick stored at "cLogRange:<tick>"
 bool db_get_cLogRange_from_kvrocks(uint32_t tick, LogRangesPerTxInTick& outLogRange)
 {
-    if (!g_kvrocks) return false;
+    if (!g_cold) return false;
     try {
-        const std::string key = "cLogRange:" + std::to_string(tick);
-        auto val = g_kvrocks->get(key);
+        auto val = getKey(*g_cold, Keyspace::cLogRange(tick), [&] { return Keyspace::cLogRange(tick, Version::V1); });
         if (!val) {
             return false;
         }
@@ -1475,12 +2099,12 @@ bool db_get_cLogRange_from_kvrocks(uint32_t tick, LogRangesPerTxInTick& outLogRa
         }
 
         if (dSize != dstSize) {
-            Logger::get()->warn("Decompressed ResponseAllLogIdRangesFromTick size mismatch for key %s: got %zu, expected %zu",
-                                key.c_str(), dSize, dstSize);
+            Logger::get()->warn("Decompressed ResponseAllLogIdRangesFromTick size mismatch for tick %u: got %zu, expected %zu",
+                                tick, dSize, dstSize);
             return false;
         }
         return true;
-    } catch (const sw::redis::Error& e) {
+    } catch (const StorageError& e) {
         Logger::get()->error("KVROCKS error in db_get_cLogRange_from_kvrocks: %s\n", e.what());
         return false;
     }
@@ -1489,7 +2113,7 @@ bool db_get_cLogRange_from_kvrocks(uint32_t tick, LogRangesPerTxInTick& outLogRa
 
 
 void db_kvrocks_connect(const std::string &connectionString) {
-    if (g_kvrocks) {
+    if (g_cold) {
         Logger::get()->info("Kvrocks connection already open.\n");
         return;
     }
@@ -1501,18 +2125,38 @@ void db_kvrocks_connect(const std::string &connectionString) {
             uri_with_pool += "&pool_size=32";
         }
 
-        g_kvrocks = std::make_unique<sw::redis::Redis>(uri_with_pool);
-        g_kvrocks->ping();
-    } catch (const sw::redis::Error &e) {
-        g_kvrocks.reset();
+        g_cold = std::make_unique<RedisBackend>(uri_with_pool);
+    } catch (const StorageError &e) {
+        g_cold.reset();
         throw std::runtime_error("Cannot connect to Kvrocks: " + std::string(e.what()));
         exit(1);
     }
     Logger::get()->trace("Connected to Kvrocks!");
+    loadVtickDictionary();
 }
 
 void db_kvrocks_close() {
-    g_kvrocks.reset();
+    g_cold.reset();
     Logger::get()->info("Closed kvrocks DB connections");
 }
 
+void db_open_log_segments(const std::string& directory) {
+    if (g_logSegments) return;
+    g_logSegments = std::make_unique<LogSegmentStore>(directory, std::chrono::seconds(gKvrocksTTL));
+    Logger::get()->info("Opened log segments in {}", directory);
+}
+
+void db_close_log_segments() {
+    g_logSegments.reset();
+}
+
+void db_kvrocks_open_embedded(const std::string& directory) {
+    if (g_cold) {
+        Logger::get()->info("Kvrocks connection already open.\n");
+        return;
+    }
+    g_cold = openEmbedded(directory, "cold.log", true);
+    Logger::get()->trace("Opened embedded cold storage!");
+    loadVtickDictionary();
+}
+
@@ -5,15 +5,20 @@
  - Provides a narrow, implementation-agnostic interface for persisting and retrieving
    TickVotes, TickData, transactions, and log events.
  - Encapsulates connection lifecycle management to Redis.
+ - All access goes through a StorageBackend (database/StorageBackend.h): RedisBackend for KeyDB/kvrocks,
+   or EmbeddedBackend when bob runs without external services (storage-backend "embedded").
 
  Keyspace conventions (conceptual)
  - tick_vote:{tick}:{computorIndex}:{hash}        -> binary TickVote
+ - tick_votes:{tick}                              -> the votes of a verified tick packed together (PackedTickVotes.h)
  - tick_data:{tick}:{computorIndex}:{hash}        -> binary TickData
  - transaction:{tick}:{hash}                      -> binary Transaction (or envelope)
  - log:{epoch}:{tick}:{txHash}:{type}:{logId}:{hash} -> binary log content
  - log_range:{tick}:{txId}                        -> from/length pair (per-tx in a tick)
  - db_status                                      -> latest overall tick/epoch, latest event tick/epoch
  - db_status:epoch:{epoch}                        -> per-epoch fields such as latest_log_id, latest_verified_tick
+ - The names above are the v1 keyspace; a v2 database stores the per-tick, log, transaction and indexer keys
+   under compact binary names built by Keyspace.h (db_status field keyspace_version).
 
  Binary layout and endianness
  - All structs are written and read as-is (host byte order, little-endian on typical targets). Consumers must
@@ -37,6 +42,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <cstdint>
 #include <memory>
@@ -45,8 +51,7 @@
 #include "structs.h"
 #include "Logger.h"
 #include "LogEvent.h"
-// Forward declaration for the Redis client
-namespace sw { namespace redis { class Redis; }}
+#include "StateJournal.h"
 
 // Placeholder definitions for constants from structs.h
 #define SIGNATURE_SIZE 64
@@ -56,15 +61,46 @@ namespace sw { namespace redis { class Redis; }}
 
 // ---- Database Interface ----
 
+// Which KeyDB connection pool the calling thread uses. Ingest is the default; the verifier, indexer and
+// cleaners tag themselves Background and the REST/request handlers Api.
+enum class DbWorkload : uint8_t
+{
+    Ingest = 0,
+    Background = 1,
+    Api = 2,
+};
+
+/**
+ * Sets the workload class of the calling thread (see DbWorkload).
+ *
+ * Notes
+ * - Only routes KeyDB calls; the embedded engine serves every class from one store.
+ */
+void db_set_thread_workload(DbWorkload workload);
+
+struct DbPoolOptions
+{
+    unsigned ingestPoolSize = 32;
+    unsigned backgroundPoolSize = 16;
+    unsigned apiPoolSize = 16;
+    // KeyDB replica for API reads; empty reads from the primary
+    std::string replicaUrl;
+    // API reads go to the replica only while its latest_verified_tick is at most this far behind the primary
+    long long replicaMaxLagTicks = 5;
+};
+
 /**
  * Connects to the Redis server and prepares the DB layer for use.
  *
  * Notes
  * - Safe to call multiple times; subsequent calls are no-ops if already connected.
  *
+ * - Each workload class gets its own connection pool (see DbPoolOptions).
+ *
  * Parameters
  * - connectionString: Redis (or KeyDB) URI. Example: "tcp://127.0.0.1:6379"
- *   Implementation may append connection options (e.g., pool sizing).
+ *   The pool size of each workload class is appended as the `pool_size` option.
+ * - pools: pool sizes and the optional replica for API reads.
  *
  * Return Value
  * - None
@@ -72,7 +108,7 @@ namespace sw { namespace redis { class Redis; }}
  * Throws
  * - std::runtime_error on connection or authentication failure.
  */
-void db_connect(const std::string& connectionString);
+void db_connect(const std::string& connectionString, const DbPoolOptions& pools = {});
 
 /**
  * Closes the Redis connection and releases any associated resources.
@@ -85,6 +121,27 @@ void db_connect(const std::string& connectionString);
  */
 void db_close();
 
+/**
+ * Opens the embedded storage engine instead of connecting to KeyDB.
+ *
+ * Parameters
+ * - directory: where the engine keeps hot.log; created if missing.
+ *
+ * Throws
+ * - std::runtime_error if the directory or the log file cannot be opened.
+ */
+void db_open_embedded(const std::string& directory);
+
+/**
+ * Re-reads the keyspace version and migration flag from db_status (see Keyspace.h) and acknowledges them.
+ * db_connect and db_open_embedded load them once; bob calls this periodically so that it follows
+ * migrator/migrator.cpp while running.
+ *
+ * Return Value
+ * - true on success; false if not connected or on a Redis error.
+ */
+bool db_refresh_keyspace();
+
 // ---- Insertion Functions ----
 
 /**
@@ -304,6 +361,28 @@ bool db_update_latest_verified_tick(uint32_t tick);
  */
 long long db_get_latest_verified_tick();
 
+/**
+ * Monotonic status fields of a batch; a field left at -1 is not touched.
+ */
+struct StatusCommit
+{
+    uint16_t epoch = 0;
+    long long latestTick = -1;         // db_status latest_tick, with latest_epoch = epoch
+    long long latestVerifiedTick = -1; // db_status latest_verified_tick
+    long long lastIndexedTick = -1;    // db_status last_indexed_tick
+    long long latestLogId = -1;        // db_status:epoch:{epoch} latest_log_id
+};
+
+/**
+ * Updates the set fields of a StatusCommit atomically in one round trip, each one only if it grows.
+ * Every monotonic status write goes through here; the db_update_* functions above commit one field.
+ *
+ * Return Value
+ * - true on success
+ * - false on failure
+ */
+bool db_commit_status(const StatusCommit& commit);
+
 /**
  * Count the number of votes for a given tick.
  *
@@ -411,6 +490,11 @@ bool db_delete_log_ranges(uint32_t tick);
 bool db_delete_tick_data(uint32_t tick);
 
 bool db_delete_tick_vote(uint32_t tick);
+// Packs the votes of each verified tick of [fromTick, toTick] into tick_votes:<tick> and drops their
+// tick_vote:<tick>:<computorIndex> keys. The vote getters read both forms.
+bool db_pack_tick_votes(uint32_t fromTick, uint32_t toTick);
+// Deletes TickData and all TickVotes of [fromTick, toTick] with multi-key UNLINKs.
+bool db_delete_ticks(uint32_t fromTick, uint32_t toTick);
 
 // New: get aggregated log range for the whole tick (from key "...:-1")
 // Returns true on success; outputs fromLogId and length.
@@ -420,8 +504,13 @@ bool db_try_get_log_range_for_tick(uint32_t tick, long long& fromLogId, long lon
 bool db_insert_computors(const Computors& comps);
 bool db_get_computors(uint16_t epoch, Computors& comps);
 bool db_log_exists(uint16_t epoch, uint64_t logId);
+// Checks which logs in [fromLogId, fromLogId + count) exist using pipelined EXISTS (one round trip
+// per 1024 ids). exists[i] is 1 when log fromLogId + i is stored. Returns false on Redis error.
+bool db_check_logs_exist(uint16_t epoch, long long fromLogId, long long count, std::vector<uint8_t>& exists);
 
+// Looks in KeyDB, then the log segments, then kvrocks.
 bool db_try_get_log(uint16_t epoch, uint64_t logId, LogEvent &log);
+// Logs of [logIdStart, logIdEnd] in id order; ids not found anywhere are left out.
 std::vector<LogEvent> db_try_get_logs(uint16_t epoch, long long logIdStart, long long logIdEnd);
 
 long long db_get_last_indexed_tick();
@@ -457,6 +546,44 @@ bool db_get_indexed_tx(const char* tx_hash,
 
 bool db_add_indexer(const std::string &key, uint32_t tickNumber);
 
+// ---- State journal (historical balances) ----
+
+/**
+ * Persists journaled balance changes of verified ticks.
+ *
+ * Key Format
+ * - balance_history:{epoch}:{spectrumIndex}   (StateJournal::QU)
+ * - share_history:{epoch}:{universeIndex}     (StateJournal::SHARES)
+ *   Sorted sets scored by tick. Members are "{ordinal}:{oldValue}:{newValue}" with a zero-padded
+ *   ordinal, so the changes of one tick sort in the order they were made. Re-simulating a tick
+ *   writes identical members, so replays are idempotent.
+ * - state_history_keys:{epoch}
+ *   Sorted set of the history keys written in the epoch, member and score (kind << 32) | index.
+ *
+ * Return Value
+ * - true on success, false on Redis error.
+ */
+bool db_insert_state_deltas(uint16_t epoch, const std::vector<StateJournal::Delta>& deltas);
+
+/**
+ * Looks up the value of a journaled record at the end of a tick.
+ *
+ * Return Value
+ * - true if the journal decides the value: the new value of the last change at or before tick,
+ *   or else the old value of the first change after it.
+ * - false if the record has no persisted change in this epoch (or on Redis error).
+ */
+bool db_get_state_value_at_tick(uint16_t epoch, uint8_t kind, uint32_t index, uint32_t tick, long long& value);
+
+/**
+ * Deletes the balance_history and share_history keys of an epoch listed in its state_history_keys
+ * index, page by page, then the index itself.
+ *
+ * Return Value
+ * - true on success, false on Redis error or when stopFlag is set. Calling it again starts over.
+ */
+bool db_delete_state_history(uint16_t epoch, const std::atomic_bool& stopFlag);
+
 bool db_get_combined_log_range_for_ticks(uint32_t startTick, uint32_t endTick, long long &fromLogId, long long &length);
 
 std::vector<TickVote> db_try_to_get_votes(uint32_t tick);
@@ -467,6 +594,8 @@ std::vector<uint32_t> db_search_log(uint32_t scIndex, uint32_t scLogType, uint32
 bool db_insert_u32(const std::string key, uint32_t value);
 bool db_get_u32(const std::string key, uint32_t &value);
 bool db_rename(const std::string &key1, const std::string &key2);
+// Moves the log ranges of the virtual end-epoch tick to end_epoch:tick_log_range:<epoch> / end_epoch:log_ranges:<epoch>.
+bool db_rename_end_epoch_log_ranges(uint32_t endTick, uint16_t epoch);
 bool db_key_exists(const std::string &key);
 bool db_update_field(const std::string key, const std::string field, const std::string value);
 
@@ -480,23 +609,47 @@ bool db_get_end_epoch_log_range(uint16_t epoch, long long &fromLogId, long long
 void db_kvrocks_connect(const std::string &connectionString);
 
 // functions for persistant on disk layer
-void compressTickAndMoveToKVRocks(uint32_t tick);
+// Returns false if the tick could not be written to kvrocks (its raw data must then stay in KeyDB).
+bool compressTickAndMoveToKVRocks(uint32_t tick);
 bool cleanRawTick(uint32_t fromTick, uint32_t toTick, bool withTransactions);
-bool cleanTransactionLogs(uint32_t tick);
+// Moves (tx-storage-mode kvrocks) and deletes the transactions and logs of [fromTick, toTick], in bulk.
+// Nothing is deleted if a copy fails; returns false then, or if a delete fails.
+bool cleanTransactionLogs(uint32_t fromTick, uint32_t toTick);
 
 bool db_insert_vtick_to_kvrocks(uint32_t tick, const FullTickStruct& fullTick);
 bool db_get_vtick_from_kvrocks(uint32_t tick, FullTickStruct& outFullTick);
+// Parts of a vtick; ticks stored in the framed format only decompress the part asked for.
+bool db_get_vtick_data_from_kvrocks(uint32_t tick, TickData& outData);
+bool db_get_vtick_vote_from_kvrocks(uint32_t tick, uint16_t computorIndex, TickVote& outVote);
+// All 676 votes in computor order, including the empty ones.
+bool db_get_vtick_votes_from_kvrocks(uint32_t tick, std::vector<TickVote>& outVotes);
 
 std::vector<TickVote> db_try_get_tick_vote(uint32_t tick);
+// One vote of the tick, from KeyDB or else from its vtick.
+bool db_try_get_tick_vote(uint32_t tick, uint16_t computorIndex, TickVote& vote);
 
 void db_kvrocks_close();
+// Opens the embedded engine's cold tier (cold.log under directory) in place of kvrocks.
+void db_kvrocks_open_embedded(const std::string& directory);
 
 bool db_insert_cLogRange_to_kvrocks(uint32_t tick, const LogRangesPerTxInTick& logRange);
 bool db_insert_TickLogRange_to_kvrocks(uint32_t tick, long long& logStart, long long& logLen);
 bool db_get_cLogRange_from_kvrocks(uint32_t tick, LogRangesPerTxInTick& outLogRange);
 
 bool db_copy_transaction_to_kvrocks(const std::string &tx_hash);
+// Copies many transactions with MGET from KeyDB and pipelined SETs into kvrocks. The hashes must be computed
+// from tick data (getTransactionHash), their checksum is not checked.
+bool db_copy_transactions_to_kvrocks(const std::vector<std::string>& txHashes);
 
+// Moves logs to the cold tier: the epoch's log segment if db_open_log_segments was called, kvrocks otherwise.
+// Returns false if the cold tier could not be written; logs missing from KeyDB are logged and skipped.
 bool db_move_logs_to_kvrocks_by_range(uint16_t epoch, long long fromLogId, long long toLogId);
+// Opens the per-epoch log segment store under directory (see LogSegmentStore.h). From then on moved logs
+// go there instead of kvrocks, and log reads look there after KeyDB. Segments older than kvrocks_ttl are deleted.
+// Throws std::runtime_error if the directory cannot be created.
+void db_open_log_segments(const std::string& directory);
+void db_close_log_segments();
 bool db_delete_transaction(std::string hash);
+// Like db_copy_transactions_to_kvrocks, the hashes must be computed from tick data.
+bool db_delete_transactions(const std::vector<std::string>& hashes);
 bool db_delete_logs(uint16_t epoch, long long start, long long end);
\ No newline at end of file
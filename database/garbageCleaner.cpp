@@ -1,29 +1,51 @@
 #include "database/db.h"
 #include "shim.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
 static const std::string KEY_LAST_CLEAN_TICK_DATA = "garbage_cleaner:last_clean_tick_data";
 static const std::string KEY_LAST_CLEAN_TX_TICK = "garbage_cleaner:last_clean_tx_tick";
+static const std::string KEY_LAST_CLEAN_STATE_HISTORY_EPOCH = "garbage_cleaner:last_clean_state_history_epoch";
+// Ticks per migration batch, and batches processed at the same time (the KeyDB and kvrocks pools have 32 connections)
+static constexpr uint32_t TICKS_PER_BATCH = 32;
+static constexpr unsigned MIGRATION_WORKERS = 8;
+// A range that failed is retried from its first failed batch after this delay; at the end of the epoch it is
+// retried this many times before the data left in KeyDB is given up on
+static constexpr unsigned RETRY_DELAY_MS = 1000;
+static constexpr int END_EPOCH_ATTEMPTS = 5;
 
-bool cleanTransactionAndLogsAndSaveToDisk(TickData& td, LogRangesPerTxInTick& lr)
+// Runs fn(from, to) over [fromTick, toTick] cut into batches of TICKS_PER_BATCH, up to MIGRATION_WORKERS at a time.
+// fn returns false if its batch must be retried. Returns once every batch is done with the last tick up to which
+// every batch succeeded (fromTick - 1 if the first one failed), so the caller can then persist its progress marker.
+template <typename F>
+static long long forEachTickBatch(uint32_t fromTick, uint32_t toTick, F&& fn)
 {
-    for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
-    {
-        if (td.transactionDigests[i] != m256i::zero())
+    if (toTick < fromTick) return static_cast<long long>(fromTick) - 1;
+    const uint64_t batches = (uint64_t(toTick) - fromTick) / TICKS_PER_BATCH + 1;
+    std::vector<uint8_t> succeeded(batches, 0);
+    std::atomic<uint64_t> next{0};
+    auto worker = [&]() {
+        // thread_local: the spawned workers would otherwise use the ingest pool
+        db_set_thread_workload(DbWorkload::Background);
+        for (uint64_t b = next++; b < batches; b = next++)
         {
-            if (gTxStorageMode == TxStorageMode::Kvrocks) db_copy_transaction_to_kvrocks(td.transactionDigests[i].toQubicHash());
-
-            if (lr.fromLogId[i] > 0 && lr.length[i] > 0)
-            {
-                long long start = lr.fromLogId[i];
-                long long end = start + lr.length[i] - 1; // inclusive
-                if (gTxStorageMode == TxStorageMode::Kvrocks) db_move_logs_to_kvrocks_by_range(td.epoch, start, end);
-                db_delete_logs(td.epoch, start, end);
-            }
-            db_delete_transaction(td.transactionDigests[i].toQubicHash());
+            const uint32_t from = static_cast<uint32_t>(fromTick + b * TICKS_PER_BATCH);
+            const uint32_t to = static_cast<uint32_t>(std::min<uint64_t>(toTick, uint64_t(from) + TICKS_PER_BATCH - 1));
+            succeeded[b] = fn(from, to) ? 1 : 0;
         }
-    }
-    return true;
+    };
+    const unsigned workers = static_cast<unsigned>(std::min<uint64_t>(MIGRATION_WORKERS, batches));
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < workers; w++) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+    uint64_t done = 0;
+    while (done < batches && succeeded[done]) done++;
+    if (done == batches) return toTick;
+    return static_cast<long long>(fromTick) + static_cast<long long>(done * TICKS_PER_BATCH) - 1;
 }
-void compressTickAndMoveToKVRocks(uint32_t tick)
+
+bool compressTickAndMoveToKVRocks(uint32_t tick)
 {
     // Load TickData
     // Prepare the aggregated struct
@@ -52,67 +74,167 @@ void compressTickAndMoveToKVRocks(uint32_t tick)
         {
             Logger::get()->warn("Tick Data are deleted before being saved to disk, please check your KeyDB and bob config, make sure data is not evicted too early.");
             Logger::get()->warn("Failed to save tick {}", tick);
-            return;
+            // nothing left to save: retrying cannot bring the evicted data back
+            return true;
         }
     }
     // Insert the compressed record
     if (!db_insert_vtick_to_kvrocks(tick, full))
     {
         Logger::get()->error("compressTick: Failed to insert vtick for tick {}", tick);
-        return;
+        return false;
     }
     LogRangesPerTxInTick lr{};
-    if (db_try_get_log_ranges(tick, lr))
+    if (db_try_get_log_ranges(tick, lr) && !db_insert_cLogRange_to_kvrocks(tick, lr))
     {
-        db_insert_cLogRange_to_kvrocks(tick, lr);
+        Logger::get()->error("compressTick: Failed to insert the log ranges of tick {}", tick);
+        return false;
     }
     long long log_start, log_len;
-    if (db_try_get_log_range_for_tick(tick, log_start, log_len))
+    if (db_try_get_log_range_for_tick(tick, log_start, log_len) &&
+        !db_insert_TickLogRange_to_kvrocks(tick, log_start, log_len))
     {
-        db_insert_TickLogRange_to_kvrocks(tick, log_start, log_len);
+        Logger::get()->error("compressTick: Failed to insert the log range of tick {}", tick);
+        return false;
     }
     Logger::get()->trace("compressTick: Compressed tick {}", tick);
+    return true;
 }
 
-bool cleanTransactionLogs(uint32_t tick)
+bool cleanTransactionLogs(uint32_t fromTick, uint32_t toTick)
 {
-    TickData td{};
-    LogRangesPerTxInTick lr{};
-    if (!db_try_get_tick_data(tick, td))
+    struct LogSpan
     {
-        return false;
+        uint16_t epoch;
+        long long start;
+        long long end; // inclusive
+    };
+    std::vector<std::string> txHashes;
+    std::vector<LogSpan> spans;
+    std::vector<uint32_t> ticks;
+    for (uint32_t tick = fromTick; tick <= toTick; tick++)
+    {
+        TickData td{};
+        LogRangesPerTxInTick lr{};
+        if (!db_try_get_tick_data(tick, td))
+        {
+            continue;
+        }
+        if (!db_try_get_log_ranges(tick, lr))
+        {
+            Logger::get()->error("Failed to get log range for this tick {} - epoch {}", td.tick, td.epoch);
+            continue;
+        }
+        ticks.push_back(tick);
+        for (int i = 0; i < NUMBER_OF_TRANSACTIONS_PER_TICK; i++)
+        {
+            if (td.transactionDigests[i] == m256i::zero()) continue;
+            txHashes.push_back(td.transactionDigests[i].toQubicHash());
+            if (lr.fromLogId[i] > 0 && lr.length[i] > 0)
+            {
+                const long long start = lr.fromLogId[i];
+                const long long end = start + lr.length[i] - 1;
+                // logs of consecutive transactions follow each other: one range instead of one per transaction
+                if (!spans.empty() && spans.back().epoch == td.epoch && spans.back().end + 1 == start) spans.back().end = end;
+                else spans.push_back({td.epoch, start, end});
+            }
+        }
     }
-    if (!db_try_get_log_ranges(tick, lr))
+
+    // copy everything before deleting anything: a crash in between only repeats the copy
+    if (gTxStorageMode == TxStorageMode::Kvrocks)
     {
-        Logger::get()->error("Failed to get log range for this tick {} - epoch {}", td.tick, td.epoch);
-        return false;
+        bool copied = db_copy_transactions_to_kvrocks(txHashes);
+        for (const auto& span : spans)
+        {
+            copied = db_move_logs_to_kvrocks_by_range(span.epoch, span.start, span.end) && copied;
+        }
+        if (!copied)
+        {
+            Logger::get()->warn("cleanTransactionLogs: Failed to archive ticks {} to {}, keeping them in KeyDB", fromTick, toTick);
+            return false;
+        }
     }
-    db_delete_log_ranges(tick);
-    return cleanTransactionAndLogsAndSaveToDisk(td, lr);
+    bool deleted = true;
+    for (const auto& span : spans) deleted = db_delete_logs(span.epoch, span.start, span.end) && deleted;
+    deleted = db_delete_transactions(txHashes) && deleted;
+    for (uint32_t tick : ticks) deleted = db_delete_log_ranges(tick) && deleted;
+    return deleted;
 }
 
 bool cleanRawTick(uint32_t fromTick, uint32_t toTick, bool withTransactions)
 {
     Logger::get()->trace("Start cleaning raw tick data from {} to {}", fromTick, toTick);
-    for (uint32_t tick = fromTick; tick <= toTick; tick++)
-    {
-        if (withTransactions)
+    const long long done = forEachTickBatch(fromTick, toTick, [&](uint32_t from, uint32_t to) {
+        if (withTransactions && !cleanTransactionLogs(from, to))
         {
-            cleanTransactionLogs(tick);
+            return false;
         }
-        // Delete raw TickData
-        if (!db_delete_tick_data(tick))
+        // Delete raw TickData and all TickVotes (missing keys count as deleted)
+        if (!db_delete_ticks(from, to))
         {
-            Logger::get()->warn("cleanRawTick: Failed to delete TickData for tick {}", tick);
+            Logger::get()->warn("cleanRawTick: Failed to delete ticks {} to {}", from, to);
+            return false;
         }
-
-        // Delete all TickVotes for this tick (attempt all indices; API treats missing as success)
-        db_delete_tick_vote(tick);
-    }
+        return true;
+    });
+    if (done < toTick) return false;
     Logger::get()->trace("Cleaned raw tick data from {} to {}", fromTick, toTick);
     return true;
 }
 
+// Compresses [fromTick, toTick] into kvrocks, then deletes the raw ticks (and their transactions and logs if
+// withTransactions) from KeyDB. A batch is only deleted once all of its ticks have been compressed.
+// Returns the last tick up to which every batch was compressed and cleaned.
+static long long compressAndCleanTicks(uint32_t fromTick, uint32_t toTick, bool withTransactions)
+{
+    const long long done = forEachTickBatch(fromTick, toTick, [&](uint32_t from, uint32_t to) {
+        bool compressed = true;
+        for (uint32_t t = from; t <= to; t++)
+        {
+            compressed = compressTickAndMoveToKVRocks(t) && compressed;
+        }
+        if (!compressed)
+        {
+            Logger::get()->warn("compressAndCleanTicks: Failed to compress ticks {} to {}, keeping them in KeyDB", from, to);
+            return false;
+        }
+        if (withTransactions && !cleanTransactionLogs(from, to))
+        {
+            return false;
+        }
+        if (!db_delete_ticks(from, to))
+        {
+            Logger::get()->warn("compressAndCleanTicks: Failed to delete ticks {} to {}", from, to);
+            return false;
+        }
+        return true;
+    });
+    Logger::get()->trace("Compressed tick {}->{} to kvrocks and cleaned them in keydb", fromTick, done);
+    return done;
+}
+
+// Historical balances are only served for the current epoch: drops the balance_history/share_history keys
+// of the epochs before it. Without a marker only the previous epoch can have some left. Runs on its own
+// thread, next to the tick cleanup.
+static void cleanStateHistory(const std::atomic_bool& stopFlag)
+{
+    db_set_thread_workload(DbWorkload::Background);
+    const uint32_t epoch = gCurrentProcessingEpoch;
+    uint32_t cleaned = epoch >= 2 ? epoch - 2 : 0;
+    db_get_u32(KEY_LAST_CLEAN_STATE_HISTORY_EPOCH, cleaned);
+    for (uint32_t e = cleaned + 1; e < epoch; e++)
+    {
+        if (!db_delete_state_history(static_cast<uint16_t>(e), stopFlag))
+        {
+            if (!stopFlag.load()) Logger::get()->warn("Failed to delete the balance history of epoch {}, retrying on the next start", e);
+            return;
+        }
+        db_insert_u32(KEY_LAST_CLEAN_STATE_HISTORY_EPOCH, e);
+        Logger::get()->info("Deleted the balance history of epoch {}", e);
+    }
+}
+
 void garbageCleaner(std::atomic_bool& stopFlag)
 {
     Logger::get()->info("Start garbage cleaner");
@@ -147,6 +269,7 @@ void garbageCleaner(std::atomic_bool& stopFlag)
     if (lastCleanTickData < gInitialTick) lastCleanTickData = gInitialTick;
     if (lastCleanTransactionTick < gInitialTick) lastCleanTransactionTick = gInitialTick;
     uint32_t lastReportedTick = 0;
+    std::thread stateHistoryCleaner(cleanStateHistory, std::cref(stopFlag));
     while (!stopFlag.load())
     {
         SLEEP(100);
@@ -162,6 +285,10 @@ void garbageCleaner(std::atomic_bool& stopFlag)
                     lastCleanTickData = cleanToTick;
                     db_insert_u32(KEY_LAST_CLEAN_TICK_DATA, static_cast<uint32_t>(lastCleanTickData));
                 }
+                else
+                {
+                    SLEEP(RETRY_DELAY_MS);
+                }
 
                 if (cleanToTick - lastReportedTick > 1000)
                 {
@@ -175,17 +302,13 @@ void garbageCleaner(std::atomic_bool& stopFlag)
             long long cleanToTick = (long long)(gCurrentIndexingTick.load()) - 5;
             if (lastCleanTickData < cleanToTick)
             {
-                for (long long t = lastCleanTickData + 1; t <= cleanToTick; t++)
+                const long long done = compressAndCleanTicks(lastCleanTickData + 1, cleanToTick, false /*do not clean txs instantly*/);
+                if (done > lastCleanTickData)
                 {
-                    compressTickAndMoveToKVRocks(t);
-                }
-                Logger::get()->trace("Compressed tick {}->{} to kvrocks", lastCleanTickData + 1, cleanToTick);
-                if (cleanRawTick(lastCleanTickData + 1, cleanToTick, false /*do not clean txs instantly*/))
-                {
-                    lastCleanTickData = cleanToTick;
+                    lastCleanTickData = done;
                     db_insert_u32(KEY_LAST_CLEAN_TICK_DATA, static_cast<uint32_t>(lastCleanTickData));
                 }
-                Logger::get()->trace("Cleaned tick {}->{} in keydb", lastCleanTickData + 1, cleanToTick);
+                if (done < cleanToTick) SLEEP(RETRY_DELAY_MS);
                 if (cleanToTick - lastReportedTick > 1000)
                 {
                     Logger::get()->trace("Compressed and cleaned up to tick {}", cleanToTick);
@@ -200,26 +323,30 @@ void garbageCleaner(std::atomic_bool& stopFlag)
             cleanToTick = std::min(cleanToTick, (long long)(gCurrentIndexingTick) - 1 - gTxTickToLive);
             if (lastCleanTransactionTick < cleanToTick)
             {
-                for (long long t = lastCleanTransactionTick + 1; t <= cleanToTick; t++)
+                const long long done = forEachTickBatch(lastCleanTransactionTick + 1, cleanToTick, cleanTransactionLogs);
+                if (done > lastCleanTransactionTick)
                 {
-                    cleanTransactionLogs(t);
+                    lastCleanTransactionTick = done;
+                    db_insert_u32(KEY_LAST_CLEAN_TX_TICK, static_cast<uint32_t>(lastCleanTransactionTick));
                 }
-                lastCleanTransactionTick = cleanToTick;
-                db_insert_u32(KEY_LAST_CLEAN_TX_TICK, static_cast<uint32_t>(lastCleanTransactionTick));
+                if (done < cleanToTick) SLEEP(RETRY_DELAY_MS);
             }
         }
     }
+    stateHistoryCleaner.join();
     if (gIsEndEpoch)
     {
         Logger::get()->info("Garbage cleaner detected END EPOCH signal. Cleaning all data left on RAM");
         if (gTickStorageMode == TickStorageMode::LastNTick)
         {
             long long cleanToTick = (long long)(gCurrentIndexingTick.load()) - 1;
-            if (lastCleanTickData < cleanToTick)
+            for (int attempt = 0; attempt < END_EPOCH_ATTEMPTS && lastCleanTickData < cleanToTick; attempt++)
             {
+                if (attempt) SLEEP(RETRY_DELAY_MS);
                 if (cleanRawTick(lastCleanTickData + 1, cleanToTick, true))
                 {
                     Logger::get()->info("Cleaned all raw tick data");
+                    lastCleanTickData = cleanToTick;
                     db_insert_u32(KEY_LAST_CLEAN_TICK_DATA, static_cast<uint32_t>(cleanToTick));
                 }
             }
@@ -227,19 +354,18 @@ void garbageCleaner(std::atomic_bool& stopFlag)
         else if (gTickStorageMode == TickStorageMode::Kvrocks)
         {
             long long cleanToTick = (long long)(gCurrentIndexingTick.load()) - 1;
-            if (lastCleanTickData < cleanToTick)
+            for (int attempt = 0; attempt < END_EPOCH_ATTEMPTS && lastCleanTickData < cleanToTick; attempt++)
             {
-                for (long long t = lastCleanTickData + 1; t <= cleanToTick; t++)
-                {
-                    compressTickAndMoveToKVRocks(t);
-                }
-                Logger::get()->trace("Compressed tick {}->{} to kvrocks", lastCleanTickData + 1, cleanToTick);
-                if (cleanRawTick(lastCleanTickData + 1, cleanToTick, true))
+                if (attempt) SLEEP(RETRY_DELAY_MS);
+                const long long done = compressAndCleanTicks(lastCleanTickData + 1, cleanToTick, true);
+                if (done > lastCleanTickData)
                 {
-                    Logger::get()->info("Cleaned all raw tick data");
-                    db_insert_u32(KEY_LAST_CLEAN_TICK_DATA, static_cast<uint32_t>(cleanToTick));
+                    lastCleanTickData = done;
+                    db_insert_u32(KEY_LAST_CLEAN_TICK_DATA, static_cast<uint32_t>(lastCleanTickData));
                 }
             }
+            if (lastCleanTickData >= cleanToTick) Logger::get()->info("Cleaned all raw tick data");
+            else Logger::get()->error("Failed to clean ticks {} to {}, they stay in KeyDB", lastCleanTickData + 1, cleanToTick);
         }
     }
     Logger::get()->info("Exited garbage cleaner");
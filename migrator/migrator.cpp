@@ -0,0 +1,303 @@
+// Moves a bob database from the v1 keyspace to v2 (see database/Keyspace.h) while bob keeps running:
+//  1. sets keyspace_version=2 and keyspace_migrating=1 in db_status and waits until bob acknowledges them
+//     (from then on bob writes v2 names and reads the v1 name of a key that is not migrated yet)
+//  2. scans KeyDB and kvrocks for the v1 families and renames every key to its v2 name (RENAMENX keeps the
+//     TTL); tick_log_range hashes are rewritten as 16-byte values
+//  3. clears keyspace_migrating
+// The progress of each scan is saved in the hash keyspace_migration, so an interrupted run resumes.
+// Only KeyDB/kvrocks are supported: an embedded store that starts empty is created as v2.
+#include "database/Keyspace.h"
+#include "Logger.h"
+#include "sw/redis++/redis++.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr long long kScanCount = 1000;
+constexpr size_t kMaxQueuedBatches = 64;
+// Time for writes bob started before it switched to v2 to land, after the acknowledgement
+constexpr auto kGracePeriod = std::chrono::seconds(10);
+
+struct Family
+{
+    const char* pattern;
+    bool logRangeHash = false; // value is converted from the v1 hash
+    bool sortedSet = false;    // merged into the v2 set if bob has started one already
+};
+
+const std::vector<Family> kHotFamilies = {
+    {"log:*"}, {"log_ranges:*"}, {"tick_log_range:*", true}, {"end_epoch:tick_log_range:*", true},
+    {"tick_data:*"}, {"tick_vote:*"}, {"tick_votes:*"}, {"transaction:*"}, {"itx:*"}, {"indexed:*", false, true},
+};
+
+const std::vector<Family> kColdFamilies = {
+    {"log:*"}, {"transaction:*"}, {"vtick:*"}, {"tick_log_range:*", true}, {"cLogRange:*"},
+};
+
+struct Stats
+{
+    std::atomic<size_t> moved{0};
+    std::atomic<size_t> merged{0};  // the v2 key existed already; the v1 key was merged or dropped
+    std::atomic<size_t> skipped{0}; // not a key of the family
+};
+
+using Moves = std::vector<std::pair<std::string, std::string>>;
+
+void renameKeys(sw::redis::Redis& redis, const Family& family, const Moves& moves, Stats& stats)
+{
+    auto pipe = redis.pipeline(false);
+    for (const auto& m : moves) pipe.command("RENAMENX", m.first, m.second);
+    auto replies = pipe.exec();
+    std::vector<size_t> existing;
+    for (size_t i = 0; i < moves.size(); i++) {
+        try {
+            if (replies.get<long long>(i)) stats.moved++;
+            else existing.push_back(i);
+        } catch (const sw::redis::ReplyError&) {
+            // deleted by bob since the scan
+        }
+    }
+    if (existing.empty()) return;
+    // bob wrote the v2 key after the switch: strings are the same data, sets get the older members
+    auto fix = redis.pipeline(false);
+    for (size_t i : existing) {
+        const auto& m = moves[i];
+        if (family.sortedSet) fix.command("ZUNIONSTORE", m.second, "2", m.second, m.first, "AGGREGATE", "MAX");
+        fix.command("UNLINK", m.first);
+    }
+    fix.exec();
+    stats.merged += existing.size();
+}
+
+void convertLogRanges(sw::redis::Redis& redis, const Moves& moves, Stats& stats)
+{
+    auto pipe = redis.pipeline(false);
+    for (const auto& m : moves) pipe.command("HMGET", m.first, "fromLogId", "length").command("PTTL", m.first);
+    auto replies = pipe.exec();
+    auto writes = redis.pipeline(false);
+    size_t converted = 0;
+    for (size_t i = 0; i < moves.size(); i++) {
+        std::vector<sw::redis::OptionalString> vals;
+        long long ttl;
+        long long fromLogId, length;
+        try {
+            replies.get(2 * i, std::back_inserter(vals));
+            ttl = replies.get<long long>(2 * i + 1);
+            if (vals.size() != 2 || !vals[0] || !vals[1]) continue;
+            fromLogId = std::stoll(*vals[0]);
+            length = std::stoll(*vals[1]);
+        } catch (const sw::redis::ReplyError&) {
+            continue;
+        } catch (const std::logic_error&) {
+            stats.skipped++;
+            continue;
+        }
+        const std::string value = Keyspace::encodeLogRange(fromLogId, length);
+        if (ttl > 0) writes.command("SET", moves[i].second, value, "NX", "PX", std::to_string(ttl));
+        else writes.command("SET", moves[i].second, value, "NX");
+        writes.command("UNLINK", moves[i].first);
+        converted++;
+    }
+    if (converted) writes.exec();
+    stats.moved += converted;
+}
+
+void migrateBatch(sw::redis::Redis& redis, const Family& family, const std::vector<std::string>& keys, Stats& stats)
+{
+    Moves moves;
+    moves.reserve(keys.size());
+    for (const auto& key : keys) {
+        auto v2 = Keyspace::toV2(key);
+        if (!v2) {
+            stats.skipped++;
+            continue;
+        }
+        moves.emplace_back(key, std::move(*v2));
+    }
+    if (moves.empty()) return;
+    if (family.logRangeHash) convertLogRanges(redis, moves, stats);
+    else renameKeys(redis, family, moves, stats);
+}
+
+struct Batch
+{
+    size_t seq;
+    long long cursorAfter;
+    std::vector<std::string> keys;
+};
+
+// Scans one family of a store with SCAN MATCH and migrates the pages on worker threads. The saved cursor
+// is the one after the last page that, with all pages before it, is done.
+bool migrateFamily(sw::redis::Redis& redis, sw::redis::Redis& progress, const std::string& store,
+                   const Family& family, int threads, Stats& stats)
+{
+    const std::string field = store + ":" + family.pattern;
+    auto saved = progress.hget("keyspace_migration", field);
+    if (saved && *saved == "done") return true;
+    long long cursor = saved ? std::stoll(*saved) : 0;
+    std::cout << "Migrating " << store << " " << family.pattern
+              << (cursor ? " (resuming at cursor " + std::to_string(cursor) + ")" : "") << std::endl;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Batch> queue;
+    std::map<size_t, long long> finished; // seq -> cursorAfter of pages done out of order
+    size_t nextToSave = 0;
+    bool scanning = true;
+    std::atomic<bool> failed{false};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            while (true) {
+                Batch batch;
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    cv.wait(lock, [&] { return !queue.empty() || !scanning; });
+                    if (queue.empty()) return;
+                    batch = std::move(queue.front());
+                    queue.pop_front();
+                }
+                cv.notify_all();
+                try {
+                    migrateBatch(redis, family, batch.keys, stats);
+                } catch (const sw::redis::Error& e) {
+                    Logger::get()->error("Failed to migrate a batch of {} {}: {}", store, family.pattern, e.what());
+                    failed = true;
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(mtx);
+                finished[batch.seq] = batch.cursorAfter;
+                long long done = -1;
+                while (!finished.empty() && finished.begin()->first == nextToSave) {
+                    done = finished.begin()->second;
+                    finished.erase(finished.begin());
+                    nextToSave++;
+                }
+                if (done <= 0 || failed) continue;
+                try {
+                    progress.hset("keyspace_migration", field, std::to_string(done));
+                } catch (const sw::redis::Error& e) {
+                    Logger::get()->warn("Failed to save the progress of {} {}: {}", store, family.pattern, e.what());
+                }
+            }
+        });
+    }
+
+    size_t seq = 0;
+    try {
+        do {
+            Batch batch;
+            cursor = redis.scan(cursor, family.pattern, kScanCount, std::back_inserter(batch.keys));
+            batch.seq = seq++;
+            batch.cursorAfter = cursor;
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&] { return queue.size() < kMaxQueuedBatches || failed; });
+            queue.push_back(std::move(batch));
+            cv.notify_all();
+        } while (cursor != 0 && !failed);
+    } catch (const sw::redis::Error& e) {
+        Logger::get()->error("Failed to scan {} {}: {}", store, family.pattern, e.what());
+        failed = true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        scanning = false;
+    }
+    cv.notify_all();
+    for (auto& w : workers) w.join();
+    if (failed) return false;
+    progress.hset("keyspace_migration", field, "done");
+    return true;
+}
+
+std::string getStatus(sw::redis::Redis& keydb, const std::string& field)
+{
+    auto val = keydb.hget("db_status", field);
+    return val ? *val : "";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <keydb_address> [kvrocks_address|-] [threads] [--no-wait]" << std::endl;
+        std::cerr << "Example: " << argv[0] << " tcp://127.0.0.1:6379 tcp://127.0.0.1:6666 8" << std::endl;
+        std::cerr << "--no-wait: do not wait for bob to acknowledge the switch (bob is stopped)" << std::endl;
+        return 1;
+    }
+    Logger::init("info");
+    std::vector<std::string> args;
+    bool wait = true;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--no-wait") wait = false;
+        else args.emplace_back(argv[i]);
+    }
+    const std::string keydbAddress = args[0];
+    const std::string kvrocksAddress = args.size() > 1 ? args[1] : "-";
+    int threads = 8;
+    try {
+        if (args.size() > 2) threads = std::max(1, std::stoi(args[2]));
+    } catch (...) {
+        std::cerr << "Invalid arguments" << std::endl;
+        return 1;
+    }
+
+    try {
+        sw::redis::ConnectionPoolOptions pool;
+        pool.size = threads + 1;
+        sw::redis::Redis keydb(sw::redis::ConnectionOptions(keydbAddress), pool);
+        std::unique_ptr<sw::redis::Redis> kvrocks;
+        if (kvrocksAddress != "-") {
+            kvrocks = std::make_unique<sw::redis::Redis>(sw::redis::ConnectionOptions(kvrocksAddress), pool);
+        }
+
+        if (getStatus(keydb, "keyspace_version") == "2" && getStatus(keydb, "keyspace_migrating") != "1") {
+            std::cout << "The database already uses the v2 keyspace" << std::endl;
+            return 0;
+        }
+        keydb.hset("db_status", "keyspace_version", "2");
+        keydb.hset("db_status", "keyspace_migrating", "1");
+        if (wait) {
+            std::cout << "Waiting for bob to switch to the v2 keyspace..." << std::endl;
+            while (getStatus(keydb, "keyspace_ack") != "2") std::this_thread::sleep_for(std::chrono::seconds(1));
+            std::this_thread::sleep_for(kGracePeriod);
+        }
+
+        Stats stats;
+        bool ok = true;
+        for (const auto& family : kHotFamilies) {
+            ok = ok && migrateFamily(keydb, keydb, "keydb", family, threads, stats);
+        }
+        for (const auto& family : kColdFamilies) {
+            if (!kvrocks) break;
+            ok = ok && migrateFamily(*kvrocks, keydb, "kvrocks", family, threads, stats);
+        }
+        std::cout << "Moved " << stats.moved << " keys, merged " << stats.merged << ", skipped " << stats.skipped
+                  << std::endl;
+        if (!ok) {
+            std::cerr << "Migration incomplete; run the migrator again to resume" << std::endl;
+            return 1;
+        }
+        keydb.hset("db_status", "keyspace_migrating", "0");
+        keydb.del("keyspace_migration");
+        std::cout << "Migration to the v2 keyspace done" << std::endl;
+    } catch (const sw::redis::Error& e) {
+        std::cerr << "Redis error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -8,6 +8,12 @@
 #define requestMapperFrom          (GS().requestMapperFrom)
 #define requestMapperTo            (GS().requestMapperTo)
 #define responseSCData              (GS().responseSCData)
+#define inflightRequests           (GS().inflightRequests)
+#define logFetchWindow             (GS().logFetchWindow)
+#define assetHolderIndex           (GS().assetHolderIndex)
+#define richList                   (GS().richList)
+#define stateJournal               (GS().stateJournal)
+#define undoJournal                (GS().undoJournal)
 
 #define gCurrentFetchingTick     (GS().gCurrentProcessingTick)
 #define gCurrentProcessingEpoch    (GS().gCurrentProcessingEpoch)
@@ -15,6 +21,11 @@
 #define gCurrentFetchingLogTick   (GS().gCurrentLoggingEventTick)
 #define gCurrentVerifyLoggingTick  (GS().gCurrentVerifyLoggingTick)
 #define gCurrentIndexingTick       (GS().gCurrentIndexingTick)
+#define gBundlePeerClaimedTick     (GS().gBundlePeerClaimedTick)
+#define gBundlePeerVerifiedTick    (GS().gBundlePeerVerifiedTick)
+#define gBackfillFromTick          (GS().gBackfillFromTick)
+#define gBackfillToTick            (GS().gBackfillToTick)
+#define gInMemoryStateEpoch        (GS().gInMemoryStateEpoch)
 #define computorsList              (GS().computorsList)
 
 #define spectrum                   ((EntityRecord*)GS().spectrum)
@@ -45,5 +56,8 @@
 #define gSpamThreshold (GS().gSpamThreshold)
 
 #define gNumBMConnection (GS().gNumBMConnection)
+#define gBundlePeers (GS().gBundlePeers)
 
-#define gKvrocksTTL (GS().gKvrocksTTL)
\ No newline at end of file
+#define gKvrocksTTL (GS().gKvrocksTTL)
+#define gVtickCompressionLevel (GS().gVtickCompressionLevel)
+#define gVtickDictionary (GS().gVtickDictionary)
\ No newline at end of file
@@ -372,6 +372,89 @@ struct ResponseLogStateDigest
     }
 };
 
+// Bob-to-bob bulk sync: request every verified tick in [fromTick, toTick]
+struct RequestVerifiedTickBundle
+{
+    unsigned int fromTick;
+    unsigned int toTick;
+
+    static constexpr unsigned int MAX_TICKS = 64; // per request, larger ranges are cut
+    static constexpr unsigned char type()
+    {
+        return 60;
+    }
+};
+
+// One frame of a bundle response, followed by a zstd frame of rawSize bytes holding
+// consecutive TickBundleRecord. A request is answered by one or more frames, the last one has LAST_FRAME set.
+struct RespondVerifiedTickBundle
+{
+    unsigned int requestFromTick;    // echo of RequestVerifiedTickBundle::fromTick
+    unsigned int fromTick;           // first tick in this frame
+    unsigned int toTick;             // last tick in this frame
+    unsigned int latestVerifiedTick; // sender's latest verified tick
+    unsigned int rawSize;            // decompressed size, 0 if the frame carries no tick
+    unsigned short epoch;
+    unsigned short flags;
+
+    static constexpr unsigned short WITH_LOGS = 1;  // records carry log ranges and log events
+    static constexpr unsigned short LAST_FRAME = 2;
+    static constexpr unsigned int MAX_RAW_SIZE = 4 * 1024 * 1024; // a frame is closed once it reaches this size
+    static constexpr unsigned int MAX_TICK_LOG_SIZE = 4 * 1024 * 1024; // logs of bigger ticks are left to the log fetcher
+    static constexpr unsigned char type()
+    {
+        return 61;
+    }
+};
+
+// Fast sync: request one chunk of a verified spectrum/universe checkpoint
+struct RequestStateCheckpoint
+{
+    unsigned int tick;     // 0 asks for the latest checkpoint
+    unsigned int chunk;
+    unsigned char part;    // SPECTRUM or UNIVERSE
+    unsigned char _padding[3];
+
+    static constexpr unsigned char SPECTRUM = 0;
+    static constexpr unsigned char UNIVERSE = 1;
+    static constexpr unsigned int CHUNK_SIZE = 8 * 1024 * 1024; // raw bytes per chunk
+    static constexpr unsigned char type()
+    {
+        return 62;
+    }
+};
+
+// One chunk of a checkpoint file, followed by a zstd frame of rawSize bytes
+struct RespondStateCheckpoint
+{
+    unsigned int tick;       // checkpoint tick, the state after every log of this tick
+    unsigned int chunk;
+    unsigned int chunkCount;
+    unsigned int rawSize;
+    unsigned short epoch;
+    unsigned char part;
+    unsigned char _padding;
+
+    static constexpr unsigned char type()
+    {
+        return 63;
+    }
+};
+
+// Per-tick record inside a decompressed bundle frame, followed by:
+// TickData (if hasTickData), TickVote[voteCount], LogRangesPerTxInTick (if hasLogRange),
+// txCount x (uint32 size, transaction), logSize bytes of packed log events
+struct TickBundleRecord
+{
+    unsigned int tick;
+    unsigned short voteCount;
+    unsigned short txCount;
+    unsigned int logSize;
+    unsigned char hasTickData;
+    unsigned char hasLogRange;
+    unsigned char _padding[2];
+};
+
 
 /*STRUCT FOR LOGGING*/
 /*
@@ -0,0 +1,286 @@
+#include <cstdio>
+#include <cstring>
+#include "gtest/gtest.h"
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+// Include the headers for the code under test
+#include "database/EmbeddedBackend.h"
+#include "Logger.h"
+
+
+// --- Test Fixture ---
+
+class EmbeddedBackendTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // the backend logs replays and rewrites; a logger without sinks drops them
+        if (!Logger::get()) Logger::get() = std::make_shared<spdlog::logger>("tests");
+        dir = std::filesystem::temp_directory_path() /
+              ("bob_embedded_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    // Tests call through a StorageBackend* like db.cpp does (the default arguments live on the interface).
+    std::unique_ptr<EmbeddedBackend> open(bool valuesOnDisk = false) {
+        EmbeddedBackend::Options options;
+        options.path = (dir / "data.log").string();
+        options.valuesOnDisk = valuesOnDisk;
+        return std::make_unique<EmbeddedBackend>(options);
+    }
+
+    std::filesystem::path dir;
+};
+
+// --- Test Cases ---
+
+TEST_F(EmbeddedBackendTest, StringsAndKeys) {
+    auto backend = open();
+    StorageBackend* db = backend.get();
+    EXPECT_FALSE(db->get("a").has_value());
+    EXPECT_TRUE(db->set("a", "1"));
+    EXPECT_FALSE(db->set("a", "2", std::chrono::seconds(0), true)); // NX keeps the old value
+    EXPECT_EQ(*db->get("a"), "1");
+
+    db->set("b", "2");
+    std::vector<StorageBackend::OptionalString> values;
+    db->mget({"a", "missing", "b"}, values);
+    ASSERT_EQ(values.size(), 3u);
+    EXPECT_EQ(*values[0], "1");
+    EXPECT_FALSE(values[1].has_value());
+    EXPECT_EQ(*values[2], "2");
+
+    std::vector<uint8_t> found;
+    db->exists({"a", "missing", "b"}, found);
+    EXPECT_EQ(found, (std::vector<uint8_t>{1, 0, 1}));
+
+    db->rename("b", "c");
+    EXPECT_FALSE(db->exists("b"));
+    EXPECT_EQ(*db->get("c"), "2");
+    EXPECT_THROW(db->rename("b", "d"), StorageError);
+
+    db->unlink("a");
+    EXPECT_FALSE(db->exists("a"));
+    EXPECT_EQ(backend->size(), 1u);
+
+    db->mset({{"m1", "x"}, {"m2", "y"}}, std::chrono::seconds(60));
+    db->mget({"m1", "m2"}, values);
+    ASSERT_EQ(values.size(), 2u);
+    EXPECT_EQ(*values[0], "x");
+    EXPECT_EQ(*values[1], "y");
+}
+
+TEST_F(EmbeddedBackendTest, HashesAndMonotonicFields) {
+    auto backend = open();
+    StorageBackend* db = backend.get();
+    EXPECT_TRUE(db->hsetIfGreater("db_status", "latest_tick", 10, 0, {{"latest_epoch", "150"}}));
+    EXPECT_FALSE(db->hsetIfGreater("db_status", "latest_tick", 9, 0, {{"latest_epoch", "149"}}));
+    EXPECT_EQ(*db->hget("db_status", "latest_tick"), "10");
+    EXPECT_EQ(*db->hget("db_status", "latest_epoch"), "150");
+
+    // a missing field compares as missingValue
+    EXPECT_FALSE(db->hsetIfGreater("db_status", "latest_log_id", -1, -1));
+    EXPECT_TRUE(db->hsetIfGreater("db_status", "latest_log_id", 0, -1));
+
+    std::vector<StorageBackend::OptionalString> values;
+    db->hmget("db_status", {"latest_tick", "nope", "latest_log_id"}, values);
+    ASSERT_EQ(values.size(), 3u);
+    EXPECT_EQ(*values[0], "10");
+    EXPECT_FALSE(values[1].has_value());
+    EXPECT_EQ(*values[2], "0");
+
+    // commands against the wrong type fail like they do on a server
+    db->set("plain", "x");
+    EXPECT_THROW(db->hget("plain", "f"), StorageError);
+}
+
+TEST_F(EmbeddedBackendTest, CommitsMonotonicFieldsTogether) {
+    auto backend = open();
+    StorageBackend* db = backend.get();
+    db->hset("db_status", {{"latest_verified_tick", "100"}});
+    const size_t applied = db->hsetIfGreaterAll({
+            {"db_status", "latest_verified_tick", 99, -1, {}},
+            {"db_status", "last_indexed_tick", 99, -1, {}},
+            {"db_status:epoch:150", "latest_log_id", 5000, -1, {{"note", "x"}}},
+    });
+    EXPECT_EQ(applied, 2u);
+    EXPECT_EQ(*db->hget("db_status", "latest_verified_tick"), "100");
+    EXPECT_EQ(*db->hget("db_status", "last_indexed_tick"), "99");
+    EXPECT_EQ(*db->hget("db_status:epoch:150", "latest_log_id"), "5000");
+    EXPECT_EQ(*db->hget("db_status:epoch:150", "note"), "x");
+    EXPECT_EQ(db->hsetIfGreaterAll({}), 0u);
+}
+
+TEST_F(EmbeddedBackendTest, SortedSetRanges) {
+    auto backend = open();
+    StorageBackend* db = backend.get();
+    db->zadd({{"z", "a", 1}, {"z", "b", 2}, {"z", "c", 3}, {"z", "d", 5}});
+    db->zadd({{"z", "a", 4}}, true); // NX leaves the score alone
+
+    std::vector<std::string> out;
+    StorageBackend::ScoreRange all;
+    db->zrangeByScore("z", all, false, 0, out);
+    EXPECT_EQ(out, (std::vector<std::string>{"a", "b", "c", "d"}));
+
+    StorageBackend::ScoreRange upTo;
+    upTo.max = 4;
+    db->zrangeByScore("z", upTo, true, 1, out);
+    EXPECT_EQ(out, (std::vector<std::string>{"c"}));
+
+    StorageBackend::ScoreRange after;
+    after.min = 3;
+    after.minOpen = true;
+    db->zrangeByScore("z", after, false, 1, out);
+    EXPECT_EQ(out, (std::vector<std::string>{"d"}));
+
+    StorageBackend::ScoreRange closed;
+    closed.min = 2;
+    closed.max = 3;
+    db->zrangeByScore("z", closed, false, 0, out);
+    EXPECT_EQ(out, (std::vector<std::string>{"b", "c"}));
+}
+
+TEST_F(EmbeddedBackendTest, ReplaysTheLogOnReopen) {
+    for (bool valuesOnDisk : {false, true}) {
+        std::filesystem::remove_all(dir / "data.log");
+        {
+            auto backend = open(valuesOnDisk);
+            StorageBackend* db = backend.get();
+            db->set("tick:1", std::string(1000, 'x'));
+            db->set("tick:2", "two");
+            db->set("tick:2", "TWO");
+            db->set("gone", "soon");
+            db->unlink("gone");
+            db->rename("tick:1", "tick:one");
+            db->hset("h", {{"f", "v"}});
+            db->zadd({{"z", "m", 7}});
+        }
+        auto backend = open(valuesOnDisk);
+        StorageBackend* db = backend.get();
+        EXPECT_EQ(backend->size(), 4u);
+        EXPECT_EQ(*db->get("tick:one"), std::string(1000, 'x'));
+        EXPECT_EQ(*db->get("tick:2"), "TWO");
+        EXPECT_FALSE(db->exists("gone"));
+        EXPECT_FALSE(db->exists("tick:1"));
+        EXPECT_EQ(*db->hget("h", "f"), "v");
+        std::vector<std::string> out;
+        db->zrangeByScore("z", StorageBackend::ScoreRange{}, false, 0, out);
+        EXPECT_EQ(out, (std::vector<std::string>{"m"}));
+    }
+}
+
+TEST_F(EmbeddedBackendTest, DropsATornRecord) {
+    {
+        auto backend = open();
+        StorageBackend* db = backend.get();
+        db->set("a", "1");
+        db->set("b", "2");
+    }
+    // a crash in the middle of the last append leaves part of a record behind
+    const auto path = dir / "data.log";
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    {
+        auto backend = open();
+        StorageBackend* db = backend.get();
+        EXPECT_EQ(*db->get("a"), "1");
+        EXPECT_FALSE(db->exists("b"));
+        db->set("c", "3"); // appends after the truncated tail
+    }
+    auto backend = open();
+    StorageBackend* db = backend.get();
+    EXPECT_EQ(*db->get("a"), "1");
+    EXPECT_EQ(*db->get("c"), "3");
+}
+
+TEST_F(EmbeddedBackendTest, ExpiredKeysReadAsMissing) {
+    auto backend = open();
+    StorageBackend* db = backend.get();
+    db->set("a", "1");
+    db->expire("a", std::chrono::seconds(0));
+    EXPECT_FALSE(db->exists("a"));
+    db->set("b", "2", std::chrono::seconds(3600));
+    EXPECT_TRUE(db->exists("b"));
+}
+
+TEST_F(EmbeddedBackendTest, CompactsAtRuntimeAndDropsExpiredKeys) {
+    for (bool valuesOnDisk : {false, true}) {
+        std::filesystem::remove_all(dir / "data.log");
+        const auto path = dir / "data.log";
+        {
+            EmbeddedBackend::Options options;
+            options.path = path.string();
+            options.valuesOnDisk = valuesOnDisk;
+            options.minRewriteWaste = 1;
+            options.compactIntervalSec = 0; // the test calls compact() itself
+            EmbeddedBackend backend(options);
+            StorageBackend* db = &backend;
+            for (int i = 0; i < 1000; i++) db->set("hot", std::to_string(i));
+            db->set("kept", std::string(100, 'k'));
+            db->set("expiring", std::string(100, 'e'), std::chrono::seconds(1));
+            const auto before = std::filesystem::file_size(path);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+            backend.compact();
+            EXPECT_LT(std::filesystem::file_size(path), before / 4);
+            EXPECT_EQ(backend.size(), 2u);
+            EXPECT_FALSE(db->exists("expiring"));
+            EXPECT_EQ(*db->get("hot"), "999");
+            EXPECT_EQ(*db->get("kept"), std::string(100, 'k'));
+            db->set("after", "1"); // appends to the rewritten file
+            EXPECT_EQ(*db->get("hot"), "999");
+        }
+        auto backend = open(valuesOnDisk);
+        StorageBackend* db = backend.get();
+        EXPECT_EQ(backend->size(), 3u);
+        EXPECT_EQ(*db->get("hot"), "999");
+        EXPECT_EQ(*db->get("after"), "1");
+        EXPECT_FALSE(db->exists("expiring"));
+    }
+}
+
+TEST_F(EmbeddedBackendTest, KeepsWritesMadeDuringARewrite) {
+    for (bool valuesOnDisk : {false, true}) {
+        std::filesystem::remove_all(dir / "data.log");
+        {
+            EmbeddedBackend::Options options;
+            options.path = (dir / "data.log").string();
+            options.valuesOnDisk = valuesOnDisk;
+            options.minRewriteWaste = 1;
+            options.compactIntervalSec = 0;
+            EmbeddedBackend backend(options);
+            StorageBackend* db = &backend;
+            for (int round = 0; round < 4; round++) {
+                for (int i = 0; i < 2000; i++) db->set("k" + std::to_string(i), std::string(200, char('a' + round)));
+            }
+            // the writer runs while the snapshot is copied, its records end up in the new log as the tail
+            std::thread writer([db]() {
+                for (int i = 0; i < 2000; i++) {
+                    db->set("k" + std::to_string(i), "w" + std::to_string(i));
+                    if (i % 2) db->unlink("k" + std::to_string(i));
+                }
+                db->rename("k0", "renamed");
+            });
+            backend.compact();
+            writer.join();
+            EXPECT_EQ(*db->get("renamed"), "w0");
+            for (int i = 1; i < 2000; i++) {
+                if (i % 2) EXPECT_FALSE(db->exists("k" + std::to_string(i))) << i;
+                else EXPECT_EQ(*db->get("k" + std::to_string(i)), "w" + std::to_string(i)) << i;
+            }
+            backend.compact();
+            EXPECT_EQ(*db->get("k2"), "w2");
+        }
+        auto backend = open(valuesOnDisk);
+        StorageBackend* db = backend.get();
+        EXPECT_EQ(backend->size(), 1000u);
+        EXPECT_EQ(*db->get("renamed"), "w0");
+        EXPECT_EQ(*db->get("k1998"), "w1998");
+        EXPECT_FALSE(db->exists("k1999"));
+    }
+}
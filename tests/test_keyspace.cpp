@@ -0,0 +1,123 @@
+#include <cstdio>
+#include <cstring>
+#include "gtest/gtest.h"
+#include <string>
+// Include the headers for the code under test
+#include "database/Keyspace.h"
+#include "K12AndKeyUtil.h"
+
+using Keyspace::Version;
+
+// --- Test Fixture ---
+
+class KeyspaceTest : public ::testing::Test {
+protected:
+    void TearDown() override { Keyspace::setState(Version::V1, false); }
+
+    static std::string identity(uint8_t seed) {
+        uint8_t pubkey[32];
+        for (int i = 0; i < 32; i++) pubkey[i] = static_cast<uint8_t>(seed * 7 + i);
+        char id[61] = {0};
+        getIdentityFromPublicKey(pubkey, id, true);
+        return id;
+    }
+};
+
+// --- Test Cases ---
+
+TEST_F(KeyspaceTest, V1NamesAreUnchanged) {
+    EXPECT_EQ(Keyspace::log(190, 12345, Version::V1), "log:190:12345");
+    EXPECT_EQ(Keyspace::tickVote(5000, 7, Version::V1), "tick_vote:5000:7");
+    EXPECT_EQ(Keyspace::tickLogRange(5000, Version::V1), "tick_log_range:5000");
+    EXPECT_EQ(Keyspace::endEpochTickLogRange(190, Version::V1), "end_epoch:tick_log_range:190");
+    EXPECT_EQ(Keyspace::indexedTx(5000, 3, Version::V1), "itx:5000_3");
+    EXPECT_EQ(Keyspace::indexed(1, 2, "ANY", "b", "ANY", Version::V1), "indexed:1:2:ANY:b:ANY");
+    // v1 is the default state
+    EXPECT_EQ(Keyspace::tickData(42), "tick_data:42");
+}
+
+TEST_F(KeyspaceTest, V2NamesAreCompactAndOrdered) {
+    Keyspace::setState(Version::V2, false);
+    EXPECT_EQ(Keyspace::log(190, 12345).size(), 12u);
+    EXPECT_EQ(Keyspace::tickVote(5000, 7).size(), 8u);
+    EXPECT_EQ(Keyspace::tickData(5000).size(), 6u);
+    EXPECT_EQ(Keyspace::transaction(identity(1)).size(), 35u);
+    EXPECT_LT(Keyspace::tickData(255), Keyspace::tickData(256));
+    EXPECT_LT(Keyspace::log(190, 0xff), Keyspace::log(190, 0x100));
+    EXPECT_NE(Keyspace::tickData(5000), Keyspace::vtick(5000));
+}
+
+TEST_F(KeyspaceTest, HashesThatAreNotIdentitiesStayDistinct) {
+    const std::string id = identity(2);
+    std::string upper = id;
+    for (auto& c : upper) c = static_cast<char>(c - 'a' + 'A');
+    std::string badChecksum = id;
+    badChecksum[59] = badChecksum[59] == 'a' ? 'b' : 'a';
+
+    const std::string raw = Keyspace::transaction(id, Version::V2);
+    EXPECT_NE(raw, Keyspace::transaction(upper, Version::V2));
+    EXPECT_NE(raw, Keyspace::transaction(badChecksum, Version::V2));
+    EXPECT_EQ(Keyspace::transaction(badChecksum, Version::V2).size(), 2u + 3u + 60u);
+    EXPECT_NE(Keyspace::indexed(1, 2, "ANY", id, "ANY", Version::V2),
+              Keyspace::indexed(1, 2, id, "ANY", "ANY", Version::V2));
+}
+
+TEST_F(KeyspaceTest, ComputedHashesGiveTheSameKeys) {
+    using Keyspace::Origin;
+    for (uint8_t seed = 0; seed < 32; seed++) {
+        const std::string id = identity(seed);
+        uint8_t digest[32];
+        for (int i = 0; i < 32; i++) digest[i] = static_cast<uint8_t>(seed * 7 + i);
+        EXPECT_EQ(Keyspace::transaction(id, Origin::Computed, Version::V2), Keyspace::transaction(id, Version::V2));
+        EXPECT_EQ(Keyspace::transaction(id, digest, Version::V2), Keyspace::transaction(id, Version::V2));
+        EXPECT_EQ(Keyspace::transaction(id, digest, Version::V1), Keyspace::transaction(id, Version::V1));
+        EXPECT_EQ(Keyspace::indexedTx(id, Origin::Computed, Version::V2), Keyspace::indexedTx(id, Version::V2));
+        EXPECT_EQ(Keyspace::indexedTx(id, digest, Version::V2), Keyspace::indexedTx(id, Version::V2));
+        EXPECT_EQ(Keyspace::indexed(1, 2, id, "ANY", id, Origin::Computed, Version::V2),
+                  Keyspace::indexed(1, 2, id, "ANY", id, Version::V2));
+    }
+    // letters that overflow a fragment are still refused: the name stays a string
+    EXPECT_EQ(Keyspace::transaction(std::string(60, 'z'), Origin::Computed, Version::V2).size(), 2u + 3u + 60u);
+}
+
+TEST_F(KeyspaceTest, ConvertsEveryV1Family) {
+    const std::string id = identity(3);
+    bool isHash = false;
+    EXPECT_EQ(Keyspace::toV2("log:190:12345"), Keyspace::log(190, 12345, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("log_ranges:7"), Keyspace::logRanges(7, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("tick_data:7"), Keyspace::tickData(7, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("tick_vote:7:675"), Keyspace::tickVote(7, 675, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("tick_votes:7"), Keyspace::tickVotes(7, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("vtick:7"), Keyspace::vtick(7, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("cLogRange:7"), Keyspace::cLogRange(7, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("transaction:" + id), Keyspace::transaction(id, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("itx:" + id), Keyspace::indexedTx(id, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("itx:7_1"), Keyspace::indexedTx(7, 1, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("indexed:4"), Keyspace::indexed(4, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("indexed:4:0"), Keyspace::indexed(4, 0, Version::V2));
+    EXPECT_EQ(Keyspace::toV2("indexed:4:0:ANY:" + id + ":ANY"), Keyspace::indexed(4, 0, "ANY", id, "ANY", Version::V2));
+    EXPECT_EQ(Keyspace::toV2("log:190:1", &isHash), Keyspace::log(190, 1, Version::V2));
+    EXPECT_FALSE(isHash);
+    EXPECT_EQ(Keyspace::toV2("tick_log_range:7", &isHash), Keyspace::tickLogRange(7, Version::V2));
+    EXPECT_TRUE(isHash);
+    EXPECT_EQ(Keyspace::toV2("end_epoch:tick_log_range:190", &isHash), Keyspace::endEpochTickLogRange(190, Version::V2));
+    EXPECT_TRUE(isHash);
+}
+
+TEST_F(KeyspaceTest, RejectsKeysOfOtherShapes) {
+    for (const char* key : {"db_status", "log:190", "log:190:01", "log:70000:1", "tick_data:", "tick_data:-1",
+                            "tick_data:4294967296", "tick_vote:7:676x", "itx:7_x", "indexed:4:0:ANY",
+                            "indexed:4:0:a:b:c:d", "end_epoch:log_ranges:190", "computor:190"}) {
+        EXPECT_FALSE(Keyspace::toV2(key).has_value()) << key;
+    }
+}
+
+TEST_F(KeyspaceTest, LogRangeValueRoundTrips) {
+    long long fromLogId = 0, length = 0;
+    const std::string value = Keyspace::encodeLogRange(123456789012LL, -1);
+    ASSERT_EQ(value.size(), 16u);
+    ASSERT_TRUE(Keyspace::decodeLogRange(value, fromLogId, length));
+    EXPECT_EQ(fromLogId, 123456789012LL);
+    EXPECT_EQ(length, -1);
+    EXPECT_FALSE(Keyspace::decodeLogRange(value.substr(1), fromLogId, length));
+}
@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <cstring>
+#include "gtest/gtest.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+// Include the headers for the code under test
+#include "database/LogSegmentStore.h"
+#include "Logger.h"
+
+
+// --- Test Fixture ---
+
+class LogSegmentStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // the store logs repairs and pruning; a logger without sinks drops them
+        if (!Logger::get()) Logger::get() = std::make_shared<spdlog::logger>("tests");
+        dir = std::filesystem::temp_directory_path() /
+              ("bob_segments_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    static std::string payload(uint64_t logId) {
+        return "log-" + std::to_string(logId) + std::string(logId % 7, '#');
+    }
+
+    // Appends payload(id) for every id in [from, to].
+    static void appendRange(LogSegmentStore& store, uint16_t epoch, uint64_t from, uint64_t to) {
+        std::vector<std::string> data;
+        for (uint64_t id = from; id <= to; id++) data.push_back(payload(id));
+        std::vector<LogSegmentStore::Record> records;
+        for (uint64_t id = from; id <= to; id++) records.push_back({id, data[id - from]});
+        ASSERT_TRUE(store.append(epoch, records));
+    }
+
+    static std::vector<std::pair<uint64_t, std::string>> readRange(LogSegmentStore& store, uint16_t epoch,
+                                                                   uint64_t from, uint64_t to) {
+        std::vector<std::pair<uint64_t, std::string>> out;
+        EXPECT_TRUE(store.readRange(epoch, from, to, [&](uint64_t logId, const uint8_t* data, size_t size) {
+            out.emplace_back(logId, std::string(reinterpret_cast<const char*>(data), size));
+        }));
+        return out;
+    }
+
+    std::filesystem::path dir;
+};
+
+// --- Test Cases ---
+
+TEST_F(LogSegmentStoreTest, ReadsBackRangesAndSkipsGaps) {
+    LogSegmentStore store(dir.string(), std::chrono::seconds(0));
+    appendRange(store, 190, 0, 99);
+    appendRange(store, 190, 150, 159); // ids 100..149 were never moved
+
+    std::string value;
+    ASSERT_TRUE(store.get(190, 42, value));
+    EXPECT_EQ(value, payload(42));
+    EXPECT_FALSE(store.get(190, 120, value));
+    EXPECT_FALSE(store.get(191, 42, value));
+
+    auto logs = readRange(store, 190, 95, 155);
+    ASSERT_EQ(logs.size(), 11u);
+    for (size_t i = 0; i < 5; i++) EXPECT_EQ(logs[i], std::make_pair(95 + i, payload(95 + i)));
+    for (size_t i = 5; i < 11; i++) EXPECT_EQ(logs[i], std::make_pair(145 + i, payload(145 + i)));
+
+    EXPECT_TRUE(readRange(store, 191, 0, 10).empty());
+}
+
+TEST_F(LogSegmentStoreTest, KeepsTheFirstCopyOfALog) {
+    LogSegmentStore store(dir.string(), std::chrono::seconds(0));
+    appendRange(store, 190, 0, 9);
+    const std::string other = "other";
+    ASSERT_TRUE(store.append(190, {{5, other}, {10, other}}));
+    std::string value;
+    ASSERT_TRUE(store.get(190, 5, value));
+    EXPECT_EQ(value, payload(5));
+    ASSERT_TRUE(store.get(190, 10, value));
+    EXPECT_EQ(value, other);
+}
+
+TEST_F(LogSegmentStoreTest, SurvivesReopenAndGrowsTheIndex) {
+    const uint64_t far = 3'000'000; // beyond the first index allocation
+    {
+        LogSegmentStore store(dir.string(), std::chrono::seconds(0));
+        appendRange(store, 190, 0, 9);
+        appendRange(store, 190, far, far + 9);
+    }
+    LogSegmentStore store(dir.string(), std::chrono::seconds(0));
+    auto logs = readRange(store, 190, far - 5, far + 100);
+    ASSERT_EQ(logs.size(), 10u);
+    EXPECT_EQ(logs.front(), std::make_pair(far, payload(far)));
+    std::string value;
+    ASSERT_TRUE(store.get(190, 3, value));
+    EXPECT_EQ(value, payload(3));
+}
+
+TEST_F(LogSegmentStoreTest, DropsSlotsPastTheEndOfTheData) {
+    {
+        LogSegmentStore store(dir.string(), std::chrono::seconds(0));
+        appendRange(store, 190, 0, 9);
+    }
+    // the data of the last log never reached the disk
+    const auto seg = dir / "190.seg";
+    std::filesystem::resize_file(seg, std::filesystem::file_size(seg) - 1);
+    LogSegmentStore store(dir.string(), std::chrono::seconds(0));
+    std::string value;
+    EXPECT_FALSE(store.get(190, 9, value));
+    ASSERT_TRUE(store.get(190, 8, value));
+    EXPECT_EQ(value, payload(8));
+    // it can be moved again
+    appendRange(store, 190, 9, 9);
+    ASSERT_TRUE(store.get(190, 9, value));
+    EXPECT_EQ(value, payload(9));
+}
+
+TEST_F(LogSegmentStoreTest, DeletesExpiredEpochs) {
+    {
+        LogSegmentStore store(dir.string(), std::chrono::seconds(0));
+        appendRange(store, 180, 0, 9);
+        appendRange(store, 190, 0, 9);
+    }
+    const auto old = std::filesystem::file_time_type::clock::now() - std::chrono::hours(24 * 30);
+    std::filesystem::last_write_time(dir / "180.seg", old);
+
+    LogSegmentStore store(dir.string(), std::chrono::seconds(1814400));
+    std::string value;
+    EXPECT_FALSE(store.get(180, 1, value));
+    EXPECT_FALSE(std::filesystem::exists(dir / "180.idx"));
+    EXPECT_TRUE(store.get(190, 1, value));
+}
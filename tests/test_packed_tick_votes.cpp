@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <cstring>
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+// Include the headers for the code under test
+#include "database/PackedTickVotes.h"
+
+
+// --- Test Fixture ---
+
+class PackedTickVotesTest : public ::testing::Test {
+protected:
+    static TickVote makeVote(uint16_t computorIndex) {
+        TickVote vote{};
+        memset((void*)&vote, 0, sizeof(vote));
+        vote.computorIndex = computorIndex;
+        vote.epoch = 190;
+        vote.tick = 5000;
+        vote.signature[0] = static_cast<uint8_t>(computorIndex);
+        return vote;
+    }
+};
+
+// --- Test Cases ---
+
+TEST_F(PackedTickVotesTest, PacksOnlyThePresentVotes) {
+    std::vector<TickVote> votes{makeVote(675), makeVote(3), makeVote(0), makeVote(3)};
+    const std::string blob = PackedTickVotes::pack(votes);
+    EXPECT_EQ(blob.size(), PackedTickVotes::kBitmapSize + 3 * sizeof(TickVote));
+    EXPECT_TRUE(PackedTickVotes::valid(blob));
+    EXPECT_EQ(PackedTickVotes::count(blob), 3u);
+
+    std::vector<TickVote> out;
+    ASSERT_TRUE(PackedTickVotes::unpack(blob, out));
+    ASSERT_EQ(out.size(), 3u);
+    EXPECT_EQ(out[0].computorIndex, 0);
+    EXPECT_EQ(out[1].computorIndex, 3);
+    EXPECT_EQ(out[2].computorIndex, 675);
+}
+
+TEST_F(PackedTickVotesTest, FindsASingleVote) {
+    std::vector<TickVote> votes;
+    for (uint16_t i = 0; i < 676; i += 5) votes.push_back(makeVote(i));
+    const std::string blob = PackedTickVotes::pack(votes);
+
+    TickVote vote;
+    ASSERT_TRUE(PackedTickVotes::find(blob, 500, vote));
+    EXPECT_EQ(memcmp(&vote, &votes[100], sizeof(TickVote)), 0);
+    EXPECT_FALSE(PackedTickVotes::find(blob, 501, vote));
+    EXPECT_FALSE(PackedTickVotes::find(blob, 676, vote));
+}
+
+TEST_F(PackedTickVotesTest, RejectsMalformedBlobs) {
+    const std::string blob = PackedTickVotes::pack({makeVote(1), makeVote(2)});
+    std::vector<TickVote> out;
+    EXPECT_FALSE(PackedTickVotes::unpack(blob.substr(0, blob.size() - 1), out));
+    EXPECT_FALSE(PackedTickVotes::unpack("short", out));
+    TickVote vote;
+    EXPECT_FALSE(PackedTickVotes::find(blob + "x", 1, vote));
+    EXPECT_TRUE(out.empty());
+}
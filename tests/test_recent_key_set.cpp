@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <cstring>
+#include "gtest/gtest.h"
+#include <thread>
+#include <vector>
+// Include the headers for the code under test
+#include "database/RecentKeySet.h"
+
+// --- Test Cases ---
+
+TEST(RecentKeySetTest, InsertEraseAndClear) {
+    RecentKeySet set(1024);
+    EXPECT_FALSE(set.contains(7));
+    set.insert(7);
+    set.insert(7);
+    set.insert(8);
+    EXPECT_TRUE(set.contains(7));
+    EXPECT_TRUE(set.contains(8));
+    EXPECT_EQ(set.size(), 2u);
+    set.erase(7);
+    EXPECT_FALSE(set.contains(7));
+    EXPECT_TRUE(set.contains(8));
+    set.clear();
+    EXPECT_FALSE(set.contains(8));
+    EXPECT_EQ(set.size(), 0u);
+}
+
+TEST(RecentKeySetTest, KeepsTheMostRecentKeysWithinCapacity) {
+    const size_t capacity = 1024;
+    RecentKeySet set(capacity);
+    const uint64_t n = 100000;
+    for (uint64_t key = 0; key < n; key++) set.insert(key);
+    // two generations per shard, each just over capacity / 32 keys
+    EXPECT_LE(set.size(), capacity + 32);
+    for (uint64_t key = n - 256; key < n; key++) EXPECT_TRUE(set.contains(key)) << key;
+    EXPECT_FALSE(set.contains(0));
+}
+
+TEST(RecentKeySetTest, EraseReachesBothGenerations) {
+    RecentKeySet set(1024);
+    for (uint64_t key = 0; key < 2000; key++) set.insert(key);
+    for (uint64_t key = 0; key < 2000; key++) set.erase(key);
+    EXPECT_EQ(set.size(), 0u);
+}
+
+TEST(RecentKeySetTest, ConcurrentInsertsAreAllVisible) {
+    RecentKeySet set(1 << 20);
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; t++) {
+        threads.emplace_back([&set, t] {
+            for (uint64_t i = 0; i < 10000; i++) set.insert(t * 10000 + i);
+        });
+    }
+    for (auto& th : threads) th.join();
+    EXPECT_EQ(set.size(), 40000u);
+    for (uint64_t key = 0; key < 40000; key++) ASSERT_TRUE(set.contains(key)) << key;
+}
+
+TEST(RecentKeySetTest, InsertStampedBeforeAnEraseIsDropped) {
+    RecentKeySet set(1024);
+    // a write that raced with a delete: stamped before it, inserted after its erase
+    const uint64_t stamp = set.stamp(7);
+    set.erase(7);
+    set.insert(7, stamp);
+    EXPECT_FALSE(set.contains(7));
+    // the same after clear()
+    const uint64_t before = set.stamp(8);
+    set.clear();
+    set.insert(8, before);
+    EXPECT_FALSE(set.contains(8));
+    // a stamp taken after the erase is good
+    set.insert(7, set.stamp(7));
+    EXPECT_TRUE(set.contains(7));
+}
@@ -0,0 +1,112 @@
+#include <cstdio>
+#include <cstring>
+#include "gtest/gtest.h"
+#include <filesystem>
+#include <string>
+#include <vector>
+// Include the headers for the code under test
+#include "database/ReplicaRoutingBackend.h"
+#include "database/EmbeddedBackend.h"
+#include "Logger.h"
+
+
+// --- Test Fixture ---
+
+class ReplicaRoutingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!Logger::get()) Logger::get() = std::make_shared<spdlog::logger>("tests");
+        dir = std::filesystem::temp_directory_path() /
+              ("bob_replica_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) + "_" +
+               ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    // Two embedded stores stand in for the KeyDB primary and its replica; the test keeps raw pointers to
+    // write to each side directly.
+    std::unique_ptr<ReplicaRoutingBackend> open(long long primaryTick, long long replicaTick, long long maxLag) {
+        auto p = openStore("primary.log");
+        auto r = openStore("replica.log");
+        primary = p.get();
+        replica = r.get();
+        if (primaryTick >= 0) primary->hset("db_status", {{"latest_verified_tick", std::to_string(primaryTick)}});
+        if (replicaTick >= 0) replica->hset("db_status", {{"latest_verified_tick", std::to_string(replicaTick)}});
+        return std::make_unique<ReplicaRoutingBackend>(std::move(p), std::move(r), maxLag);
+    }
+
+    std::unique_ptr<StorageBackend> openStore(const char* file) {
+        EmbeddedBackend::Options options;
+        options.path = (dir / file).string();
+        return std::make_unique<EmbeddedBackend>(options);
+    }
+
+    std::filesystem::path dir;
+    StorageBackend* primary = nullptr;
+    StorageBackend* replica = nullptr;
+};
+
+// --- Test Cases ---
+
+TEST_F(ReplicaRoutingTest, FreshReplicaServesReads) {
+    auto backend = open(100, 97, 5);
+    StorageBackend* db = backend.get();
+    ASSERT_TRUE(backend->replicaFresh());
+    replica->set("a", "replica");
+    primary->set("a", "primary");
+    EXPECT_EQ(*db->get("a"), "replica");
+    replica->hset("h", {{"f", "replica"}});
+    EXPECT_EQ(*db->hget("h", "f"), "replica");
+}
+
+TEST_F(ReplicaRoutingTest, MissingOnReplicaFallsBackToPrimary) {
+    auto backend = open(100, 100, 5);
+    StorageBackend* db = backend.get();
+    ASSERT_TRUE(backend->replicaFresh());
+    replica->set("a", "1");
+    primary->set("b", "2");
+    EXPECT_EQ(*db->get("b"), "2");
+    EXPECT_TRUE(db->exists("b"));
+
+    std::vector<StorageBackend::OptionalString> values;
+    db->mget({"a", "b", "missing"}, values);
+    ASSERT_EQ(values.size(), 3u);
+    EXPECT_EQ(*values[0], "1");
+    EXPECT_EQ(*values[1], "2");
+    EXPECT_FALSE(values[2].has_value());
+
+    std::vector<uint8_t> found;
+    db->exists({"a", "b", "missing"}, found);
+    EXPECT_EQ(found, (std::vector<uint8_t>{1, 1, 0}));
+}
+
+TEST_F(ReplicaRoutingTest, LaggingReplicaIsNotRead) {
+    auto backend = open(100, 90, 5);
+    StorageBackend* db = backend.get();
+    EXPECT_FALSE(backend->replicaFresh());
+    replica->set("a", "replica");
+    primary->set("a", "primary");
+    EXPECT_EQ(*db->get("a"), "primary");
+}
+
+TEST_F(ReplicaRoutingTest, ReplicaWithoutStatusIsNotRead) {
+    auto backend = open(100, -1, 5);
+    EXPECT_FALSE(backend->replicaFresh());
+}
+
+TEST_F(ReplicaRoutingTest, WritesGoToPrimary) {
+    auto backend = open(100, 100, 5);
+    StorageBackend* db = backend.get();
+    db->set("a", "1");
+    db->hset("h", {{"f", "v"}});
+    EXPECT_TRUE(db->hsetIfGreater("db_status", "latest_verified_tick", 101, 0, {}));
+    EXPECT_EQ(*primary->get("a"), "1");
+    EXPECT_EQ(*primary->hget("h", "f"), "v");
+    EXPECT_EQ(*primary->hget("db_status", "latest_verified_tick"), "101");
+    EXPECT_FALSE(replica->exists("a"));
+    EXPECT_FALSE(replica->exists("h"));
+}
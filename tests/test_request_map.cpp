@@ -0,0 +1,191 @@
+#include "gtest/gtest.h"
+#include <thread>
+#include <vector>
+#include <random>
+#include <unordered_map>
+// Include the headers for the code under test
+#include "RequestMap.h"
+
+
+// --- Test Fixture ---
+
+class RequestMapTest : public ::testing::Test {
+protected:
+    /**
+     * @brief Builds a payload of the given size filled with a pattern derived from seed.
+     */
+    static std::vector<uint8_t> makePayload(size_t size, uint8_t seed) {
+        std::vector<uint8_t> v(size);
+        for (size_t i = 0; i < size; ++i) v[i] = static_cast<uint8_t>(seed + i);
+        return v;
+    }
+};
+
+
+// --- Single-Threaded Tests ---
+
+// Inline (small) payloads round-trip through get/peek/take.
+TEST_F(RequestMapTest, InlinePayloadAccessors) {
+    RequestMap map;
+    auto payload = makePayload(44, 7);
+    map.add(1234, payload.data(), (int)payload.size(), nullptr);
+
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(map.get(1234, out));
+    ASSERT_EQ(out, payload);
+
+    uint8_t buf[64] = {0};
+    ASSERT_EQ(map.peek(1234, buf, sizeof(buf)), (int)payload.size());
+    ASSERT_EQ(0, memcmp(buf, payload.data(), payload.size()));
+
+    QCPtr conn;
+    out.clear();
+    ASSERT_TRUE(map.take(1234, out, conn));
+    ASSERT_EQ(out, payload);
+    ASSERT_FALSE(map.contains(1234));
+    ASSERT_EQ(map.peek(1234, buf, sizeof(buf)), -1);
+}
+
+// Payloads larger than the inline area spill and are moved out intact.
+TEST_F(RequestMapTest, SpilledPayload) {
+    RequestMap map;
+    auto payload = makePayload(RequestMap::kInlineSize * 4 + 3, 1);
+    map.add(42, payload.data(), (int)payload.size(), nullptr);
+
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(map.get(42, out));
+    ASSERT_EQ(out, payload);
+
+    // peek truncates to the caller's capacity but reports the full size
+    uint8_t small[8];
+    ASSERT_EQ(map.peek(42, small, sizeof(small)), (int)payload.size());
+    ASSERT_EQ(0, memcmp(small, payload.data(), sizeof(small)));
+
+    QCPtr conn;
+    ASSERT_TRUE(map.take(42, out, conn));
+    ASSERT_EQ(out, payload);
+    ASSERT_FALSE(map.contains(42));
+}
+
+// A request's connection is looked up by every packet carrying its dejavu; only clean() drops it.
+TEST_F(RequestMapTest, GetConnKeepsTheEntry) {
+    RequestMap map;
+    // never dereferenced: an aliasing pointer with no owner stands in for a connection
+    QCPtr peer(std::shared_ptr<void>(), reinterpret_cast<QubicConnection*>(0x10));
+    map.add(77, nullptr, 0, peer);
+
+    for (int i = 0; i < 3; ++i) {
+        QCPtr conn;
+        ASSERT_TRUE(map.getConn(77, conn));
+        ASSERT_EQ(conn, peer);
+    }
+    ASSERT_TRUE(map.contains(77));
+    QCPtr none;
+    ASSERT_FALSE(map.getConn(78, none));
+    ASSERT_EQ(none, nullptr);
+}
+
+// Re-adding a key replaces the previous entry.
+TEST_F(RequestMapTest, ReplaceExisting) {
+    RequestMap map;
+    auto a = makePayload(100, 1);
+    auto b = makePayload(10, 2);
+    map.add(5, a.data(), (int)a.size(), nullptr);
+    map.add(5, b.data(), (int)b.size(), nullptr);
+
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(map.get(5, out));
+    ASSERT_EQ(out, b);
+}
+
+// Many keys force table growth; random removals exercise backward-shift deletion.
+TEST_F(RequestMapTest, GrowAndEraseAgainstReference) {
+    RequestMap map;
+    std::mt19937 rng(12345);
+    std::unordered_map<uint32_t, uint8_t> ref;
+
+    for (int i = 0; i < 40000; ++i) {
+        uint32_t key = rng();
+        uint8_t seed = static_cast<uint8_t>(key);
+        auto p = makePayload(16, seed);
+        map.add(key, p.data(), (int)p.size(), nullptr);
+        ref[key] = seed;
+    }
+    int n = 0;
+    for (auto it = ref.begin(); it != ref.end(); ) {
+        if ((n++ % 3) == 0) {
+            QCPtr conn;
+            std::vector<uint8_t> out;
+            ASSERT_TRUE(map.take(it->first, out, conn));
+            it = ref.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const auto& [key, seed] : ref) {
+        uint8_t buf[16];
+        ASSERT_EQ(map.peek(key, buf, sizeof(buf)), 16);
+        ASSERT_EQ(buf[0], seed);
+    }
+}
+
+// Entries older than the cleaning period are dropped; fresh ones survive.
+TEST_F(RequestMapTest, CleanExpiresOldEntries) {
+    RequestMap map;
+    auto p = makePayload(8, 3);
+    map.add(1, p.data(), (int)p.size(), nullptr);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    map.add(2, p.data(), (int)p.size(), nullptr);
+
+    map.clean(1);
+    ASSERT_FALSE(map.contains(1));
+    ASSERT_TRUE(map.contains(2));
+}
+
+// A burst of spilled payloads grows the tables; once drained, clean() shrinks them back.
+TEST_F(RequestMapTest, ShrinksAfterBurst) {
+    RequestMap map;
+    auto p = makePayload(8 * 1024, 5);
+    for (uint32_t key = 1; key <= 8000; ++key) map.add(key, p.data(), (int)p.size(), nullptr);
+    std::vector<uint8_t> out;
+    QCPtr conn;
+    for (uint32_t key = 1; key <= 8000; ++key) ASSERT_TRUE(map.take(key, out, conn));
+    ASSERT_EQ(out, p);
+
+    map.clean();
+    const uint32_t initialSlots = RequestMap::kShards * RequestMap::kInitialSlotsPerShard;
+    ASSERT_EQ(map.GetMapUsageString(), "Map Usage: 0 entries (" + std::to_string(initialSlots) + " slots)");
+    map.add(7, p.data(), (int)p.size(), nullptr);
+    ASSERT_TRUE(map.get(7, out));
+    ASSERT_EQ(out, p);
+}
+
+// --- Multi-Threaded Tests ---
+
+// Concurrent writers and readers on disjoint keys never lose entries.
+TEST_F(RequestMapTest, ConcurrentAddTake) {
+    RequestMap map;
+    const int num_threads = 4;
+    const int per_thread = 5000;
+    std::vector<std::thread> threads;
+    std::atomic<int> taken{0};
+
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                uint32_t key = static_cast<uint32_t>(t * per_thread + i + 1);
+                uint8_t v = static_cast<uint8_t>(key);
+                map.add(key, &v, 1, nullptr);
+            }
+            for (int i = 0; i < per_thread; ++i) {
+                uint32_t key = static_cast<uint32_t>(t * per_thread + i + 1);
+                std::vector<uint8_t> out;
+                QCPtr conn;
+                if (map.take(key, out, conn) && out.size() == 1 && out[0] == static_cast<uint8_t>(key)) taken++;
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    ASSERT_EQ(taken.load(), num_threads * per_thread);
+}
@@ -0,0 +1,145 @@
+#include <cstdio>
+#include "gtest/gtest.h"
+#include <random>
+#include <cstdint>
+#include <utility>
+#include <vector>
+// Include the headers for the code under test
+#include "StateReorg.h"
+
+
+// --- Test Fixture ---
+
+class StateReorgTest : public ::testing::Test {
+protected:
+    static constexpr unsigned kWorkers = 8;
+
+    static m256i randomKey(std::mt19937_64& rng, uint32_t home) {
+        m256i k;
+        for (int i = 0; i < 4; ++i) k.m256i_u64[i] = rng();
+        k.m256i_u32[0] = home;
+        return k;
+    }
+
+    // Mostly clustered homes, including a cluster that wraps around the end of the table.
+    static uint32_t randomHome(std::mt19937_64& rng, uint64_t capacity) {
+        switch (rng() % 4) {
+            case 0: return static_cast<uint32_t>(rng() & (capacity - 1));
+            case 1: return static_cast<uint32_t>((capacity - 2048 + rng() % 4096) & (capacity - 1));
+            default: return static_cast<uint32_t>((rng() % 64) * (capacity / 64) + rng() % 8192);
+        }
+    }
+
+    // Spectrum with live and zero-balance entities stored away from their home slots.
+    static void fillSpectrum(uint32_t seed) {
+        setMem(spectrum, SPECTRUM_CAPACITY * sizeof(EntityRecord), 0);
+        std::mt19937_64 rng(seed);
+        for (int i = 0; i < 300000; ++i) {
+            unsigned int index = rng() & (SPECTRUM_CAPACITY - 1);
+            while (!isZero(spectrum[index].publicKey)) index = (index + 1) & (SPECTRUM_CAPACITY - 1);
+            EntityRecord& e = spectrum[index];
+            e.publicKey = randomKey(rng, randomHome(rng, SPECTRUM_CAPACITY));
+            e.incomingAmount = static_cast<long long>(rng() % 1000000);
+            e.outgoingAmount = (rng() % 3 == 0) ? e.incomingAmount : static_cast<long long>(rng() % 1000);
+            e.numberOfIncomingTransfers = static_cast<unsigned int>(rng());
+            e.numberOfOutgoingTransfers = static_cast<unsigned int>(rng());
+            e.latestIncomingTransferTick = static_cast<unsigned int>(rng());
+            e.latestOutgoingTransferTick = static_cast<unsigned int>(rng());
+        }
+    }
+
+    static unsigned int freeAssetSlot(std::mt19937_64& rng) {
+        unsigned int index = rng() & (ASSETS_CAPACITY - 1);
+        while (assets[index].varStruct.issuance.type != EMPTY) index = (index + 1) & (ASSETS_CAPACITY - 1);
+        return index;
+    }
+
+    // Universe with duplicate ownerships/possessions that have to be merged and empty possessions.
+    static void fillUniverse(uint32_t seed) {
+        setMem(assets, ASSETS_CAPACITY * sizeof(AssetRecord), 0);
+        std::mt19937_64 rng(seed);
+        std::vector<m256i> people;
+        for (int i = 0; i < 5000; ++i) people.push_back(randomKey(rng, randomHome(rng, ASSETS_CAPACITY)));
+
+        std::vector<unsigned int> issuances;
+        for (int i = 0; i < 300; ++i) {
+            const unsigned int index = freeAssetSlot(rng);
+            auto& r = assets[index].varStruct.issuance;
+            r.publicKey = people[rng() % people.size()];
+            r.type = ISSUANCE;
+            for (int c = 0; c < 7; ++c) r.name[c] = static_cast<char>('A' + rng() % 26);
+            r.numberOfDecimalPlaces = static_cast<char>(rng() % 4);
+            issuances.push_back(index);
+        }
+        std::vector<unsigned int> ownerships;
+        for (int i = 0; i < 40000; ++i) {
+            const unsigned int index = freeAssetSlot(rng);
+            auto& r = assets[index].varStruct.ownership;
+            r.publicKey = people[rng() % people.size()];
+            r.type = OWNERSHIP;
+            r.managingContractIndex = static_cast<unsigned short>(rng() % 3);
+            r.issuanceIndex = issuances[rng() % issuances.size()];
+            r.numberOfShares = static_cast<long long>(rng() % 100000);
+            ownerships.push_back(index);
+        }
+        for (int i = 0; i < 120000; ++i) {
+            const unsigned int index = freeAssetSlot(rng);
+            auto& r = assets[index].varStruct.possession;
+            r.publicKey = people[rng() % people.size()];
+            r.type = POSSESSION;
+            r.managingContractIndex = static_cast<unsigned short>(rng() % 3);
+            r.ownershipIndex = ownerships[rng() % ownerships.size()];
+            r.numberOfShares = (rng() % 5 == 0) ? 0 : static_cast<long long>(rng() % 100000);
+        }
+    }
+
+    // Index and raw bytes of every non-empty slot.
+    template <typename Record>
+    static std::vector<std::pair<uint32_t, std::vector<uint8_t>>> snapshot(const Record* table, uint64_t capacity) {
+        std::vector<std::pair<uint32_t, std::vector<uint8_t>>> out;
+        for (uint64_t i = 0; i < capacity; ++i) {
+            if (isZero(&table[i], sizeof(Record))) continue;
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(&table[i]);
+            out.emplace_back(static_cast<uint32_t>(i), std::vector<uint8_t>(p, p + sizeof(Record)));
+        }
+        return out;
+    }
+
+    static void expectSame(const std::vector<std::pair<uint32_t, std::vector<uint8_t>>>& a,
+                           const std::vector<std::pair<uint32_t, std::vector<uint8_t>>>& b) {
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            ASSERT_EQ(a[i].first, b[i].first);
+            ASSERT_EQ(a[i].second, b[i].second) << "slot " << a[i].first;
+        }
+    }
+};
+
+
+// --- Tests ---
+
+// The parallel spectrum rebuild lays out every entity exactly like the serial one.
+TEST_F(StateReorgTest, SpectrumMatchesSerial) {
+    fillSpectrum(1);
+    reorganizeSpectrum();
+    auto expected = snapshot(spectrum, SPECTRUM_CAPACITY);
+    ASSERT_FALSE(expected.empty());
+
+    fillSpectrum(1);
+    reorganizeSpectrumParallel(kWorkers);
+    auto actual = snapshot(spectrum, SPECTRUM_CAPACITY);
+    expectSame(expected, actual);
+}
+
+// The parallel universe rebuild merges and indexes records exactly like the serial one.
+TEST_F(StateReorgTest, UniverseMatchesSerial) {
+    fillUniverse(2);
+    assetsEndEpoch();
+    auto expected = snapshot(assets, ASSETS_CAPACITY);
+    ASSERT_FALSE(expected.empty());
+
+    fillUniverse(2);
+    assetsEndEpochParallel(kWorkers);
+    auto actual = snapshot(assets, ASSETS_CAPACITY);
+    expectSame(expected, actual);
+}
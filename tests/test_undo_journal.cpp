@@ -0,0 +1,149 @@
+#include <cstdio>
+#include <cstring>
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+// Include the headers for the code under test
+#include "StateRollback.h"
+
+
+// --- Test Fixture ---
+
+class UndoJournalTest : public ::testing::Test {
+protected:
+    static m256i key(uint64_t seed) {
+        return m256i(seed * 0x9E3779B97F4A7C15ULL, seed, ~seed, 42);
+    }
+
+    static uint64_t assetName(const char* name) {
+        uint64_t v = 0;
+        memcpy(&v, name, strlen(name));
+        return v;
+    }
+
+    // Index and raw bytes of every non-empty slot.
+    template <typename Record>
+    static std::vector<std::pair<uint32_t, std::vector<uint8_t>>> snapshot(const Record* table, uint64_t capacity) {
+        std::vector<std::pair<uint32_t, std::vector<uint8_t>>> out;
+        for (uint64_t i = 0; i < capacity; ++i) {
+            if (isZero(&table[i], sizeof(Record))) continue;
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(&table[i]);
+            out.emplace_back(static_cast<uint32_t>(i), std::vector<uint8_t>(p, p + sizeof(Record)));
+        }
+        return out;
+    }
+
+    using Ranking = std::vector<std::pair<long long, uint64_t>>;
+
+    // Balances and first key word of the n largest holders, plus their count.
+    static std::pair<Ranking, size_t> ranking(const std::vector<HolderRanking::Entry>& top, size_t holders) {
+        Ranking out;
+        for (const auto& e : top) out.emplace_back(e.balance, e.publicKey.m256i_u64[0]);
+        return {out, holders};
+    }
+
+    static std::pair<Ranking, size_t> topQu() {
+        std::vector<HolderRanking::Entry> top;
+        size_t holders = 0;
+        EXPECT_TRUE(richList.topQu(100, top, holders));
+        return ranking(top, holders);
+    }
+
+    static std::pair<Ranking, size_t> topAsset(const m256i& issuer, const char* name) {
+        std::vector<HolderRanking::Entry> top;
+        size_t holders = 0;
+        EXPECT_TRUE(richList.topAsset(issuer, assetName(name), 100, top, holders));
+        return ranking(top, holders);
+    }
+
+    static std::vector<uint32_t> indexed(const m256i& publicKey) {
+        std::vector<uint32_t> out;
+        EXPECT_TRUE(assetHolderIndex.get(publicKey, out));
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    void SetUp() override {
+        setMem(spectrum, SPECTRUM_CAPACITY * sizeof(EntityRecord), 0);
+        setMem(assets, ASSETS_CAPACITY * sizeof(AssetRecord), 0);
+        undoJournal.clear();
+        rebuildRichList();
+        rebuildAssetHolderIndex();
+    }
+};
+
+
+// --- Tests ---
+
+// Rolling a batch back undoes every QU and share change, in the records, the rich list and the holder index.
+TEST_F(UndoJournalTest, RestoresStateBeforeBatch) {
+    const m256i a = key(1), b = key(2), c = key(3);
+    const char unit[7] = {0};
+    int issuance, ownership, possession;
+    increaseEnergy(a, 1000, 10);
+    increaseEnergy(b, 500, 10);
+    issueAsset(a, "TOKEN\0\0", 0, unit, 1000, 1, &issuance, &ownership, &possession);
+    const auto spectrumBefore = snapshot(spectrum, SPECTRUM_CAPACITY);
+    const auto assetsBefore = snapshot(assets, ASSETS_CAPACITY);
+    const auto quBefore = topQu();
+    const auto tokenBefore = topAsset(a, "TOKEN");
+    const auto indexA = indexed(a), indexB = indexed(b), indexC = indexed(c);
+    ASSERT_EQ(quBefore.second, 2u);
+    ASSERT_EQ(tokenBefore.second, 1u);
+    ASSERT_EQ(indexB.size(), 0u);
+    undoJournal.clear();
+
+    // the batch
+    ASSERT_TRUE(decreaseEnergy(spectrumIndex(a), 300, 11));
+    increaseEnergy(c, 300, 11);
+    increaseEnergy(b, 10, 12);
+    int burnOwnership, burnPossession;
+    ASSERT_TRUE(transferShareOwnershipAndPossession(ownership, possession, m256i::zero(), 50, &burnOwnership, &burnPossession, true));
+    ASSERT_GE(transferShareOwnershipAndPossession(assetName("TOKEN"), a, a, a, 400, 1, c), 0);
+    int issuance2, ownership2, possession2;
+    issueAsset(b, "OTHER\0\0", 2, unit, 77, 1, &issuance2, &ownership2, &possession2);
+    ASSERT_NE(snapshot(spectrum, SPECTRUM_CAPACITY), spectrumBefore);
+    ASSERT_NE(snapshot(assets, ASSETS_CAPACITY), assetsBefore);
+    ASSERT_NE(topQu(), quBefore);
+    ASSERT_NE(topAsset(a, "TOKEN"), tokenBefore);
+    ASSERT_EQ(topAsset(b, "OTHER").second, 1u);
+    ASSERT_NE(indexed(b), indexB);
+
+    restoreUndoJournal();
+    EXPECT_TRUE(undoJournal.spectrumImages().empty());
+    EXPECT_TRUE(undoJournal.assetImages().empty());
+    EXPECT_EQ(snapshot(spectrum, SPECTRUM_CAPACITY), spectrumBefore);
+    EXPECT_EQ(snapshot(assets, ASSETS_CAPACITY), assetsBefore);
+    EXPECT_EQ(energy(spectrumIndex(a)), 1000);
+    EXPECT_EQ(energy(spectrumIndex(b)), 500);
+    EXPECT_LT(spectrumIndex(c), 0);
+    EXPECT_EQ(topQu(), quBefore);
+    EXPECT_EQ(topAsset(a, "TOKEN"), tokenBefore);
+    EXPECT_EQ(topAsset(b, "OTHER").second, 0u);
+    EXPECT_EQ(indexed(a), indexA);
+    EXPECT_EQ(indexed(b), indexB);
+    EXPECT_EQ(indexed(c), indexC);
+}
+
+// Only the first change of a record in a batch is kept.
+TEST_F(UndoJournalTest, KeepsFirstImageOnly) {
+    const m256i a = key(7);
+    increaseEnergy(a, 100, 1);
+    undoJournal.clear();
+    increaseEnergy(a, 5, 2);
+    increaseEnergy(a, 5, 3);
+    ASSERT_TRUE(decreaseEnergy(spectrumIndex(a), 20, 4));
+    ASSERT_EQ(undoJournal.spectrumImages().size(), 1u);
+
+    restoreUndoJournal();
+    const int index = spectrumIndex(a);
+    ASSERT_GE(index, 0);
+    EXPECT_EQ(energy(index), 100);
+    const auto qu = topQu();
+    ASSERT_EQ(qu.second, 1u);
+    EXPECT_EQ(qu.first[0].first, 100);
+    EXPECT_EQ(spectrum[index].latestIncomingTransferTick, 1u);
+    EXPECT_EQ(spectrum[index].numberOfOutgoingTransfers, 0u);
+}
@@ -0,0 +1,176 @@
+#include <cstdio>
+#include <cstring>
+#include "gtest/gtest.h"
+#include <map>
+#include <memory>
+#include <string>
+// Include the headers for the code under test
+#include "database/VtickCodec.h"
+#include "zstd.h"
+
+
+// --- Test Fixture ---
+
+class VtickCodecTest : public ::testing::Test {
+protected:
+    // A tick whose votes agree on the digests and differ in index, time and signature, like real ones.
+    static std::unique_ptr<FullTickStruct> makeTick(uint32_t tick) {
+        auto full = std::make_unique<FullTickStruct>();
+        memset((void*)full.get(), 0, sizeof(FullTickStruct));
+        full->td.epoch = 190;
+        full->td.tick = tick;
+        full->td.computorIndex = static_cast<uint16_t>(tick % 676);
+        for (size_t i = 0; i < sizeof(full->td.transactionDigests); i++) {
+            reinterpret_cast<uint8_t*>(full->td.transactionDigests)[i] = static_cast<uint8_t>(i * 31 + tick);
+        }
+        const size_t votes = sizeof(full->tv) / sizeof(TickVote);
+        for (size_t v = 0; v < votes; v++) {
+            TickVote& vote = full->tv[v];
+            vote.computorIndex = static_cast<uint16_t>(v);
+            vote.epoch = 190;
+            vote.tick = tick;
+            vote.millisecond = static_cast<uint16_t>((v * 7) % 1000);
+            vote.second = static_cast<uint8_t>(v % 60);
+            vote.prevSpectrumDigest.m256i_u32[0] = tick * 3;
+            vote.transactionDigest.m256i_u32[1] = tick * 5;
+            for (size_t i = 0; i < sizeof(vote.signature); i++) {
+                vote.signature[i] = static_cast<uint8_t>((v * 131 + i * 17 + tick) ^ (i >> 2));
+            }
+        }
+        return full;
+    }
+
+    static bool sameTick(const FullTickStruct& a, const FullTickStruct& b) {
+        return memcmp(&a, &b, sizeof(FullTickStruct)) == 0;
+    }
+};
+
+// --- Test Cases ---
+
+TEST_F(VtickCodecTest, ColumnarLayoutRoundTrips) {
+    auto tick = makeTick(1000);
+    std::string columns;
+    VtickCodec::toColumns(*tick, columns);
+    ASSERT_EQ(columns.size(), sizeof(FullTickStruct));
+    // the votes' computor indices are stored together right after the TickData
+    uint16_t second;
+    memcpy(&second, columns.data() + sizeof(TickData) + sizeof(uint16_t), sizeof(second));
+    EXPECT_EQ(second, 1);
+
+    auto back = std::make_unique<FullTickStruct>();
+    VtickCodec::fromColumns(columns.data(), *back);
+    EXPECT_TRUE(sameTick(*tick, *back));
+}
+
+TEST_F(VtickCodecTest, EncodesAndDecodesWithoutDictionary) {
+    VtickCodec codec;
+    codec.setSampling(false);
+    auto tick = makeTick(1001);
+    std::string blob;
+    ASSERT_TRUE(codec.encode(*tick, 3, blob));
+    EXPECT_LT(blob.size(), sizeof(FullTickStruct));
+
+    auto back = std::make_unique<FullTickStruct>();
+    ASSERT_TRUE(codec.decode(blob, *back));
+    EXPECT_TRUE(sameTick(*tick, *back));
+    EXPECT_FALSE(codec.decode(blob.substr(0, blob.size() / 2), *back));
+    EXPECT_FALSE(codec.decode("garbage", *back));
+}
+
+TEST_F(VtickCodecTest, DecodesPartsOfATick) {
+    VtickCodec codec;
+    codec.setSampling(false);
+    auto tick = makeTick(1003);
+    // a block of votes that never arrived
+    memset((void*)&tick->tv[64], 0, VtickCodec::kVotesPerBlock * sizeof(TickVote));
+    std::string blob;
+    ASSERT_TRUE(codec.encode(*tick, 3, blob));
+
+    TickData td;
+    ASSERT_TRUE(codec.decodeTickData(blob, td));
+    EXPECT_EQ(memcmp(&td, &tick->td, sizeof(TickData)), 0);
+
+    TickVote vote;
+    for (uint16_t i : {0, 31, 32, 70, 675}) {
+        ASSERT_TRUE(codec.decodeVote(blob, i, vote));
+        EXPECT_EQ(memcmp(&vote, &tick->tv[i], sizeof(TickVote)), 0) << i;
+    }
+    EXPECT_FALSE(codec.decodeVote(blob, 676, vote));
+
+    std::vector<TickVote> votes;
+    ASSERT_TRUE(codec.decodeVotes(blob, votes));
+    ASSERT_EQ(votes.size(), 676u);
+    EXPECT_EQ(memcmp(votes.data(), tick->tv, sizeof(tick->tv)), 0);
+
+    auto back = std::make_unique<FullTickStruct>();
+    ASSERT_TRUE(codec.decode(blob, *back));
+    EXPECT_TRUE(sameTick(*tick, *back));
+}
+
+TEST_F(VtickCodecTest, DecodesOlderFormats) {
+    auto tick = makeTick(1002);
+    std::string legacy(ZSTD_compressBound(sizeof(FullTickStruct)), '\0');
+    size_t size = ZSTD_compress(&legacy[0], legacy.size(), tick.get(), sizeof(FullTickStruct), 3);
+    ASSERT_FALSE(ZSTD_isError(size));
+    legacy.resize(size);
+
+    std::string columns;
+    VtickCodec::toColumns(*tick, columns);
+    std::string columnar(4 + ZSTD_compressBound(columns.size()), '\0');
+    memcpy(&columnar[0], "VTK\x01", 4);
+    size = ZSTD_compress(&columnar[4], columnar.size() - 4, columns.data(), columns.size(), 3);
+    ASSERT_FALSE(ZSTD_isError(size));
+    columnar.resize(4 + size);
+
+    VtickCodec codec;
+    for (const std::string& blob : {legacy, columnar}) {
+        auto back = std::make_unique<FullTickStruct>();
+        ASSERT_TRUE(codec.decode(blob, *back));
+        EXPECT_TRUE(sameTick(*tick, *back));
+        TickData td;
+        ASSERT_TRUE(codec.decodeTickData(blob, td));
+        EXPECT_EQ(td.tick, 1002u);
+        TickVote vote;
+        ASSERT_TRUE(codec.decodeVote(blob, 100, vote));
+        EXPECT_EQ(memcmp(&vote, &tick->tv[100], sizeof(TickVote)), 0);
+    }
+}
+
+TEST_F(VtickCodecTest, TrainsADictionaryAndLoadsItOnDemand) {
+    VtickCodec codec;
+    std::string blob;
+    for (uint32_t t = 0; t < VtickCodec::kSampleTicks - 1; t++) {
+        ASSERT_TRUE(codec.encode(*makeTick(2000 + t), 3, blob));
+        EXPECT_FALSE(codec.shouldTrain());
+    }
+    ASSERT_TRUE(codec.encode(*makeTick(2000 + VtickCodec::kSampleTicks), 3, blob));
+    ASSERT_TRUE(codec.shouldTrain());
+    EXPECT_FALSE(codec.shouldTrain()); // claimed once
+
+    const std::string dict = codec.trainDictionary();
+    ASSERT_FALSE(dict.empty());
+    const uint32_t id = codec.useDictionary(dict);
+    ASSERT_NE(id, 0u);
+    EXPECT_EQ(codec.currentDictionaryId(), id);
+    EXPECT_FALSE(codec.shouldTrain());
+
+    auto tick = makeTick(3000);
+    ASSERT_TRUE(codec.encode(*tick, 3, blob));
+
+    // a reader that has never seen the dictionary fetches it by id
+    std::map<uint32_t, std::string> stored{{id, dict}};
+    int loads = 0;
+    VtickCodec reader;
+    auto back = std::make_unique<FullTickStruct>();
+    EXPECT_FALSE(reader.decode(blob, *back));
+    reader.setDictionaryLoader([&](uint32_t dictId) -> std::optional<std::string> {
+        loads++;
+        auto it = stored.find(dictId);
+        if (it == stored.end()) return std::nullopt;
+        return it->second;
+    });
+    ASSERT_TRUE(reader.decode(blob, *back));
+    EXPECT_TRUE(sameTick(*tick, *back));
+    ASSERT_TRUE(reader.decode(blob, *back));
+    EXPECT_EQ(loads, 1);
+}